@@ -0,0 +1,157 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+Animation.h
+Classes for storing, playing and blending skeletal animations.
+*/
+
+#pragma once
+
+#include "Skeleton.h"
+
+#include "glad/glad.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nou
+{
+	//A single animation for a skeleton (e.g., a walk cycle).
+	//Clips are resampled at a fixed frame rate when they are imported, so finding the frames
+	//around a time is just a division rather than a search through keyframes.
+	//To keep memory down (we might have hundreds of these), every component of every joint is
+	//stored as a 16-bit fraction of the range that component covers over the clip.
+	class AnimationClip
+	{
+		public:
+
+		AnimationClip() = default;
+		~AnimationClip() = default;
+
+		//Compresses a clip from poses sampled at a fixed rate (in frames per second).
+		void Build(const std::string& name, const std::vector<Pose>& frames, float sampleRate);
+
+		const std::string& GetName() const { return m_name; }
+		float GetDuration() const { return m_duration; }
+		size_t FrameCount() const { return m_frameCount; }
+		size_t JointCount() const { return m_jointCount; }
+
+		//Returns roughly how many bytes the clip takes up.
+		size_t GetMemoryUsage() const;
+
+		//Decodes the pose at the given time (in seconds), blending between the frames on either side.
+		//If loop is false, the time is clamped to the ends of the clip.
+		void Sample(float time, bool loop, Pose& out) const;
+
+		protected:
+
+		std::string m_name;
+		float m_sampleRate = 30.0f;
+		float m_duration = 0.0f;
+		size_t m_frameCount = 0;
+		size_t m_jointCount = 0;
+		size_t m_paddedCount = 0;
+
+		//Each frame is laid out the same way as a Pose (one padded array per component),
+		//so that we can decode 4 joints at a time.
+		std::vector<uint16_t> m_frames;
+		//The minimum value and the size of one step of every component of every joint,
+		//also laid out like a Pose.
+		std::vector<float> m_min;
+		std::vector<float> m_step;
+	};
+
+	//A playing animation, which can crossfade from one clip into another.
+	//Any number of skinned meshes can follow the same state, and its pose is only
+	//worked out once per frame - so a crowd of enemies that share a state (e.g., all
+	//walking in step) costs about the same as one.
+	class AnimationState
+	{
+		public:
+
+		float m_speed;
+		bool m_loop;
+
+		AnimationState(const Skeleton& skeleton);
+		~AnimationState() = default;
+
+		//Switches to a new clip, blending from the current one over fadeTime seconds.
+		void Play(const AnimationClip& clip, float fadeTime = 0.0f);
+
+		const Skeleton& GetSkeleton() const { return *m_skeleton; }
+		const AnimationClip* GetClip() const { return m_clip; }
+		float GetTime() const { return m_time; }
+		const Pose& GetPose() const { return m_pose; }
+
+		//The index of this state's first joint matrix in its animator's joint texture.
+		GLint GetPaletteOffset() const { return m_paletteOffset; }
+
+		protected:
+
+		friend class Animator;
+
+		const Skeleton* m_skeleton;
+		const AnimationClip* m_clip;
+		const AnimationClip* m_prevClip;
+		float m_time;
+		float m_prevTime;
+		float m_fade;
+		float m_fadeTime;
+
+		Pose m_pose;
+		Pose m_prevPose;
+		GLint m_paletteOffset;
+
+		//Moves the state forward in time, then works out its pose and joint matrices.
+		void Update(float deltaTime, glm::mat4* palette);
+	};
+
+	//Updates every animation state, and keeps all of their joint matrices in one
+	//texture buffer for our skinning shaders to read from.
+	//States are spread over a few threads, since each one only touches its own pose
+	//and its own part of the joint matrices.
+	class Animator
+	{
+		public:
+
+		//The texture slot our skinning shaders expect the joint matrices on.
+		//This is the last slot a Material can use, so materials on skinned meshes get one less texture.
+		static const GLenum JOINT_SLOT = GL_TEXTURE15;
+
+		Animator();
+		~Animator();
+
+		Animator(const Animator&) = delete;
+		Animator& operator=(const Animator&) = delete;
+
+		//Creates a new state for a skeleton.
+		//The state is removed from the animator once nothing is holding on to it anymore.
+		std::shared_ptr<AnimationState> CreateState(const Skeleton& skeleton);
+
+		//Advances every state and uploads their joint matrices.
+		//This should be called once per frame, before drawing any skinned meshes.
+		void Update(float deltaTime);
+
+		//Binds the joint matrices to JOINT_SLOT.
+		void Bind() const;
+
+		size_t StateCount() const { return m_live.size(); }
+
+		protected:
+
+		//Below this many states, it isn't worth handing the work to other threads.
+		static const size_t PARALLEL_THRESHOLD = 16;
+		static const unsigned MAX_THREADS = 8;
+
+		std::vector<std::weak_ptr<AnimationState>> m_states;
+		std::vector<std::shared_ptr<AnimationState>> m_live;
+		std::vector<glm::mat4> m_palette;
+
+		//The buffer holding the joint matrices, and the texture we read it through.
+		GLuint m_buffer;
+		GLuint m_texture;
+	};
+}
@@ -43,7 +43,7 @@ namespace nou
 		//one for us.
 		CMeshRenderer& operator=(CMeshRenderer&&) = default;
 
-		void SetMesh(const Mesh& mesh);
+		virtual void SetMesh(const Mesh& mesh);
 		void SetMaterial(Material& mat);
 		virtual void Draw();
 
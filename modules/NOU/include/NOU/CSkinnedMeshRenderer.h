@@ -0,0 +1,44 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+CSkinnedMeshRenderer.h
+Mesh renderer component for meshes that are deformed by a skeleton.
+The skinning itself happens on the GPU, in the vertex shader.
+*/
+
+#pragma once
+
+#include "CMeshRenderer.h"
+#include "Animation.h"
+
+#include <memory>
+
+namespace nou
+{
+	class CSkinnedMeshRenderer : public CMeshRenderer
+	{
+		public:
+
+		//Any number of renderers can share the same animation state,
+		//in which case they will all be drawn in the same pose.
+		CSkinnedMeshRenderer(Entity& owner, const Mesh& mesh, Material& mat,
+							 const Animator& animator, std::shared_ptr<AnimationState> state);
+		virtual ~CSkinnedMeshRenderer() = default;
+
+		CSkinnedMeshRenderer(CSkinnedMeshRenderer&&) = default;
+		CSkinnedMeshRenderer& operator=(CSkinnedMeshRenderer&&) = default;
+
+		void SetMesh(const Mesh& mesh) override;
+		void SetState(std::shared_ptr<AnimationState> state);
+		AnimationState& GetState() { return *m_state; }
+
+		//Expects the material's shader to follow the conventions in skinned.vert.
+		void Draw() override;
+
+		protected:
+
+		const Animator* m_animator;
+		std::shared_ptr<AnimationState> m_state;
+	};
+}
@@ -240,6 +240,20 @@ namespace nou
 														 (long long)buf.ElementSize()));
 		}
 
+		//Like BindAttrib, but the buffer holds one element per instance rather than per vertex.
+		//Instance buffers don't count towards the number of vertices we draw.
+		void BindInstanceAttrib(const VertexBuffer& buf, GLuint attribLoc)
+		{
+			glBindVertexArray(m_id);
+			glEnableVertexAttribArray(attribLoc);
+			glBindBuffer(GL_ARRAY_BUFFER, buf.GetID());
+			glVertexAttribPointer(attribLoc, buf.ElementLength(),
+								  GL_FLOAT, GL_FALSE, 0,
+								 reinterpret_cast<void*>((long long)buf.StartIndex() *
+														 (long long)buf.ElementSize()));
+			glVertexAttribDivisor(attribLoc, 1);
+		}
+
 		void SetDrawMode(DrawMode drawMode)
 		{
 			m_drawMode = drawMode;
@@ -253,6 +267,15 @@ namespace nou
 			glDrawArrays((int)m_drawMode, 0, m_len);
 		}
 
+		//Draws the whole VAO instanceCount times in a single draw call.
+		void DrawInstanced(GLsizei instanceCount)
+		{
+			m_len = m_vbos.begin()->second->Length();
+
+			glBindVertexArray(m_id);
+			glDrawArraysInstanced((int)m_drawMode, 0, m_len, instanceCount);
+		}
+
 		void DrawElements(const std::vector<GLuint>& indices, size_t count)
 		{
 			if (count == 0)
@@ -10,6 +10,8 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 #pragma once
 
 #include "Mesh.h"
+#include "Skeleton.h"
+#include "Animation.h"
 
 #include <string>
 
@@ -17,6 +19,7 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 namespace tinygltf
 {
 	class Model;
+	class Node;
 	struct Primitive;
 }
 
@@ -32,6 +35,12 @@ namespace nou::GLTF
 
 	//Loads a 3D model into the mesh object given.
 	void LoadMesh(const std::string& filename, Mesh& mesh, bool flipUVY = true);
+
+	//Loads a skinned 3D model into the mesh object given, along with its skeleton
+	//and every animation in the file. Animations are resampled at sampleRate frames per second.
+	void LoadSkinnedMesh(const std::string& filename, Mesh& mesh, Skeleton& skeleton,
+						 std::vector<AnimationClip>& clips, bool flipUVY = true,
+						 float sampleRate = 30.0f);
 	
 	void DumpErrorsAndWarnings(const std::string& filename,
 							   const std::string& err,
@@ -45,6 +54,25 @@ namespace nou::GLTF
 	bool ExtractGeometry(const tinygltf::Model& gltf, Mesh& mesh, bool flipUVY,
 					     std::string& err, std::string& warn);
 
+	//Takes a glTF model and extracts the joints that influence each vertex, and their weights.
+	//The vertices come out in the same order as ExtractGeometry.
+	bool ExtractSkin(const tinygltf::Model& gltf, Mesh& mesh,
+					 std::string& err, std::string& warn);
+
+	//Builds a skeleton from the first skin in a glTF model.
+	//jointNodes is filled with the glTF node that each joint came from.
+	bool ExtractSkeleton(const tinygltf::Model& gltf, Skeleton& skeleton, std::vector<int>& jointNodes,
+						 std::string& err, std::string& warn);
+
+	//Resamples every animation in a glTF model at a fixed rate, and compresses them into clips.
+	bool ExtractAnimations(const tinygltf::Model& gltf, const Skeleton& skeleton,
+						   const std::vector<int>& jointNodes, float sampleRate,
+						   std::vector<AnimationClip>& clips,
+						   std::string& err, std::string& warn);
+
+	//Gets the local transform of a glTF node, whether it is stored as a matrix or as separate parts.
+	void GetNodeTransform(const tinygltf::Node& node, glm::vec3& pos, glm::quat& rot, glm::vec3& scale);
+
 	bool ProcessPrimitive(const tinygltf::Model& gltf, size_t geomIndex, 
 					      std::vector<glm::vec3>& verts, std::vector<glm::vec2>& uvs,
 						  std::vector<glm::vec3>& normals, bool flipUVY,
@@ -41,6 +41,19 @@ namespace nou
 		void SetNormals(const std::vector<glm::vec3>& normals);
 		void SetUVs(const std::vector<glm::vec2>& uvs);
 
+		//For skinned meshes - the indices of the (up to) 4 joints that move each vertex,
+		//and how much each of those joints moves it by (the weights should add up to 1).
+		//Joint indices are stored as floats, since our vertex buffers only deal in floats.
+		void SetJointInfluences(const std::vector<glm::vec4>& joints);
+		void SetSkinWeights(const std::vector<glm::vec4>& weights);
+
+		//CPU-side copies of the mesh data (e.g., for baking animations).
+		const std::vector<glm::vec3>& GetVerts() const { return m_verts; }
+		const std::vector<glm::vec3>& GetNormals() const { return m_normals; }
+		const std::vector<glm::vec2>& GetUVs() const { return m_uvs; }
+		const std::vector<glm::vec4>& GetJointInfluences() const { return m_joints; }
+		const std::vector<glm::vec4>& GetSkinWeights() const { return m_weights; }
+
 		//Fetches a vertex buffer associated with the desired attribute.
 		//Used by mesh rendering components to grab the requisite data
 		//associated with this model in OpenGL.
@@ -51,6 +64,8 @@ namespace nou
 		std::vector<glm::vec3> m_verts;
 		std::vector<glm::vec3> m_normals;
 		std::vector<glm::vec2> m_uvs;
+		std::vector<glm::vec4> m_joints;
+		std::vector<glm::vec4> m_weights;
 
 		std::map<Attrib, std::unique_ptr<VertexBuffer>> m_vbo;
 
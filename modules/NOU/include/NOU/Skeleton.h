@@ -0,0 +1,115 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+Skeleton.h
+Classes for managing the joint hierarchy of a skinned mesh, and poses of that hierarchy.
+*/
+
+#pragma once
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include "GLM/glm.hpp"
+#include "GLM/gtx/quaternion.hpp"
+
+#include <vector>
+#include <string>
+
+namespace nou
+{
+	//A pose stores the local translation, rotation and scale of every joint in a skeleton.
+	//Rather than an array of transforms, we keep one array per component (all the X translations,
+	//then all the Y translations, and so on). This is called a "structure of arrays" layout,
+	//and it lets us work on 4 joints at a time with SIMD instructions when sampling and blending.
+	//Each array is padded out to a multiple of 4 joints so we never need to handle leftovers.
+	class Pose
+	{
+		public:
+
+		enum Channel
+		{
+			TX = 0, TY, TZ,
+			RX, RY, RZ, RW,
+			SX, SY, SZ,
+			CHANNEL_COUNT
+		};
+
+		Pose() = default;
+		explicit Pose(size_t jointCount);
+		~Pose() = default;
+
+		void Resize(size_t jointCount);
+
+		size_t JointCount() const { return m_jointCount; }
+		size_t PaddedCount() const { return m_paddedCount; }
+
+		float* GetChannel(int channel) { return m_data.data() + channel * m_paddedCount; }
+		const float* GetChannel(int channel) const { return m_data.data() + channel * m_paddedCount; }
+
+		void SetJoint(size_t joint, const glm::vec3& pos, const glm::quat& rot, const glm::vec3& scale);
+		glm::vec3 GetTranslation(size_t joint) const;
+		glm::quat GetRotation(size_t joint) const;
+		glm::vec3 GetScale(size_t joint) const;
+
+		//Brings every rotation back to unit length, which is needed after blending
+		//rotations component by component.
+		void NormalizeRotations();
+
+		//Blends between two poses of the same skeleton (a weight of 0 gives a, 1 gives b),
+		//4 joints at a time. It is safe for out to be the same pose as a or b.
+		static void Blend(const Pose& a, const Pose& b, float weight, Pose& out);
+
+		protected:
+
+		size_t m_jointCount = 0;
+		size_t m_paddedCount = 0;
+		std::vector<float> m_data;
+	};
+
+	//A skeleton is the hierarchy of joints that a skinned mesh is bound to.
+	//Joints are stored in the same order as the joint indices in the mesh's vertex data,
+	//which is not necessarily an order where parents come before their children - so we also
+	//keep an evaluation order that does.
+	class Skeleton
+	{
+		public:
+
+		struct Joint
+		{
+			std::string name;
+			//The index of the parent joint, or -1 for a root.
+			int parent;
+			//Takes a vertex from model space into the joint's space when the mesh is in its bind pose.
+			glm::mat4 inverseBind;
+			//The joint's local transform in the bind pose.
+			glm::vec3 pos;
+			glm::quat rot;
+			glm::vec3 scale;
+		};
+
+		Skeleton() = default;
+		~Skeleton() = default;
+
+		void SetJoints(const std::vector<Joint>& joints);
+
+		size_t JointCount() const { return m_joints.size(); }
+		const Joint& GetJoint(size_t index) const { return m_joints[index]; }
+
+		//Returns the index of the joint with the given name, or -1 if there isn't one.
+		int FindJoint(const std::string& name) const;
+
+		//Fills the pose with the skeleton's bind pose.
+		void GetBindPose(Pose& pose) const;
+
+		//Turns a pose into the matrices our skinning shader needs, which take a vertex
+		//from its bind pose in model space to its posed position in model space.
+		//out must have room for JointCount() matrices.
+		void ComputeSkinningMatrices(const Pose& pose, glm::mat4* out) const;
+
+		protected:
+
+		std::vector<Joint> m_joints;
+		//Joint indices ordered so that every parent comes before its children.
+		std::vector<int> m_order;
+	};
+}
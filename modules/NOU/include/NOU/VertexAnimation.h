@@ -0,0 +1,170 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+VertexAnimation.h
+Classes for baking skeletal animations into vertex animation textures (VATs),
+and for drawing large crowds of instances that play them back.
+*/
+
+#pragma once
+
+#include "Mesh.h"
+#include "Skeleton.h"
+#include "Animation.h"
+#include "Material.h"
+#include "GLObjects.h"
+
+#include "GLM/glm.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nou
+{
+	//A set of animations where, rather than storing joints, we store where every vertex
+	//of the mesh ends up on every frame. This takes a lot more memory than a skeleton,
+	//but playing it back is just a couple of texture reads per vertex - no joints to
+	//evaluate on the CPU, and no joint matrices to blend on the GPU.
+	//
+	//Each frame takes up rowsPerFrame rows of the textures, with one texel per vertex.
+	//Positions are stored as half floats, and normals as 8-bit signed values.
+	class VertexAnimation
+	{
+		public:
+
+		struct Clip
+		{
+			std::string name;
+			//The row of frames in the textures that the clip starts at, and how many frames it has.
+			uint32_t firstFrame;
+			uint32_t frameCount;
+			float frameRate;
+		};
+
+		//The texture slots our VAT shader expects the positions and normals on.
+		static const GLenum POSITION_SLOT = GL_TEXTURE13;
+		static const GLenum NORMAL_SLOT = GL_TEXTURE14;
+
+		VertexAnimation();
+		~VertexAnimation();
+
+		VertexAnimation(const VertexAnimation&) = delete;
+		VertexAnimation& operator=(const VertexAnimation&) = delete;
+
+		//Bakes animations of a skinned mesh into a .vat file.
+		//This is meant to be run ahead of time, as a tool, rather than while the game is loading.
+		//Every clip is sampled at frameRate frames per second, and is assumed to loop.
+		static bool Bake(const Mesh& mesh, const Skeleton& skeleton,
+						 const std::vector<AnimationClip>& clips, float frameRate,
+						 const std::string& filename);
+
+		//Loads a baked .vat file, and uploads its textures.
+		bool LoadFromFile(const std::string& filename);
+
+		//Returns the index of the clip with the given name, or -1 if there isn't one.
+		int FindClip(const std::string& name) const;
+		const Clip& GetClip(int index) const { return m_clips[index]; }
+		size_t ClipCount() const { return m_clips.size(); }
+
+		size_t VertexCount() const { return m_vertexCount; }
+
+		//Binds the textures to POSITION_SLOT and NORMAL_SLOT, and points the current shader at them.
+		void Bind() const;
+
+		protected:
+
+		//The textures are never wider than this, longer meshes wrap onto more rows.
+		static const uint32_t MAX_WIDTH = 2048;
+
+		struct FileHeader
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t vertexCount;
+			uint32_t width;
+			uint32_t rowsPerFrame;
+			uint32_t frameCount;
+			uint32_t clipCount;
+		};
+
+		uint32_t m_vertexCount;
+		uint32_t m_width;
+		uint32_t m_rowsPerFrame;
+		std::vector<Clip> m_clips;
+
+		GLuint m_positions;
+		GLuint m_normals;
+	};
+
+	//Draws many copies of a mesh, each playing one of the clips in a VertexAnimation
+	//with its own start time and playback rate. Each instance only needs its placement
+	//and a few numbers describing its animation, and the frame to show is worked out
+	//in the vertex shader - so on the CPU, an animated instance costs about the same
+	//as a static one, and the whole crowd is drawn in one draw call.
+	class VatCrowd
+	{
+		public:
+
+		//The shader must follow the conventions in vat.vert.
+		VatCrowd(const VertexAnimation& anim, const Mesh& mesh, Material& mat);
+		~VatCrowd() = default;
+
+		VatCrowd(const VatCrowd&) = delete;
+		VatCrowd& operator=(const VatCrowd&) = delete;
+
+		//Adds an instance, returning its index. timeOffset (in seconds) lets instances
+		//playing the same clip be out of step with each other.
+		size_t AddInstance(const glm::vec3& pos, float yaw, int clip,
+						   float timeOffset = 0.0f, float rate = 1.0f);
+
+		//Removes an instance. To keep the instances tightly packed,
+		//the last instance is moved into its place (and takes its index).
+		void RemoveInstance(size_t index);
+
+		size_t InstanceCount() const { return m_placement.size(); }
+
+		//Yaw is the rotation around the Y axis, in radians.
+		void SetTransform(size_t index, const glm::vec3& pos, float yaw);
+
+		//Switches an instance to a new clip, starting from its first frame.
+		void Play(size_t index, int clip, float rate = 1.0f);
+
+		//Changes how fast an instance plays its clip, without making it jump to a different frame.
+		void SetRate(size_t index, float rate);
+
+		//Advances the crowd's clock. This is the only thing that changes every frame
+		//for instances that aren't moving or switching clips.
+		void Update(float deltaTime);
+
+		void Draw();
+
+		protected:
+
+		//The attribute locations of the per instance data in vat.vert.
+		static const GLuint PLACEMENT_LOC = 5;
+		static const GLuint ANIM_LOC = 6;
+
+		const VertexAnimation* m_anim;
+		Material* m_mat;
+		float m_time;
+
+		//Per instance - the position in xyz and yaw in w,
+		//and the first frame of the clip, its frame count, its frame rate
+		//(including the playback rate) and the frame it started on.
+		std::vector<glm::vec4> m_placement;
+		std::vector<glm::vec4> m_animState;
+		//The clip each instance is playing, only kept on the CPU.
+		std::vector<int> m_clips;
+		bool m_dirty;
+
+		std::unique_ptr<VertexArray> m_vao;
+		std::unique_ptr<VertexBuffer> m_placementVBO;
+		std::unique_ptr<VertexBuffer> m_animVBO;
+
+		//Works out the (fractional) frame an instance is on right now.
+		float CurrentFrame(size_t index) const;
+	};
+}
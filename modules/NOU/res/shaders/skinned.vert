@@ -0,0 +1,56 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+skinned.vert
+Vertex shader.
+Deforms the vertex by the joints of its skeleton, then passes world vertex position,
+transformed normal direction, and UV coordinates to the fragment shader
+(use with texturedlit.frag).
+*/
+
+#version 420 core
+
+uniform mat4 model;
+uniform mat3 normal;
+uniform mat4 viewproj;
+
+//The joint matrices for every animation, 4 texels per matrix.
+uniform samplerBuffer jointMatrices;
+//Where the matrices for this mesh's animation start.
+uniform int jointOffset;
+
+layout(location = 0) in vec4 inPos;
+layout(location = 1) in vec3 inNorm;
+layout(location = 2) in vec2 inUV;
+layout(location = 3) in vec4 inJoints;
+layout(location = 4) in vec4 inWeights;
+
+layout(location = 0) out vec4 outPos;
+layout(location = 1) out vec3 outNorm;
+layout(location = 2) out vec2 outUV;
+
+mat4 GetJoint(float joint)
+{
+    int texel = (jointOffset + int(joint)) * 4;
+
+    return mat4(texelFetch(jointMatrices, texel),
+                texelFetch(jointMatrices, texel + 1),
+                texelFetch(jointMatrices, texel + 2),
+                texelFetch(jointMatrices, texel + 3));
+}
+
+void main()
+{
+    //Blend the matrices of the joints that influence this vertex.
+    mat4 skin = GetJoint(inJoints.x) * inWeights.x +
+                GetJoint(inJoints.y) * inWeights.y +
+                GetJoint(inJoints.z) * inWeights.z +
+                GetJoint(inJoints.w) * inWeights.w;
+
+    outNorm = normal * mat3(skin) * inNorm;
+    outPos = model * skin * inPos;
+    outUV = inUV;
+
+    gl_Position = viewproj * outPos;
+}
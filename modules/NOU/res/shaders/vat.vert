@@ -0,0 +1,64 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+vat.vert
+Vertex shader.
+Plays back a vertex animation texture (VAT) for each instance of a crowd,
+then passes world vertex position, transformed normal direction, and UV coordinates
+to the fragment shader (use with texturedlit.frag).
+*/
+
+#version 420 core
+
+uniform mat4 viewproj;
+//The crowd's clock, in seconds.
+uniform float time;
+
+//Every vertex's position and normal on every frame, one texel per vertex.
+uniform sampler2D vatPositions;
+uniform sampler2D vatNormals;
+uniform int vatWidth;
+uniform int vatRowsPerFrame;
+
+layout(location = 2) in vec2 inUV;
+//Per instance - position in xyz, rotation around the Y axis (in radians) in w.
+layout(location = 5) in vec4 inPlacement;
+//Per instance - the clip's first frame, its frame count, frames per second and frame offset.
+layout(location = 6) in vec4 inAnim;
+
+layout(location = 0) out vec4 outPos;
+layout(location = 1) out vec3 outNorm;
+layout(location = 2) out vec2 outUV;
+
+ivec2 GetTexel(int frame)
+{
+    return ivec2(gl_VertexID % vatWidth, frame * vatRowsPerFrame + gl_VertexID / vatWidth);
+}
+
+void main()
+{
+    //Work out which frames we're between - clips loop, so the last frame blends back into the first.
+    float frame = mod(time * inAnim.z + inAnim.w, inAnim.y);
+    int f0 = int(frame);
+    int f1 = (f0 + 1) % int(inAnim.y);
+    float blend = fract(frame);
+
+    int first = int(inAnim.x);
+    vec3 pos = mix(texelFetch(vatPositions, GetTexel(first + f0), 0).xyz,
+                   texelFetch(vatPositions, GetTexel(first + f1), 0).xyz, blend);
+    vec3 norm = mix(texelFetch(vatNormals, GetTexel(first + f0), 0).xyz,
+                    texelFetch(vatNormals, GetTexel(first + f1), 0).xyz, blend);
+
+    float c = cos(inPlacement.w);
+    float s = sin(inPlacement.w);
+    mat3 rotation = mat3(c, 0.0, -s,
+                         0.0, 1.0, 0.0,
+                         s, 0.0, c);
+
+    outNorm = normalize(rotation * norm);
+    outPos = vec4(rotation * pos + inPlacement.xyz, 1.0);
+    outUV = inUV;
+
+    gl_Position = viewproj * outPos;
+}
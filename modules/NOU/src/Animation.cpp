@@ -0,0 +1,278 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+Animation.cpp
+Classes for storing, playing and blending skeletal animations.
+*/
+
+#include "NOU/Animation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <thread>
+#include <emmintrin.h>
+
+namespace nou
+{
+	void AnimationClip::Build(const std::string& name, const std::vector<Pose>& frames, float sampleRate)
+	{
+		m_name = name;
+		m_sampleRate = sampleRate;
+		m_frameCount = frames.size();
+		m_jointCount = (m_frameCount > 0) ? frames[0].JointCount() : 0;
+		m_paddedCount = (m_frameCount > 0) ? frames[0].PaddedCount() : 0;
+		m_duration = (m_frameCount > 1) ? (m_frameCount - 1) / sampleRate : 0.0f;
+
+		const size_t frameSize = m_paddedCount * Pose::CHANNEL_COUNT;
+
+		//q and -q are the same rotation, but blending between them gives garbage.
+		//By flipping each frame's rotations onto the same side as the frame before,
+		//we can blend between neighbouring frames with a plain lerp when sampling.
+		std::vector<Pose> fixed = frames;
+
+		for (size_t f = 1; f < m_frameCount; ++f)
+		{
+			for (size_t j = 0; j < m_jointCount; ++j)
+			{
+				if (glm::dot(fixed[f - 1].GetRotation(j), fixed[f].GetRotation(j)) < 0.0f)
+				{
+					for (int c = Pose::RX; c <= Pose::RW; ++c)
+						fixed[f].GetChannel(c)[j] = -fixed[f].GetChannel(c)[j];
+				}
+			}
+		}
+
+		//Find the range each component covers, and split it into 65536 steps.
+		m_min.assign(frameSize, 0.0f);
+		m_step.assign(frameSize, 0.0f);
+
+		for (size_t i = 0; i < frameSize; ++i)
+		{
+			float lo = fixed[0].GetChannel(0)[i];
+			float hi = lo;
+
+			for (size_t f = 1; f < m_frameCount; ++f)
+			{
+				lo = std::min(lo, fixed[f].GetChannel(0)[i]);
+				hi = std::max(hi, fixed[f].GetChannel(0)[i]);
+			}
+
+			m_min[i] = lo;
+			m_step[i] = (hi - lo) / 65535.0f;
+		}
+
+		m_frames.resize(frameSize * m_frameCount);
+
+		for (size_t f = 0; f < m_frameCount; ++f)
+		{
+			for (size_t i = 0; i < frameSize; ++i)
+			{
+				float steps = (m_step[i] > 0.0f) ? (fixed[f].GetChannel(0)[i] - m_min[i]) / m_step[i] : 0.0f;
+				m_frames[f * frameSize + i] = (uint16_t)glm::clamp(std::round(steps), 0.0f, 65535.0f);
+			}
+		}
+	}
+
+	size_t AnimationClip::GetMemoryUsage() const
+	{
+		return m_frames.size() * sizeof(uint16_t) + (m_min.size() + m_step.size()) * sizeof(float);
+	}
+
+	void AnimationClip::Sample(float time, bool loop, Pose& out) const
+	{
+		out.Resize(m_jointCount);
+
+		if (m_frameCount == 0)
+			return;
+
+		float frame;
+
+		if (loop && m_duration > 0.0f)
+		{
+			float t = std::fmod(time, m_duration);
+
+			if (t < 0.0f)
+				t += m_duration;
+
+			frame = t * m_sampleRate;
+		}
+		else
+			frame = glm::clamp(time * m_sampleRate, 0.0f, (float)(m_frameCount - 1));
+
+		size_t f0 = std::min((size_t)frame, m_frameCount - 1);
+		size_t f1 = std::min(f0 + 1, m_frameCount - 1);
+		float alpha = frame - (float)f0;
+
+		//Decode the frames on either side 4 values at a time, and lerp between them.
+		//Since a frame is laid out just like a pose, we can run over every component
+		//of every joint in one loop.
+		const size_t frameSize = m_paddedCount * Pose::CHANNEL_COUNT;
+		const uint16_t* q0 = &m_frames[f0 * frameSize];
+		const uint16_t* q1 = &m_frames[f1 * frameSize];
+		float* dst = out.GetChannel(0);
+
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 a = _mm_set1_ps(alpha);
+
+		for (size_t i = 0; i < frameSize; i += 4)
+		{
+			//Widen 4 16-bit values to 32-bit integers, then convert them to floats.
+			__m128 v0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(q0 + i)), zero));
+			__m128 v1 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(q1 + i)), zero));
+
+			__m128 lo = _mm_loadu_ps(&m_min[i]);
+			__m128 step = _mm_loadu_ps(&m_step[i]);
+			v0 = _mm_add_ps(lo, _mm_mul_ps(v0, step));
+			v1 = _mm_add_ps(lo, _mm_mul_ps(v1, step));
+
+			_mm_storeu_ps(dst + i, _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), a)));
+		}
+
+		out.NormalizeRotations();
+	}
+
+	AnimationState::AnimationState(const Skeleton& skeleton)
+	{
+		m_speed = 1.0f;
+		m_loop = true;
+		m_skeleton = &skeleton;
+		m_clip = nullptr;
+		m_prevClip = nullptr;
+		m_time = 0.0f;
+		m_prevTime = 0.0f;
+		m_fade = 0.0f;
+		m_fadeTime = 0.0f;
+		m_paletteOffset = 0;
+
+		skeleton.GetBindPose(m_pose);
+	}
+
+	void AnimationState::Play(const AnimationClip& clip, float fadeTime)
+	{
+		if (&clip == m_clip)
+			return;
+
+		//Keep the old clip running while we fade out of it.
+		m_prevClip = (fadeTime > 0.0f) ? m_clip : nullptr;
+		m_prevTime = m_time;
+		m_clip = &clip;
+		m_time = 0.0f;
+		m_fade = 0.0f;
+		m_fadeTime = fadeTime;
+	}
+
+	void AnimationState::Update(float deltaTime, glm::mat4* palette)
+	{
+		m_time += deltaTime * m_speed;
+		m_prevTime += deltaTime * m_speed;
+		m_fade += deltaTime;
+
+		if (m_clip != nullptr)
+			m_clip->Sample(m_time, m_loop, m_pose);
+
+		if (m_prevClip != nullptr)
+		{
+			if (m_fade < m_fadeTime)
+			{
+				m_prevClip->Sample(m_prevTime, m_loop, m_prevPose);
+				Pose::Blend(m_prevPose, m_pose, m_fade / m_fadeTime, m_pose);
+			}
+			else
+				m_prevClip = nullptr;
+		}
+
+		m_skeleton->ComputeSkinningMatrices(m_pose, palette);
+	}
+
+	Animator::Animator()
+	{
+		glGenBuffers(1, &m_buffer);
+		glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+		glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+
+		//A buffer texture lets the shader read our matrices straight out of the buffer,
+		//4 RGBA texels per matrix, without the size limits of a uniform array.
+		glGenTextures(1, &m_texture);
+		glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_buffer);
+	}
+
+	Animator::~Animator()
+	{
+		glDeleteTextures(1, &m_texture);
+		glDeleteBuffers(1, &m_buffer);
+	}
+
+	std::shared_ptr<AnimationState> Animator::CreateState(const Skeleton& skeleton)
+	{
+		auto state = std::make_shared<AnimationState>(skeleton);
+		m_states.push_back(state);
+		return state;
+	}
+
+	void Animator::Update(float deltaTime)
+	{
+		//Forget about any states that nothing is using anymore.
+		m_states.erase(std::remove_if(m_states.begin(), m_states.end(),
+			[](const std::weak_ptr<AnimationState>& state) { return state.expired(); }), m_states.end());
+
+		m_live.clear();
+
+		GLint jointCount = 0;
+
+		for (auto& weak : m_states)
+		{
+			auto state = weak.lock();
+			state->m_paletteOffset = jointCount;
+			jointCount += (GLint)state->GetSkeleton().JointCount();
+			m_live.push_back(state);
+		}
+
+		m_palette.resize(jointCount);
+
+		auto updateRange = [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+				m_live[i]->Update(deltaTime, m_palette.data() + m_live[i]->m_paletteOffset);
+		};
+
+		//Every state writes to its own pose and its own part of the palette,
+		//so we can split them between threads without any locking.
+		size_t threadCount = 1;
+
+		if (m_live.size() >= PARALLEL_THRESHOLD)
+			threadCount = glm::clamp(std::thread::hardware_concurrency(), 1u, MAX_THREADS);
+
+		size_t perThread = (m_live.size() + threadCount - 1) / threadCount;
+		std::vector<std::future<void>> tasks;
+
+		for (size_t t = 1; t < threadCount; ++t)
+		{
+			size_t begin = t * perThread;
+			size_t end = std::min(m_live.size(), begin + perThread);
+
+			if (begin < end)
+				tasks.push_back(std::async(std::launch::async, updateRange, begin, end));
+		}
+
+		updateRange(0, std::min(m_live.size(), perThread));
+
+		for (auto& task : tasks)
+			task.get();
+
+		//Re-specifying the whole buffer means we don't have to wait on last frame's draws.
+		if (jointCount > 0)
+		{
+			glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+			glBufferData(GL_TEXTURE_BUFFER, m_palette.size() * sizeof(glm::mat4), m_palette.data(), GL_STREAM_DRAW);
+		}
+	}
+
+	void Animator::Bind() const
+	{
+		glActiveTexture(JOINT_SLOT);
+		glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+	}
+}
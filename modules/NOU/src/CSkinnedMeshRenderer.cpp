@@ -0,0 +1,66 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+CSkinnedMeshRenderer.cpp
+Mesh renderer component for meshes that are deformed by a skeleton.
+The skinning itself happens on the GPU, in the vertex shader.
+*/
+
+#include "NOU/CSkinnedMeshRenderer.h"
+#include "NOU/CCamera.h"
+
+namespace nou
+{
+	CSkinnedMeshRenderer::CSkinnedMeshRenderer(Entity& owner,
+											   const Mesh& mesh,
+											   Material& mat,
+											   const Animator& animator,
+											   std::shared_ptr<AnimationState> state)
+	{
+		m_owner = &owner;
+		m_mat = &mat;
+		m_vao = std::make_unique<VertexArray>();
+		m_animator = &animator;
+		m_state = std::move(state);
+		SetMesh(mesh);
+	}
+
+	void CSkinnedMeshRenderer::SetMesh(const Mesh& mesh)
+	{
+		CMeshRenderer::SetMesh(mesh);
+
+		//On top of the usual data, we need to know which joints move each vertex, and by how much.
+		const VertexBuffer* vbo;
+
+		if ((vbo = mesh.GetVBO(Mesh::Attrib::JOINT_INFLUENCE)) != nullptr)
+			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::JOINT_INFLUENCE);
+
+		if ((vbo = mesh.GetVBO(Mesh::Attrib::SKIN_WEIGHT)) != nullptr)
+			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::SKIN_WEIGHT);
+	}
+
+	void CSkinnedMeshRenderer::SetState(std::shared_ptr<AnimationState> state)
+	{
+		m_state = std::move(state);
+	}
+
+	void CSkinnedMeshRenderer::Draw()
+	{
+		m_mat->Use();
+
+		auto& transform = m_owner->transform;
+
+		ShaderProgram::Current()->SetUniform("viewproj", CCamera::current->Get<CCamera>().GetVP());
+		ShaderProgram::Current()->SetUniform("model", transform.GetGlobal());
+		ShaderProgram::Current()->SetUniform("normal", transform.GetNormal());
+
+		//Every animation's joint matrices live in the same texture,
+		//so we just need to tell the shader where ours start.
+		m_animator->Bind();
+		ShaderProgram::Current()->SetUniform("jointMatrices", (int)(Animator::JOINT_SLOT - GL_TEXTURE0));
+		ShaderProgram::Current()->SetUniform("jointOffset", (int)m_state->GetPaletteOffset());
+
+		m_vao->Draw();
+	}
+}
@@ -10,8 +10,12 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 #include "NOU/GLTFLoader.h"
 
 #include <sstream>
+#include <algorithm>
+#include <cmath>
 
 #include "tiny_gltf.h"
+#include "GLM/gtc/type_ptr.hpp"
+#include "GLM/gtx/matrix_decompose.hpp"
 
 namespace nou::GLTF
 {
@@ -41,6 +45,29 @@ namespace nou::GLTF
 		printf("Loaded mesh from %s.\n", filename.c_str());
 	}
 
+	void LoadSkinnedMesh(const std::string& filename, Mesh& mesh, Skeleton& skeleton,
+						 std::vector<AnimationClip>& clips, bool flipUVY, float sampleRate)
+	{
+		auto gltf = std::make_unique<tinygltf::Model>();
+
+		std::string err, warn;
+		std::vector<int> jointNodes;
+
+		bool result = ParseGLTF(filename, *gltf, err, warn) &&
+					  ExtractGeometry(*gltf, mesh, flipUVY, err, warn) &&
+					  ExtractSkin(*gltf, mesh, err, warn) &&
+					  ExtractSkeleton(*gltf, skeleton, jointNodes, err, warn) &&
+					  ExtractAnimations(*gltf, skeleton, jointNodes, sampleRate, clips, err, warn);
+
+		DumpErrorsAndWarnings(filename, err, warn);
+
+		if (!result)
+			return;
+
+		printf("Loaded skinned mesh from %s (%d joints, %d animations).\n",
+			filename.c_str(), (int)skeleton.JointCount(), (int)clips.size());
+	}
+
 	void DumpErrorsAndWarnings(const std::string& filename,
 							   const std::string& err,
 							   const std::string& warn)
@@ -278,6 +305,346 @@ namespace nou::GLTF
 		return true;
 	}
 
+	bool ExtractSkin(const tinygltf::Model& gltf, Mesh& mesh,
+					 std::string& err, std::string& warn)
+	{
+		const tinygltf::Mesh& meshData = gltf.meshes[0];
+
+		std::vector<glm::vec4> joints;
+		std::vector<glm::vec4> weights;
+
+		for (size_t p = 0; p < meshData.primitives.size(); ++p)
+		{
+			const tinygltf::Primitive& geom = meshData.primitives[p];
+
+			int jID = FindAccessor(geom, "JOINTS_0");
+			int wID = FindAccessor(geom, "WEIGHTS_0");
+
+			if (jID == -1 || wID == -1)
+			{
+				err = "No joint influences found in mesh primitive " + std::to_string(p);
+				return false;
+			}
+
+			int jointType = gltf.accessors[jID].componentType;
+
+			if ((jointType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE &&
+				 jointType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) ||
+				gltf.accessors[wID].componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+			{
+				err = "Skin data is in a currently unsupported format. " \
+					"Consider changing your GLTF export settings, or else this loader " \
+					"must be augmented to support the provided format.";
+
+				return false;
+			}
+
+			//Just like in ProcessPrimitive, we spell the data out triangle by triangle.
+			DataGetter faceIndexer = BuildGetter(gltf, geom.indices);
+			DataGetter jGetter = BuildGetter(gltf, jID);
+			DataGetter wGetter = BuildGetter(gltf, wID);
+
+			//Only warn once per primitive about weights that needed fixing.
+			bool normalized = false;
+
+			for (size_t f = 0; f < faceIndexer.len; ++f)
+			{
+				GLushort vertIndex;
+				memcpy(&vertIndex, &faceIndexer.data[f * faceIndexer.stride], sizeof(GLushort));
+
+				size_t vert = vertIndex;
+
+				glm::vec4 joint;
+
+				if (jointType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+				{
+					const unsigned char* src = &jGetter.data[vert * jGetter.stride];
+					joint = glm::vec4(src[0], src[1], src[2], src[3]);
+				}
+				else
+				{
+					GLushort src[4];
+					memcpy(src, &jGetter.data[vert * jGetter.stride], sizeof(src));
+					joint = glm::vec4(src[0], src[1], src[2], src[3]);
+				}
+
+				glm::vec4 weight;
+				memcpy(&weight, &wGetter.data[vert * wGetter.stride], sizeof(glm::vec4));
+
+				//Some exporters don't quite get the weights to add up to 1, which makes the mesh shrink or grow.
+				float total = weight.x + weight.y + weight.z + weight.w;
+
+				if (total > 0.0f)
+				{
+					if (!normalized && std::abs(total - 1.0f) > 0.01f)
+					{
+						warn += "\nSkin weights in mesh primitive " + std::to_string(p) + " don't add up to 1, and were normalized.";
+						normalized = true;
+					}
+
+					weight /= total;
+				}
+
+				joints.push_back(joint);
+				weights.push_back(weight);
+			}
+		}
+
+		mesh.SetJointInfluences(joints);
+		mesh.SetSkinWeights(weights);
+
+		return true;
+	}
+
+	bool ExtractSkeleton(const tinygltf::Model& gltf, Skeleton& skeleton, std::vector<int>& jointNodes,
+						 std::string& err, std::string& warn)
+	{
+		if (gltf.skins.size() == 0)
+		{
+			err = "No skin in file.";
+			return false;
+		}
+
+		const tinygltf::Skin& skin = gltf.skins[0];
+		jointNodes = skin.joints;
+
+		//glTF nodes only know about their children, so work out every node's parent,
+		//and which joint (if any) each node is.
+		std::vector<int> nodeParent(gltf.nodes.size(), -1);
+		std::vector<int> nodeJoint(gltf.nodes.size(), -1);
+
+		for (size_t n = 0; n < gltf.nodes.size(); ++n)
+		{
+			for (int child : gltf.nodes[n].children)
+				nodeParent[child] = (int)n;
+		}
+
+		for (size_t j = 0; j < jointNodes.size(); ++j)
+			nodeJoint[jointNodes[j]] = (int)j;
+
+		bool hasInverseBind = skin.inverseBindMatrices != -1;
+		DataGetter ibmGetter;
+
+		if (hasInverseBind)
+		{
+			ibmGetter = BuildGetter(gltf, skin.inverseBindMatrices);
+
+			if (ibmGetter.elementSize != sizeof(glm::mat4))
+			{
+				hasInverseBind = false;
+				warn += "\nInverse bind matrices are in a currently unsupported format.";
+			}
+		}
+
+		std::vector<Skeleton::Joint> joints(jointNodes.size());
+
+		for (size_t j = 0; j < jointNodes.size(); ++j)
+		{
+			const tinygltf::Node& node = gltf.nodes[jointNodes[j]];
+			Skeleton::Joint& joint = joints[j];
+
+			joint.name = node.name;
+
+			//Skip past any nodes between us and our parent joint that aren't part of the skeleton.
+			int parent = nodeParent[jointNodes[j]];
+
+			while (parent != -1 && nodeJoint[parent] == -1)
+				parent = nodeParent[parent];
+
+			joint.parent = (parent != -1) ? nodeJoint[parent] : -1;
+
+			GetNodeTransform(node, joint.pos, joint.rot, joint.scale);
+
+			joint.inverseBind = glm::mat4(1.0f);
+
+			if (hasInverseBind)
+				memcpy(&joint.inverseBind, &ibmGetter.data[j * ibmGetter.stride], sizeof(glm::mat4));
+		}
+
+		skeleton.SetJoints(joints);
+
+		return true;
+	}
+
+	bool ExtractAnimations(const tinygltf::Model& gltf, const Skeleton& skeleton,
+						   const std::vector<int>& jointNodes, float sampleRate,
+						   std::vector<AnimationClip>& clips,
+						   std::string& err, std::string& warn)
+	{
+		std::vector<int> nodeJoint(gltf.nodes.size(), -1);
+
+		for (size_t j = 0; j < jointNodes.size(); ++j)
+			nodeJoint[jointNodes[j]] = (int)j;
+
+		//Joints that an animation doesn't touch stay in their bind pose.
+		Pose bindPose;
+		skeleton.GetBindPose(bindPose);
+
+		for (const tinygltf::Animation& anim : gltf.animations)
+		{
+			//The animation lasts until the last key of its longest channel.
+			float duration = 0.0f;
+
+			for (const tinygltf::AnimationSampler& sampler : anim.samplers)
+			{
+				DataGetter times = BuildGetter(gltf, sampler.input);
+
+				if (times.len == 0)
+					continue;
+
+				float last;
+				memcpy(&last, &times.data[(times.len - 1) * times.stride], sizeof(float));
+				duration = std::max(duration, last);
+			}
+
+			size_t frameCount = (size_t)std::ceil(duration * sampleRate) + 1;
+			std::vector<Pose> frames(frameCount, bindPose);
+
+			//Only warn once per animation about the cubic spline fallback.
+			bool warnedCubic = false;
+
+			for (const tinygltf::AnimationChannel& channel : anim.channels)
+			{
+				if (channel.sampler < 0 || channel.sampler >= (int)anim.samplers.size() ||
+					channel.target_node >= (int)nodeJoint.size())
+				{
+					err = "Animation " + anim.name + " has a channel that points at a missing sampler or node.";
+					return false;
+				}
+
+				if (channel.target_node < 0 || nodeJoint[channel.target_node] == -1)
+					continue;
+
+				size_t joint = nodeJoint[channel.target_node];
+				int firstChannel, components;
+
+				if (channel.target_path == "translation")
+				{
+					firstChannel = Pose::TX;
+					components = 3;
+				}
+				else if (channel.target_path == "rotation")
+				{
+					firstChannel = Pose::RX;
+					components = 4;
+				}
+				else if (channel.target_path == "scale")
+				{
+					firstChannel = Pose::SX;
+					components = 3;
+				}
+				//Morph target weights aren't supported.
+				else
+					continue;
+
+				const tinygltf::AnimationSampler& sampler = anim.samplers[channel.sampler];
+				DataGetter times = BuildGetter(gltf, sampler.input);
+				DataGetter values = BuildGetter(gltf, sampler.output);
+
+				if (times.len == 0 || values.elementSize != components * (int)sizeof(float))
+				{
+					warn += "\nAnimation data in " + anim.name + " is in a currently unsupported format.";
+					continue;
+				}
+
+				//Cubic spline samplers store an in-tangent, a value and an out-tangent for every key.
+				//We only use the values, which turns the curve into straight lines between its keys.
+				bool cubic = sampler.interpolation == "CUBICSPLINE";
+				bool step = sampler.interpolation == "STEP";
+
+				if (cubic && !warnedCubic)
+				{
+					warn += "\nAnimation " + anim.name + " uses cubic spline interpolation, only its key values are used.";
+					warnedCubic = true;
+				}
+
+				auto getTime = [&](size_t key)
+				{
+					float t;
+					memcpy(&t, &times.data[key * times.stride], sizeof(float));
+					return t;
+				};
+
+				auto getValue = [&](size_t key)
+				{
+					glm::vec4 v(0.0f);
+					size_t index = (cubic) ? key * 3 + 1 : key;
+					memcpy(&v, &values.data[index * values.stride], values.elementSize);
+					return v;
+				};
+
+				size_t key = 0;
+
+				for (size_t f = 0; f < frameCount; ++f)
+				{
+					float t = f / sampleRate;
+
+					//Our frames go forwards in time, so we can walk along the keys rather than searching for them.
+					while (key + 1 < times.len && getTime(key + 1) <= t)
+						++key;
+
+					glm::vec4 value = getValue(key);
+
+					if (!step && key + 1 < times.len)
+					{
+						float t0 = getTime(key);
+						float t1 = getTime(key + 1);
+						float alpha = (t1 > t0) ? glm::clamp((t - t0) / (t1 - t0), 0.0f, 1.0f) : 0.0f;
+						glm::vec4 next = getValue(key + 1);
+
+						if (components == 4)
+						{
+							//glTF stores quaternions as XYZW, but GLM's constructor takes W first.
+							glm::quat q = glm::slerp(glm::quat(value.w, value.x, value.y, value.z),
+													 glm::quat(next.w, next.x, next.y, next.z), alpha);
+							value = glm::vec4(q.x, q.y, q.z, q.w);
+						}
+						else
+							value = glm::mix(value, next, alpha);
+					}
+
+					for (int c = 0; c < components; ++c)
+						frames[f].GetChannel(firstChannel + c)[joint] = value[c];
+				}
+			}
+
+			clips.emplace_back();
+			clips.back().Build(anim.name, frames, sampleRate);
+		}
+
+		return true;
+	}
+
+	void GetNodeTransform(const tinygltf::Node& node, glm::vec3& pos, glm::quat& rot, glm::vec3& scale)
+	{
+		pos = glm::vec3(0.0f);
+		rot = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		scale = glm::vec3(1.0f);
+
+		if (node.matrix.size() == 16)
+		{
+			glm::mat4 m;
+
+			for (int i = 0; i < 16; ++i)
+				glm::value_ptr(m)[i] = (float)node.matrix[i];
+
+			glm::vec3 skew;
+			glm::vec4 perspective;
+			glm::decompose(m, scale, rot, pos, skew, perspective);
+			return;
+		}
+
+		if (node.translation.size() == 3)
+			pos = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
+
+		if (node.rotation.size() == 4)
+			rot = glm::quat((float)node.rotation[3], (float)node.rotation[0],
+							(float)node.rotation[1], (float)node.rotation[2]);
+
+		if (node.scale.size() == 3)
+			scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+	}
+
 	int FindAccessor(const tinygltf::Primitive& geom, const std::string& name)
 	{
 		auto it = geom.attributes.find(name);
@@ -28,6 +28,18 @@ namespace nou
 		SetVBO(Attrib::UV, 2, m_uvs);
 	}
 
+	void Mesh::SetJointInfluences(const std::vector<glm::vec4>& joints)
+	{
+		m_joints = joints;
+		SetVBO(Attrib::JOINT_INFLUENCE, 4, m_joints);
+	}
+
+	void Mesh::SetSkinWeights(const std::vector<glm::vec4>& weights)
+	{
+		m_weights = weights;
+		SetVBO(Attrib::SKIN_WEIGHT, 4, m_weights);
+	}
+
 	const VertexBuffer* Mesh::GetVBO(Mesh::Attrib attrib) const
 	{
 		auto it = m_vbo.find(attrib);
@@ -0,0 +1,221 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+Skeleton.cpp
+Classes for managing the joint hierarchy of a skinned mesh, and poses of that hierarchy.
+*/
+
+#include "NOU/Skeleton.h"
+
+#include <algorithm>
+#include <xmmintrin.h>
+
+namespace nou
+{
+	Pose::Pose(size_t jointCount)
+	{
+		Resize(jointCount);
+	}
+
+	void Pose::Resize(size_t jointCount)
+	{
+		if (jointCount == m_jointCount && !m_data.empty())
+			return;
+
+		m_jointCount = jointCount;
+		m_paddedCount = (jointCount + 3) & ~size_t(3);
+		m_data.assign(m_paddedCount * CHANNEL_COUNT, 0.0f);
+
+		//Start every joint (including the padding) at the identity transform.
+		std::fill_n(GetChannel(RW), m_paddedCount, 1.0f);
+		std::fill_n(GetChannel(SX), m_paddedCount * 3, 1.0f);
+	}
+
+	void Pose::SetJoint(size_t joint, const glm::vec3& pos, const glm::quat& rot, const glm::vec3& scale)
+	{
+		GetChannel(TX)[joint] = pos.x;
+		GetChannel(TY)[joint] = pos.y;
+		GetChannel(TZ)[joint] = pos.z;
+		GetChannel(RX)[joint] = rot.x;
+		GetChannel(RY)[joint] = rot.y;
+		GetChannel(RZ)[joint] = rot.z;
+		GetChannel(RW)[joint] = rot.w;
+		GetChannel(SX)[joint] = scale.x;
+		GetChannel(SY)[joint] = scale.y;
+		GetChannel(SZ)[joint] = scale.z;
+	}
+
+	glm::vec3 Pose::GetTranslation(size_t joint) const
+	{
+		return glm::vec3(GetChannel(TX)[joint], GetChannel(TY)[joint], GetChannel(TZ)[joint]);
+	}
+
+	glm::quat Pose::GetRotation(size_t joint) const
+	{
+		//Note that GLM's quaternion constructor takes W first.
+		return glm::quat(GetChannel(RW)[joint], GetChannel(RX)[joint],
+						 GetChannel(RY)[joint], GetChannel(RZ)[joint]);
+	}
+
+	glm::vec3 Pose::GetScale(size_t joint) const
+	{
+		return glm::vec3(GetChannel(SX)[joint], GetChannel(SY)[joint], GetChannel(SZ)[joint]);
+	}
+
+	void Pose::NormalizeRotations()
+	{
+		float* px = GetChannel(RX);
+		float* py = GetChannel(RY);
+		float* pz = GetChannel(RZ);
+		float* pw = GetChannel(RW);
+
+		for (size_t i = 0; i < m_paddedCount; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(px + i);
+			__m128 y = _mm_loadu_ps(py + i);
+			__m128 z = _mm_loadu_ps(pz + i);
+			__m128 w = _mm_loadu_ps(pw + i);
+
+			__m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+									  _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+
+			//The max keeps us from dividing by zero if a rotation somehow ends up all zeroes.
+			__m128 invLen = _mm_div_ps(_mm_set1_ps(1.0f),
+									   _mm_sqrt_ps(_mm_max_ps(lenSq, _mm_set1_ps(1e-12f))));
+
+			_mm_storeu_ps(px + i, _mm_mul_ps(x, invLen));
+			_mm_storeu_ps(py + i, _mm_mul_ps(y, invLen));
+			_mm_storeu_ps(pz + i, _mm_mul_ps(z, invLen));
+			_mm_storeu_ps(pw + i, _mm_mul_ps(w, invLen));
+		}
+	}
+
+	void Pose::Blend(const Pose& a, const Pose& b, float weight, Pose& out)
+	{
+		out.Resize(a.m_jointCount);
+
+		const size_t count = a.m_paddedCount;
+		const __m128 w = _mm_set1_ps(weight);
+
+		//Translation and scale can just be blended linearly.
+		for (int channel : { TX, TY, TZ, SX, SY, SZ })
+		{
+			const float* pa = a.GetChannel(channel);
+			const float* pb = b.GetChannel(channel);
+			float* po = out.GetChannel(channel);
+
+			for (size_t i = 0; i < count; i += 4)
+			{
+				__m128 va = _mm_loadu_ps(pa + i);
+				__m128 vb = _mm_loadu_ps(pb + i);
+				_mm_storeu_ps(po + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), w)));
+			}
+		}
+
+		//Rotations are blended with a normalized lerp (nlerp).
+		//q and -q are the same rotation, so if b is on the far side of the hypersphere from a,
+		//we flip it over first - otherwise we would take the long way around.
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+
+		for (size_t i = 0; i < count; i += 4)
+		{
+			__m128 ax = _mm_loadu_ps(a.GetChannel(RX) + i), bx = _mm_loadu_ps(b.GetChannel(RX) + i);
+			__m128 ay = _mm_loadu_ps(a.GetChannel(RY) + i), by = _mm_loadu_ps(b.GetChannel(RY) + i);
+			__m128 az = _mm_loadu_ps(a.GetChannel(RZ) + i), bz = _mm_loadu_ps(b.GetChannel(RZ) + i);
+			__m128 aw = _mm_loadu_ps(a.GetChannel(RW) + i), bw = _mm_loadu_ps(b.GetChannel(RW) + i);
+
+			__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+									_mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+			__m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, zero), signBit);
+
+			bx = _mm_xor_ps(bx, flip);
+			by = _mm_xor_ps(by, flip);
+			bz = _mm_xor_ps(bz, flip);
+			bw = _mm_xor_ps(bw, flip);
+
+			__m128 rx = _mm_add_ps(ax, _mm_mul_ps(_mm_sub_ps(bx, ax), w));
+			__m128 ry = _mm_add_ps(ay, _mm_mul_ps(_mm_sub_ps(by, ay), w));
+			__m128 rz = _mm_add_ps(az, _mm_mul_ps(_mm_sub_ps(bz, az), w));
+			__m128 rw = _mm_add_ps(aw, _mm_mul_ps(_mm_sub_ps(bw, aw), w));
+
+			_mm_storeu_ps(out.GetChannel(RX) + i, rx);
+			_mm_storeu_ps(out.GetChannel(RY) + i, ry);
+			_mm_storeu_ps(out.GetChannel(RZ) + i, rz);
+			_mm_storeu_ps(out.GetChannel(RW) + i, rw);
+		}
+
+		out.NormalizeRotations();
+	}
+
+	void Skeleton::SetJoints(const std::vector<Joint>& joints)
+	{
+		m_joints = joints;
+
+		//Sorting the joints by how deep they are in the hierarchy guarantees
+		//that every parent gets evaluated before its children.
+		std::vector<int> depth(m_joints.size(), 0);
+
+		for (size_t i = 0; i < m_joints.size(); ++i)
+		{
+			int parent = m_joints[i].parent;
+
+			//The depth check stops us from looping forever on a broken hierarchy.
+			while (parent >= 0 && depth[i] < (int)m_joints.size())
+			{
+				++depth[i];
+				parent = m_joints[parent].parent;
+			}
+		}
+
+		m_order.resize(m_joints.size());
+
+		for (size_t i = 0; i < m_order.size(); ++i)
+			m_order[i] = (int)i;
+
+		std::stable_sort(m_order.begin(), m_order.end(),
+						 [&](int a, int b) { return depth[a] < depth[b]; });
+	}
+
+	int Skeleton::FindJoint(const std::string& name) const
+	{
+		for (size_t i = 0; i < m_joints.size(); ++i)
+		{
+			if (m_joints[i].name == name)
+				return (int)i;
+		}
+
+		return -1;
+	}
+
+	void Skeleton::GetBindPose(Pose& pose) const
+	{
+		pose.Resize(m_joints.size());
+
+		for (size_t i = 0; i < m_joints.size(); ++i)
+			pose.SetJoint(i, m_joints[i].pos, m_joints[i].rot, m_joints[i].scale);
+	}
+
+	void Skeleton::ComputeSkinningMatrices(const Pose& pose, glm::mat4* out) const
+	{
+		//First, find where every joint is in model space by walking down the hierarchy.
+		for (int j : m_order)
+		{
+			glm::vec3 scale = pose.GetScale(j);
+			glm::mat4 local = glm::toMat4(pose.GetRotation(j));
+			local[0] *= scale.x;
+			local[1] *= scale.y;
+			local[2] *= scale.z;
+			local[3] = glm::vec4(pose.GetTranslation(j), 1.0f);
+
+			int parent = m_joints[j].parent;
+			out[j] = (parent >= 0) ? out[parent] * local : local;
+		}
+
+		//Then take vertices out of the bind pose before moving them with their joint.
+		//This has to be a second pass, since children need their parent's model space transform.
+		for (size_t j = 0; j < m_joints.size(); ++j)
+			out[j] = out[j] * m_joints[j].inverseBind;
+	}
+}
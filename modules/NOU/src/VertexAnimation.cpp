@@ -0,0 +1,389 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+VertexAnimation.cpp
+Classes for baking skeletal animations into vertex animation textures (VATs),
+and for drawing large crowds of instances that play them back.
+*/
+
+#include "NOU/VertexAnimation.h"
+#include "NOU/CCamera.h"
+
+#include "GLM/gtc/packing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace nou
+{
+	namespace
+	{
+		const char VAT_MAGIC[4] = { 'V', 'A', 'T', ' ' };
+		const uint32_t VAT_VERSION = 1;
+
+		GLuint CreateVatTexture(GLenum internalFormat, GLsizei width, GLsizei height,
+								GLenum type, const void* data)
+		{
+			GLuint id;
+			glGenTextures(1, &id);
+			glBindTexture(GL_TEXTURE_2D, id);
+
+			//We read these with texelFetch, one exact texel per vertex, so there's no need for filtering or mips.
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, GL_RGBA, type, data);
+
+			return id;
+		}
+
+		//Brings a frame number back into the range of a clip.
+		float WrapFrame(float frame, float frameCount)
+		{
+			float f = std::fmod(frame, frameCount);
+			return (f < 0.0f) ? f + frameCount : f;
+		}
+	}
+
+	VertexAnimation::VertexAnimation()
+	{
+		m_vertexCount = 0;
+		m_width = 0;
+		m_rowsPerFrame = 0;
+		m_positions = 0;
+		m_normals = 0;
+	}
+
+	VertexAnimation::~VertexAnimation()
+	{
+		glDeleteTextures(1, &m_positions);
+		glDeleteTextures(1, &m_normals);
+	}
+
+	bool VertexAnimation::Bake(const Mesh& mesh, const Skeleton& skeleton,
+							   const std::vector<AnimationClip>& clips, float frameRate,
+							   const std::string& filename)
+	{
+		const auto& verts = mesh.GetVerts();
+		const auto& normals = mesh.GetNormals();
+		const auto& joints = mesh.GetJointInfluences();
+		const auto& weights = mesh.GetSkinWeights();
+
+		if (verts.empty() || joints.size() != verts.size() || weights.size() != verts.size())
+		{
+			printf("Can't bake %s - the mesh isn't skinned.\n", filename.c_str());
+			return false;
+		}
+
+		bool hasNormals = normals.size() == verts.size();
+
+		uint32_t vertexCount = (uint32_t)verts.size();
+		uint32_t width = std::min(vertexCount, MAX_WIDTH);
+		uint32_t rowsPerFrame = (vertexCount + width - 1) / width;
+
+		//Lay the clips out one after another. Clips are assumed to loop,
+		//so their last frame (which would match the first) is left out.
+		std::vector<Clip> baked;
+		uint32_t frameCount = 0;
+
+		for (const AnimationClip& clip : clips)
+		{
+			uint32_t frames = std::max(1u, (uint32_t)std::round(clip.GetDuration() * frameRate));
+			baked.push_back({ clip.GetName(), frameCount, frames, frameRate });
+			frameCount += frames;
+		}
+
+		uint32_t height = rowsPerFrame * frameCount;
+
+		if (height > 16384)
+			printf("Warning: %s will be %u texels tall, which some GPUs can't load. " \
+				"Consider baking at a lower frame rate.\n", filename.c_str(), height);
+
+		std::vector<uint16_t> positionData((size_t)width * height * 4, 0);
+		std::vector<int8_t> normalData((size_t)width * height * 4, 0);
+
+		Pose pose;
+		std::vector<glm::mat4> skin(skeleton.JointCount());
+		int lastJoint = (int)skeleton.JointCount() - 1;
+
+		for (size_t c = 0; c < clips.size(); ++c)
+		{
+			for (uint32_t f = 0; f < baked[c].frameCount; ++f)
+			{
+				clips[c].Sample(f / frameRate, true, pose);
+				skeleton.ComputeSkinningMatrices(pose, skin.data());
+
+				//Vertices go across each row, then wrap onto the next row of the frame.
+				size_t frameStart = (size_t)(baked[c].firstFrame + f) * rowsPerFrame * width;
+
+				for (size_t v = 0; v < vertexCount; ++v)
+				{
+					//This is the same blend as our skinning shader does.
+					glm::mat4 m(0.0f);
+
+					for (int i = 0; i < 4; ++i)
+						m += skin[glm::clamp((int)joints[v][i], 0, lastJoint)] * weights[v][i];
+
+					glm::vec3 pos = glm::vec3(m * glm::vec4(verts[v], 1.0f));
+					glm::vec3 norm = (hasNormals) ? glm::normalize(glm::mat3(m) * normals[v]) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+					size_t texel = (frameStart + v) * 4;
+
+					for (int i = 0; i < 3; ++i)
+					{
+						positionData[texel + i] = glm::packHalf1x16(pos[i]);
+						normalData[texel + i] = (int8_t)std::round(glm::clamp(norm[i], -1.0f, 1.0f) * 127.0f);
+					}
+
+					positionData[texel + 3] = glm::packHalf1x16(1.0f);
+				}
+			}
+		}
+
+		std::ofstream file(filename, std::ios::binary);
+
+		if (!file)
+		{
+			printf("Failed to open %s for writing.\n", filename.c_str());
+			return false;
+		}
+
+		FileHeader header;
+		memcpy(header.magic, VAT_MAGIC, sizeof(VAT_MAGIC));
+		header.version = VAT_VERSION;
+		header.vertexCount = vertexCount;
+		header.width = width;
+		header.rowsPerFrame = rowsPerFrame;
+		header.frameCount = frameCount;
+		header.clipCount = (uint32_t)baked.size();
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		for (const Clip& clip : baked)
+		{
+			uint32_t nameLen = (uint32_t)clip.name.size();
+			file.write(reinterpret_cast<const char*>(&nameLen), sizeof(nameLen));
+			file.write(clip.name.data(), nameLen);
+			file.write(reinterpret_cast<const char*>(&clip.firstFrame), sizeof(clip.firstFrame));
+			file.write(reinterpret_cast<const char*>(&clip.frameCount), sizeof(clip.frameCount));
+			file.write(reinterpret_cast<const char*>(&clip.frameRate), sizeof(clip.frameRate));
+		}
+
+		file.write(reinterpret_cast<const char*>(positionData.data()), positionData.size() * sizeof(uint16_t));
+		file.write(reinterpret_cast<const char*>(normalData.data()), normalData.size() * sizeof(int8_t));
+
+		printf("Baked %d clips (%u frames of %u vertices) to %s.\n",
+			(int)baked.size(), frameCount, vertexCount, filename.c_str());
+
+		return (bool)file;
+	}
+
+	bool VertexAnimation::LoadFromFile(const std::string& filename)
+	{
+		std::ifstream file(filename, std::ios::binary);
+
+		if (!file)
+		{
+			printf("Failed to open %s.\n", filename.c_str());
+			return false;
+		}
+
+		FileHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		if (!file || memcmp(header.magic, VAT_MAGIC, sizeof(VAT_MAGIC)) != 0 || header.version != VAT_VERSION)
+		{
+			printf("%s is not a vertex animation file, or was baked with a different version.\n", filename.c_str());
+			return false;
+		}
+
+		std::vector<Clip> clips(header.clipCount);
+
+		for (Clip& clip : clips)
+		{
+			uint32_t nameLen = 0;
+			file.read(reinterpret_cast<char*>(&nameLen), sizeof(nameLen));
+			clip.name.resize(nameLen);
+			file.read(&clip.name[0], nameLen);
+			file.read(reinterpret_cast<char*>(&clip.firstFrame), sizeof(clip.firstFrame));
+			file.read(reinterpret_cast<char*>(&clip.frameCount), sizeof(clip.frameCount));
+			file.read(reinterpret_cast<char*>(&clip.frameRate), sizeof(clip.frameRate));
+		}
+
+		GLsizei height = header.rowsPerFrame * header.frameCount;
+		std::vector<uint16_t> positionData((size_t)header.width * height * 4);
+		std::vector<int8_t> normalData((size_t)header.width * height * 4);
+		file.read(reinterpret_cast<char*>(positionData.data()), positionData.size() * sizeof(uint16_t));
+		file.read(reinterpret_cast<char*>(normalData.data()), normalData.size() * sizeof(int8_t));
+
+		if (!file)
+		{
+			printf("%s is missing data.\n", filename.c_str());
+			return false;
+		}
+
+		glDeleteTextures(1, &m_positions);
+		glDeleteTextures(1, &m_normals);
+		m_positions = CreateVatTexture(GL_RGBA16F, header.width, height, GL_HALF_FLOAT, positionData.data());
+		m_normals = CreateVatTexture(GL_RGBA8_SNORM, header.width, height, GL_BYTE, normalData.data());
+
+		m_vertexCount = header.vertexCount;
+		m_width = header.width;
+		m_rowsPerFrame = header.rowsPerFrame;
+		m_clips = std::move(clips);
+
+		return true;
+	}
+
+	int VertexAnimation::FindClip(const std::string& name) const
+	{
+		for (size_t i = 0; i < m_clips.size(); ++i)
+		{
+			if (m_clips[i].name == name)
+				return (int)i;
+		}
+
+		return -1;
+	}
+
+	void VertexAnimation::Bind() const
+	{
+		glActiveTexture(POSITION_SLOT);
+		glBindTexture(GL_TEXTURE_2D, m_positions);
+		glActiveTexture(NORMAL_SLOT);
+		glBindTexture(GL_TEXTURE_2D, m_normals);
+
+		ShaderProgram::Current()->SetUniform("vatPositions", (int)(POSITION_SLOT - GL_TEXTURE0));
+		ShaderProgram::Current()->SetUniform("vatNormals", (int)(NORMAL_SLOT - GL_TEXTURE0));
+		ShaderProgram::Current()->SetUniform("vatWidth", (int)m_width);
+		ShaderProgram::Current()->SetUniform("vatRowsPerFrame", (int)m_rowsPerFrame);
+	}
+
+	VatCrowd::VatCrowd(const VertexAnimation& anim, const Mesh& mesh, Material& mat)
+	{
+		m_anim = &anim;
+		m_mat = &mat;
+		m_time = 0.0f;
+		m_dirty = true;
+		m_vao = std::make_unique<VertexArray>();
+
+		//The positions and normals come from the VAT, so all we really need from the mesh
+		//is its UVs. The positions are still bound, since they tell the VAO how many vertices there are.
+		const VertexBuffer* vbo;
+
+		if ((vbo = mesh.GetVBO(Mesh::Attrib::POSITION)) != nullptr)
+			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::POSITION);
+
+		if ((vbo = mesh.GetVBO(Mesh::Attrib::UV)) != nullptr)
+			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::UV);
+	}
+
+	size_t VatCrowd::AddInstance(const glm::vec3& pos, float yaw, int clip, float timeOffset, float rate)
+	{
+		m_placement.push_back(glm::vec4(pos, yaw));
+		m_animState.push_back(glm::vec4(0.0f));
+		m_clips.push_back(clip);
+
+		size_t index = m_placement.size() - 1;
+		Play(index, clip, rate);
+
+		//Shift the instance along its clip, so it isn't in lockstep with everything else playing it.
+		glm::vec4& state = m_animState[index];
+		state.w = WrapFrame(state.w + timeOffset * state.z, state.y);
+
+		return index;
+	}
+
+	void VatCrowd::RemoveInstance(size_t index)
+	{
+		m_placement[index] = m_placement.back();
+		m_animState[index] = m_animState.back();
+		m_clips[index] = m_clips.back();
+
+		m_placement.pop_back();
+		m_animState.pop_back();
+		m_clips.pop_back();
+
+		m_dirty = true;
+	}
+
+	void VatCrowd::SetTransform(size_t index, const glm::vec3& pos, float yaw)
+	{
+		m_placement[index] = glm::vec4(pos, yaw);
+		m_dirty = true;
+	}
+
+	void VatCrowd::Play(size_t index, int clip, float rate)
+	{
+		const VertexAnimation::Clip& info = m_anim->GetClip(clip);
+
+		//The shader works out the frame as (time * frames per second + offset),
+		//so to start on the first frame right now, we subtract where the clock is at.
+		float fps = info.frameRate * rate;
+		float count = (float)info.frameCount;
+
+		m_clips[index] = clip;
+		m_animState[index] = glm::vec4((float)info.firstFrame, count, fps, WrapFrame(-m_time * fps, count));
+		m_dirty = true;
+	}
+
+	void VatCrowd::SetRate(size_t index, float rate)
+	{
+		glm::vec4& state = m_animState[index];
+
+		//Pick a new offset so the instance carries on from the frame it is on now.
+		float frame = CurrentFrame(index);
+		state.z = m_anim->GetClip(m_clips[index]).frameRate * rate;
+		state.w = WrapFrame(frame - m_time * state.z, state.y);
+		m_dirty = true;
+	}
+
+	float VatCrowd::CurrentFrame(size_t index) const
+	{
+		const glm::vec4& state = m_animState[index];
+		return WrapFrame(m_time * state.z + state.w, state.y);
+	}
+
+	void VatCrowd::Update(float deltaTime)
+	{
+		m_time += deltaTime;
+	}
+
+	void VatCrowd::Draw()
+	{
+		if (m_placement.empty())
+			return;
+
+		//Only upload instance data when something has actually changed.
+		if (m_dirty)
+		{
+			if (m_placementVBO == nullptr)
+			{
+				m_placementVBO = std::make_unique<VertexBuffer>(4, m_placement, true);
+				m_animVBO = std::make_unique<VertexBuffer>(4, m_animState, true);
+				m_vao->BindInstanceAttrib(*m_placementVBO, PLACEMENT_LOC);
+				m_vao->BindInstanceAttrib(*m_animVBO, ANIM_LOC);
+			}
+			else
+			{
+				m_placementVBO->UpdateData(m_placement);
+				m_animVBO->UpdateData(m_animState);
+			}
+
+			m_dirty = false;
+		}
+
+		m_mat->Use();
+
+		ShaderProgram::Current()->SetUniform("viewproj", CCamera::current->Get<CCamera>().GetVP());
+		ShaderProgram::Current()->SetUniform("time", m_time);
+		m_anim->Bind();
+
+		m_vao->DrawInstanced((GLsizei)m_placement.size());
+	}
+}
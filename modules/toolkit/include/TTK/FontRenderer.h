@@ -13,6 +13,9 @@
 //////////////////////////////////////////////////////////////////////////
 #pragma once
 
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "GLM/glm.hpp"
 #include "glad/glad.h"
 #include "stb_truetype.h"
@@ -43,12 +46,37 @@ namespace  TTK
 		char R, G, B, A;
 	};
 
+	/*
+	 * A string that has already been broken up into glyph quads, relative to where it starts. The quads are in the
+	 * units of the font's SDF atlas, so one layout can be drawn at any size
+	 */
+	struct TextLayout {
+		struct Quad {
+			glm::vec2 Min, Max;
+			glm::vec2 UvMin, UvMax;
+		};
+		std::vector<Quad> Quads;
+		glm::vec2         Size;
+	};
+
 	class FontRenderer;
 	
+	/*
+	 * A TrueType font, rendered once into a signed distance field atlas. Since the atlas stores the distance to the
+	 * edge of each glyph instead of its coverage, the same texture stays sharp from small labels up to large titles
+	 */
 	class TrueTypeTextureFont {
 	public:
+		/*
+		 * Loads a font and generates its SDF atlas
+		 * @param fileName The path to the .ttf file
+		 * @param size The default height of the text in pixels, at a scale of 1
+		 */
 		TrueTypeTextureFont(const char* fileName, uint32_t size);
 		~TrueTypeTextureFont();
+
+		TrueTypeTextureFont(const TrueTypeTextureFont& other) = delete;
+		TrueTypeTextureFont& operator=(const TrueTypeTextureFont& other) = delete;
 		
 		GlyphInfo GetGlyph(int codePoint, float offsetX, float offsetY) const;
 		float  GetKerning(int char1, int char2) const;
@@ -58,19 +86,38 @@ namespace  TTK
 
 		virtual GLint GetTexture() const { return myTexture; }
 
+		/*
+		 * Breaks a string up into glyph quads, see FontRenderer::Render for a cached version of this
+		 * @param text The text to lay out
+		 * @param result Receives the quads and the size of the text
+		 */
+		void LayoutText(const char* text, TextLayout& result) const;
+
 	protected:
 		friend class FontRenderer;
 		GLuint   myTexture;
 		GLuint64 m_TexHandle;
 
-		const uint32_t ATLAS_WIDTH = 1024;
-		const uint32_t ATLAS_HEIGHT = 1024;
-		const uint32_t FONT_OVERSAMPLE_X = 2;
-		const uint32_t FONT_OVERSAMPLE_Y = 2;
-		const uint32_t FIRST_CHAR = ' ';
-		const uint32_t CHAR_COUNT = '~' - ' ';
+		struct SdfGlyph {
+			glm::vec2 Min, Max;
+			glm::vec2 UvMin, UvMax;
+			float     Advance;
+		};
+
+		static const uint32_t ATLAS_WIDTH = 512;
+		static const uint32_t ATLAS_HEIGHT = 512;
+		// The pixel height that glyphs are rendered at in the atlas, and how far out from the edges the distance is kept
+		static const uint32_t SDF_PIXEL_HEIGHT = 48;
+		static const uint32_t SDF_PADDING = 6;
+		static const uint32_t FIRST_CHAR = ' ';
+		static const uint32_t CHAR_COUNT = '~' - ' ' + 1;
+
+		// Glyph metrics are in atlas pixels, this scales them to the font's size
+		float __AtlasToPixel() const { return static_cast<float>(myFontSize) / SDF_PIXEL_HEIGHT; }
+		const SdfGlyph* __FindGlyph(int codePoint) const;
 
-		stbtt_packedchar* myCharInfo;
+		SdfGlyph          myGlyphs[CHAR_COUNT];
+		unsigned char*    myFontData;
 		uint32_t          myFontSize;
 		stbtt_fontinfo    myFontInfo;
 		float             myPixelHeightScale;
@@ -80,6 +127,11 @@ namespace  TTK
 						  myLineGap;
 	};
 	
+	/*
+	 * Batches up all of the text drawn in a frame, and draws it in one call per font when the context is flushed.
+	 * The layout of each string is cached, so text that doesn't change from frame to frame only has its vertices
+	 * written out again
+	 */
 	class FontRenderer {
 	public:
 		static FontRenderer& Instance() {
@@ -93,6 +145,7 @@ namespace  TTK
 		}
 
 	private:
+		friend class TrueTypeTextureFont;
 		static FontRenderer* m_Instance;
 
 		struct Vert {
@@ -101,17 +154,50 @@ namespace  TTK
 			glm::vec2 UV;
 		};
 
+		struct Batch {
+			const TrueTypeTextureFont* Font;
+			std::vector<Vert>          Verts;
+		};
+
+		struct CachedLayout {
+			TextLayout Layout;
+			uint64_t   LastUsedFrame;
+		};
+
 	public:
 		~FontRenderer();
 
+		/*
+		 * Queues up text to be drawn on the next Flush
+		 * @param font The font to draw the text with
+		 * @param text The text to draw, with no limit on its length
+		 * @param pos The position of the start of the first line's baseline, in screen coordinates
+		 * @param color The color of the text
+		 * @param scale The size of the text, relative to the font's size
+		 */
 		void Render(const TrueTypeTextureFont& font, const char* text, const glm::vec2& pos, const glm::vec4& color, float scale = 1.0f);
+
+		/*
+		 * Draws all of the text queued up since the last flush, and forgets any layouts that haven't been used in a while
+		 */
+		void Flush();
 		
 	private:
 		FontRenderer();
+
+		const TextLayout& __GetLayout(const TrueTypeTextureFont& font, const char* text);
+		void __ReserveQuads(size_t quadCount);
+		void __ForgetFont(const TrueTypeTextureFont* font);
+
+		// How many frames a layout can go unused before it is dropped from the cache
+		static const uint64_t LAYOUT_CACHE_FRAMES = 120;
 				
 		GLuint   m_ShaderHandle;
 		GLuint   m_VAO, m_VBO, m_EBO;
-		Vert     m_MeshData[256 * 4];
-		GLuint   m_IndexData[256 * 6];
+		size_t   m_QuadCapacity;
+		uint64_t m_FrameIndex;
+
+		std::vector<Batch> m_Batches;
+		std::unordered_map<const TrueTypeTextureFont*, std::unordered_map<std::string, CachedLayout>> m_LayoutCache;
 	};
 }
\ No newline at end of file
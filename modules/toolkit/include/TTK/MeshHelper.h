@@ -17,25 +17,41 @@
 
 namespace TTK {
 	namespace Impl {
+		/*
+		 * Collects the shapes drawn through the context, and draws every shape of each type with a single instanced
+		 * draw call when the context is flushed
+		 */
 		class MeshHelper {			
 		public:
 			~MeshHelper();
 			MeshHelper();
-			void RenderTeapot(const glm::mat4& transform, const glm::vec4& color) const;
-			void RenderSphere(const glm::mat4& transform, const glm::vec4& color) const;
-			void RenderCube(const glm::mat4& transform, const glm::vec4& color) const;
+			void RenderTeapot(const glm::mat4& transform, const glm::vec4& color, float duration, double now);
+			void RenderSphere(const glm::mat4& transform, const glm::vec4& color, float duration, double now);
+			void RenderCube(const glm::mat4& transform, const glm::vec4& color, float duration, double now);
+
+			void Flush(const glm::mat4& viewProjection, double now);
 			
 		private:
+			struct Instance {
+				glm::mat4 Transform;
+				glm::vec4 Color;
+			};
 			struct mesh {
 				GLuint VAO;
 				GLuint VBO;
+				GLsizei VertexCount;
+				DebugBatch<Instance> Instances;
 			};
-			mesh __MakeMesh(const float* data, size_t size) const;
+			void __MakeMesh(mesh& result, const float* data, size_t size) const;
 			
 			mesh m_Teapot;
 			mesh m_Sphere;
 			mesh m_Cube;
 			GLuint m_Shader;
+			// Holds the instances for every shape, each draw starts at its own base instance
+			GLuint m_InstanceVBO;
+			size_t m_InstanceCapacity;
+			std::vector<Instance> m_InstanceData;
 		};
 	}
 }
\ No newline at end of file
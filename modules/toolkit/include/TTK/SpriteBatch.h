@@ -0,0 +1,162 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This header is a part of the Tutorial Tool Kit (TTK) library.
+// You may not use this header in your GDW games.
+//
+// This class draws large numbers of animated, camera facing sprites,
+// taking the place of one SpriteSheetQuad per sprite
+//
+// Shawn Matthews - 2019
+//
+//////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <GLM/glm.hpp>
+#include "glad/glad.h"
+#include "stb_rect_pack.h"
+
+namespace TTK {
+
+	/*
+	 * Draws animated billboards (hit effects, pickups, health bars and so on). The frames of every sprite sheet are
+	 * packed into a few shared atlases, and the sprites themselves are kept in flat arrays, so that one Update call
+	 * advances every animation in a single tight loop, and each atlas is drawn with a single instanced draw
+	 */
+	class SpriteBatch
+	{
+	public:
+		typedef uint32_t SpriteHandle;
+		static const SpriteHandle INVALID_SPRITE = 0xFFFFFFFF;
+
+		/*
+		 * Creates a new, empty sprite batch
+		 * @param atlasSize The width and height of each atlas page, in pixels
+		 */
+		SpriteBatch(int atlasSize = 2048);
+		~SpriteBatch();
+
+		SpriteBatch(const SpriteBatch& other) = delete;
+		SpriteBatch& operator=(const SpriteBatch& other) = delete;
+
+		/*
+		 * Loads a sprite sheet and packs its frames into an atlas
+		 * @param fileName The path to the texture to load, relative to the current working directory
+		 * @param numSpritesPerRow The number of sprites in a single row
+		 * @param numRows The number of rows that make up the sheet
+		 * @param animTime The time it should take to complete one full cycle of the animation, if this is 0, then the sprite will default to 60 FPS
+		 * @returns The index of the sheet to pass to AddSprite, or -1 if it could not be loaded
+		 */
+		int AddSheet(const char* fileName, int numSpritesPerRow, int numRows, float animTime = 0.0f);
+
+		/*
+		 * Adds a new sprite, starting at the first frame of its sheet
+		 * @param sheet The sheet to animate the sprite with, from AddSheet
+		 * @param position The world position of the center of the sprite
+		 * @param size The width and height of the sprite, in world units
+		 * @param color The color to multiply the sprite by
+		 * @param looping True if the animation should loop, false if it should stop on the last frame
+		 * @returns A handle to the sprite, which stays valid until it is removed
+		 */
+		SpriteHandle AddSprite(int sheet, const glm::vec3& position, const glm::vec2& size, const glm::vec4& color = glm::vec4(1.0f), bool looping = true);
+		/*
+		 * Removes a sprite from the batch
+		 */
+		void RemoveSprite(SpriteHandle sprite);
+
+		void SetPosition(SpriteHandle sprite, const glm::vec3& position);
+		void SetSize(SpriteHandle sprite, const glm::vec2& size);
+		void SetColor(SpriteHandle sprite, const glm::vec4& color);
+
+		/*
+		 * Restarts a sprite's animation from its first frame
+		 */
+		void ResetAnimation(SpriteHandle sprite);
+		/*
+		 * Checks whether a sprite that doesn't loop has reached the end of its animation
+		 */
+		bool IsFinished(SpriteHandle sprite) const;
+
+		/*
+		 * Gets the number of sprites in the batch
+		 */
+		size_t GetSpriteCount() const { return m_Positions.size(); }
+
+		/*
+		 * Advances the animation of every sprite
+		 * @param deltaTime The time since the last frame, in seconds
+		 */
+		void Update(float deltaTime);
+
+		/*
+		 * Draws every sprite facing the camera, sorted back to front so that they blend correctly. Sprites are only
+		 * sorted against other sprites in the same atlas
+		 * @param view The view matrix of the camera
+		 * @param projection The projection matrix of the camera
+		 */
+		void Draw(const glm::mat4& view, const glm::mat4& projection);
+
+	private:
+		struct Page {
+			GLuint Texture;
+			stbrp_context Packer;
+			std::vector<stbrp_node> Nodes;
+			bool MipsDirty;
+		};
+
+		struct Sheet {
+			int      Page;
+			uint32_t FirstFrame;
+			uint32_t FrameCount;
+			float    FrameRate;
+		};
+
+		struct Instance {
+			glm::vec3 Position;
+			glm::vec2 Size;
+			glm::vec4 UvRect;
+			glm::vec4 Color;
+		};
+
+		// The gap around each frame in the atlas, filled with the frame's edge pixels so filtering doesn't pick up its neighbours
+		static const int FRAME_PADDING = 2;
+
+		Page* __AddPage();
+		size_t __IndexOf(SpriteHandle sprite) const;
+
+		int    m_AtlasSize;
+		GLuint m_Shader;
+		GLuint m_VAO, m_InstanceVBO;
+		size_t m_InstanceCapacity;
+
+		std::vector<std::unique_ptr<Page>> m_Pages;
+		std::vector<Sheet>                 m_Sheets;
+		// The UV rectangle of every frame of every sheet, as (uMin, vMin, uMax, vMax)
+		std::vector<glm::vec4>             m_FrameUvs;
+
+		// The sprites themselves, kept tightly packed with one array per attribute
+		std::vector<glm::vec3> m_Positions;
+		std::vector<glm::vec2> m_Sizes;
+		std::vector<glm::vec4> m_Colors;
+		std::vector<float>     m_Times;
+		std::vector<float>     m_FrameRates;
+		std::vector<float>     m_FrameCounts;
+		std::vector<float>     m_Looping;
+		std::vector<uint32_t>  m_FirstFrames;
+		std::vector<uint32_t>  m_Frames;
+		std::vector<int>       m_SpritePages;
+		std::vector<SpriteHandle> m_Handles;
+
+		// Handles index into m_Slots, which holds where the sprite currently lives in the arrays above
+		std::vector<uint32_t>     m_Slots;
+		std::vector<SpriteHandle> m_FreeHandles;
+
+		// Scratch space for drawing, kept around between frames
+		std::vector<uint32_t> m_DrawOrder;
+		std::vector<float>    m_Depths;
+		std::vector<Instance> m_InstanceData;
+	};
+
+}
@@ -13,6 +13,7 @@
 //////////////////////////////////////////////////////////////////////////
 #pragma once
 
+#include <vector>
 #include <GLM/glm.hpp>
 #include "FontRenderer.h"
 
@@ -20,6 +21,53 @@ namespace TTK
 {
 	namespace Impl {
 		class MeshHelper;
+
+		/*
+		 * The debug primitives of one type that are waiting to be drawn. Items with a duration stick around and are
+		 * drawn every frame until they expire, everything else is only drawn on the next flush
+		 */
+		template <typename T>
+		class DebugBatch {
+		public:
+			void Add(const T& item, float duration, double now) {
+				if (duration > 0.0f) {
+					m_Persistent.push_back(item);
+					m_ExpiresAt.push_back(now + duration);
+				}
+				else {
+					m_Items.push_back(item);
+				}
+			}
+
+			/*
+			 * Drops any expired items, and gets everything that should be drawn this frame
+			 */
+			const std::vector<T>& Gather(double now) {
+				for (size_t ix = 0; ix < m_Persistent.size();) {
+					if (m_ExpiresAt[ix] <= now) {
+						m_Persistent[ix] = m_Persistent.back();
+						m_ExpiresAt[ix] = m_ExpiresAt.back();
+						m_Persistent.pop_back();
+						m_ExpiresAt.pop_back();
+					}
+					else {
+						ix++;
+					}
+				}
+				m_Items.insert(m_Items.end(), m_Persistent.begin(), m_Persistent.end());
+				return m_Items;
+			}
+
+			/*
+			 * Forgets this frame's items, keeping the memory around for the next frame
+			 */
+			void Clear() { m_Items.clear(); }
+
+		private:
+			std::vector<T>      m_Items;
+			std::vector<T>      m_Persistent;
+			std::vector<double> m_ExpiresAt;
+		};
 	}
 	
 	class Context {
@@ -48,6 +96,13 @@ namespace TTK
 	private:
 		static Context* m_Instance;
 
+		struct Line {
+			SimpleVert Verts[2];
+		};
+		struct Tri {
+			SimpleVert Verts[3];
+		};
+
 	public:
 		~Context();
 
@@ -65,14 +120,16 @@ namespace TTK
 
 		void RenderText(const char* text, const glm::vec2& position, const glm::vec4& color, float scale = 1.0f);
 		
-		void DrawTeapot(const glm::mat4& mat, const glm::vec4& color = glm::vec4(1.0f)) const;
-		void DrawSphere(const glm::mat4& mat, const glm::vec4& color = glm::vec4(1.0f)) const;
-		void DrawCube(const glm::mat4& mat, const glm::vec4& color = glm::vec4(1.0f)) const;
-
-		void AddLine(const glm::vec3& a, const glm::vec3& b, const glm::vec4& color = {0, 0, 0, 1});
-		void AddTri(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec4& color = { 0, 0, 0, 1 });
-		void AddQuad(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color = { 0, 0, 0, 1 });
-		void AddPoint(const glm::vec3& pos, float size, const glm::vec4& color = { 0, 0, 0, 1 });
+		// Everything below is batched up until the next Flush. Passing a duration (in seconds) keeps drawing the item
+		// every frame until it runs out, without having to add it again
+		void DrawTeapot(const glm::mat4& mat, const glm::vec4& color = glm::vec4(1.0f), float duration = 0.0f);
+		void DrawSphere(const glm::mat4& mat, const glm::vec4& color = glm::vec4(1.0f), float duration = 0.0f);
+		void DrawCube(const glm::mat4& mat, const glm::vec4& color = glm::vec4(1.0f), float duration = 0.0f);
+
+		void AddLine(const glm::vec3& a, const glm::vec3& b, const glm::vec4& color = {0, 0, 0, 1}, float duration = 0.0f);
+		void AddTri(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec4& color = { 0, 0, 0, 1 }, float duration = 0.0f);
+		void AddQuad(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color = { 0, 0, 0, 1 }, float duration = 0.0f);
+		void AddPoint(const glm::vec3& pos, float size, const glm::vec4& color = { 0, 0, 0, 1 }, float duration = 0.0f);
 		
 		void Flush();
 
@@ -88,26 +145,21 @@ namespace TTK
 		GLuint m_PointShaderHandle;
 		struct GLBuff {
 			GLuint VBO, VAO;
-			size_t Count;
-			size_t ElemSize;
+			size_t Capacity;
 			GLenum Mode;
-			void*  Data;
 			GLuint Shader;
 		};
 		GLBuff m_Tris, m_Lines, m_Points;
 
 		int m_WindowWidth, m_WindowHeight;
 
-		GLBuff __InitBuff(GLenum mode, GLuint shader, void* dataSource, size_t elemSize, size_t maxElems);
-		void __Flush(GLBuff& buff);
+		GLBuff __InitBuff(GLenum mode, GLuint shader, size_t elemSize, size_t initialElems);
+		void __Flush(GLBuff& buff, const void* data, size_t vertCount, size_t vertSize);
 		GLuint __CompileShader(const char* vsSource, const char* fsSource);
+		double __Now() const;
 
-		static const size_t MaxPointVerts = 512;
-		static const size_t MaxLineVerts = 512 * 2;
-		static const size_t MaxTriVerts = 512 * 3;
-
-		PointVert  m_PointVerts[MaxPointVerts];
-		SimpleVert m_LineVerts[MaxLineVerts];
-		SimpleVert m_TriVerts[MaxTriVerts];
+		Impl::DebugBatch<PointVert> m_PointBatch;
+		Impl::DebugBatch<Line>      m_LineBatch;
+		Impl::DebugBatch<Tri>       m_TriBatch;
 	};
 }
@@ -12,6 +12,7 @@
 
 #include "TTK/FontRenderer.h"
 #include <fstream>
+#include "stb_rect_pack.h"
 #include "Logging.h"
 #include <GLM/gtc/matrix_transform.hpp>
 #include "TTK/TTKContext.h"
@@ -56,16 +57,19 @@ TTK::FontRenderer* TTK::FontRenderer::m_Instance = nullptr;
 TTK::TrueTypeTextureFont::TrueTypeTextureFont(const char* fileName, uint32_t size)
 {
 	myFontSize = size;
+	myTexture = 0;
+	m_TexHandle = 0;
+	memset(myGlyphs, 0, sizeof(myGlyphs));
+
+	// The font data needs to stick around for as long as myFontInfo does, since stb reads kerning out of it
+	myFontData = (unsigned char*)readFile(fileName);
+	if (myFontData == nullptr) {
+		LOG_ERROR("Failed to open font \"{}\"", fileName);
+		return;
+	}
 
-	unsigned char* fontData = (unsigned char*)readFile(fileName);
-	uint8_t* atlasData = new uint8_t[static_cast<size_t>(ATLAS_WIDTH) * ATLAS_HEIGHT];
-
-	myCharInfo = new stbtt_packedchar[CHAR_COUNT];
-
-	if (!stbtt_InitFont(&myFontInfo, fontData, 0)) {
+	if (!stbtt_InitFont(&myFontInfo, myFontData, 0)) {
 		LOG_ERROR("Failed to initialize font");
-		delete[] atlasData;
-		delete[] fontData;
 		return;
 	}
 
@@ -75,72 +79,117 @@ TTK::TrueTypeTextureFont::TrueTypeTextureFont(const char* fileName, uint32_t siz
 	myPixelHeightScale = stbtt_ScaleForPixelHeight(&myFontInfo, static_cast<float>(size));
 	myEmToPixel = stbtt_ScaleForMappingEmToPixels(&myFontInfo, 1.0f);
 
-	stbtt_pack_context context;
-	if (!stbtt_PackBegin(&context, atlasData, ATLAS_WIDTH, ATLAS_HEIGHT, 0, 1, nullptr)) {
-		LOG_ERROR("Failed to pack font texture");
-		delete[] atlasData;
-		delete[] fontData;
-		return;
+	// Render the distance field for every glyph, 128 is the edge of the glyph, and the distance falls off to 0 at
+	// SDF_PADDING pixels outside of it
+	const float sdfScale = stbtt_ScaleForPixelHeight(&myFontInfo, static_cast<float>(SDF_PIXEL_HEIGHT));
+	unsigned char* bitmaps[CHAR_COUNT];
+	stbrp_rect rects[CHAR_COUNT];
+	for (uint32_t ix = 0; ix < CHAR_COUNT; ix++) {
+		int advance{ 0 }, leftBearing{ 0 };
+		stbtt_GetCodepointHMetrics(&myFontInfo, FIRST_CHAR + ix, &advance, &leftBearing);
+		myGlyphs[ix].Advance = advance * sdfScale;
+
+		int width{ 0 }, height{ 0 }, xOff{ 0 }, yOff{ 0 };
+		bitmaps[ix] = stbtt_GetCodepointSDF(&myFontInfo, sdfScale, FIRST_CHAR + ix, SDF_PADDING, 128, 128.0f / SDF_PADDING, &width, &height, &xOff, &yOff);
+		if (bitmaps[ix] == nullptr) {
+			width = height = 0;
+		}
+		myGlyphs[ix].Min = glm::vec2(xOff, yOff);
+		myGlyphs[ix].Max = glm::vec2(xOff + width, yOff + height);
+
+		// Leave a gap between glyphs so that the mip maps don't blend them together
+		rects[ix].id = ix;
+		rects[ix].w = width > 0 ? width + 1 : 0;
+		rects[ix].h = height > 0 ? height + 1 : 0;
 	}
 
-	stbtt_PackSetOversampling(&context, FONT_OVERSAMPLE_X, FONT_OVERSAMPLE_Y);
-	if (!stbtt_PackFontRange(&context, fontData, 0, static_cast<float>(size), FIRST_CHAR, CHAR_COUNT, myCharInfo)) {
-		LOG_ERROR("Failed to pack font range");
-		delete[] atlasData;
-		delete[] fontData;
-		return;
+	std::vector<stbrp_node> nodes(ATLAS_WIDTH);
+	stbrp_context packer;
+	stbrp_init_target(&packer, ATLAS_WIDTH, ATLAS_HEIGHT, nodes.data(), static_cast<int>(nodes.size()));
+	if (!stbrp_pack_rects(&packer, rects, CHAR_COUNT)) {
+		LOG_ERROR("Font atlas is too small for \"{}\", some glyphs will be missing", fileName);
 	}
-	stbtt_PackEnd(&context);
 
-	for (uint32_t ix = FIRST_CHAR; ix < FIRST_CHAR + CHAR_COUNT; ix++) {
-		// TODO: Grab glyph data
+	uint8_t* atlasData = new uint8_t[static_cast<size_t>(ATLAS_WIDTH) * ATLAS_HEIGHT];
+	memset(atlasData, 0, static_cast<size_t>(ATLAS_WIDTH) * ATLAS_HEIGHT);
+	for (uint32_t ix = 0; ix < CHAR_COUNT; ix++) {
+		SdfGlyph& glyph = myGlyphs[ix];
+		const int width = static_cast<int>(glyph.Max.x - glyph.Min.x);
+		const int height = static_cast<int>(glyph.Max.y - glyph.Min.y);
+		if (bitmaps[ix] != nullptr && rects[ix].was_packed) {
+			for (int y = 0; y < height; y++) {
+				memcpy(atlasData + (static_cast<size_t>(rects[ix].y) + y) * ATLAS_WIDTH + rects[ix].x, bitmaps[ix] + static_cast<size_t>(y) * width, width);
+			}
+			glyph.UvMin = glm::vec2(rects[ix].x, rects[ix].y) / glm::vec2(ATLAS_WIDTH, ATLAS_HEIGHT);
+			glyph.UvMax = glm::vec2(rects[ix].x + width, rects[ix].y + height) / glm::vec2(ATLAS_WIDTH, ATLAS_HEIGHT);
+		}
+		else {
+			// Nothing to draw (ex: space), we only need the advance
+			glyph.Max = glyph.Min;
+		}
+		stbtt_FreeSDF(bitmaps[ix], nullptr);
 	}
 
-	// Create and upload the texture to store our font in
+	// Create and upload the texture to store our font in, the distance field blends nicely so we can use mip maps
+	// for small text
 	LOG_ASSERT(glGetError() == GL_NONE, "Some error has occured!");
 	glCreateTextures(GL_TEXTURE_2D, 1, &myTexture);
 	glTextureParameteri(myTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTextureParameteri(myTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTextureParameteri(myTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+	glTextureParameteri(myTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTextureParameteri(myTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	LOG_ASSERT(glGetError() == GL_NONE, "Some error has occured!");
-	glTextureStorage2D(myTexture, 1, GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT);
+	glTextureStorage2D(myTexture, 4, GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT);
 	LOG_ASSERT(glGetError() == GL_NONE, "Internal texture format not supported");
 	glTextureSubImage2D(myTexture, 0, 0, 0, ATLAS_WIDTH, ATLAS_HEIGHT, GL_RED, GL_UNSIGNED_BYTE, atlasData);
 	LOG_ASSERT(glGetError() == GL_NONE, "Texture transfer format not supported");
+	glGenerateTextureMipmap(myTexture);
 	m_TexHandle = glGetTextureHandleARB(myTexture);
 	glMakeTextureHandleResidentARB(m_TexHandle);
 
 	delete[] atlasData;
-	delete[] fontData;
 }
 
 TTK::TrueTypeTextureFont::~TrueTypeTextureFont()
 {
-	delete[] myCharInfo;
+	if (FontRenderer::m_Instance != nullptr)
+		FontRenderer::m_Instance->__ForgetFont(this);
+	if (m_TexHandle != 0)
+		glMakeTextureHandleNonResidentARB(m_TexHandle);
 	glDeleteTextures(1, &myTexture);
+	delete[] myFontData;
+}
+
+const TTK::TrueTypeTextureFont::SdfGlyph* TTK::TrueTypeTextureFont::__FindGlyph(int codePoint) const {
+	if (codePoint < static_cast<int>(FIRST_CHAR) || codePoint >= static_cast<int>(FIRST_CHAR + CHAR_COUNT))
+		return nullptr;
+	return &myGlyphs[codePoint - FIRST_CHAR];
 }
 
 TTK::GlyphInfo TTK::TrueTypeTextureFont::GetGlyph(int codePoint, float offsetX, float offsetY) const {
-	stbtt_aligned_quad quad;
+	GlyphInfo info = GlyphInfo();
+	const SdfGlyph* glyph = __FindGlyph(codePoint);
+	if (glyph == nullptr) {
+		info.OffsetX = offsetX;
+		info.OffsetY = offsetY;
+		return info;
+	}
 
-	stbtt_GetPackedQuad(myCharInfo, ATLAS_WIDTH, ATLAS_HEIGHT, codePoint - FIRST_CHAR, &offsetX, &offsetY, &quad, 1);
-	auto xmin = quad.x0;
-	auto xmax = quad.x1;
-	auto ymin = -quad.y1;
-	auto ymax = -quad.y0;
+	const float toPixel = __AtlasToPixel();
+	const glm::vec2 offset = glm::vec2(offsetX, offsetY);
+	const glm::vec2 min = offset + glyph->Min * toPixel;
+	const glm::vec2 max = offset + glyph->Max * toPixel;
 
-	GlyphInfo info = GlyphInfo();
-	info.OffsetX = offsetX;
+	info.OffsetX = offsetX + glyph->Advance * toPixel;
 	info.OffsetY = offsetY;
-	info.Positions[0] = { xmax, -ymin };
-	info.Positions[1] = { xmax, -ymax };
-	info.Positions[2] = { xmin, -ymax };
-	info.Positions[3] = { xmin, -ymin };
-	info.UVs[0] = { quad.s1, quad.t1 };
-	info.UVs[1] = { quad.s1, quad.t0 };
-	info.UVs[2] = { quad.s0, quad.t0 };
-	info.UVs[3] = { quad.s0, quad.t1 };
+	info.Positions[0] = { max.x, max.y };
+	info.Positions[1] = { max.x, min.y };
+	info.Positions[2] = { min.x, min.y };
+	info.Positions[3] = { min.x, max.y };
+	info.UVs[0] = { glyph->UvMax.x, glyph->UvMax.y };
+	info.UVs[1] = { glyph->UvMax.x, glyph->UvMin.y };
+	info.UVs[2] = { glyph->UvMin.x, glyph->UvMin.y };
+	info.UVs[3] = { glyph->UvMin.x, glyph->UvMax.y };
 
 	return info;
 }
@@ -154,65 +203,94 @@ float TTK::TrueTypeTextureFont::GetLineHeight() const {
 }
 
 glm::vec2 TTK::TrueTypeTextureFont::MeausureString(const char* text, const float scale) {
-	float multiplier = scale;
+	TextLayout layout;
+	LayoutText(text, layout);
+	return layout.Size * __AtlasToPixel() * scale;
+}
 
-	glm::vec2 originPos = glm::vec2();
+void TTK::TrueTypeTextureFont::LayoutText(const char* text, TextLayout& result) const {
+	result.Quads.clear();
+	result.Size = glm::vec2(0.0f);
+	if (myFontData == nullptr)
+		return;
 
-	GlyphInfo glyph;
+	// Everything here is in atlas pixels, the renderer scales it to the size the text is drawn at
+	const float atlasScale = myPixelHeightScale / __AtlasToPixel();
+	const float lineHeight = (myAscent - myDescent + myLineGap) * atlasScale;
+	const SdfGlyph* space = __FindGlyph(' ');
 
+	glm::vec2 pen = glm::vec2(0.0f);
+	int lineCount = 1;
+	int prevChar = 0;
 	size_t length = strlen(text);
-	float xOff{ 0 }, yOff{ 0 };
-	float lineHeight = 0.0f;
-	float maxWidth = 0.0f;
-	float totalHeight = 0.0f;
+	result.Quads.reserve(length);
 
 	for (size_t i = 0; i < length; i++) {
-		glyph = GetGlyph(text[i], xOff, yOff);
-		xOff = glyph.OffsetX;
-		yOff = glyph.OffsetY;
-
-		lineHeight = glm::max(lineHeight, -glyph.Positions[1].y);
-		maxWidth = glm::max(maxWidth, xOff);
-
-		if (text[i] == '\n')
-		{
-			yOff += GetLineHeight() * multiplier;
-			totalHeight += lineHeight;
-			lineHeight = 0.0f;
-			xOff = 0;
+		const int codePoint = static_cast<unsigned char>(text[i]);
+		if (codePoint == '\n') {
+			pen.x = 0.0f;
+			pen.y += lineHeight;
+			lineCount++;
+			prevChar = 0;
 		}
-		else if (text[i] == '\r') {
-			xOff = 0;
+		else if (codePoint == '\r') {
+			pen.x = 0.0f;
+			prevChar = 0;
 		}
-		else if (text[i] == '\t') {
-			float xOffTemp{ 0 }, yOffTemp{ 0 };
-			glyph = GetGlyph(' ', xOffTemp, yOffTemp);
-			xOff += glyph.OffsetX * 4;
+		else if (codePoint == '\t') {
+			pen.x += space->Advance * 4;
+			prevChar = 0;
+		}
+		else {
+			const SdfGlyph* glyph = __FindGlyph(codePoint);
+			if (glyph == nullptr)
+				continue;
+			if (prevChar != 0)
+				pen.x += stbtt_GetCodepointKernAdvance(&myFontInfo, prevChar, codePoint) * atlasScale;
+
+			if (glyph->Max.x > glyph->Min.x) {
+				TextLayout::Quad quad;
+				quad.Min = pen + glyph->Min;
+				quad.Max = pen + glyph->Max;
+				quad.UvMin = glyph->UvMin;
+				quad.UvMax = glyph->UvMax;
+				result.Quads.push_back(quad);
+			}
+			pen.x += glyph->Advance;
+			prevChar = codePoint;
 		}
+		result.Size.x = glm::max(result.Size.x, pen.x);
 	}
-	GlyphInfo space = GetGlyph('|', xOff, yOff);
-	yOff += -(space.Positions[1].y - space.Positions[0].y);
-	return glm::vec2(xOff, yOff);
+	result.Size.y = (lineCount - 1) * lineHeight + (myAscent - myDescent) * atlasScale;
 }
 
 TTK::FontRenderer::~FontRenderer()
 {
-	glDeleteShader(m_ShaderHandle);
+	glDeleteProgram(m_ShaderHandle);
+	glDeleteBuffers(1, &m_VBO);
+	glDeleteBuffers(1, &m_EBO);
 	glDeleteVertexArrays(1, &m_VAO);
 }
 
 void TTK::FontRenderer::Render(const TrueTypeTextureFont& font, const char* text, const glm::vec2& pos, const glm::vec4& color, float scale)
 {
-	size_t length = strlen(text);
-	
-	float multiplier = scale;
-
-	// The number of quads ACTUALLY drawn Shit-For-Brains
-	int quads = 0;
-
-	glm::vec2 originPos = glm::vec2(pos.x, pos.y);
+	const TextLayout& layout = __GetLayout(font, text);
+	if (layout.Quads.empty())
+		return;
 
-	static GlyphInfo glyph;
+	// Text for each font goes into its own batch, so that we can draw it all with one texture
+	Batch* batch = nullptr;
+	for (Batch& existing : m_Batches) {
+		if (existing.Font == &font) {
+			batch = &existing;
+			break;
+		}
+	}
+	if (batch == nullptr) {
+		m_Batches.push_back(Batch());
+		batch = &m_Batches.back();
+		batch->Font = &font;
+	}
 
 	Col8 gpuCol;
 	gpuCol.R = static_cast<char>(color.r * 255);
@@ -220,110 +298,145 @@ void TTK::FontRenderer::Render(const TrueTypeTextureFont& font, const char* text
 	gpuCol.B = static_cast<char>(color.b * 255);
 	gpuCol.A = static_cast<char>(color.a * 255);
 
-	float xOff{ 0 }, yOff{ 0 };
-
-	for (int i = 0; i < length; i++) {
-		glyph = font.GetGlyph(text[i], xOff, yOff);
-		xOff = glyph.OffsetX;
-		yOff = glyph.OffsetY;
+	const float multiplier = font.__AtlasToPixel() * scale;
+	std::vector<Vert>& verts = batch->Verts;
+	verts.reserve(verts.size() + layout.Quads.size() * 4);
+	for (const TextLayout::Quad& quad : layout.Quads) {
+		const glm::vec2 min = pos + quad.Min * multiplier;
+		const glm::vec2 max = pos + quad.Max * multiplier;
+		verts.push_back({ { max.x, max.y }, gpuCol, { quad.UvMax.x, quad.UvMax.y } });
+		verts.push_back({ { max.x, min.y }, gpuCol, { quad.UvMax.x, quad.UvMin.y } });
+		verts.push_back({ { min.x, min.y }, gpuCol, { quad.UvMin.x, quad.UvMin.y } });
+		verts.push_back({ { min.x, max.y }, gpuCol, { quad.UvMin.x, quad.UvMax.y } });
+	}
+}
 
-		if (text[i] == '\n')
-		{
-			yOff += font.GetLineHeight() * multiplier;
-			xOff = 0;
-		}
-		else if (text[i] == '\r') {
-			xOff = 0;
-		}
-		else if (text[i] == '\t') {
-			float xOffTemp{ 0 }, yOffTemp{ 0 };
-			glyph = font.GetGlyph(' ', xOffTemp, yOffTemp);
-			xOff += glyph.OffsetX * 4;
+void TTK::FontRenderer::Flush()
+{
+	size_t quadCount = 0;
+	for (const Batch& batch : m_Batches)
+		quadCount += batch.Verts.size() / 4;
+
+	if (quadCount > 0) {
+		__ReserveQuads(quadCount);
+
+		// Orphan last frame's vertices, so that we don't have to wait for the GPU to finish with them
+		glNamedBufferData(m_VBO, m_QuadCapacity * 4 * sizeof(Vert), nullptr, GL_STREAM_DRAW);
+		size_t offset = 0;
+		for (const Batch& batch : m_Batches) {
+			glNamedBufferSubData(m_VBO, offset * sizeof(Vert), batch.Verts.size() * sizeof(Vert), batch.Verts.data());
+			offset += batch.Verts.size();
 		}
-		else {
-			m_MeshData[quads * 4 + 0].Position = originPos + glyph.Positions[0] * multiplier;
-			m_MeshData[quads * 4 + 0].UV = glyph.UVs[0];
-			m_MeshData[quads * 4 + 0].Color = gpuCol;
 
-			m_MeshData[quads * 4 + 1].Position = originPos + glyph.Positions[1] * multiplier;
-			m_MeshData[quads * 4 + 1].UV = glyph.UVs[1];
-			m_MeshData[quads * 4 + 1].Color = gpuCol;
-
-			m_MeshData[quads * 4 + 2].Position = originPos + glyph.Positions[2] * multiplier;
-			m_MeshData[quads * 4 + 2].UV = glyph.UVs[2];
-			m_MeshData[quads * 4 + 2].Color = gpuCol;
+		bool blendState = glIsEnabled(GL_BLEND);
+		GLboolean depthMaskEnabled = false;
+		glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMaskEnabled);
+		glDepthMask(GL_FALSE);
+		glEnable(GL_BLEND);
+		glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+		glGetError();
+		glm::mat4 proj = TTK::Context::Instance().GetOrthoProjection();
+		glUseProgram(m_ShaderHandle);
+		glProgramUniformMatrix4fv(m_ShaderHandle, 0, 1, false, &proj[0][0]);
+		glBindVertexArray(m_VAO);
+
+		// One draw per font, every batch shares the same quad indices and just starts further into the vertices
+		GLint baseVertex = 0;
+		for (Batch& batch : m_Batches) {
+			if (batch.Verts.empty())
+				continue;
+			glProgramUniformHandleui64ARB(m_ShaderHandle, 1, batch.Font->m_TexHandle);
+			glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(batch.Verts.size() / 4 * 6), GL_UNSIGNED_INT, nullptr, baseVertex);
+			baseVertex += static_cast<GLint>(batch.Verts.size());
+			batch.Verts.clear();
+		}
 
-			m_MeshData[quads * 4 + 3].Position = originPos + glyph.Positions[3] * multiplier;
-			m_MeshData[quads * 4 + 3].UV = glyph.UVs[3];
-			m_MeshData[quads * 4 + 3].Color = gpuCol;
+		glBindVertexArray(0);
+		LOG_ASSERT(glGetError() == GL_NONE, "Failed to draw our text mesh!");
+		if (!blendState) glDisable(GL_BLEND);
+		glDepthMask(depthMaskEnabled);
+	}
 
+	// Drop any layouts that haven't been drawn recently, so that text that changes every frame doesn't pile up
+	m_FrameIndex++;
+	for (auto& fontCache : m_LayoutCache) {
+		for (auto it = fontCache.second.begin(); it != fontCache.second.end();) {
+			if (m_FrameIndex - it->second.LastUsedFrame > LAYOUT_CACHE_FRAMES)
+				it = fontCache.second.erase(it);
+			else
+				++it;
+		}
+	}
+}
 
-			m_IndexData[quads * 6 + 0] = quads * 4 + 0;
-			m_IndexData[quads * 6 + 1] = quads * 4 + 1;
-			m_IndexData[quads * 6 + 2] = quads * 4 + 2;
+const TTK::TextLayout& TTK::FontRenderer::__GetLayout(const TrueTypeTextureFont& font, const char* text)
+{
+	std::unordered_map<std::string, CachedLayout>& cache = m_LayoutCache[&font];
+	auto it = cache.find(text);
+	if (it == cache.end()) {
+		it = cache.emplace(text, CachedLayout()).first;
+		font.LayoutText(text, it->second.Layout);
+	}
+	it->second.LastUsedFrame = m_FrameIndex;
+	return it->second.Layout;
+}
 
-			m_IndexData[quads * 6 + 3] = quads * 4 + 0;
-			m_IndexData[quads * 6 + 4] = quads * 4 + 2;
-			m_IndexData[quads * 6 + 5] = quads * 4 + 3;
+void TTK::FontRenderer::__ReserveQuads(size_t quadCount)
+{
+	if (quadCount <= m_QuadCapacity)
+		return;
+	m_QuadCapacity = glm::max(quadCount, m_QuadCapacity * 2);
+
+	// Every quad uses the same pattern of indices, so they only need to be updated when we grow
+	std::vector<GLuint> indices(m_QuadCapacity * 6);
+	for (size_t ix = 0; ix < m_QuadCapacity; ix++) {
+		const GLuint vert = static_cast<GLuint>(ix * 4);
+		indices[ix * 6 + 0] = vert + 0;
+		indices[ix * 6 + 1] = vert + 1;
+		indices[ix * 6 + 2] = vert + 2;
+		indices[ix * 6 + 3] = vert + 0;
+		indices[ix * 6 + 4] = vert + 2;
+		indices[ix * 6 + 5] = vert + 3;
+	}
+	glNamedBufferData(m_EBO, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	glNamedBufferData(m_VBO, m_QuadCapacity * 4 * sizeof(Vert), nullptr, GL_STREAM_DRAW);
+}
 
-			quads++;
+void TTK::FontRenderer::__ForgetFont(const TrueTypeTextureFont* font)
+{
+	m_LayoutCache.erase(font);
+	for (auto it = m_Batches.begin(); it != m_Batches.end(); ++it) {
+		if (it->Font == font) {
+			m_Batches.erase(it);
+			break;
 		}
 	}
-
-	length = quads;
-
-	// Update and render our meshes
-	bool blendState = glIsEnabled(GL_BLEND);
-	GLboolean depthMaskEnabled = false;
-	glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMaskEnabled);
-	glDepthMask(GL_FALSE);
-	glEnable(GL_BLEND);
-	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
-	glGetError();
-	glm::mat4 proj = TTK::Context::Instance().GetOrthoProjection();
-	glUseProgram(m_ShaderHandle);
-	glProgramUniformMatrix4fv(m_ShaderHandle, 0, 1, false, &proj[0][0]);
-	glProgramUniformHandleui64ARB(m_ShaderHandle, 1, font.m_TexHandle);	
-	glBindVertexArray(m_VAO);
-	glNamedBufferSubData(m_VBO, 0, length * 4 * sizeof(Vert), m_MeshData);
-	glNamedBufferSubData(m_EBO, 0, length * 6 * sizeof(GLuint), m_IndexData);
-	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(length * 6), GL_UNSIGNED_INT, nullptr);
-	glBindVertexArray(0);
-	LOG_ASSERT(glGetError() == GL_NONE, "Failed to draw our text mesh!");
-	if (!blendState) glDisable(GL_BLEND);
-	glDepthMask(depthMaskEnabled);
 }
 
 TTK::FontRenderer::FontRenderer() {
 	LOG_INFO("Initializing font renderer");
 
-	memset(m_MeshData, 0, sizeof(m_MeshData));
-	memset(m_IndexData, 0, sizeof(m_IndexData));
+	m_QuadCapacity = 0;
+	m_FrameIndex = 0;
 
 	glCreateVertexArrays(1, &m_VAO);
 	glBindVertexArray(m_VAO);
 	GLuint buffers[2];
 	glCreateBuffers(2, buffers);
-	glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
-	glNamedBufferData(buffers[0], 256 * 4 * sizeof(Vert), m_MeshData, GL_DYNAMIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
-	glNamedBufferData(buffers[1], 256 * 6 * sizeof(GLuint), m_IndexData, GL_DYNAMIC_DRAW);
+	m_VBO = buffers[0];
+	m_EBO = buffers[1];
+	__ReserveQuads(256);
+	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
 	glEnableVertexAttribArray(2);
-	#pragma warning(push)
-	#pragma warning(disable: 6011)
-	Vert* v = nullptr;
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Vert), &v->Position);
-	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, false, sizeof(Vert), &v->Color);
-	glVertexAttribPointer(2, 2, GL_FLOAT, false, sizeof(Vert), &v->UV);
-	#pragma warning(pop)
+	glVertexAttribPointer(0, 2, GL_FLOAT, false, sizeof(Vert), (void*)offsetof(Vert, Position));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true, sizeof(Vert), (void*)offsetof(Vert, Color));
+	glVertexAttribPointer(2, 2, GL_FLOAT, false, sizeof(Vert), (void*)offsetof(Vert, UV));
 	
 	glBindVertexArray(0);
 
-	m_VBO = buffers[0];
-	m_EBO = buffers[1];
-
 	const char* vsSource = R"LIT(#version 430
             layout (location = 0) in vec2 vertexPosition;
             layout (location = 1) in vec4 vertexColor;
@@ -337,6 +450,8 @@ TTK::FontRenderer::FontRenderer() {
                 fragmentTexture = vertexTexture;
             })LIT";
 
+	// The atlas stores the distance to the edge of the glyph, with the edge at 0.5. Blending over the width of a
+	// screen pixel keeps the edges smooth at any scale
 	const char* fsSource = R"LIT(#version 430
 			#extension GL_ARB_bindless_texture : enable
             layout(bindless_sampler, location = 1) uniform sampler2D xSampler;
@@ -344,8 +459,10 @@ TTK::FontRenderer::FontRenderer() {
             layout (location = 1) in vec2 fragUv;            	
             out vec4 frag_color;            	
             void main() {
+                float dist = texture(xSampler, fragUv).r;
+                float edgeWidth = max(fwidth(dist), 0.0001);
                 frag_color = fragColor;
-				frag_color.a = texture2D(xSampler, fragUv).r;
+				frag_color.a *= smoothstep(0.5 - edgeWidth, 0.5 + edgeWidth, dist);
             })LIT";
 
 	m_ShaderHandle = glCreateProgram();
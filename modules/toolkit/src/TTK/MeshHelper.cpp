@@ -21,72 +21,110 @@ TTK::Impl::MeshHelper::~MeshHelper() {
 	glDeleteBuffers(1, &m_Teapot.VBO);
 	glDeleteBuffers(1, &m_Sphere.VBO);
 	glDeleteBuffers(1, &m_Cube.VBO);
+	glDeleteBuffers(1, &m_InstanceVBO);
 	glDeleteVertexArrays(1, &m_Teapot.VAO);
 	glDeleteVertexArrays(1, &m_Sphere.VAO);
 	glDeleteVertexArrays(1, &m_Cube.VAO);
 	glDeleteProgram(m_Shader);
 }
 
-void TTK::Impl::MeshHelper::RenderTeapot(const glm::mat4& transform, const glm::vec4& color) const {
-	glUseProgram(m_Shader);
-	glm::mat4 t = Context::Instance().GetViewProjection() * transform;
-	glProgramUniformMatrix4fv(m_Shader, 0, 1, FALSE, &t[0][0]);
-	glProgramUniform4fv(m_Shader, 1, 1, &color[0]);
-	glBindVertexArray(m_Teapot.VAO);
-	glDrawArrays(GL_TRIANGLES, 0, sizeof(TeapotData) / (sizeof(float) * 6));
+void TTK::Impl::MeshHelper::RenderTeapot(const glm::mat4& transform, const glm::vec4& color, float duration, double now) {
+	m_Teapot.Instances.Add({ transform, color }, duration, now);
 }
 
-void TTK::Impl::MeshHelper::RenderSphere(const glm::mat4& transform, const glm::vec4& color) const {
-	glUseProgram(m_Shader);
-	glm::mat4 t = Context::Instance().GetViewProjection() * transform;
-	glProgramUniformMatrix4fv(m_Shader, 0, 1, FALSE, &t[0][0]);
-	glProgramUniform4fv(m_Shader, 1, 1, &color[0]);
-	glBindVertexArray(m_Sphere.VAO);
-	glDrawArrays(GL_TRIANGLES, 0, sizeof(SphereData) / (sizeof(float) * 6));
+void TTK::Impl::MeshHelper::RenderSphere(const glm::mat4& transform, const glm::vec4& color, float duration, double now) {
+	m_Sphere.Instances.Add({ transform, color }, duration, now);
 }
 
-void TTK::Impl::MeshHelper::RenderCube(const glm::mat4& transform, const glm::vec4& color) const
+void TTK::Impl::MeshHelper::RenderCube(const glm::mat4& transform, const glm::vec4& color, float duration, double now)
 {
+	m_Cube.Instances.Add({ transform, color }, duration, now);
+}
+
+void TTK::Impl::MeshHelper::Flush(const glm::mat4& viewProjection, double now)
+{
+	// Gather the instances for every shape into one buffer, so they can all go up to the GPU at once
+	mesh* meshes[3] = { &m_Teapot, &m_Sphere, &m_Cube };
+	size_t counts[3];
+	m_InstanceData.clear();
+	for (int ix = 0; ix < 3; ix++) {
+		const std::vector<Instance>& instances = meshes[ix]->Instances.Gather(now);
+		counts[ix] = instances.size();
+		m_InstanceData.insert(m_InstanceData.end(), instances.begin(), instances.end());
+		meshes[ix]->Instances.Clear();
+	}
+	if (m_InstanceData.empty())
+		return;
+
+	const size_t size = m_InstanceData.size() * sizeof(Instance);
+	if (size > m_InstanceCapacity)
+		m_InstanceCapacity = glm::max(size, m_InstanceCapacity * 2);
+	glNamedBufferData(m_InstanceVBO, m_InstanceCapacity, nullptr, GL_STREAM_DRAW);
+	glNamedBufferSubData(m_InstanceVBO, 0, size, m_InstanceData.data());
+
 	glUseProgram(m_Shader);
-	glm::mat4 t = Context::Instance().GetViewProjection() * transform;
-	glProgramUniformMatrix4fv(m_Shader, 0, 1, FALSE, &t[0][0]);
-	glProgramUniform4fv(m_Shader, 1, 1, &color[0]);
-	glBindVertexArray(m_Cube.VAO);
-	glDrawArrays(GL_TRIANGLES, 0, sizeof(CubeData) / (sizeof(float) * 6));
+	glProgramUniformMatrix4fv(m_Shader, 0, 1, false, &viewProjection[0][0]);
+	GLuint baseInstance = 0;
+	for (int ix = 0; ix < 3; ix++) {
+		if (counts[ix] > 0) {
+			glBindVertexArray(meshes[ix]->VAO);
+			glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, meshes[ix]->VertexCount, static_cast<GLsizei>(counts[ix]), baseInstance);
+			baseInstance += static_cast<GLuint>(counts[ix]);
+		}
+	}
+	glBindVertexArray(0);
 }
 
-TTK::Impl::MeshHelper::mesh TTK::Impl::MeshHelper::__MakeMesh(const float* data, size_t size) const {
-	mesh result;
+void TTK::Impl::MeshHelper::__MakeMesh(mesh& result, const float* data, size_t size) const {
+	result.VertexCount = static_cast<GLsizei>(size / (sizeof(float) * 6));
 	glCreateVertexArrays(1, &result.VAO);
 	glBindVertexArray(result.VAO);
 	glCreateBuffers(1, &result.VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, result.VBO);
-	glNamedBufferData(result.VBO, size, data, GL_DYNAMIC_DRAW);
+	glNamedBufferData(result.VBO, size, data, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(float) * 6, 0);
-	return result;
+
+	// The transform takes up 4 slots, one per column, followed by the color, and they all advance once per instance
+	glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+	for (GLuint col = 0; col < 4; col++) {
+		glEnableVertexAttribArray(1 + col);
+		glVertexAttribPointer(1 + col, 4, GL_FLOAT, false, sizeof(Instance), (void*)(offsetof(Instance, Transform) + sizeof(glm::vec4) * col));
+		glVertexAttribDivisor(1 + col, 1);
+	}
+	glEnableVertexAttribArray(5);
+	glVertexAttribPointer(5, 4, GL_FLOAT, false, sizeof(Instance), (void*)offsetof(Instance, Color));
+	glVertexAttribDivisor(5, 1);
 }
 
 TTK::Impl::MeshHelper::MeshHelper()
 {
-	m_Teapot = __MakeMesh(TeapotData, sizeof(TeapotData));
-	m_Sphere = __MakeMesh(SphereData, sizeof(SphereData));
-	m_Cube   = __MakeMesh(CubeData, sizeof(CubeData));
+	m_InstanceCapacity = 256 * sizeof(Instance);
+	glCreateBuffers(1, &m_InstanceVBO);
+	glNamedBufferData(m_InstanceVBO, m_InstanceCapacity, nullptr, GL_STREAM_DRAW);
+
+	__MakeMesh(m_Teapot, TeapotData, sizeof(TeapotData));
+	__MakeMesh(m_Sphere, SphereData, sizeof(SphereData));
+	__MakeMesh(m_Cube, CubeData, sizeof(CubeData));
 	
 	glBindVertexArray(0);
 	
 	const char* vsSource = R"LIT(#version 430
             layout (location = 0) in vec3 vertexPosition;
-            layout (location = 0) uniform mat4 xTransform;	
+            layout (location = 1) in mat4 instanceTransform;
+            layout (location = 5) in vec4 instanceColor;
+            layout (location = 0) uniform mat4 xViewProjection;
+            layout (location = 0) out vec4 fragmentColor;
             void main() {
-                gl_Position = xTransform * vec4(vertexPosition, 1);
+                gl_Position = xViewProjection * instanceTransform * vec4(vertexPosition, 1);
+                fragmentColor = instanceColor;
             })LIT";
 
 	const char* fsSource = R"LIT(#version 430   
-            layout (location = 1) uniform vec4 xColor;		
+            layout (location = 0) in vec4 fragColor;
             out vec4 frag_color;            	
             void main() {
-                frag_color = xColor;
+                frag_color = fragColor;
             })LIT";
 
 	m_Shader = glCreateProgram();
@@ -0,0 +1,397 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is a part of the Tutorial Tool Kit (TTK) library.
+// You may not use this file in your GDW games.
+//
+// This file implements the TTK sprite batch
+//
+// Shawn Matthews - 2019
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "TTK/SpriteBatch.h"
+#include <algorithm>
+#include <numeric>
+#include "stb_image.h"
+#include "Logging.h"
+
+TTK::SpriteBatch::SpriteBatch(int atlasSize)
+{
+	m_AtlasSize = atlasSize;
+	m_InstanceCapacity = 256 * sizeof(Instance);
+
+	// The quad corners come from gl_VertexID, so the only vertex data is the per sprite instance data
+	glCreateVertexArrays(1, &m_VAO);
+	glBindVertexArray(m_VAO);
+	glCreateBuffers(1, &m_InstanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+	glNamedBufferData(m_InstanceVBO, m_InstanceCapacity, nullptr, GL_STREAM_DRAW);
+	for (GLuint ix = 0; ix < 4; ix++) {
+		glEnableVertexAttribArray(ix);
+		glVertexAttribDivisor(ix, 1);
+	}
+	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Instance), (void*)offsetof(Instance, Position));
+	glVertexAttribPointer(1, 2, GL_FLOAT, false, sizeof(Instance), (void*)offsetof(Instance, Size));
+	glVertexAttribPointer(2, 4, GL_FLOAT, false, sizeof(Instance), (void*)offsetof(Instance, UvRect));
+	glVertexAttribPointer(3, 4, GL_FLOAT, false, sizeof(Instance), (void*)offsetof(Instance, Color));
+	glBindVertexArray(0);
+
+	const char* vsSource = R"LIT(#version 440
+            layout (location = 0) in vec3 instancePosition;
+            layout (location = 1) in vec2 instanceSize;
+            layout (location = 2) in vec4 instanceUvRect;
+            layout (location = 3) in vec4 instanceColor;
+            layout (location = 0) out vec4 fragmentColor;
+            layout (location = 1) out vec2 fragmentTexture;
+            layout (location = 0) uniform mat4 xViewProjection;
+            layout (location = 1) uniform vec3 xCameraRight;
+            layout (location = 2) uniform vec3 xCameraUp;
+            void main() {
+                // Corners of a triangle strip, starting at the bottom left
+                vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+                vec3 world = instancePosition +
+                    xCameraRight * ((corner.x - 0.5) * instanceSize.x) +
+                    xCameraUp * ((corner.y - 0.5) * instanceSize.y);
+                gl_Position = xViewProjection * vec4(world, 1);
+                fragmentColor = instanceColor;
+                fragmentTexture = mix(instanceUvRect.xw, instanceUvRect.zy, corner);
+            })LIT";
+
+	const char* fsSource = R"LIT(#version 440
+            layout(binding = 0) uniform sampler2D xSampler;
+            layout (location = 0) in vec4 fragColor;
+            layout (location = 1) in vec2 fragUv;
+            out vec4 frag_color;
+            void main() {
+                frag_color = texture(xSampler, fragUv) * fragColor;
+                if (frag_color.a < 0.01)
+                    discard;
+            })LIT";
+
+	m_Shader = glCreateProgram();
+
+	GLuint programs[2];
+	programs[0] = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(programs[0], 1, &vsSource, NULL);
+	glCompileShader(programs[0]);
+	programs[1] = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(programs[1], 1, &fsSource, NULL);
+	glCompileShader(programs[1]);
+
+	// Attach our two shaders
+	glAttachShader(m_Shader, programs[0]);
+	glAttachShader(m_Shader, programs[1]);
+
+	// Perform linking
+	glLinkProgram(m_Shader);
+
+	// Remove shader parts to save space
+	glDetachShader(m_Shader, programs[0]);
+	glDeleteShader(programs[0]);
+	glDetachShader(m_Shader, programs[1]);
+	glDeleteShader(programs[1]);
+}
+
+TTK::SpriteBatch::~SpriteBatch()
+{
+	for (auto& page : m_Pages)
+		glDeleteTextures(1, &page->Texture);
+	glDeleteBuffers(1, &m_InstanceVBO);
+	glDeleteVertexArrays(1, &m_VAO);
+	glDeleteProgram(m_Shader);
+}
+
+int TTK::SpriteBatch::AddSheet(const char* fileName, int numSpritesPerRow, int numRows, float animTime)
+{
+	int width, height, numChannels;
+	unsigned char* imageData = stbi_load(fileName, &width, &height, &numChannels, 4);
+	if (imageData == nullptr) {
+		LOG_ERROR("Failed to load sprite sheet from \"{}\"", fileName);
+		return -1;
+	}
+
+	const int spriteWidth = width / numSpritesPerRow;
+	const int spriteHeight = height / numRows;
+	const int frameCount = numSpritesPerRow * numRows;
+
+	// Each frame gets packed on its own, with its edges stretched out into the padding around it
+	const int paddedWidth = spriteWidth + FRAME_PADDING * 2;
+	const int paddedHeight = spriteHeight + FRAME_PADDING * 2;
+	if (paddedWidth > m_AtlasSize || paddedHeight > m_AtlasSize) {
+		LOG_ERROR("Sprite sheet \"{}\" has frames that are too big for the atlas ({}x{})", fileName, spriteWidth, spriteHeight);
+		stbi_image_free(imageData);
+		return -1;
+	}
+
+	// Every frame of a sheet goes on the same page, so that a sprite only ever draws from one atlas. If the sheet
+	// doesn't fit on the newest page, it gets a page of its own
+	std::vector<stbrp_rect> rects(frameCount);
+	for (int ix = 0; ix < frameCount; ix++) {
+		rects[ix].id = ix;
+		rects[ix].w = paddedWidth;
+		rects[ix].h = paddedHeight;
+	}
+	if (m_Pages.empty())
+		__AddPage();
+	if (!stbrp_pack_rects(&m_Pages.back()->Packer, rects.data(), frameCount)) {
+		Page* page = __AddPage();
+		if (!stbrp_pack_rects(&page->Packer, rects.data(), frameCount)) {
+			LOG_ERROR("Sprite sheet \"{}\" has too many frames to fit in one atlas", fileName);
+			stbi_image_free(imageData);
+			return -1;
+		}
+	}
+
+	Sheet sheet;
+	sheet.Page = static_cast<int>(m_Pages.size()) - 1;
+	sheet.FirstFrame = static_cast<uint32_t>(m_FrameUvs.size());
+	sheet.FrameCount = frameCount;
+	sheet.FrameRate = animTime == 0.0f ? 60.0f : frameCount / animTime;
+	Page& page = *m_Pages[sheet.Page];
+
+	std::vector<uint32_t> framePixels(static_cast<size_t>(paddedWidth) * paddedHeight);
+	const uint32_t* pixels = reinterpret_cast<const uint32_t*>(imageData);
+	const float atlasSize = static_cast<float>(m_AtlasSize);
+	for (int j = 0; j < numRows; j++) {
+		for (int i = 0; i < numSpritesPerRow; i++) {
+			const stbrp_rect& rect = rects[j * numSpritesPerRow + i];
+			for (int py = 0; py < paddedHeight; py++) {
+				const int srcY = j * spriteHeight + glm::clamp(py - FRAME_PADDING, 0, spriteHeight - 1);
+				for (int px = 0; px < paddedWidth; px++) {
+					const int srcX = i * spriteWidth + glm::clamp(px - FRAME_PADDING, 0, spriteWidth - 1);
+					framePixels[static_cast<size_t>(py) * paddedWidth + px] = pixels[static_cast<size_t>(srcY) * width + srcX];
+				}
+			}
+			glTextureSubImage2D(page.Texture, 0, rect.x, rect.y, paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, framePixels.data());
+
+			m_FrameUvs.push_back(glm::vec4(
+				(rect.x + FRAME_PADDING) / atlasSize, (rect.y + FRAME_PADDING) / atlasSize,
+				(rect.x + FRAME_PADDING + spriteWidth) / atlasSize, (rect.y + FRAME_PADDING + spriteHeight) / atlasSize));
+		}
+	}
+	page.MipsDirty = true;
+
+	stbi_image_free(imageData);
+	m_Sheets.push_back(sheet);
+	return static_cast<int>(m_Sheets.size()) - 1;
+}
+
+TTK::SpriteBatch::Page* TTK::SpriteBatch::__AddPage()
+{
+	// The packer keeps pointers into itself, so pages have to stay put in memory
+	m_Pages.push_back(std::make_unique<Page>());
+	Page* page = m_Pages.back().get();
+	page->Nodes.resize(m_AtlasSize);
+	stbrp_init_target(&page->Packer, m_AtlasSize, m_AtlasSize, page->Nodes.data(), m_AtlasSize);
+	page->MipsDirty = true;
+
+	int levels = 1;
+	while ((m_AtlasSize >> levels) >= 64)
+		levels++;
+	glCreateTextures(GL_TEXTURE_2D, 1, &page->Texture);
+	glTextureParameteri(page->Texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(page->Texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(page->Texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTextureParameteri(page->Texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureStorage2D(page->Texture, levels, GL_RGBA8, m_AtlasSize, m_AtlasSize);
+	const uint32_t clear = 0;
+	glClearTexImage(page->Texture, 0, GL_RGBA, GL_UNSIGNED_BYTE, &clear);
+	return page;
+}
+
+size_t TTK::SpriteBatch::__IndexOf(SpriteHandle sprite) const
+{
+	LOG_ASSERT(sprite < m_Slots.size() && m_Slots[sprite] != INVALID_SPRITE, "SpriteBatch.cpp Error! Sprite {} does not exist!", sprite);
+	return m_Slots[sprite];
+}
+
+TTK::SpriteBatch::SpriteHandle TTK::SpriteBatch::AddSprite(int sheet, const glm::vec3& position, const glm::vec2& size, const glm::vec4& color, bool looping)
+{
+	if (sheet < 0 || sheet >= static_cast<int>(m_Sheets.size())) {
+		LOG_ERROR("SpriteBatch.cpp Error! Sheet {} does not exist!", sheet);
+		return INVALID_SPRITE;
+	}
+	const Sheet& info = m_Sheets[sheet];
+
+	SpriteHandle handle;
+	if (!m_FreeHandles.empty()) {
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+	}
+	else {
+		handle = static_cast<SpriteHandle>(m_Slots.size());
+		m_Slots.push_back(INVALID_SPRITE);
+	}
+	m_Slots[handle] = static_cast<uint32_t>(m_Positions.size());
+
+	m_Positions.push_back(position);
+	m_Sizes.push_back(size);
+	m_Colors.push_back(color);
+	m_Times.push_back(0.0f);
+	m_FrameRates.push_back(info.FrameRate);
+	m_FrameCounts.push_back(static_cast<float>(info.FrameCount));
+	m_Looping.push_back(looping ? 1.0f : 0.0f);
+	m_FirstFrames.push_back(info.FirstFrame);
+	m_Frames.push_back(info.FirstFrame);
+	m_SpritePages.push_back(info.Page);
+	m_Handles.push_back(handle);
+	return handle;
+}
+
+void TTK::SpriteBatch::RemoveSprite(SpriteHandle sprite)
+{
+	// Move the last sprite into the hole, so the arrays stay tightly packed
+	const size_t index = __IndexOf(sprite);
+	const size_t last = m_Positions.size() - 1;
+	if (index != last) {
+		m_Positions[index] = m_Positions[last];
+		m_Sizes[index] = m_Sizes[last];
+		m_Colors[index] = m_Colors[last];
+		m_Times[index] = m_Times[last];
+		m_FrameRates[index] = m_FrameRates[last];
+		m_FrameCounts[index] = m_FrameCounts[last];
+		m_Looping[index] = m_Looping[last];
+		m_FirstFrames[index] = m_FirstFrames[last];
+		m_Frames[index] = m_Frames[last];
+		m_SpritePages[index] = m_SpritePages[last];
+		m_Handles[index] = m_Handles[last];
+		m_Slots[m_Handles[index]] = static_cast<uint32_t>(index);
+	}
+	m_Positions.pop_back();
+	m_Sizes.pop_back();
+	m_Colors.pop_back();
+	m_Times.pop_back();
+	m_FrameRates.pop_back();
+	m_FrameCounts.pop_back();
+	m_Looping.pop_back();
+	m_FirstFrames.pop_back();
+	m_Frames.pop_back();
+	m_SpritePages.pop_back();
+	m_Handles.pop_back();
+
+	m_Slots[sprite] = INVALID_SPRITE;
+	m_FreeHandles.push_back(sprite);
+}
+
+void TTK::SpriteBatch::SetPosition(SpriteHandle sprite, const glm::vec3& position) {
+	m_Positions[__IndexOf(sprite)] = position;
+}
+
+void TTK::SpriteBatch::SetSize(SpriteHandle sprite, const glm::vec2& size) {
+	m_Sizes[__IndexOf(sprite)] = size;
+}
+
+void TTK::SpriteBatch::SetColor(SpriteHandle sprite, const glm::vec4& color) {
+	m_Colors[__IndexOf(sprite)] = color;
+}
+
+void TTK::SpriteBatch::ResetAnimation(SpriteHandle sprite) {
+	const size_t index = __IndexOf(sprite);
+	m_Times[index] = 0.0f;
+	m_Frames[index] = m_FirstFrames[index];
+}
+
+bool TTK::SpriteBatch::IsFinished(SpriteHandle sprite) const {
+	const size_t index = __IndexOf(sprite);
+	return m_Looping[index] == 0.0f && m_Times[index] * m_FrameRates[index] >= m_FrameCounts[index];
+}
+
+void TTK::SpriteBatch::Update(float deltaTime)
+{
+	// No branches in here, so that the compiler can run it over several sprites at a time. Looping sprites wrap their
+	// time around so it never gets big enough to lose precision, the others stop on their last frame
+	const size_t count = m_Times.size();
+	float* times = m_Times.data();
+	const float* rates = m_FrameRates.data();
+	const float* frameCounts = m_FrameCounts.data();
+	const float* looping = m_Looping.data();
+	const uint32_t* firstFrames = m_FirstFrames.data();
+	uint32_t* frames = m_Frames.data();
+
+	for (size_t ix = 0; ix < count; ix++) {
+		const float frame = (times[ix] + deltaTime) * rates[ix];
+		const float wrapped = frame - glm::floor(frame / frameCounts[ix]) * frameCounts[ix];
+		const float clamped = glm::min(frame, frameCounts[ix] - 1.0f);
+		times[ix] = looping[ix] * (wrapped / rates[ix]) + (1.0f - looping[ix]) * (times[ix] + deltaTime);
+		frames[ix] = firstFrames[ix] + static_cast<uint32_t>(looping[ix] * wrapped + (1.0f - looping[ix]) * clamped);
+	}
+}
+
+void TTK::SpriteBatch::Draw(const glm::mat4& view, const glm::mat4& projection)
+{
+	const size_t count = m_Positions.size();
+	if (count == 0)
+		return;
+
+	// Sort by atlas page first, then from furthest to nearest within each page
+	m_Depths.resize(count);
+	for (size_t ix = 0; ix < count; ix++) {
+		const glm::vec3& p = m_Positions[ix];
+		m_Depths[ix] = view[0][2] * p.x + view[1][2] * p.y + view[2][2] * p.z + view[3][2];
+	}
+	m_DrawOrder.resize(count);
+	std::iota(m_DrawOrder.begin(), m_DrawOrder.end(), 0);
+	std::sort(m_DrawOrder.begin(), m_DrawOrder.end(), [&](uint32_t a, uint32_t b) {
+		if (m_SpritePages[a] != m_SpritePages[b])
+			return m_SpritePages[a] < m_SpritePages[b];
+		return m_Depths[a] < m_Depths[b];
+	});
+
+	m_InstanceData.resize(count);
+	for (size_t ix = 0; ix < count; ix++) {
+		const uint32_t sprite = m_DrawOrder[ix];
+		Instance& instance = m_InstanceData[ix];
+		instance.Position = m_Positions[sprite];
+		instance.Size = m_Sizes[sprite];
+		instance.UvRect = m_FrameUvs[m_Frames[sprite]];
+		instance.Color = m_Colors[sprite];
+	}
+
+	const size_t size = count * sizeof(Instance);
+	if (size > m_InstanceCapacity)
+		m_InstanceCapacity = glm::max(size, m_InstanceCapacity * 2);
+	glNamedBufferData(m_InstanceVBO, m_InstanceCapacity, nullptr, GL_STREAM_DRAW);
+	glNamedBufferSubData(m_InstanceVBO, 0, size, m_InstanceData.data());
+
+	int currentProgram, currentVAO;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &currentVAO);
+	bool blendState = glIsEnabled(GL_BLEND);
+	GLboolean depthMaskEnabled = false;
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMaskEnabled);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+
+	const glm::mat4 viewProjection = projection * view;
+	const glm::vec3 right = glm::vec3(view[0][0], view[1][0], view[2][0]);
+	const glm::vec3 up = glm::vec3(view[0][1], view[1][1], view[2][1]);
+	glUseProgram(m_Shader);
+	glProgramUniformMatrix4fv(m_Shader, 0, 1, false, &viewProjection[0][0]);
+	glProgramUniform3fv(m_Shader, 1, 1, &right.x);
+	glProgramUniform3fv(m_Shader, 2, 1, &up.x);
+	glBindVertexArray(m_VAO);
+
+	// One draw for each run of sprites on the same page
+	size_t first = 0;
+	while (first < count) {
+		const int page = m_SpritePages[m_DrawOrder[first]];
+		size_t last = first + 1;
+		while (last < count && m_SpritePages[m_DrawOrder[last]] == page)
+			last++;
+
+		if (m_Pages[page]->MipsDirty) {
+			glGenerateTextureMipmap(m_Pages[page]->Texture);
+			m_Pages[page]->MipsDirty = false;
+		}
+		glBindTextureUnit(0, m_Pages[page]->Texture);
+		glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(last - first), static_cast<GLuint>(first));
+		first = last;
+	}
+
+	glBindTextureUnit(0, 0);
+	glBindVertexArray(currentVAO);
+	glUseProgram(currentProgram);
+	if (!blendState) glDisable(GL_BLEND);
+	glDepthMask(depthMaskEnabled);
+}
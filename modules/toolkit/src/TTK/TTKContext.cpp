@@ -12,6 +12,7 @@
 
 #include "TTK/TTKContext.h"
 #include <GLM/gtc/matrix_transform.hpp>
+#include <chrono>
 #include <string>
 #include "Logging.h"
 #include "TTK/MeshHelper.h"
@@ -45,64 +46,77 @@ void TTK::Context::RenderText(const char* text, const glm::vec2& position, const
 	TTK::FontRenderer::Instance().Render(*m_DefaultFont, text, position, color, scale);
 }
 
-void TTK::Context::DrawTeapot(const glm::mat4& mat, const glm::vec4& color) const {
-	m_MeshHelper->RenderTeapot(mat, color);
+void TTK::Context::DrawTeapot(const glm::mat4& mat, const glm::vec4& color, float duration) {
+	m_MeshHelper->RenderTeapot(mat, color, duration, __Now());
 }
 
-void TTK::Context::DrawSphere(const glm::mat4& mat, const glm::vec4& color) const {
-	m_MeshHelper->RenderSphere(mat, color);
+void TTK::Context::DrawSphere(const glm::mat4& mat, const glm::vec4& color, float duration) {
+	m_MeshHelper->RenderSphere(mat, color, duration, __Now());
 }
 
-void TTK::Context::DrawCube(const glm::mat4& mat, const glm::vec4& color) const {
-	m_MeshHelper->RenderCube(mat, color);
+void TTK::Context::DrawCube(const glm::mat4& mat, const glm::vec4& color, float duration) {
+	m_MeshHelper->RenderCube(mat, color, duration, __Now());
 }
 
-void TTK::Context::AddLine(const glm::vec3& a, const glm::vec3& b, const glm::vec4& color) {
-	m_LineVerts[m_Lines.Count + 0].Position = a;
-	m_LineVerts[m_Lines.Count + 0].Color = color;
-	m_LineVerts[m_Lines.Count + 1].Position = b;
-	m_LineVerts[m_Lines.Count + 1].Color = color;
-	m_Lines.Count += 2;
-	if (m_Lines.Count == MaxLineVerts) {
-		__Flush(m_Lines);
-	}
+void TTK::Context::AddLine(const glm::vec3& a, const glm::vec3& b, const glm::vec4& color, float duration) {
+	Line line;
+	line.Verts[0].Position = a;
+	line.Verts[0].Color = color;
+	line.Verts[1].Position = b;
+	line.Verts[1].Color = color;
+	m_LineBatch.Add(line, duration, __Now());
 }
 
-void TTK::Context::AddTri(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec4& color) {
-	m_TriVerts[m_Tris.Count + 0].Position = a;
-	m_TriVerts[m_Tris.Count + 0].Color = color;
-	m_TriVerts[m_Tris.Count + 1].Position = b;
-	m_TriVerts[m_Tris.Count + 1].Color = color;
-	m_TriVerts[m_Tris.Count + 2].Position = c;
-	m_TriVerts[m_Tris.Count + 2].Color = color;
-	m_Tris.Count += 3;
-	if (m_Tris.Count == MaxTriVerts) {
-		__Flush(m_Tris);
-	}
+void TTK::Context::AddTri(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec4& color, float duration) {
+	Tri tri;
+	tri.Verts[0].Position = a;
+	tri.Verts[0].Color = color;
+	tri.Verts[1].Position = b;
+	tri.Verts[1].Color = color;
+	tri.Verts[2].Position = c;
+	tri.Verts[2].Color = color;
+	m_TriBatch.Add(tri, duration, __Now());
 }
 
-void TTK::Context::AddQuad(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color) {
+void TTK::Context::AddQuad(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color, float duration) {
 	glm::vec3 minXmaxY = { min.x, max.y, min.z };
 	glm::vec3 maxXminY = { max.x, min.y, min.z };
-	AddTri(min, maxXminY, minXmaxY, color);
-	AddTri(maxXminY, max, minXmaxY, color);
+	AddTri(min, maxXminY, minXmaxY, color, duration);
+	AddTri(maxXminY, max, minXmaxY, color, duration);
 }
 
-void TTK::Context::AddPoint(const glm::vec3& pos, float size, const glm::vec4& color)
+void TTK::Context::AddPoint(const glm::vec3& pos, float size, const glm::vec4& color, float duration)
 {
-	m_PointVerts[m_Points.Count].Position = pos;
-	m_PointVerts[m_Points.Count].Color = color;
-	m_PointVerts[m_Points.Count].Size = size;
-	m_Points.Count += 1;
-	if (m_Points.Count == MaxPointVerts) {
-		__Flush(m_Points);
-	}
+	PointVert point;
+	point.Position = pos;
+	point.Color = color;
+	point.Size = size;
+	m_PointBatch.Add(point, duration, __Now());
 }
 
 void TTK::Context::Flush() {
-	__Flush(m_Tris);
-	__Flush(m_Lines);
-	__Flush(m_Points);
+	const double now = __Now();
+
+	m_MeshHelper->Flush(m_ViewProjection, now);
+
+	const std::vector<Tri>& tris = m_TriBatch.Gather(now);
+	__Flush(m_Tris, tris.data(), tris.size() * 3, sizeof(SimpleVert));
+	m_TriBatch.Clear();
+
+	const std::vector<Line>& lines = m_LineBatch.Gather(now);
+	__Flush(m_Lines, lines.data(), lines.size() * 2, sizeof(SimpleVert));
+	m_LineBatch.Clear();
+
+	const std::vector<PointVert>& points = m_PointBatch.Gather(now);
+	__Flush(m_Points, points.data(), points.size(), sizeof(PointVert));
+	m_PointBatch.Clear();
+
+	// Text goes last so that it ends up on top
+	TTK::FontRenderer::Instance().Flush();
+}
+
+double TTK::Context::__Now() const {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 TTK::Context::Context() {
@@ -148,19 +162,19 @@ TTK::Context::Context() {
 	m_PointShaderHandle = __CompileShader(vsSourcePoint, fsSource);
 
 
-	m_Tris = __InitBuff(GL_TRIANGLES, m_ShaderHandle, m_TriVerts, sizeof(SimpleVert), MaxTriVerts);
+	m_Tris = __InitBuff(GL_TRIANGLES, m_ShaderHandle, sizeof(SimpleVert), 512 * 3);
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Position));
 	glVertexAttribPointer(1, 4, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Color));
 
-	m_Lines = __InitBuff(GL_LINES, m_ShaderHandle, m_LineVerts, sizeof(SimpleVert), MaxLineVerts);
+	m_Lines = __InitBuff(GL_LINES, m_ShaderHandle, sizeof(SimpleVert), 512 * 2);
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Position));
 	glVertexAttribPointer(1, 4, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Color));
 
-	m_Points = __InitBuff(GL_POINTS, m_PointShaderHandle, m_PointVerts, sizeof(PointVert), MaxLineVerts);
+	m_Points = __InitBuff(GL_POINTS, m_PointShaderHandle, sizeof(PointVert), 512);
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
 	glEnableVertexAttribArray(2);
@@ -177,32 +191,36 @@ TTK::Context::Context() {
 	glEnable(GL_PROGRAM_POINT_SIZE);
 }
 
-TTK::Context::GLBuff TTK::Context::__InitBuff(GLenum mode, GLuint shader, void* dataSource, size_t elemSize, size_t maxElems)
+TTK::Context::GLBuff TTK::Context::__InitBuff(GLenum mode, GLuint shader, size_t elemSize, size_t initialElems)
 {
 	GLBuff result;
 	result.Mode = mode;
-	result.Count = 0;
-	result.Data = dataSource;
-	result.ElemSize = elemSize;
+	result.Capacity = elemSize * initialElems;
 	result.Shader = shader;
 
 	glCreateVertexArrays(1, &result.VAO);
 	glBindVertexArray(result.VAO);
 	glCreateBuffers(1, &result.VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, result.VBO);
-	glNamedBufferData(result.VBO, elemSize * maxElems, nullptr, GL_STREAM_DRAW);
+	glNamedBufferData(result.VBO, result.Capacity, nullptr, GL_STREAM_DRAW);
 
 	return result;
 }
 
-void TTK::Context::__Flush(GLBuff& buff) {
-	if (buff.Count > 0) {
+void TTK::Context::__Flush(GLBuff& buff, const void* data, size_t vertCount, size_t vertSize) {
+	if (vertCount > 0) {
+		// Grow the buffer when a frame has more than it can hold, otherwise orphan it so we don't have to wait on the
+		// GPU to finish drawing last frame's vertices
+		const size_t size = vertCount * vertSize;
+		if (size > buff.Capacity)
+			buff.Capacity = glm::max(size, buff.Capacity * 2);
+		glNamedBufferData(buff.VBO, buff.Capacity, nullptr, GL_STREAM_DRAW);
+		glNamedBufferSubData(buff.VBO, 0, size, data);
+
 		glUseProgram(buff.Shader);
 		glUniformMatrix4fv(0, 1, false, &m_ViewProjection[0][0]);
-		glNamedBufferSubData(buff.VBO, 0, buff.Count * buff.ElemSize, buff.Data);
 		glBindVertexArray(buff.VAO);
-		glDrawArrays(buff.Mode, 0, static_cast<GLsizei>(buff.Count));
-		buff.Count = 0;
+		glDrawArrays(buff.Mode, 0, static_cast<GLsizei>(vertCount));
 	}
 }
 
@@ -0,0 +1,68 @@
+#version 420
+
+layout(location = 0) in vec2 inUV;
+
+out vec4 frag_color;
+
+//The full resolution image, and the low resolution effect's premultiplied layer
+layout (binding = 0) uniform sampler2D s_screenTex;
+layout (binding = 1) uniform sampler2D s_layerTex;
+//The min and max linear depth under each layer pixel, and the scene's full resolution depth buffer
+layout (binding = 2) uniform sampler2D s_lowDepthTex;
+layout (binding = 3) uniform sampler2D s_depthTex;
+
+//s_screenTex's UVs come in scaled by u_UvScale, the others need their own scales
+uniform vec2 u_UvScale = vec2(1.0);
+uniform vec2 u_LayerSize;
+uniform vec2 u_DepthUvScale = vec2(1.0);
+uniform float u_NearPlane = 0.1;
+uniform float u_FarPlane = 1000.0;
+uniform float u_DepthSharpness = 20.0;
+
+float Linearize(float depth)
+{
+	float z = depth * 2.0 - 1.0;
+	return (2.0 * u_NearPlane * u_FarPlane) / (u_FarPlane + u_NearPlane - z * (u_FarPlane - u_NearPlane));
+}
+
+void main() 
+{
+	vec2 uv = inUV / u_UvScale;
+	float depth = Linearize(texture(s_depthTex, uv * u_DepthUvScale).r);
+
+	//Blend the 4 layer pixels around us like bilinear filtering would, but fade out ones whose depth range doesn't
+	//cover ours (relative to our depth, so distant objects aren't held to a tighter standard than near ones)
+	vec2 position = uv * u_LayerSize - 0.5;
+	ivec2 base = ivec2(floor(position));
+	vec2 f = position - vec2(base);
+	ivec2 maxTexel = ivec2(u_LayerSize) - 1;
+
+	vec4 sum = vec4(0.0);
+	float totalWeight = 0.0;
+	vec4 closest = vec4(0.0);
+	float closestError = 1e20;
+	for (int i = 0; i < 4; i++)
+	{
+		ivec2 offset = ivec2(i & 1, i >> 1);
+		ivec2 texel = clamp(base + offset, ivec2(0), maxTexel);
+		vec4 texelLayer = texelFetch(s_layerTex, texel, 0);
+		vec2 range = texelFetch(s_lowDepthTex, texel, 0).rg;
+
+		float depthError = max(max(range.x - depth, depth - range.y), 0.0) / depth;
+		vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+		float weight = bilinear.x * bilinear.y * exp(-depthError * u_DepthSharpness);
+		sum += texelLayer * weight;
+		totalWeight += weight;
+
+		//If none of them are close, fall back to whichever is closest in depth
+		if (depthError < closestError)
+		{
+			closestError = depthError;
+			closest = texelLayer;
+		}
+	}
+	vec4 layer = totalWeight > 1e-4 ? sum / totalWeight : closest;
+
+	vec4 source = texture(s_screenTex, inUV);
+	frag_color = vec4(source.rgb * (1.0 - layer.a) + layer.rgb, source.a);
+}
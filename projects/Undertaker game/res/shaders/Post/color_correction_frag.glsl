@@ -7,13 +7,19 @@ out vec4 frag_color;
 layout (binding = 0) uniform sampler2D u_FinishedFrame;
 layout (binding = 30) uniform sampler3D u_TexColorGrade;
 
+//The number of entries along each axis of the LUT, and the range of colors it covers
+uniform float u_LutSize = 64.0;
+uniform vec3 u_DomainMin = vec3(0.0);
+uniform vec3 u_DomainMax = vec3(1.0);
+
 void main()
 {
 	vec4 textureColor = texture(u_FinishedFrame, inUV);
 
-	vec3 scale = vec3((64.0 - 1.0) / 64.0);
-	vec3 offset = vec3(1.0 / (2.0 * 64.0));
+	vec3 scale = vec3((u_LutSize - 1.0) / u_LutSize);
+	vec3 offset = vec3(1.0 / (2.0 * u_LutSize));
+	vec3 coords = clamp((textureColor.rgb - u_DomainMin) / (u_DomainMax - u_DomainMin), 0.0, 1.0);
 
-	frag_color.rgb = texture(u_TexColorGrade, scale * textureColor.rgb + offset).rgb;
+	frag_color.rgb = texture(u_TexColorGrade, scale * coords + offset).rgb;
 	frag_color.a = textureColor.a;
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+//Fusable version of color_correction_frag.glsl
+//$ is replaced with a unique prefix when this is fused into a post processing chain
+
+uniform sampler3D $Lut;
+
+//The number of entries along each axis of the LUT, and the range of colors it covers
+uniform float $LutSize = 64.0;
+uniform vec3 $DomainMin = vec3(0.0);
+uniform vec3 $DomainMax = vec3(1.0);
+
+//How much of the graded color to use
+uniform float $Intensity = 1.0;
+
+vec4 $Apply(vec4 source)
+{
+	vec3 scale = vec3(($LutSize - 1.0) / $LutSize);
+	vec3 offset = vec3(1.0 / (2.0 * $LutSize));
+	vec3 coords = clamp((source.rgb - $DomainMin) / ($DomainMax - $DomainMin), 0.0, 1.0);
+
+	vec3 graded = texture($Lut, scale * coords + offset).rgb;
+	return vec4(mix(source.rgb, graded, $Intensity), source.a);
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 420
+
+layout(location = 0) in vec2 inUV;
+
+out vec4 frag_color;
+
+layout (binding = 0) uniform sampler2D s_screenTex;
+
+void main() 
+{
+	//Our targets use nearest filtering, so each tap picks up one texel of the 2x2 block around our UVs
+	vec2 offset = 0.5 / vec2(textureSize(s_screenTex, 0));
+	frag_color = (texture(s_screenTex, inUV + vec2(-offset.x, -offset.y)) +
+		texture(s_screenTex, inUV + vec2(offset.x, -offset.y)) +
+		texture(s_screenTex, inUV + vec2(-offset.x, offset.y)) +
+		texture(s_screenTex, inUV + vec2(offset.x, offset.y))) * 0.25;
+}
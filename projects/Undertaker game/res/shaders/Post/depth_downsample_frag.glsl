@@ -0,0 +1,39 @@
+#version 420
+
+layout(location = 0) in vec2 inUV;
+
+out vec2 frag_minmax;
+
+//Either the scene's depth buffer, or the previous level of the chain
+layout (binding = 0) uniform sampler2D s_depthTex;
+
+//The first level reads the depth buffer and makes it linear, later levels read min/max pairs
+uniform bool u_FromDepthBuffer = false;
+uniform float u_NearPlane = 0.1;
+uniform float u_FarPlane = 1000.0;
+
+//Turns a depth buffer value back into the distance from the camera
+vec4 Linearize(vec4 depth)
+{
+	vec4 z = depth * 2.0 - 1.0;
+	return (2.0 * u_NearPlane * u_FarPlane) / (u_FarPlane + u_NearPlane - z * (u_FarPlane - u_NearPlane));
+}
+
+void main() 
+{
+	//Our UVs land on the corner between the 2x2 block of texels under this pixel, so gather grabs all 4 of them
+	vec4 mins;
+	vec4 maxs;
+	if (u_FromDepthBuffer)
+	{
+		mins = Linearize(textureGather(s_depthTex, inUV, 0));
+		maxs = mins;
+	}
+	else
+	{
+		mins = textureGather(s_depthTex, inUV, 0);
+		maxs = textureGather(s_depthTex, inUV, 1);
+	}
+
+	frag_minmax = vec2(min(min(mins.x, mins.y), min(mins.z, mins.w)), max(max(maxs.x, maxs.y), max(maxs.z, maxs.w)));
+}
@@ -0,0 +1,24 @@
+#version 420
+
+layout(location = 0) in vec2 inUV;
+
+out vec4 frag_color;
+
+layout (binding = 0) uniform sampler2D s_screenTex;
+//The min and max linear depth under each pixel, bound by the post process chain
+layout (binding = 1) uniform sampler2D s_depthTex;
+
+uniform vec3 u_Color = vec3(0.5);
+//How thick the fog is, and how far from the camera it starts
+uniform float u_Density = 0.05;
+uniform float u_Start = 5.0;
+
+void main() 
+{
+	vec2 range = texture(s_depthTex, inUV).rg;
+	float depth = (range.x + range.y) * 0.5;
+
+	//Exponential fog, drawn as a premultiplied layer over the scene
+	float amount = 1.0 - exp(-u_Density * max(depth - u_Start, 0.0));
+	frag_color = vec4(u_Color * amount, amount);
+}
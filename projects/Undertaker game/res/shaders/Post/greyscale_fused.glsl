@@ -0,0 +1,13 @@
+//Fusable version of greyscale_frag.glsl
+//$ is replaced with a unique prefix when this is fused into a post processing chain
+
+//Affects how greyscale
+//Lower the number, closer we are to regular
+uniform float $Intensity = 1.0;
+
+vec4 $Apply(vec4 source)
+{
+	float luminence = 0.2989 * source.r + 0.587 * source.g + 0.114 * source.b;
+
+	return vec4(mix(source.rgb, vec3(luminence), $Intensity), source.a);
+}
\ No newline at end of file
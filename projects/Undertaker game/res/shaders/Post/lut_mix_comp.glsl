@@ -0,0 +1,45 @@
+#version 430
+
+//Blends up to MAX_SOURCES LUTs into a single LUT, one invocation per output texel
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+layout(binding = 0, rgba16f) uniform writeonly image3D u_Output;
+
+#define MAX_SOURCES 8
+
+uniform sampler3D u_Sources[MAX_SOURCES];
+uniform float u_Weights[MAX_SOURCES];
+uniform float u_SourceSizes[MAX_SOURCES];
+uniform vec3 u_DomainMins[MAX_SOURCES];
+uniform vec3 u_DomainMaxs[MAX_SOURCES];
+uniform int u_SourceCount;
+
+void main()
+{
+	ivec3 texel = ivec3(gl_GlobalInvocationID);
+	ivec3 size = imageSize(u_Output);
+	if (any(greaterThanEqual(texel, size)))
+		return;
+
+	//The color this texel of the output maps
+	vec3 color = vec3(texel) / vec3(size - 1);
+
+	//Weights that add up to less than 1 leave some of the original color, more than 1 get normalized
+	float total = 0.0;
+	for (int i = 0; i < u_SourceCount; i++)
+		total += u_Weights[i];
+	float scale = total > 1.0 ? 1.0 / total : 1.0;
+
+	vec3 result = color * (1.0 - min(total, 1.0));
+	for (int i = 0; i < u_SourceCount; i++)
+	{
+		if (u_Weights[i] <= 0.0)
+			continue;
+
+		vec3 coords = clamp((color - u_DomainMins[i]) / (u_DomainMaxs[i] - u_DomainMins[i]), 0.0, 1.0);
+		vec3 uv = coords * ((u_SourceSizes[i] - 1.0) / u_SourceSizes[i]) + 0.5 / u_SourceSizes[i];
+		result += texture(u_Sources[i], uv).rgb * u_Weights[i] * scale;
+	}
+
+	imageStore(u_Output, texel, vec4(result, 1.0));
+}
\ No newline at end of file
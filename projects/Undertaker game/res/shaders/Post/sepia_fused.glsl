@@ -0,0 +1,16 @@
+//Fusable version of sepia_frag.glsl
+//$ is replaced with a unique prefix when this is fused into a post processing chain
+
+//Intensity of the sepia effect
+//Lower the number, closer to regular color
+uniform float $Intensity = 0.6;
+
+vec4 $Apply(vec4 source)
+{
+	vec3 sepiaColor;
+	sepiaColor.r = ((source.r * 0.393) + (source.g * 0.769) + (source.b * 0.189));
+	sepiaColor.g = ((source.r * 0.349) + (source.g * 0.686) + (source.b * 0.168));
+	sepiaColor.b = ((source.r * 0.272) + (source.g * 0.534) + (source.b * 0.131));
+
+	return vec4(mix(source.rgb, sepiaColor.rgb, $Intensity), source.a);
+}
\ No newline at end of file
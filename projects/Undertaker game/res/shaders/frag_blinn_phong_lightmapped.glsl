@@ -0,0 +1,106 @@
+#version 410
+
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 inNormal;
+layout(location = 3) in vec2 inUV;
+layout(location = 4) in vec2 inLightmapUV;
+
+uniform sampler2D s_Diffuse;
+uniform sampler2D s_Diffuse2;
+uniform sampler2D s_Specular;
+// Baked sun, sky and bounce lighting in RGB, ambient occlusion in A
+uniform sampler2D s_Lightmap;
+
+uniform vec3  u_LightPos;
+uniform vec3  u_LightCol;
+uniform float u_AmbientLightStrength;
+uniform float u_SpecularLightStrength;
+uniform float u_Shininess;
+uniform float u_LightAttenuationConstant;
+uniform float u_LightAttenuationLinear;
+uniform float u_LightAttenuationQuadratic;
+
+uniform float u_TextureMix;
+
+uniform vec3  u_CamPos;
+
+out vec4 frag_color;
+
+uniform bool u_Option1;
+uniform bool u_Option2;
+uniform bool u_Option3;
+uniform bool u_Option4;
+uniform bool u_Option5;
+
+// Toon Shading //
+const int bands = 5;
+const float scaleFactor = 1.0/bands;
+
+// frag_blinn_phong_textured.glsl for static geometry. The fixed ambient term is replaced with the baked lighting, and
+// only the light that moves with the player is still calculated per pixel
+void main() {
+	// Stands in for the fixed ambient term, the bake already includes the sky and is darker wherever it's occluded
+	vec3 baked = texture(s_Lightmap, inLightmapUV).rgb;
+	vec3 ambient = u_AmbientLightStrength * u_LightCol;
+
+	// Diffuse
+	vec3 N = normalize(inNormal);
+	vec3 lightDir = normalize(u_LightPos - inPos);
+
+	float dif = max(dot(N, lightDir), 0.0);
+	vec3 diffuse = dif * u_LightCol;
+
+	//Attenuation
+	float dist = length(u_LightPos - inPos);
+	float attenuation = 1.0f / (
+		u_LightAttenuationConstant + 
+		u_LightAttenuationLinear * dist +
+		u_LightAttenuationQuadratic * dist * dist);
+
+	// Specular
+	vec3 viewDir  = normalize(u_CamPos - inPos);
+	vec3 h        = normalize(lightDir + viewDir);
+
+	float texSpec = texture(s_Specular, inUV).x;
+	float spec = pow(max(dot(N, h), 0.0), u_Shininess);
+	vec3 specular = u_SpecularLightStrength * texSpec * spec * u_LightCol;
+
+	vec4 textureColor1 = texture(s_Diffuse, inUV);
+	vec4 textureColor2 = texture(s_Diffuse2, inUV);
+	vec4 textureColor = mix(textureColor1, textureColor2, u_TextureMix);
+
+	// Toon Shading - Outline Effect
+	float edge = (dot(viewDir, N) < 0.4) ? 0.0 : 1.0;
+
+	vec3 result = vec3(0.0);
+	//Debug Toggles
+	//No Lighting
+	if(u_Option1 == true)
+	{
+		result = inColor * textureColor.rgb;
+	}
+	//Ambient Only
+	else if(u_Option2 == true)
+	{
+		result = (baked + (ambient * attenuation)) * inColor * textureColor.rgb;
+	}
+	//Specular Only
+	else if(u_Option3 == true)
+	{
+		result = specular * attenuation * inColor * textureColor.rgb;
+	}
+	//Ambient + Specular
+	else if(u_Option4 == true)
+	{
+		result = (baked + (ambient + diffuse + specular) * attenuation) * inColor * textureColor.rgb;
+	}
+	//Custom Lighting
+	else if(u_Option5 == true)
+	{
+		diffuse = floor(diffuse * bands) * scaleFactor;
+		result = baked + (ambient + diffuse + specular) * edge * inColor * textureColor.rgb;
+	}
+
+	frag_color = vec4(result, textureColor.a);
+}
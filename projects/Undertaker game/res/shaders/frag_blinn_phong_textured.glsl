@@ -4,14 +4,13 @@ layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
+// The ambient light from the irradiance volume, or our flat ambient color if there isn't one
+layout(location = 4) in vec3 inAmbient;
 
 uniform sampler2D s_Diffuse;
 uniform sampler2D s_Diffuse2;
 uniform sampler2D s_Specular;
 
-uniform vec3  u_AmbientCol;
-uniform float u_AmbientStrength;
-
 uniform vec3  u_LightPos;
 uniform vec3 u_LightMix;
 uniform vec3  u_LightCol;
@@ -87,7 +86,7 @@ void main() {
 		//Ambient Only
 		else if(u_Option2 == true)
 		{
-			result = ((u_AmbientCol * u_AmbientStrength) + (ambient  * attenuation)) * inColor * textureColor.rgb;
+			result = (inAmbient + (ambient  * attenuation)) * inColor * textureColor.rgb;
 		}
 		//Specular Only
 		else if(u_Option3 == true)
@@ -97,14 +96,14 @@ void main() {
 		//Ambient + Specular
 		else if(u_Option4 == true)
 		{
-			result = ((u_AmbientCol * u_AmbientStrength) + (ambient + diffuse + specular) * attenuation) * inColor * textureColor.rgb;
+			result = (inAmbient + (ambient + diffuse + specular) * attenuation) * inColor * textureColor.rgb;
 		}
 		//Custom Lighting
 		else if(u_Option5 == true)
 		{
 			diffuse = floor(diffuse * bands) * scaleFactor;
 			
-			result = (u_AmbientCol * u_AmbientStrength) + (ambient + diffuse + specular) * edge * inColor * textureColor.rgb;
+			result = inAmbient + (ambient + diffuse + specular) * edge * inColor * textureColor.rgb;
 		}
 
 	frag_color = vec4(result, textureColor.a);
@@ -0,0 +1,125 @@
+#version 410
+
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in vec2 inFrameUV[3];
+layout(location = 4) flat in vec2 inFrame[3];
+layout(location = 7) flat in vec3 inWeights;
+layout(location = 8) flat in mat3 inRotation;
+layout(location = 11) flat in vec3 inToCamera;
+layout(location = 12) flat in float inRadius;
+layout(location = 13) flat in vec3 inAmbient;
+
+// Albedo and coverage, and model space normal and depth (see ImpostorAtlas)
+uniform sampler2D s_ImpostorAlbedo;
+uniform sampler2D s_ImpostorNormalDepth;
+uniform float u_FramesPerSide;
+// Half a texel of a frame, in frame UVs
+uniform float u_HalfTexel;
+
+uniform mat4  u_ViewProjection;
+
+uniform vec3  u_LightPos;
+uniform vec3  u_LightCol;
+uniform float u_AmbientLightStrength;
+uniform float u_SpecularLightStrength;
+uniform float u_Shininess = 8.0;
+uniform float u_LightAttenuationConstant;
+uniform float u_LightAttenuationLinear;
+uniform float u_LightAttenuationQuadratic;
+
+uniform vec3  u_CamPos;
+
+out vec4 frag_color;
+
+uniform bool u_Option1;
+uniform bool u_Option2;
+uniform bool u_Option3;
+uniform bool u_Option4;
+uniform bool u_Option5;
+
+// Toon Shading //
+const int bands = 5;
+const float scaleFactor = 1.0/bands;
+
+// The same lighting as frag_terrain.glsl, with the albedo and normal blended together from the impostor's frames
+void main() {
+	// The atlases are scaled by coverage, so blending them and then dividing by the blended coverage gives the
+	// coverage weighted average of the frames
+	vec4 albedo = vec4(0.0);
+	vec4 normalDepth = vec4(0.0);
+	for (int ix = 0; ix < 3; ix++) {
+		// Parts of the quad that project outside of a frame don't get anything from it, and everything else stays
+		// half a texel inside so we never filter in the neighbouring frame
+		vec2 uv = inFrameUV[ix];
+		float inside = step(0.0, uv.x) * step(uv.x, 1.0) * step(0.0, uv.y) * step(uv.y, 1.0);
+		vec2 atlasUV = (inFrame[ix] + clamp(uv, u_HalfTexel, 1.0 - u_HalfTexel)) / u_FramesPerSide;
+		float weight = inWeights[ix] * inside;
+		albedo += texture(s_ImpostorAlbedo, atlasUV) * weight;
+		normalDepth += texture(s_ImpostorNormalDepth, atlasUV) * weight;
+	}
+	if (albedo.a < 0.5) {
+		discard;
+	}
+	vec3 color = albedo.rgb / albedo.a;
+	vec3 N = normalize(inRotation * (normalDepth.rgb / albedo.a * 2.0 - 1.0));
+	float depth = normalDepth.a / albedo.a * 2.0 - 1.0;
+
+	// Push the fragment to where the surface actually is, so impostors cut into the ground and each other properly
+	vec3 worldPos = inPos + inToCamera * depth * inRadius;
+	vec4 clipPos = u_ViewProjection * vec4(worldPos, 1.0);
+	gl_FragDepth = (clipPos.z / clipPos.w) * 0.5 + 0.5;
+
+	vec3 ambient = u_AmbientLightStrength * u_LightCol;
+
+	// Diffuse
+	vec3 lightDir = normalize(u_LightPos - worldPos);
+	float dif = max(dot(N, lightDir), 0.0);
+	vec3 diffuse = dif * u_LightCol;
+
+	//Attenuation
+	float dist = length(u_LightPos - worldPos);
+	float attenuation = 1.0f / (
+		u_LightAttenuationConstant + 
+		u_LightAttenuationLinear * dist +
+		u_LightAttenuationQuadratic * dist * dist);
+
+	// Specular, there's no specular map in the atlas so it's the same everywhere
+	vec3 viewDir  = normalize(u_CamPos - worldPos);
+	vec3 h        = normalize(lightDir + viewDir);
+	float spec = pow(max(dot(N, h), 0.0), u_Shininess);
+	vec3 specular = u_SpecularLightStrength * spec * u_LightCol;
+
+	// Toon Shading - Outline Effect
+	float edge = (dot(viewDir, N) < 0.4) ? 0.0 : 1.0;
+
+	vec3 result = vec3(0.0);
+	//Debug Toggles
+	//No Lighting
+	if(u_Option1 == true)
+	{
+		result = color;
+	}
+	//Ambient Only
+	else if(u_Option2 == true)
+	{
+		result = (inAmbient + (ambient * attenuation)) * color;
+	}
+	//Specular Only
+	else if(u_Option3 == true)
+	{
+		result = specular * attenuation * color;
+	}
+	//Ambient + Specular
+	else if(u_Option4 == true)
+	{
+		result = (inAmbient + (ambient + diffuse + specular) * attenuation) * color;
+	}
+	//Custom Lighting
+	else if(u_Option5 == true)
+	{
+		diffuse = floor(diffuse * bands) * scaleFactor;
+		result = inAmbient + (ambient + diffuse + specular) * edge * color;
+	}
+
+	frag_color = vec4(result, 1.0);
+}
@@ -0,0 +1,28 @@
+#version 410
+
+// Model space, since impostors are baked with an identity model matrix
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 inNormal;
+layout(location = 3) in vec2 inUV;
+
+uniform sampler2D s_Diffuse;
+uniform int   u_HasDiffuse;
+
+// The bounding sphere the impostor is baked around, and the direction this frame is looking at it from
+uniform vec3  u_ImpostorCenter;
+uniform float u_ImpostorRadius;
+uniform vec3  u_FrameDir;
+
+layout(location = 0) out vec4 out_Albedo;
+layout(location = 1) out vec4 out_NormalDepth;
+
+// Lighting is left out, impostors are lit when they're drawn so they match the scene around them
+void main() {
+	vec3 albedo = u_HasDiffuse != 0 ? texture(s_Diffuse, inUV).rgb : vec3(1.0);
+	out_Albedo = vec4(albedo * inColor, 1.0);
+
+	// How far towards the viewer this point is, from -1 to 1 across the bounding sphere
+	float depth = dot(inPos - u_ImpostorCenter, u_FrameDir) / u_ImpostorRadius;
+	out_NormalDepth = vec4(normalize(inNormal) * 0.5 + 0.5, depth * 0.5 + 0.5);
+}
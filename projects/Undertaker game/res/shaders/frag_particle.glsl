@@ -0,0 +1,43 @@
+#version 410
+
+layout(location = 0) in vec2 inUV;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in float inViewDepth;
+
+out vec4 frag_color;
+
+// The scene's depth buffer, read at the same pixel we're drawing to
+uniform sampler2D s_Depth;
+uniform sampler2D s_Texture;
+uniform int u_HasTexture;
+
+uniform float u_NearPlane = 0.1;
+uniform float u_FarPlane = 1000.0;
+// How far in front of the scene particles start to fade out
+uniform float u_SoftDistance = 0.5;
+
+float Linearize(float depth)
+{
+	float z = depth * 2.0 - 1.0;
+	return (2.0 * u_NearPlane * u_FarPlane) / (u_FarPlane + u_NearPlane - z * (u_FarPlane - u_NearPlane));
+}
+
+void main() {
+	vec4 color = inColor;
+	if (u_HasTexture == 1) {
+		color *= texture(s_Texture, inUV);
+	} else {
+		// A soft round dot
+		float radius = length(inUV * 2.0 - 1.0);
+		color.a *= 1.0 - smoothstep(0.0, 1.0, radius);
+	}
+
+	// Fade out as we get close to whatever is behind us, so there are no hard edges where we cut into the scene
+	float sceneDepth = Linearize(texelFetch(s_Depth, ivec2(gl_FragCoord.xy), 0).r);
+	color.a *= clamp((sceneDepth - inViewDepth) / u_SoftDistance, 0.0, 1.0);
+
+	if (color.a < 0.004) {
+		discard;
+	}
+	frag_color = color;
+}
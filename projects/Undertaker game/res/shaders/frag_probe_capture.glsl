@@ -0,0 +1,22 @@
+#version 410
+
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 inNormal;
+layout(location = 3) in vec2 inUV;
+
+// A cheap stand in for the full lighting, used when rendering reflection probes
+uniform sampler2D s_Diffuse;
+
+uniform vec3 u_ProbeLightDir = vec3(0.3, 0.9, 0.3);
+uniform vec3 u_ProbeLightColor = vec3(0.7);
+uniform vec3 u_ProbeAmbient = vec3(0.35);
+
+out vec4 frag_color;
+
+void main() {
+	// Probe faces are tiny, so there's no point reading the top mips
+	vec3 albedo = texture(s_Diffuse, inUV, 2.0).rgb * inColor;
+	float diffuse = max(dot(normalize(inNormal), normalize(u_ProbeLightDir)), 0.0);
+	frag_color = vec4(albedo * (u_ProbeAmbient + u_ProbeLightColor * diffuse), 1.0);
+}
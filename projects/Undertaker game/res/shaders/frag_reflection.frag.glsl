@@ -5,14 +5,59 @@ layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
 
+// Prefiltered with GGX, each mip is rougher than the last
 uniform samplerCube s_Environment;
-uniform mat3 u_EnvironmentRotation;
+uniform mat3 u_EnvironmentRotation = mat3(1.0);
+// The mip holding the roughest reflections
+uniform float u_EnvironmentMaxLod;
+// Order 2 spherical harmonics, already convolved with the cosine lobe
+uniform vec3  u_IrradianceSH[9];
+
+// The two nearest reflection probes, blended by distance. When there are none, u_ProbeWeight is 0
+uniform samplerCube s_ProbeA;
+uniform samplerCube s_ProbeB;
+uniform float u_ProbeBlend;
+uniform float u_ProbeWeight = 0.0;
+uniform float u_ProbeMaxLod;
 
 uniform vec3  u_CamPos;
+uniform float u_Roughness = 0.2;
+uniform float u_Metallic = 1.0;
 
 out vec4 frag_color;
 
-// https://learnopengl.com/Advanced-Lighting/Advanced-Lighting
+vec3 EvaluateIrradiance(vec3 n) {
+	return max(
+		u_IrradianceSH[0] * 0.282095 +
+		u_IrradianceSH[1] * 0.488603 * n.y +
+		u_IrradianceSH[2] * 0.488603 * n.z +
+		u_IrradianceSH[3] * 0.488603 * n.x +
+		u_IrradianceSH[4] * 1.092548 * n.x * n.y +
+		u_IrradianceSH[5] * 1.092548 * n.y * n.z +
+		u_IrradianceSH[6] * 0.315392 * (3.0 * n.z * n.z - 1.0) +
+		u_IrradianceSH[7] * 1.092548 * n.x * n.z +
+		u_IrradianceSH[8] * 0.546274 * (n.x * n.x - n.y * n.y), 0.0);
+}
+
+// https://learnopengl.com/PBR/IBL/Specular-IBL
 void main() {
-	frag_color = vec4(1, 0, 0, 1.0);
-}
\ No newline at end of file
+	vec3 N = normalize(inNormal);
+	vec3 V = normalize(u_CamPos - inPos);
+	vec3 R = reflect(-V, N);
+
+	// The blur was done ahead of time, so a rough reflection is just a lookup into a smaller mip
+	vec3 specular = textureLod(s_Environment, u_EnvironmentRotation * R, u_Roughness * u_EnvironmentMaxLod).rgb;
+	if (u_ProbeWeight > 0.0) {
+		float probeLod = u_Roughness * u_ProbeMaxLod;
+		vec3 probe = mix(textureLod(s_ProbeA, R, probeLod).rgb, textureLod(s_ProbeB, R, probeLod).rgb, u_ProbeBlend);
+		specular = mix(specular, probe, u_ProbeWeight);
+	}
+	vec3 diffuse = EvaluateIrradiance(u_EnvironmentRotation * N) * inColor * (1.0 - u_Metallic);
+
+	// Schlick's fresnel, with the roughness keeping rough surfaces from getting bright rims
+	float NdotV = max(dot(N, V), 0.0);
+	vec3 F0 = mix(vec3(0.04), inColor, u_Metallic);
+	vec3 F = F0 + (max(vec3(1.0 - u_Roughness), F0) - F0) * pow(1.0 - NdotV, 5.0);
+
+	frag_color = vec4(diffuse * (1.0 - F) + specular * F, 1.0);
+}
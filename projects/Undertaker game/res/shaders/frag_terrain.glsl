@@ -0,0 +1,123 @@
+#version 410
+
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in vec2 inUV;
+layout(location = 2) in vec3 inAmbient;
+
+uniform sampler2D s_Heightmap;
+uniform vec2  u_HeightmapSize;
+uniform vec3  u_TerrainSize;
+
+// How much of each layer to use, one layer per channel
+uniform sampler2D      s_Splatmap;
+uniform sampler2DArray s_Layers;
+uniform int   u_LayerCount;
+uniform float u_LayerTiling;
+
+// Baked sun, sky and bounce lighting in RGB, ambient occlusion in A, laid over the same UVs as the heightmap
+uniform sampler2D s_Lightmap;
+uniform int   u_UseLightmap = 0;
+
+uniform vec3  u_LightPos;
+uniform vec3  u_LightCol;
+uniform float u_AmbientLightStrength;
+uniform float u_SpecularLightStrength;
+uniform float u_Shininess = 8.0;
+uniform float u_LightAttenuationConstant;
+uniform float u_LightAttenuationLinear;
+uniform float u_LightAttenuationQuadratic;
+
+uniform vec3  u_CamPos;
+
+out vec4 frag_color;
+
+uniform bool u_Option1;
+uniform bool u_Option2;
+uniform bool u_Option3;
+uniform bool u_Option4;
+uniform bool u_Option5;
+
+// Toon Shading //
+const int bands = 5;
+const float scaleFactor = 1.0/bands;
+
+float SampleHeight(vec2 uv) {
+	return textureLod(s_Heightmap, (uv * (u_HeightmapSize - 1.0) + 0.5) / u_HeightmapSize, 0.0).r * u_TerrainSize.y;
+}
+
+// The same lighting as frag_blinn_phong_lightmapped.glsl, but the normal comes from the heightmap, so it doesn't change
+// as chunks switch LODs, and the albedo is blended together from the splat map's layers
+void main() {
+	// Central differences across one sample of the heightmap
+	vec2 texel = 1.0 / (u_HeightmapSize - 1.0);
+	float dx = SampleHeight(inUV + vec2(texel.x, 0.0)) - SampleHeight(inUV - vec2(texel.x, 0.0));
+	float dz = SampleHeight(inUV + vec2(0.0, texel.y)) - SampleHeight(inUV - vec2(0.0, texel.y));
+	vec3 N = normalize(vec3(-dx / (2.0 * texel.x * u_TerrainSize.x), 1.0, -dz / (2.0 * texel.y * u_TerrainSize.z)));
+
+	// Blend the layers, renormalizing in case the weights don't quite add up to 1
+	vec4 weights = texture(s_Splatmap, inUV);
+	vec2 layerUV = inPos.xz / u_LayerTiling;
+	vec3 albedo = vec3(0.0);
+	float total = 0.0;
+	for (int ix = 0; ix < u_LayerCount; ix++) {
+		albedo += texture(s_Layers, vec3(layerUV, float(ix))).rgb * weights[ix];
+		total += weights[ix];
+	}
+	albedo /= max(total, 0.0001);
+
+	// Stands in for the fixed ambient term, the bake already includes the sky and is darker wherever it's occluded
+	vec3 baked = u_UseLightmap != 0 ? texture(s_Lightmap, inUV).rgb : inAmbient;
+	vec3 ambient = u_AmbientLightStrength * u_LightCol;
+
+	// Diffuse
+	vec3 lightDir = normalize(u_LightPos - inPos);
+	float dif = max(dot(N, lightDir), 0.0);
+	vec3 diffuse = dif * u_LightCol;
+
+	//Attenuation
+	float dist = length(u_LightPos - inPos);
+	float attenuation = 1.0f / (
+		u_LightAttenuationConstant + 
+		u_LightAttenuationLinear * dist +
+		u_LightAttenuationQuadratic * dist * dist);
+
+	// Specular, the ground is rough so there's no specular map
+	vec3 viewDir  = normalize(u_CamPos - inPos);
+	vec3 h        = normalize(lightDir + viewDir);
+	float spec = pow(max(dot(N, h), 0.0), u_Shininess);
+	vec3 specular = u_SpecularLightStrength * spec * u_LightCol;
+
+	// Toon Shading - Outline Effect
+	float edge = (dot(viewDir, N) < 0.4) ? 0.0 : 1.0;
+
+	vec3 result = vec3(0.0);
+	//Debug Toggles
+	//No Lighting
+	if(u_Option1 == true)
+	{
+		result = albedo;
+	}
+	//Ambient Only
+	else if(u_Option2 == true)
+	{
+		result = (baked + (ambient * attenuation)) * albedo;
+	}
+	//Specular Only
+	else if(u_Option3 == true)
+	{
+		result = specular * attenuation * albedo;
+	}
+	//Ambient + Specular
+	else if(u_Option4 == true)
+	{
+		result = (baked + (ambient + diffuse + specular) * attenuation) * albedo;
+	}
+	//Custom Lighting
+	else if(u_Option5 == true)
+	{
+		diffuse = floor(diffuse * bands) * scaleFactor;
+		result = baked + (ambient + diffuse + specular) * edge * albedo;
+	}
+
+	frag_color = vec4(result, 1.0);
+}
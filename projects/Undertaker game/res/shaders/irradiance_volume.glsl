@@ -0,0 +1,48 @@
+// The ambient light shared by the scene, terrain and impostor vertex shaders. This has no #version, it's loaded as a
+// second source string after each of them (see Shader::LoadShaderPartFromFiles), so they declare SampleAmbient up front
+
+// Used when there is no irradiance volume
+uniform vec3  u_AmbientCol;
+uniform float u_AmbientStrength;
+
+// The baked irradiance volume (see IrradianceVolume), the 7 slices of probe data are stacked along Z. The binding is
+// fixed so that programs which never use the volume don't leave it on unit 0 with their 2D samplers
+layout (binding = 13) uniform sampler3D s_IrradianceVolume;
+uniform vec3 u_IrradianceVolumeMin;
+uniform vec3 u_IrradianceVolumeSize;
+uniform vec3 u_IrradianceVolumeResolution;
+uniform int  u_UseIrradianceVolume = 0;
+
+const int IRRADIANCE_SLICES = 7;
+
+// Blends the probes around a world space position, and evaluates their spherical harmonics for a normal
+vec3 SampleIrradianceVolume(vec3 worldPos, vec3 n) {
+	// Probes sit on the corners of the volume, so line them up with the texel centers, and keep the lookups half a
+	// texel inside each slice so they don't blend into the next slice
+	vec3 res = u_IrradianceVolumeResolution;
+	vec3 t = clamp((worldPos - u_IrradianceVolumeMin) / u_IrradianceVolumeSize, 0.0, 1.0) * (res - 1.0) + 0.5;
+	vec4 c[IRRADIANCE_SLICES];
+	for (int ix = 0; ix < IRRADIANCE_SLICES; ix++) {
+		c[ix] = textureLod(s_IrradianceVolume, vec3(t.xy / res.xy, (t.z + float(ix) * res.z) / (res.z * IRRADIANCE_SLICES)), 0.0);
+	}
+
+	// Unpack the 27 floats back into 9 colors, in the same order as EvaluateIrradiance in frag_reflection
+	vec3 result = c[0].xyz * 0.282095;
+	result += vec3(c[0].w, c[1].xy) * 0.488603 * n.y;
+	result += vec3(c[1].zw, c[2].x) * 0.488603 * n.z;
+	result += c[2].yzw * 0.488603 * n.x;
+	result += c[3].xyz * 1.092548 * n.x * n.y;
+	result += vec3(c[3].w, c[4].xy) * 1.092548 * n.y * n.z;
+	result += vec3(c[4].zw, c[5].x) * 0.315392 * (3.0 * n.z * n.z - 1.0);
+	result += c[5].yzw * 1.092548 * n.x * n.z;
+	result += c[6].xyz * 0.546274 * (n.x * n.x - n.y * n.y);
+	return max(result, vec3(0.0));
+}
+
+// Gets the ambient light at a world space position, from the irradiance volume if there is one
+vec3 SampleAmbient(vec3 worldPos, vec3 n) {
+	if (u_UseIrradianceVolume != 0) {
+		return SampleIrradianceVolume(worldPos, n);
+	}
+	return u_AmbientCol * u_AmbientStrength;
+}
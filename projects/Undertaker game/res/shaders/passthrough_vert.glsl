@@ -5,8 +5,11 @@ layout (location = 1) in vec2 inUV;
 
 layout(location = 0) out vec2 outUV;
 
+// Render targets can be bigger than the part we drew to, this scales our UVs to only cover that part
+uniform vec2 u_UvScale = vec2(1.0);
+
 void main()
 { 
-	outUV = inUV;
+	outUV = inUV * u_UvScale;
 	gl_Position = vec4(inPosition, 1.0);
 }
\ No newline at end of file
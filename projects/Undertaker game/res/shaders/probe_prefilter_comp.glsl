@@ -0,0 +1,85 @@
+#version 430
+
+// Filters one mip level of a reflection probe with the GGX distribution
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// The captured probe, with a full mip chain
+layout(binding = 0) uniform samplerCube s_Source;
+layout(binding = 0, r11f_g11f_b10f) writeonly uniform imageCube u_Output;
+
+uniform float u_Roughness;
+uniform int   u_OutputSize;
+uniform float u_SourceSize;
+uniform int   u_SampleCount;
+
+const float PI = 3.14159265359;
+
+// Gets the direction through a texel of a face (following the OpenGL cubemap layout)
+vec3 FaceDirection(int face, vec2 st) {
+	vec2 uv = st * 2.0 - 1.0;
+	switch (face) {
+		case 0:  return normalize(vec3( 1.0, -uv.y, -uv.x));
+		case 1:  return normalize(vec3(-1.0, -uv.y,  uv.x));
+		case 2:  return normalize(vec3( uv.x,  1.0,  uv.y));
+		case 3:  return normalize(vec3( uv.x, -1.0, -uv.y));
+		case 4:  return normalize(vec3( uv.x, -uv.y,  1.0));
+		default: return normalize(vec3(-uv.x, -uv.y, -1.0));
+	}
+}
+
+vec2 Hammersley(uint i, uint count) {
+	uint bits = bitfieldReverse(i);
+	return vec2(float(i) / float(count), float(bits) * 2.3283064365386963e-10);
+}
+
+vec3 ImportanceSampleGGX(vec2 xi, vec3 N, float roughness) {
+	float a = roughness * roughness;
+	float phi = 2.0 * PI * xi.x;
+	float cosTheta = sqrt((1.0 - xi.y) / (1.0 + (a * a - 1.0) * xi.y));
+	float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+	vec3 H = vec3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta);
+
+	vec3 up = abs(N.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+	vec3 tangent = normalize(cross(up, N));
+	vec3 bitangent = cross(N, tangent);
+	return normalize(tangent * H.x + bitangent * H.y + N * H.z);
+}
+
+float DistributionGGX(float NdotH, float roughness) {
+	float a2 = roughness * roughness * roughness * roughness;
+	float denom = NdotH * NdotH * (a2 - 1.0) + 1.0;
+	return a2 / (PI * denom * denom);
+}
+
+void main() {
+	ivec3 texel = ivec3(gl_GlobalInvocationID);
+	if (texel.x >= u_OutputSize || texel.y >= u_OutputSize) {
+		return;
+	}
+	vec3 N = FaceDirection(texel.z, (vec2(texel.xy) + 0.5) / float(u_OutputSize));
+
+	vec3 color;
+	if (u_Roughness <= 0.0) {
+		color = textureLod(s_Source, N, log2(u_SourceSize / float(u_OutputSize))).rgb;
+	} else {
+		// Wide samples read blurrier mips, so a few samples don't alias (filtered importance sampling)
+		float texelAngle = 4.0 * PI / (6.0 * u_SourceSize * u_SourceSize);
+		vec3 sum = vec3(0.0);
+		float weight = 0.0;
+		for (int i = 0; i < u_SampleCount; i++) {
+			vec3 H = ImportanceSampleGGX(Hammersley(uint(i), uint(u_SampleCount)), N, u_Roughness);
+			vec3 L = 2.0 * dot(N, H) * H - N;
+			float NdotL = dot(N, L);
+			if (NdotL > 0.0) {
+				float pdf = DistributionGGX(max(dot(N, H), 0.0), u_Roughness) * 0.25;
+				float sampleAngle = 1.0 / (float(u_SampleCount) * pdf + 0.0001);
+				float lod = 0.5 * log2(sampleAngle / texelAngle) + 1.0;
+				sum += textureLod(s_Source, L, lod).rgb * NdotL;
+				weight += NdotL;
+			}
+		}
+		color = weight > 0.0 ? sum / weight : vec3(0.0);
+	}
+
+	imageStore(u_Output, texel, vec4(color, 1.0));
+}
@@ -0,0 +1,109 @@
+#version 420
+
+// The corner of the impostor's quad, from -1 to 1
+layout(location = 0) in vec2 inCorner;
+// Per impostor, the world space center of the object's bounds in xyz, and its scale in w
+layout(location = 1) in vec4 inInstance;
+// Per impostor, the object's rotation around the Y axis in radians
+layout(location = 2) in float inYaw;
+
+layout(location = 0) out vec3 outPos;
+// Where this vertex lands in each of the three frames we blend, and which frames they are
+layout(location = 1) out vec2 outFrameUV[3];
+layout(location = 4) flat out vec2 outFrame[3];
+layout(location = 7) flat out vec3 outWeights;
+// Takes the atlas' model space normals and depths into world space
+layout(location = 8) flat out mat3 outRotation;
+layout(location = 11) flat out vec3 outToCamera;
+layout(location = 12) flat out float outRadius;
+layout(location = 13) flat out vec3 outAmbient;
+
+uniform mat4  u_View;
+uniform mat4  u_ViewProjection;
+uniform vec3  u_CamPos;
+uniform int   u_Orthographic;
+
+// The layout of the atlas, and the model space radius of the bounds it was baked around
+uniform float u_FramesPerSide;
+uniform float u_ImpostorRadius;
+
+// Defined in irradiance_volume.glsl
+vec3 SampleAmbient(vec3 worldPos, vec3 n);
+
+// Folds a direction on the upper hemisphere down onto a square from -1 to 1, directions below the horizon are treated
+// as being on it. Must match DecodeHemiOct in Impostor.cpp
+vec2 EncodeHemiOct(vec3 dir) {
+	dir.y = max(dir.y, 0.0);
+	dir /= abs(dir.x) + abs(dir.y) + abs(dir.z);
+	return vec2(dir.x + dir.z, dir.x - dir.z);
+}
+
+vec3 DecodeHemiOct(vec2 encoded) {
+	vec3 dir = vec3(encoded.x + encoded.y, 0.0, encoded.x - encoded.y) * 0.5;
+	dir.y = 1.0 - abs(dir.x) - abs(dir.z);
+	return normalize(dir);
+}
+
+// The same right and up vectors that lookAt used when the frame was baked
+void FrameBasis(vec3 dir, out vec3 right, out vec3 up) {
+	vec3 worldUp = abs(dir.y) > 0.999 ? vec3(0.0, 0.0, -1.0) : vec3(0.0, 1.0, 0.0);
+	right = normalize(cross(worldUp, dir));
+	up = cross(dir, right);
+}
+
+// Follows the view ray through a point (in model space, relative to the center of the bounds) onto the plane that a
+// frame was rendered on, and returns where it lands in that frame
+vec2 GetFrameUV(vec2 frame, vec3 localPos, vec3 localRay) {
+	vec3 dir = DecodeHemiOct(frame / (u_FramesPerSide - 1.0) * 2.0 - 1.0);
+	vec3 right, up;
+	FrameBasis(dir, right, up);
+	// Rays that skim along the frame's plane would land at infinity
+	vec3 onPlane = localPos - localRay * (dot(localPos, dir) / min(dot(localRay, dir), -0.0001));
+	return vec2(dot(onPlane, right), dot(onPlane, up)) / (2.0 * u_ImpostorRadius) + 0.5;
+}
+
+void main() {
+	vec3 center = inInstance.xyz;
+	float scale = inInstance.w;
+	outRadius = u_ImpostorRadius * scale;
+
+	// Orthographic cameras look along the same direction everywhere
+	vec3 forward = -vec3(u_View[0][2], u_View[1][2], u_View[2][2]);
+	outToCamera = u_Orthographic != 0 ? -forward : normalize(u_CamPos - center);
+
+	// Expand the quad across the camera's right and up, so it always faces the camera
+	vec3 camRight = vec3(u_View[0][0], u_View[1][0], u_View[2][0]);
+	vec3 camUp = vec3(u_View[0][1], u_View[1][1], u_View[2][1]);
+	outPos = center + (inCorner.x * camRight + inCorner.y * camUp) * outRadius;
+	gl_Position = u_ViewProjection * vec4(outPos, 1.0);
+
+	// Work in the atlas' model space from here on
+	float s = sin(inYaw);
+	float c = cos(inYaw);
+	outRotation = mat3(c, 0.0, -s, 0.0, 1.0, 0.0, s, 0.0, c);
+	vec3 localPos = transpose(outRotation) * (outPos - center) / scale;
+	vec3 localToCamera = transpose(outRotation) * outToCamera;
+	vec3 localRay = u_Orthographic != 0 ? -localToCamera : transpose(outRotation) * normalize(outPos - u_CamPos);
+
+	// Find the triangle of frames around the view direction, and how close we are to each of them
+	vec2 grid = (EncodeHemiOct(localToCamera) * 0.5 + 0.5) * (u_FramesPerSide - 1.0);
+	vec2 cell = min(floor(grid), vec2(u_FramesPerSide - 2.0));
+	vec2 f = grid - cell;
+	if (f.x + f.y < 1.0) {
+		outFrame[0] = cell;
+		outFrame[1] = cell + vec2(1.0, 0.0);
+		outFrame[2] = cell + vec2(0.0, 1.0);
+		outWeights = vec3(1.0 - f.x - f.y, f.x, f.y);
+	} else {
+		outFrame[0] = cell + vec2(1.0, 1.0);
+		outFrame[1] = cell + vec2(0.0, 1.0);
+		outFrame[2] = cell + vec2(1.0, 0.0);
+		outWeights = vec3(f.x + f.y - 1.0, 1.0 - f.x, 1.0 - f.y);
+	}
+	for (int ix = 0; ix < 3; ix++) {
+		outFrameUV[ix] = GetFrameUV(outFrame[ix], localPos, localRay);
+	}
+
+	// Ambient light is worked out once per impostor, facing up, they're too small to see it change across them
+	outAmbient = SampleAmbient(center, vec3(0.0, 1.0, 0.0));
+}
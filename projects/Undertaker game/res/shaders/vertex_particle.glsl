@@ -0,0 +1,31 @@
+#version 410
+
+// The corner of the particle's quad, from -1 to 1
+layout(location = 0) in vec2 inCorner;
+// Per particle, the world position in xyz, and how far through its life it is in w
+layout(location = 1) in vec4 inParticle;
+
+layout(location = 0) out vec2 outUV;
+layout(location = 1) out vec4 outColor;
+layout(location = 2) out float outViewDepth;
+
+uniform mat4 u_View;
+uniform mat4 u_Projection;
+
+uniform vec4 u_StartColor;
+uniform vec4 u_EndColor;
+// The size of the particle at the start and end of its life
+uniform vec2 u_Size;
+
+void main() {
+	float age = inParticle.w;
+
+	// Expand the quad in view space, so it always faces the camera
+	vec4 viewPos = u_View * vec4(inParticle.xyz, 1.0);
+	viewPos.xy += inCorner * mix(u_Size.x, u_Size.y, age) * 0.5;
+	gl_Position = u_Projection * viewPos;
+
+	outUV = inCorner * 0.5 + 0.5;
+	outColor = mix(u_StartColor, u_EndColor, age);
+	outViewDepth = -viewPos.z;
+}
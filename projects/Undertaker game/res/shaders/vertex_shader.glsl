@@ -1,4 +1,4 @@
-#version 410
+#version 420
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -9,6 +9,7 @@ layout(location = 0) out vec3 outPos;
 layout(location = 1) out vec3 outColor;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec2 outUV;
+layout(location = 4) out vec3 outAmbient;
 
 uniform mat4 u_ModelViewProjection;
 uniform mat4 u_View;
@@ -16,6 +17,8 @@ uniform mat4 u_Model;
 uniform mat3 u_NormalMatrix;
 uniform vec3 u_LightPos;
 
+// Defined in irradiance_volume.glsl
+vec3 SampleAmbient(vec3 worldPos, vec3 n);
 
 void main() {
 
@@ -34,5 +37,8 @@ void main() {
 	///////////
 	outColor = inColor;
 
+	// Ambient light is worked out once per vertex, so it costs the same however many objects use it
+	outAmbient = SampleAmbient(outPos, normalize(outNormal));
+
 }
 
@@ -0,0 +1,28 @@
+#version 410
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec3 inNormal;
+layout(location = 3) in vec2 inUV;
+layout(location = 4) in vec2 inLightmapUV;
+
+layout(location = 0) out vec3 outPos;
+layout(location = 1) out vec3 outColor;
+layout(location = 2) out vec3 outNormal;
+layout(location = 3) out vec2 outUV;
+layout(location = 4) out vec2 outLightmapUV;
+
+uniform mat4 u_ModelViewProjection;
+uniform mat4 u_Model;
+uniform mat3 u_NormalMatrix;
+
+// The same as vertex_shader.glsl, but passes along the second UV set that static geometry's baked lighting uses
+void main() {
+	gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
+
+	outPos = (u_Model * vec4(inPosition, 1.0)).xyz;
+	outNormal = u_NormalMatrix * inNormal;
+	outUV = inUV;
+	outLightmapUV = inLightmapUV;
+	outColor = inColor;
+}
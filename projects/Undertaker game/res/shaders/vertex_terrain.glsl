@@ -0,0 +1,54 @@
+#version 420
+
+// The position of the vertex on the chunk's grid, in whole quads
+layout(location = 0) in vec2 inPosition;
+
+layout(location = 0) out vec3 outPos;
+layout(location = 1) out vec2 outUV;
+layout(location = 2) out vec3 outAmbient;
+
+uniform mat4 u_ViewProjection;
+uniform vec3 u_CamPos;
+
+// The heightmap, with samples on the corners of the terrain (see Heightmap)
+uniform sampler2D s_Heightmap;
+uniform vec2  u_HeightmapSize;
+uniform vec3  u_TerrainPosition;
+uniform vec3  u_TerrainSize;
+
+// The chunk being drawn, in the terrain's UV space, and the distances its vertices start and finish morphing over
+uniform vec2  u_ChunkOffset;
+uniform float u_ChunkSize;
+uniform vec2  u_MorphRange;
+uniform float u_GridSize;
+
+// Defined in irradiance_volume.glsl
+vec3 SampleAmbient(vec3 worldPos, vec3 n);
+
+float SampleHeight(vec2 uv) {
+	// Line the corners of the terrain up with the centers of the first and last texels
+	return textureLod(s_Heightmap, (uv * (u_HeightmapSize - 1.0) + 0.5) / u_HeightmapSize, 0.0).r;
+}
+
+vec3 TerrainToWorld(vec2 uv) {
+	return u_TerrainPosition + vec3(uv.x, SampleHeight(uv), uv.y) * u_TerrainSize;
+}
+
+// Every chunk is the same grid, stretched over its area of the terrain and displaced by the heightmap (see Terrain)
+void main() {
+	vec3 worldPos = TerrainToWorld(u_ChunkOffset + inPosition / u_GridSize * u_ChunkSize);
+
+	// As the vertex gets towards the end of its chunk's range, slide the odd vertices onto their even neighbours, so
+	// that by the time the next LOD takes over the grid already matches it
+	float morph = clamp((distance(worldPos, u_CamPos) - u_MorphRange.x) / (u_MorphRange.y - u_MorphRange.x), 0.0, 1.0);
+	vec2 gridPos = inPosition - mod(inPosition, 2.0) * morph;
+	vec2 uv = u_ChunkOffset + gridPos / u_GridSize * u_ChunkSize;
+	worldPos = TerrainToWorld(uv);
+
+	gl_Position = u_ViewProjection * vec4(worldPos, 1.0);
+	outPos = worldPos;
+	outUV = uv;
+
+	// The normal is worked out per pixel, but the probes are coarse enough that straight up is close enough here
+	outAmbient = SampleAmbient(worldPos, vec3(0.0, 1.0, 0.0));
+}
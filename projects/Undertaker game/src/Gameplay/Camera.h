@@ -81,6 +81,11 @@ public:
 	const glm::vec3& GetUp() const { return _up; }
 
 	float GetFovDegrees() const { return glm::degrees(_fovRadians); }
+	/// <summary>
+	/// Gets the distances to the near and far clipping planes
+	/// </summary>
+	float GetNearPlane() const { return _nearPlane; }
+	float GetFarPlane() const { return _farPlane; }
 	
 	/// <summary>
 	/// Gets the view matrix for this camera
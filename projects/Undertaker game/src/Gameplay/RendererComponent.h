@@ -6,6 +6,12 @@ class RendererComponent {
 public:
 	VertexArrayObject::sptr Mesh;
 	ShaderMaterial::sptr    Material;
+	// Whether the renderer passed culling this frame
+	bool                    IsVisible = true;
+	// Static renderers never move, reflection probes only capture these
+	bool                    IsStatic = false;
+	// Stand-ins for things that draw themselves some other way (ex: the terrain), only reflection probes draw these
+	bool                    ProbeOnly = false;
 
 	RendererComponent& SetMesh(const VertexArrayObject::sptr& mesh) { Mesh = mesh; return *this; }
 	RendererComponent& SetMaterial(const ShaderMaterial::sptr& material) { Material = material; return *this; }
@@ -14,6 +14,13 @@ void SubmitUniformsMat(const Shader::sptr& shader, const std::unordered_map<Shad
 	}
 }
 
+template<typename T>
+void RecordUniforms(CommandBuffer& commands, const Shader& shader, const std::unordered_map<ShaderParamName, T>& values) {
+	for (auto& kvp : values) {
+		commands.SetUniform(shader, kvp.first.Location, kvp.second);
+	}
+}
+
 ShaderMaterial::ShaderMaterial()
 	: Shader(nullptr),  RenderLayer(0)
 {
@@ -42,6 +49,42 @@ void ShaderMaterial::Apply()
 	SubmitUniformsMat(Shader, Mat3Params);
 }
 
+void ShaderMaterial::Record(CommandBuffer& commands) const
+{
+	int slot = 1;
+	for (auto& kvp : Textures) {
+		if (kvp.first.Location != -1 && kvp.second != nullptr) {
+			commands.SetUniform(*Shader, kvp.first.Location, slot);
+			commands.BindTexture(slot, kvp.second.get());
+			slot++;
+		}
+	}
+
+	RecordUniforms(commands, *Shader, FloatParams);
+	RecordUniforms(commands, *Shader, Vec2Params);
+	RecordUniforms(commands, *Shader, Vec3Params);
+	RecordUniforms(commands, *Shader, Vec4Params);
+	RecordUniforms(commands, *Shader, Mat4Params);
+	RecordUniforms(commands, *Shader, Mat3Params);
+}
+
+ShaderMaterial::sptr ShaderMaterial::CloneWithShader(const Shader::sptr& shader) const {
+	ShaderMaterial::sptr result = ShaderMaterial::Create();
+	result->Shader = shader;
+	result->RenderLayer = RenderLayer;
+	result->DebugName = DebugName;
+	result->UsesReflectionProbes = UsesReflectionProbes;
+	// Go through Set so that the uniform locations are looked up in the new shader
+	for (auto& kvp : Textures) { result->Set(kvp.first.Name, kvp.second); }
+	for (auto& kvp : FloatParams) { result->Set(kvp.first.Name, kvp.second); }
+	for (auto& kvp : Vec2Params) { result->Set(kvp.first.Name, kvp.second); }
+	for (auto& kvp : Vec3Params) { result->Set(kvp.first.Name, kvp.second); }
+	for (auto& kvp : Vec4Params) { result->Set(kvp.first.Name, kvp.second); }
+	for (auto& kvp : Mat4Params) { result->Set(kvp.first.Name, kvp.second); }
+	for (auto& kvp : Mat3Params) { result->Set(kvp.first.Name, kvp.second); }
+	return result;
+}
+
 void ShaderMaterial::Set(const std::string& name, const ITexture::sptr& texture) {
 	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
 	ShaderParamName pName = name;
@@ -2,6 +2,7 @@
 #include <string>
 #include "Graphics/Shader.h"
 #include "Graphics/ITexture.h"
+#include "Graphics/CommandBuffer.h"
 #include "Utilities/Macros.h"
 #include <EnumToString.h>
 
@@ -48,8 +49,23 @@ public:
 
 	int RenderLayer;
 	std::string DebugName;
+	// Should the two nearest reflection probes be bound when drawing with this material
+	bool UsesReflectionProbes = false;
 
 	void Apply();
+	/// <summary>
+	/// Records the same work as Apply into a command buffer. The uniform locations were looked up when the parameters
+	/// were set, so this is safe to call from any thread
+	/// </summary>
+	/// <param name="commands">The buffer to record into</param>
+	void Record(CommandBuffer& commands) const;
+
+	/// <summary>
+	/// Creates a copy of this material that renders with a different shader, every parameter is carried over
+	/// (parameters the new shader doesn't have are ignored)
+	/// </summary>
+	/// <param name="shader">The shader for the new material</param>
+	ShaderMaterial::sptr CloneWithShader(const Shader::sptr& shader) const;
 
 	void Set(const std::string& name, const ITexture::sptr& texture);
 	void Set(const std::string& name, float value);
@@ -0,0 +1,313 @@
+#include "CommandBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <imgui.h>
+#include <Logging.h>
+#include "ITexture.h"
+#include "Shader.h"
+#include "VertexArrayObject.h"
+
+namespace {
+	inline size_t AlignUp(size_t size, size_t alignment) {
+		return (size + alignment - 1) & ~(alignment - 1);
+	}
+
+	// The number of bytes the values of a uniform of the given type take up
+	inline size_t UniformSize(UniformType type) {
+		switch (type) {
+			case UniformType::Int:   return sizeof(int);
+			case UniformType::Float: return sizeof(float);
+			case UniformType::Vec2:  return sizeof(glm::vec2);
+			case UniformType::Vec3:  return sizeof(glm::vec3);
+			case UniformType::Vec4:  return sizeof(glm::vec4);
+			case UniformType::Mat3:  return sizeof(glm::mat3);
+			case UniformType::Mat4:  return sizeof(glm::mat4);
+			default:                 return 0;
+		}
+	}
+}
+
+uint8_t* CommandBuffer::_Push(CommandType type, const void* command, size_t commandSize, size_t extraSize) {
+	static_assert(sizeof(RenderCommands::Header) <= ALIGNMENT, "Command headers must fit in one alignment step");
+	// Commands are laid out as [header][command][extra], with the header and command each starting on the alignment
+	const size_t headerSize = AlignUp(sizeof(RenderCommands::Header), ALIGNMENT);
+	const size_t totalSize = AlignUp(headerSize + commandSize + extraSize, ALIGNMENT);
+	const size_t start = _data.size();
+	_data.resize(start + totalSize);
+
+	RenderCommands::Header header;
+	header.Type = type;
+	header.Size = static_cast<uint32_t>(totalSize);
+	memcpy(_data.data() + start, &header, sizeof(header));
+	memcpy(_data.data() + start + headerSize, command, commandSize);
+	_commandCount++;
+	return _data.data() + start + headerSize + commandSize;
+}
+
+void CommandBuffer::_PushUniform(const Shader& shader, int location, UniformType type, const void* value, size_t size) {
+	// Recording a uniform the shader doesn't have would only be skipped later, so leave it out entirely
+	if (location == -1) {
+		return;
+	}
+	RenderCommands::SetUniform command;
+	command.Program = shader.GetHandle();
+	command.Location = location;
+	command.Type = type;
+	command.Count = 1;
+	memcpy(_Push(CommandType::SetUniform, &command, sizeof(command), size), value, size);
+}
+
+void CommandBuffer::BindShader(const Shader& shader) {
+	_Push(CommandType::BindShader, RenderCommands::BindShader{ shader.GetHandle() });
+}
+
+void CommandBuffer::SetUniform(const Shader& shader, int location, int value) {
+	_PushUniform(shader, location, UniformType::Int, &value, sizeof(value));
+}
+void CommandBuffer::SetUniform(const Shader& shader, int location, float value) {
+	_PushUniform(shader, location, UniformType::Float, &value, sizeof(value));
+}
+void CommandBuffer::SetUniform(const Shader& shader, int location, const glm::vec2& value) {
+	_PushUniform(shader, location, UniformType::Vec2, &value, sizeof(value));
+}
+void CommandBuffer::SetUniform(const Shader& shader, int location, const glm::vec3& value) {
+	_PushUniform(shader, location, UniformType::Vec3, &value, sizeof(value));
+}
+void CommandBuffer::SetUniform(const Shader& shader, int location, const glm::vec4& value) {
+	_PushUniform(shader, location, UniformType::Vec4, &value, sizeof(value));
+}
+void CommandBuffer::SetUniform(const Shader& shader, int location, const glm::mat3& value) {
+	_PushUniform(shader, location, UniformType::Mat3, &value, sizeof(value));
+}
+void CommandBuffer::SetUniform(const Shader& shader, int location, const glm::mat4& value) {
+	_PushUniform(shader, location, UniformType::Mat4, &value, sizeof(value));
+}
+
+void CommandBuffer::BindTexture(int slot, const ITexture* texture) {
+	LOG_ASSERT(slot >= 0 && slot < CommandExecutor::MAX_TEXTURE_SLOTS, "Texture slot out of range");
+	_Push(CommandType::BindTexture, RenderCommands::BindTexture{ static_cast<GLuint>(slot), texture });
+}
+
+void CommandBuffer::BindVertexArray(const VertexArrayObject& vao) {
+	_Push(CommandType::BindVertexArray, RenderCommands::BindVertexArray{ vao.GetHandle() });
+}
+
+void CommandBuffer::UploadBuffer(GLuint buffer, uint32_t offset, const void* data, uint32_t size) {
+	RenderCommands::UploadBuffer command{ buffer, offset, size };
+	memcpy(_Push(CommandType::UploadBuffer, &command, sizeof(command), size), data, size);
+}
+
+void CommandBuffer::SetCapability(GLenum capability, bool enabled) {
+	_Push(CommandType::SetCapability, RenderCommands::SetCapability{ capability, enabled });
+}
+
+void CommandBuffer::Draw(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount, GLuint baseInstance) {
+	_Push(CommandType::Draw, RenderCommands::Draw{ mode, first, count, instanceCount, baseInstance });
+}
+
+void CommandBuffer::DrawIndexed(GLenum mode, GLsizei count, GLenum indexType, uint32_t firstByte, GLsizei instanceCount, GLuint baseInstance) {
+	_Push(CommandType::DrawIndexed, RenderCommands::DrawIndexed{ mode, count, indexType, firstByte, instanceCount, baseInstance });
+}
+
+void CommandBuffer::DrawMesh(const VertexArrayObject& vao, GLsizei instanceCount, GLuint baseInstance) {
+	BindVertexArray(vao);
+	const IndexBuffer::sptr& indices = vao.GetIndexBuffer();
+	if (indices != nullptr) {
+		DrawIndexed(GL_TRIANGLES, indices->GetElementCount(), indices->GetElementType(), 0, instanceCount, baseInstance);
+	} else {
+		Draw(GL_TRIANGLES, 0, vao.GetVertexCount(), instanceCount, baseInstance);
+	}
+}
+
+void CommandBuffer::Dispatch(const Shader& shader, GLuint groupsX, GLuint groupsY, GLuint groupsZ) {
+	_Push(CommandType::Dispatch, RenderCommands::Dispatch{ shader.GetHandle(), groupsX, groupsY, groupsZ });
+}
+
+void CommandBuffer::Barrier(GLbitfield bits) {
+	_Push(CommandType::Barrier, RenderCommands::Barrier{ bits });
+}
+
+uint32_t CommandBuffer::RecordParallel(std::vector<CommandBuffer>& buffers, size_t itemCount,
+	const std::function<void(CommandBuffer& buffer, size_t begin, size_t end)>& record)
+{
+	uint32_t threadCount = 1;
+	if (itemCount >= PARALLEL_THRESHOLD) {
+		threadCount = glm::clamp(std::thread::hardware_concurrency(), 1u, MAX_THREADS);
+	}
+	const size_t perThread = (itemCount + threadCount - 1) / std::max(threadCount, 1u);
+
+	// Buffers are only ever added, so their memory is reused from frame to frame
+	if (buffers.size() < threadCount) {
+		buffers.resize(threadCount);
+	}
+	for (CommandBuffer& buffer : buffers) {
+		buffer.Reset();
+	}
+
+	// Each run has its own buffer, so there is nothing to lock
+	std::vector<std::future<void>> tasks;
+	for (uint32_t ix = 1; ix < threadCount; ix++) {
+		const size_t begin = ix * perThread;
+		const size_t end = std::min(itemCount, begin + perThread);
+		if (begin < end) {
+			tasks.push_back(std::async(std::launch::async, record, std::ref(buffers[ix]), begin, end));
+		}
+	}
+	record(buffers[0], 0, std::min(itemCount, perThread));
+	for (std::future<void>& task : tasks) {
+		task.get();
+	}
+	return static_cast<uint32_t>(tasks.size() + 1);
+}
+
+CommandExecutor::CommandExecutor() {
+	Invalidate();
+}
+
+void CommandExecutor::Invalidate() {
+	_program = 0;
+	_vertexArray = 0;
+	for (int ix = 0; ix < MAX_TEXTURE_SLOTS; ix++) {
+		_textures[ix] = nullptr;
+		_textureKnown[ix] = false;
+	}
+	_capabilities.clear();
+}
+
+void CommandExecutor::_SetUniform(const RenderCommands::SetUniform& command, const void* values) {
+	const GLuint program = command.Program;
+	const GLint location = command.Location;
+	const GLsizei count = static_cast<GLsizei>(command.Count);
+	switch (command.Type) {
+		case UniformType::Int:   glProgramUniform1iv(program, location, count, static_cast<const GLint*>(values)); break;
+		case UniformType::Float: glProgramUniform1fv(program, location, count, static_cast<const GLfloat*>(values)); break;
+		case UniformType::Vec2:  glProgramUniform2fv(program, location, count, static_cast<const GLfloat*>(values)); break;
+		case UniformType::Vec3:  glProgramUniform3fv(program, location, count, static_cast<const GLfloat*>(values)); break;
+		case UniformType::Vec4:  glProgramUniform4fv(program, location, count, static_cast<const GLfloat*>(values)); break;
+		case UniformType::Mat3:  glProgramUniformMatrix3fv(program, location, count, GL_FALSE, static_cast<const GLfloat*>(values)); break;
+		case UniformType::Mat4:  glProgramUniformMatrix4fv(program, location, count, GL_FALSE, static_cast<const GLfloat*>(values)); break;
+		default: LOG_WARN("Unknown uniform type in command buffer"); break;
+	}
+}
+
+void CommandExecutor::Execute(const CommandBuffer& commands) {
+	const size_t headerSize = (sizeof(RenderCommands::Header) + CommandBuffer::ALIGNMENT - 1) & ~(CommandBuffer::ALIGNMENT - 1);
+	const uint8_t* data = commands._data.data();
+	const uint8_t* end = data + commands._data.size();
+	_stats.Buffers++;
+
+	while (data < end) {
+		const RenderCommands::Header& header = *reinterpret_cast<const RenderCommands::Header*>(data);
+		const uint8_t* body = data + headerSize;
+		data += header.Size;
+		_stats.Commands++;
+
+		switch (header.Type) {
+			case CommandType::BindShader: {
+				const auto& command = *reinterpret_cast<const RenderCommands::BindShader*>(body);
+				if (command.Program == _program) {
+					_stats.Filtered++;
+					break;
+				}
+				glUseProgram(command.Program);
+				_program = command.Program;
+			} break;
+			case CommandType::SetUniform: {
+				const auto& command = *reinterpret_cast<const RenderCommands::SetUniform*>(body);
+				const size_t valueSize = UniformSize(command.Type) * command.Count;
+				LOG_ASSERT(sizeof(command) + valueSize <= header.Size - headerSize, "Uniform values overrun their command");
+				_SetUniform(command, body + sizeof(command));
+			} break;
+			case CommandType::BindTexture: {
+				const auto& command = *reinterpret_cast<const RenderCommands::BindTexture*>(body);
+				if (_textureKnown[command.Slot] && _textures[command.Slot] == command.Texture) {
+					_stats.Filtered++;
+					break;
+				}
+				if (command.Texture != nullptr) {
+					command.Texture->Bind(command.Slot);
+				} else {
+					ITexture::Unbind(command.Slot);
+				}
+				_textures[command.Slot] = command.Texture;
+				_textureKnown[command.Slot] = true;
+			} break;
+			case CommandType::BindVertexArray: {
+				const auto& command = *reinterpret_cast<const RenderCommands::BindVertexArray*>(body);
+				if (command.Handle == _vertexArray) {
+					_stats.Filtered++;
+					break;
+				}
+				glBindVertexArray(command.Handle);
+				_vertexArray = command.Handle;
+			} break;
+			case CommandType::UploadBuffer: {
+				const auto& command = *reinterpret_cast<const RenderCommands::UploadBuffer*>(body);
+				glNamedBufferSubData(command.Buffer, command.Offset, command.Size, body + sizeof(command));
+			} break;
+			case CommandType::SetCapability: {
+				const auto& command = *reinterpret_cast<const RenderCommands::SetCapability*>(body);
+				auto it = std::find_if(_capabilities.begin(), _capabilities.end(), [&](const std::pair<GLenum, bool>& cap) {
+					return cap.first == command.Capability;
+				});
+				if (it != _capabilities.end() && it->second == command.Enabled) {
+					_stats.Filtered++;
+					break;
+				}
+				if (command.Enabled) {
+					glEnable(command.Capability);
+				} else {
+					glDisable(command.Capability);
+				}
+				if (it != _capabilities.end()) {
+					it->second = command.Enabled;
+				} else {
+					_capabilities.push_back({ command.Capability, command.Enabled });
+				}
+			} break;
+			case CommandType::Draw: {
+				const auto& command = *reinterpret_cast<const RenderCommands::Draw*>(body);
+				if (command.InstanceCount == 1 && command.BaseInstance == 0) {
+					glDrawArrays(command.Mode, command.First, command.Count);
+				} else {
+					glDrawArraysInstancedBaseInstance(command.Mode, command.First, command.Count, command.InstanceCount, command.BaseInstance);
+				}
+				_stats.Draws++;
+			} break;
+			case CommandType::DrawIndexed: {
+				const auto& command = *reinterpret_cast<const RenderCommands::DrawIndexed*>(body);
+				const void* offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(command.FirstByte));
+				if (command.InstanceCount == 1 && command.BaseInstance == 0) {
+					glDrawElements(command.Mode, command.Count, command.IndexType, offset);
+				} else {
+					glDrawElementsInstancedBaseInstance(command.Mode, command.Count, command.IndexType, offset, command.InstanceCount, command.BaseInstance);
+				}
+				_stats.Draws++;
+			} break;
+			case CommandType::Dispatch: {
+				const auto& command = *reinterpret_cast<const RenderCommands::Dispatch*>(body);
+				if (command.Program != _program) {
+					glUseProgram(command.Program);
+					_program = command.Program;
+				}
+				glDispatchCompute(command.GroupsX, command.GroupsY, command.GroupsZ);
+			} break;
+			case CommandType::Barrier: {
+				const auto& command = *reinterpret_cast<const RenderCommands::Barrier*>(body);
+				glMemoryBarrier(command.Bits);
+			} break;
+			default:
+				LOG_WARN("Unknown command type {} in command buffer", static_cast<int>(header.Type));
+				break;
+		}
+	}
+}
+
+void CommandExecutor::RenderImGui() {
+	ImGui::Text("Buffers: %d", (int)_stats.Buffers);
+	ImGui::Text("Commands: %d", (int)_stats.Commands);
+	ImGui::Text("Draw calls: %d", (int)_stats.Draws);
+	ImGui::Text("Filtered state changes: %d", (int)_stats.Filtered);
+}
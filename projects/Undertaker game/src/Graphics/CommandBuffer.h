@@ -0,0 +1,240 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glad/glad.h>
+#include <GLM/glm.hpp>
+
+class ITexture;
+class Shader;
+class VertexArrayObject;
+
+/// <summary>
+/// The kinds of command a CommandBuffer can hold
+/// </summary>
+enum class CommandType : uint8_t
+{
+	BindShader,
+	SetUniform,
+	BindTexture,
+	BindVertexArray,
+	UploadBuffer,
+	SetCapability,
+	Draw,
+	DrawIndexed,
+	Dispatch,
+	Barrier
+};
+
+/// <summary>
+/// The types of value a SetUniform command can carry
+/// </summary>
+enum class UniformType : uint8_t
+{
+	Int,
+	Float,
+	Vec2,
+	Vec3,
+	Vec4,
+	Mat3,
+	Mat4
+};
+
+/// <summary>
+/// The data stored for each command. These are all plain data, so they can be written into a buffer as raw bytes
+/// </summary>
+namespace RenderCommands
+{
+	struct Header          { CommandType Type; uint32_t Size; };
+	struct BindShader      { GLuint Program; };
+	// Followed by the values
+	struct SetUniform      { GLuint Program; GLint Location; UniformType Type; uint32_t Count; };
+	// A null texture unbinds the slot
+	struct BindTexture     { GLuint Slot; const ITexture* Texture; };
+	struct BindVertexArray { GLuint Handle; };
+	// Followed by Size bytes of data
+	struct UploadBuffer    { GLuint Buffer; uint32_t Offset; uint32_t Size; };
+	struct SetCapability   { GLenum Capability; bool Enabled; };
+	struct Draw            { GLenum Mode; GLint First; GLsizei Count; GLsizei InstanceCount; GLuint BaseInstance; };
+	struct DrawIndexed     { GLenum Mode; GLsizei Count; GLenum IndexType; uint32_t FirstByte; GLsizei InstanceCount; GLuint BaseInstance; };
+	struct Dispatch        { GLuint Program; GLuint GroupsX; GLuint GroupsY; GLuint GroupsZ; };
+	struct Barrier         { GLbitfield Bits; };
+}
+
+/// <summary>
+/// A list of render commands, recorded into one block of memory so they can be built on any thread and replayed later
+/// by a CommandExecutor on the thread that owns the GL context. Recording never touches GL, so everything a command
+/// needs (uniform locations, handles) has to be looked up ahead of time.
+///
+/// Textures are stored by pointer, and must stay alive until the buffer is executed
+/// </summary>
+class CommandBuffer final
+{
+public:
+	// Lists with fewer items than this are recorded on one thread, since starting threads would cost more than it saves
+	static constexpr size_t PARALLEL_THRESHOLD = 256;
+	static constexpr uint32_t MAX_THREADS = 8;
+
+	CommandBuffer() = default;
+	~CommandBuffer() = default;
+
+	CommandBuffer(CommandBuffer&& other) = default;
+	CommandBuffer& operator=(CommandBuffer&& other) = default;
+	CommandBuffer(const CommandBuffer& other) = delete;
+	CommandBuffer& operator=(const CommandBuffer& other) = delete;
+
+	/// <summary>
+	/// Removes every command, keeping the memory around for the next time the buffer is recorded
+	/// </summary>
+	void Reset() { _data.clear(); _commandCount = 0; }
+
+	bool IsEmpty() const { return _commandCount == 0; }
+	uint32_t GetCommandCount() const { return _commandCount; }
+	/// <summary>
+	/// Gets the number of bytes the recorded commands take up
+	/// </summary>
+	size_t GetSize() const { return _data.size(); }
+
+	void BindShader(const Shader& shader);
+
+	void SetUniform(const Shader& shader, int location, int value);
+	void SetUniform(const Shader& shader, int location, float value);
+	void SetUniform(const Shader& shader, int location, const glm::vec2& value);
+	void SetUniform(const Shader& shader, int location, const glm::vec3& value);
+	void SetUniform(const Shader& shader, int location, const glm::vec4& value);
+	void SetUniform(const Shader& shader, int location, const glm::mat3& value);
+	void SetUniform(const Shader& shader, int location, const glm::mat4& value);
+
+	/// <summary>
+	/// Binds a texture to a slot, or unbinds the slot if texture is nullptr
+	/// </summary>
+	void BindTexture(int slot, const ITexture* texture);
+	void BindVertexArray(const VertexArrayObject& vao);
+	/// <summary>
+	/// Copies data into part of a buffer. The data is copied into the command buffer, so it doesn't need to stay alive
+	/// </summary>
+	/// <param name="buffer">The OpenGL handle of the buffer to upload to</param>
+	/// <param name="offset">The offset into the buffer to start writing at, in bytes</param>
+	/// <param name="data">The data to upload</param>
+	/// <param name="size">The number of bytes to upload</param>
+	void UploadBuffer(GLuint buffer, uint32_t offset, const void* data, uint32_t size);
+	/// <summary>
+	/// Enables or disables an OpenGL capability (ex: GL_DEPTH_TEST, GL_BLEND)
+	/// </summary>
+	void SetCapability(GLenum capability, bool enabled);
+
+	/// <summary>
+	/// Draws vertices from the bound vertex array, without an index buffer
+	/// </summary>
+	void Draw(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount = 1, GLuint baseInstance = 0);
+	/// <summary>
+	/// Draws from the index buffer of the bound vertex array
+	/// </summary>
+	/// <param name="mode">The primitive type to draw</param>
+	/// <param name="count">The number of indices to draw</param>
+	/// <param name="indexType">The type of the indices (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)</param>
+	/// <param name="firstByte">The byte offset into the index buffer to start reading from</param>
+	void DrawIndexed(GLenum mode, GLsizei count, GLenum indexType, uint32_t firstByte = 0, GLsizei instanceCount = 1, GLuint baseInstance = 0);
+	/// <summary>
+	/// Binds a mesh and draws all of it, the recorded version of VertexArrayObject::Render
+	/// </summary>
+	void DrawMesh(const VertexArrayObject& vao, GLsizei instanceCount = 1, GLuint baseInstance = 0);
+	/// <summary>
+	/// Binds a compute shader and runs it
+	/// </summary>
+	void Dispatch(const Shader& shader, GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1);
+	/// <summary>
+	/// Makes sure writes from earlier commands are visible to later ones, see glMemoryBarrier
+	/// </summary>
+	void Barrier(GLbitfield bits);
+
+	/// <summary>
+	/// Records a list of items across several threads. The items are split into contiguous runs, one per buffer, so
+	/// executing the buffers in order keeps the items in order. The first run is recorded on the calling thread
+	/// </summary>
+	/// <param name="buffers">The buffers to record into, grown to the number of runs if needed. Every buffer is reset first,
+	/// so any past the last run are left empty</param>
+	/// <param name="itemCount">The number of items in the list</param>
+	/// <param name="record">Records items [begin, end) into a buffer. This is called from several threads at once</param>
+	/// <returns>The number of threads the list was recorded on</returns>
+	static uint32_t RecordParallel(std::vector<CommandBuffer>& buffers, size_t itemCount,
+		const std::function<void(CommandBuffer& buffer, size_t begin, size_t end)>& record);
+
+private:
+	friend class CommandExecutor;
+
+	// Every command starts on this alignment, so they can be read straight out of the buffer
+	static constexpr size_t ALIGNMENT = 8;
+
+	std::vector<uint8_t> _data;
+	uint32_t             _commandCount = 0;
+
+	// Adds a command with extraSize bytes of space after it, and returns where that space starts
+	uint8_t* _Push(CommandType type, const void* command, size_t commandSize, size_t extraSize);
+	template <typename T>
+	void _Push(CommandType type, const T& command) { _Push(type, &command, sizeof(T), 0); }
+	void _PushUniform(const Shader& shader, int location, UniformType type, const void* value, size_t size);
+};
+
+/// <summary>
+/// Replays command buffers on the thread that owns the GL context. The executor remembers the program, vertex array,
+/// textures and capabilities it has set, and skips commands that wouldn't change anything, so buffers recorded
+/// separately don't need to know what came before them.
+///
+/// Anything that changes GL state outside of the executor makes it out of date, call Invalidate before executing after
+/// that happens
+/// </summary>
+class CommandExecutor final
+{
+public:
+	/// <summary>
+	/// The work done since the stats were last reset
+	/// </summary>
+	struct Stats
+	{
+		uint32_t Buffers = 0;
+		uint32_t Commands = 0;
+		uint32_t Draws = 0;
+		// Commands skipped since they wouldn't have changed any state
+		uint32_t Filtered = 0;
+	};
+
+	static constexpr int MAX_TEXTURE_SLOTS = 32;
+
+	CommandExecutor();
+	~CommandExecutor() = default;
+
+	CommandExecutor(const CommandExecutor& other) = delete;
+	CommandExecutor& operator=(const CommandExecutor& other) = delete;
+
+	/// <summary>
+	/// Forgets the state we think is bound, so the next commands set everything again
+	/// </summary>
+	void Invalidate();
+
+	/// <summary>
+	/// Runs every command in a buffer, in order
+	/// </summary>
+	void Execute(const CommandBuffer& commands);
+
+	void ResetStats() { _stats = Stats(); }
+	const Stats& GetStats() const { return _stats; }
+
+	/// <summary>
+	/// Draws the stats from the last time they were reset
+	/// </summary>
+	void RenderImGui();
+
+private:
+	// The handles we've bound, 0 when we don't know what is bound
+	GLuint _program;
+	GLuint _vertexArray;
+	// The textures we've bound to each slot (null when unbound), and whether we know what's in the slot at all
+	const ITexture* _textures[MAX_TEXTURE_SLOTS];
+	bool            _textureKnown[MAX_TEXTURE_SLOTS];
+	// The capabilities we've set, and whether they're enabled
+	std::vector<std::pair<GLenum, bool>> _capabilities;
+	Stats _stats;
+
+	void _SetUniform(const RenderCommands::SetUniform& command, const void* values);
+};
@@ -0,0 +1,50 @@
+#include "DynamicResolution.h"
+
+#include <imgui.h>
+
+void DynamicResolution::Update(float gpuFrameMs) {
+	_lastFrameMs = gpuFrameMs;
+	if (!Enabled) {
+		_scale = MaxScale;
+		_overFrames = _underFrames = 0;
+		return;
+	}
+	// We won't have any timings for the first few frames
+	if (gpuFrameMs <= 0.0f) {
+		return;
+	}
+
+	if (gpuFrameMs > TargetFrameMs) {
+		_overFrames++;
+		_underFrames = 0;
+	} else if (gpuFrameMs < TargetFrameMs * UpscaleThreshold) {
+		_underFrames++;
+		_overFrames = 0;
+	} else {
+		// Inside the hysteresis band, we're happy where we are
+		_overFrames = _underFrames = 0;
+	}
+
+	if (_overFrames >= DownscaleFrames) {
+		// Most of our cost scales with the pixel count, so shed the fraction of pixels we're over by
+		const float desired = _scale * glm::sqrt(TargetFrameMs / gpuFrameMs);
+		_scale = glm::max(desired, _scale - MaxDownscaleStep);
+		_overFrames = 0;
+	} else if (_underFrames >= UpscaleFrames) {
+		_scale += UpscaleStep;
+		_underFrames = 0;
+	}
+	_scale = glm::clamp(_scale, MinScale, MaxScale);
+}
+
+glm::uvec2 DynamicResolution::GetRenderSize(unsigned width, unsigned height) const {
+	return glm::max(glm::uvec2(glm::round(glm::vec2(width, height) * _scale)), glm::uvec2(1));
+}
+
+void DynamicResolution::RenderImGui() {
+	ImGui::Checkbox("Dynamic Resolution", &Enabled);
+	ImGui::SliderFloat("Target GPU Time (ms)", &TargetFrameMs, 4.0f, 33.3f);
+	ImGui::SliderFloat("Min Scale", &MinScale, 0.25f, 1.0f);
+	MaxScale = glm::max(MaxScale, MinScale);
+	ImGui::Text("Scale: %.0f%% GPU: %.2f ms", _scale * 100.0f, _lastFrameMs);
+}
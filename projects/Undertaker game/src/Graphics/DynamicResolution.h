@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// Picks a resolution scale for the scene from the measured GPU frame time. When we go over our target frame time
+/// the scale drops (roughly in proportion to the pixels we need to shed), and when we have been comfortably under it
+/// for a while it creeps back up. The band between the two thresholds, and the number of frames each needs to hold
+/// for, keep the scale from oscillating. The scene is rendered into the bottom left of full size targets, so changing
+/// the scale never reallocates anything
+/// </summary>
+class DynamicResolution final
+{
+public:
+	/// <summary>
+	/// When disabled, the scale stays at MaxScale
+	/// </summary>
+	bool  Enabled = true;
+	/// <summary>
+	/// The GPU frame time we try to stay under, in milliseconds
+	/// </summary>
+	float TargetFrameMs = 16.6f;
+	/// <summary>
+	/// The smallest and largest scales we will pick, along each axis
+	/// </summary>
+	float MinScale = 0.5f;
+	float MaxScale = 1.0f;
+	/// <summary>
+	/// We only scale up when the frame time is below this fraction of the target
+	/// </summary>
+	float UpscaleThreshold = 0.8f;
+	/// <summary>
+	/// How many frames in a row we need to be over or under before changing the scale. GPU timings lag behind by a few
+	/// frames, so these should be at least that long
+	/// </summary>
+	uint32_t DownscaleFrames = 5;
+	uint32_t UpscaleFrames = 60;
+	/// <summary>
+	/// How far to step the scale up at a time, and the most it can drop at once
+	/// </summary>
+	float UpscaleStep = 0.05f;
+	float MaxDownscaleStep = 0.2f;
+
+	/// <summary>
+	/// Updates the scale from the latest GPU frame time, should be called once per frame
+	/// </summary>
+	/// <param name="gpuFrameMs">The time the GPU spent on the last frame, in milliseconds</param>
+	void Update(float gpuFrameMs);
+
+	/// <summary>
+	/// Gets the current scale along each axis
+	/// </summary>
+	float GetScale() const { return _scale; }
+	/// <summary>
+	/// Gets the size to render the scene at, for a target of the given size
+	/// </summary>
+	glm::uvec2 GetRenderSize(unsigned width, unsigned height) const;
+
+	/// <summary>
+	/// Draws the controller's settings and current scale using ImGui, should be called inside of an ImGui window
+	/// </summary>
+	void RenderImGui();
+
+private:
+	float    _scale = 1.0f;
+	float    _lastFrameMs = 0.0f;
+	uint32_t _overFrames = 0;
+	uint32_t _underFrames = 0;
+};
@@ -0,0 +1,443 @@
+#include "EnvironmentMap.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <GLM/gtc/packing.hpp>
+#include <GLM/gtc/constants.hpp>
+
+#include "Logging.h"
+#include "Utilities/MappedFile.h"
+#include "Utilities/SphericalHarmonics.h"
+
+// Header at the start of our environment caches, followed directly by the half float texels of every level
+struct EnvironmentCacheHeader
+{
+	char     Magic[4];
+	uint32_t Version;
+	uint32_t Size;
+	uint32_t Levels;
+	float    IrradianceSH[27];
+};
+static const char ENVIRONMENT_CACHE_MAGIC[4] = { 'E', 'N', 'V', '1' };
+static const uint32_t ENVIRONMENT_CACHE_VERSION = 1;
+
+// Irradiance is low frequency enough that we can project it from a small mip
+static const uint32_t IRRADIANCE_SOURCE_SIZE = 32;
+
+namespace {
+	// A float RGB cubemap level that we can sample on the CPU, faces are stored back to back with rows top to bottom
+	struct CubeImage
+	{
+		uint32_t Size = 0;
+		std::vector<glm::vec3> Texels;
+
+		const glm::vec3& At(int face, uint32_t x, uint32_t y) const {
+			return Texels[((size_t)face * Size + y) * Size + x];
+		}
+	};
+}
+
+// Gets the direction through a point on a face, where s and t go from 0 to 1 (following the OpenGL cubemap layout)
+static glm::vec3 FaceDirection(int face, float s, float t) {
+	const float u = s * 2.0f - 1.0f;
+	const float v = t * 2.0f - 1.0f;
+	switch (face) {
+		case 0:  return glm::normalize(glm::vec3( 1.0f, -v, -u));
+		case 1:  return glm::normalize(glm::vec3(-1.0f, -v,  u));
+		case 2:  return glm::normalize(glm::vec3( u,  1.0f,  v));
+		case 3:  return glm::normalize(glm::vec3( u, -1.0f, -v));
+		case 4:  return glm::normalize(glm::vec3( u, -v,  1.0f));
+		default: return glm::normalize(glm::vec3(-u, -v, -1.0f));
+	}
+}
+
+// The inverse of FaceDirection, picks the face a direction passes through and where
+static void DirectionToFace(const glm::vec3& dir, int& face, float& s, float& t) {
+	const glm::vec3 a = glm::abs(dir);
+	float major, sc, tc;
+	if (a.x >= a.y && a.x >= a.z) {
+		face = dir.x > 0.0f ? 0 : 1;
+		major = a.x;
+		sc = dir.x > 0.0f ? -dir.z : dir.z;
+		tc = -dir.y;
+	} else if (a.y >= a.z) {
+		face = dir.y > 0.0f ? 2 : 3;
+		major = a.y;
+		sc = dir.x;
+		tc = dir.y > 0.0f ? dir.z : -dir.z;
+	} else {
+		face = dir.z > 0.0f ? 4 : 5;
+		major = a.z;
+		sc = dir.z > 0.0f ? dir.x : -dir.x;
+		tc = -dir.y;
+	}
+	s = 0.5f * (sc / major + 1.0f);
+	t = 0.5f * (tc / major + 1.0f);
+}
+
+static glm::vec3 SampleBilinear(const CubeImage& image, const glm::vec3& dir) {
+	int face;
+	float s, t;
+	DirectionToFace(dir, face, s, t);
+
+	// Clamping at the face edges is close enough for filtering, the seams are hidden by the blur
+	const float x = glm::clamp(s * image.Size - 0.5f, 0.0f, (float)(image.Size - 1));
+	const float y = glm::clamp(t * image.Size - 0.5f, 0.0f, (float)(image.Size - 1));
+	const uint32_t x0 = (uint32_t)x, y0 = (uint32_t)y;
+	const uint32_t x1 = glm::min(x0 + 1, image.Size - 1), y1 = glm::min(y0 + 1, image.Size - 1);
+	const float fx = x - x0, fy = y - y0;
+	return glm::mix(
+		glm::mix(image.At(face, x0, y0), image.At(face, x1, y0), fx),
+		glm::mix(image.At(face, x0, y1), image.At(face, x1, y1), fx), fy);
+}
+
+static glm::vec3 SampleTrilinear(const std::vector<CubeImage>& mips, const glm::vec3& dir, float lod) {
+	lod = glm::clamp(lod, 0.0f, (float)(mips.size() - 1));
+	const int low = (int)lod;
+	const int high = glm::min(low + 1, (int)mips.size() - 1);
+	return glm::mix(SampleBilinear(mips[low], dir), SampleBilinear(mips[high], dir), lod - low);
+}
+
+static CubeImage Downsample(const CubeImage& image) {
+	CubeImage result;
+	result.Size = glm::max(image.Size / 2, 1u);
+	result.Texels.resize((size_t)result.Size * result.Size * 6);
+	for (int face = 0; face < 6; face++) {
+		for (uint32_t y = 0; y < result.Size; y++) {
+			const uint32_t y0 = glm::min(y * 2, image.Size - 1), y1 = glm::min(y * 2 + 1, image.Size - 1);
+			for (uint32_t x = 0; x < result.Size; x++) {
+				const uint32_t x0 = glm::min(x * 2, image.Size - 1), x1 = glm::min(x * 2 + 1, image.Size - 1);
+				result.Texels[((size_t)face * result.Size + y) * result.Size + x] = 0.25f *
+					(image.At(face, x0, y0) + image.At(face, x1, y0) + image.At(face, x0, y1) + image.At(face, x1, y1));
+			}
+		}
+	}
+	return result;
+}
+
+// A low discrepancy point set, spreads our samples out far better than random numbers would
+static glm::vec2 Hammersley(uint32_t index, uint32_t count) {
+	uint32_t bits = index;
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return glm::vec2((float)index / count, bits * 2.3283064365386963e-10f);
+}
+
+// Gets a half vector around normal, distributed following GGX for the given roughness
+static glm::vec3 ImportanceSampleGGX(const glm::vec2& xi, const glm::vec3& normal, float roughness) {
+	const float a = roughness * roughness;
+	const float phi = glm::two_pi<float>() * xi.x;
+	const float cosTheta = glm::sqrt((1.0f - xi.y) / (1.0f + (a * a - 1.0f) * xi.y));
+	const float sinTheta = glm::sqrt(1.0f - cosTheta * cosTheta);
+	const glm::vec3 h = glm::vec3(glm::cos(phi) * sinTheta, glm::sin(phi) * sinTheta, cosTheta);
+
+	const glm::vec3 up = glm::abs(normal.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+	const glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
+	const glm::vec3 bitangent = glm::cross(normal, tangent);
+	return glm::normalize(tangent * h.x + bitangent * h.y + normal * h.z);
+}
+
+static float DistributionGGX(float nDotH, float roughness) {
+	const float a2 = roughness * roughness * roughness * roughness;
+	const float denom = nDotH * nDotH * (a2 - 1.0f) + 1.0f;
+	return a2 / (glm::pi<float>() * denom * denom);
+}
+
+// Filters one face of one level of the radiance map. We assume the view direction is the normal (like everyone does),
+// which loses the stretched highlights at grazing angles but lets a single lookup stand in for the whole integral
+static void PrefilterFace(const std::vector<CubeImage>& mips, int face, uint32_t size, float roughness, uint16_t* out) {
+	const float sourceTexelAngle = 4.0f * glm::pi<float>() / (6.0f * mips[0].Size * mips[0].Size);
+	for (uint32_t y = 0; y < size; y++) {
+		for (uint32_t x = 0; x < size; x++) {
+			const glm::vec3 normal = FaceDirection(face, (x + 0.5f) / size, (y + 0.5f) / size);
+			glm::vec3 color;
+
+			if (roughness <= 0.0f) {
+				// A perfect mirror just needs the source at our resolution
+				color = SampleTrilinear(mips, normal, glm::log2((float)mips[0].Size / size));
+			} else {
+				glm::vec3 sum = glm::vec3(0.0f);
+				float weight = 0.0f;
+				for (uint32_t ix = 0; ix < EnvironmentMap::SAMPLE_COUNT; ix++) {
+					const glm::vec3 h = ImportanceSampleGGX(Hammersley(ix, EnvironmentMap::SAMPLE_COUNT), normal, roughness);
+					const glm::vec3 l = 2.0f * glm::dot(normal, h) * h - normal;
+					const float nDotL = glm::dot(normal, l);
+					if (nDotL > 0.0f) {
+						// Sample a blurrier source mip for samples that cover more of the sphere, so a small number
+						// of samples doesn't alias (filtered importance sampling)
+						const float nDotH = glm::max(glm::dot(normal, h), 0.0f);
+						const float pdf = DistributionGGX(nDotH, roughness) * 0.25f;
+						const float sampleAngle = 1.0f / (EnvironmentMap::SAMPLE_COUNT * pdf + 0.0001f);
+						const float lod = 0.5f * glm::log2(sampleAngle / sourceTexelAngle) + 1.0f;
+						sum += SampleTrilinear(mips, l, lod) * nDotL;
+						weight += nDotL;
+					}
+				}
+				color = weight > 0.0f ? sum / weight : glm::vec3(0.0f);
+			}
+
+			uint16_t* texel = out + ((size_t)y * size + x) * 3;
+			texel[0] = glm::packHalf1x16(color.r);
+			texel[1] = glm::packHalf1x16(color.g);
+			texel[2] = glm::packHalf1x16(color.b);
+		}
+	}
+}
+
+// Projects the radiance onto the first 9 spherical harmonics, then convolves them with the cosine lobe
+static void ProjectIrradiance(const CubeImage& image, glm::vec3 sh[9]) {
+	for (int ix = 0; ix < 9; ix++) {
+		sh[ix] = glm::vec3(0.0f);
+	}
+
+	float totalWeight = 0.0f;
+	for (int face = 0; face < 6; face++) {
+		for (uint32_t y = 0; y < image.Size; y++) {
+			for (uint32_t x = 0; x < image.Size; x++) {
+				const float u = (x + 0.5f) / image.Size * 2.0f - 1.0f;
+				const float v = (y + 0.5f) / image.Size * 2.0f - 1.0f;
+				// Texels near the corners of a face cover less of the sphere than ones in the middle
+				const float weight = 1.0f / glm::pow(1.0f + u * u + v * v, 1.5f);
+				const glm::vec3 d = FaceDirection(face, (x + 0.5f) / image.Size, (y + 0.5f) / image.Size);
+				SphericalHarmonics::AddSample(sh, d, image.At(face, x, y) * weight);
+				totalWeight += weight;
+			}
+		}
+	}
+
+	// Normalize so the weights cover the whole sphere, then turn the radiance into irradiance
+	const float normalization = 4.0f * glm::pi<float>() / totalWeight;
+	for (int ix = 0; ix < 9; ix++) {
+		sh[ix] *= normalization;
+	}
+	SphericalHarmonics::ConvolveCosineLobe(sh);
+}
+
+EnvironmentMap::EnvironmentMap(const std::string& rootImagePath) :
+	_path(rootImagePath)
+{
+	for (int ix = 0; ix < 9; ix++) {
+		_irradianceSH[ix] = glm::vec3(0.0f);
+	}
+	// A flat ambient until the real thing is ready
+	_irradianceSH[0] = glm::vec3(0.5f / 0.282095f);
+
+	TextureCubeDesc desc;
+	desc.Size = 1;
+	desc.Format = InternalFormat::R11G11B10F;
+	_radiance = TextureCubeMap::Create(desc);
+	const glm::vec3 grey[6] = { glm::vec3(0.5f), glm::vec3(0.5f), glm::vec3(0.5f), glm::vec3(0.5f), glm::vec3(0.5f), glm::vec3(0.5f) };
+	_radiance->LoadMipData(0, PixelFormat::RGB, PixelType::Float, grey);
+
+	_pending = std::async(std::launch::async, &EnvironmentMap::_Load, rootImagePath);
+}
+
+EnvironmentMap::~EnvironmentMap() {
+	// Don't leave a worker running with nobody to hand its results to
+	if (_pending.valid()) {
+		_pending.wait();
+	}
+}
+
+bool EnvironmentMap::Update() {
+	if (!_pending.valid() || _pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+		return false;
+	}
+
+	FilteredEnvironment result = _pending.get();
+	if (!result.Valid) {
+		LOG_WARN("Failed to load environment \"{}\", keeping the placeholder", _path);
+		return false;
+	}
+
+	TextureCubeDesc desc;
+	desc.Size = result.Size;
+	desc.Format = InternalFormat::R11G11B10F;
+	desc.MinificationFilter = MinFilter::LinearMipLinear;
+	desc.MipLevels = result.Levels;
+	_radiance->Recreate(desc);
+	_radiance->SetDebugName(std::filesystem::path(_path).filename().string() + " (prefiltered)");
+
+	size_t offset = 0;
+	for (uint32_t level = 0; level < result.Levels; level++) {
+		const size_t size = glm::max(result.Size >> level, 1u);
+		_radiance->LoadMipData(level, PixelFormat::RGB, PixelType::HalfFloat, result.Texels.data() + offset);
+		offset += size * size * 6 * 3;
+	}
+
+	for (int ix = 0; ix < 9; ix++) {
+		_irradianceSH[ix] = result.IrradianceSH[ix];
+	}
+
+	_isReady = true;
+	LOG_INFO("Environment \"{}\" is ready, {}x{} with {} levels", _path, result.Size, result.Size, result.Levels);
+	return true;
+}
+
+void EnvironmentMap::SetUniforms(const Shader::sptr& shader) const {
+	shader->SetUniform("u_EnvironmentMaxLod", (float)(_radiance->GetMipLevelCount() - 1));
+	shader->SetUniform(shader->GetUniformLocation("u_IrradianceSH"), _irradianceSH, 9);
+}
+
+EnvironmentMap::FilteredEnvironment EnvironmentMap::_Load(const std::string& rootImagePath) {
+	FilteredEnvironment result;
+	const std::string cachePath = rootImagePath + ".bin";
+	if (_LoadCache(cachePath, rootImagePath, result)) {
+		return result;
+	}
+
+	TextureCubeMapData::sptr source = TextureCubeMapData::LoadFromImages(rootImagePath);
+	if (source == nullptr) {
+		return result;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	result = _Filter(source);
+	if (result.Valid) {
+		auto end = std::chrono::high_resolution_clock::now();
+		LOG_INFO("Filtered environment \"{}\" in {} ms", rootImagePath, std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+		_WriteCache(cachePath, result);
+	}
+	return result;
+}
+
+EnvironmentMap::FilteredEnvironment EnvironmentMap::_Filter(const TextureCubeMapData::sptr& source) {
+	FilteredEnvironment result;
+	if (source->GetPixelType() != PixelType::UByte) {
+		LOG_WARN("Environment filtering only supports 8 bit images, got {}", source->GetPixelType());
+		return result;
+	}
+
+	// Convert the source to floats, and build its mip chain for filtered importance sampling
+	const int channels = GetTexelComponentCount(source->GetFormat());
+	std::vector<CubeImage> mips(1);
+	mips[0].Size = source->GetSize();
+	mips[0].Texels.resize((size_t)mips[0].Size * mips[0].Size * 6);
+	const uint8_t* bytes = static_cast<const uint8_t*>(source->GetDataPtr());
+	for (size_t ix = 0; ix < mips[0].Texels.size(); ix++) {
+		const uint8_t* texel = bytes + ix * channels;
+		mips[0].Texels[ix] = channels >= 3 ?
+			glm::vec3(texel[0], texel[1], texel[2]) / 255.0f :
+			glm::vec3(texel[0] / 255.0f);
+	}
+	while (mips.back().Size > 1) {
+		mips.push_back(Downsample(mips.back()));
+	}
+
+	result.Size = glm::min(PREFILTERED_SIZE, mips[0].Size);
+	result.Levels = 1;
+	while ((result.Size >> result.Levels) >= MIN_LEVEL_SIZE) {
+		result.Levels++;
+	}
+
+	std::vector<size_t> levelOffsets(result.Levels);
+	size_t texelCount = 0;
+	for (uint32_t level = 0; level < result.Levels; level++) {
+		const size_t size = glm::max(result.Size >> level, 1u);
+		levelOffsets[level] = texelCount;
+		texelCount += size * size * 6;
+	}
+	result.Texels.resize(texelCount * 3);
+
+	// Every face of every level is independent, so each face gets its own worker
+	std::vector<std::future<void>> tasks;
+	for (int face = 0; face < 6; face++) {
+		tasks.push_back(std::async(std::launch::async, [&, face]() {
+			for (uint32_t level = 0; level < result.Levels; level++) {
+				const uint32_t size = glm::max(result.Size >> level, 1u);
+				const float roughness = result.Levels > 1 ? (float)level / (result.Levels - 1) : 0.0f;
+				uint16_t* out = result.Texels.data() + (levelOffsets[level] + (size_t)face * size * size) * 3;
+				PrefilterFace(mips, face, size, roughness, out);
+			}
+		}));
+	}
+
+	// Irradiance is cheap enough to do while the faces are filtering
+	const CubeImage* irradianceSource = &mips.back();
+	for (const CubeImage& mip : mips) {
+		if (mip.Size <= IRRADIANCE_SOURCE_SIZE) {
+			irradianceSource = &mip;
+			break;
+		}
+	}
+	ProjectIrradiance(*irradianceSource, result.IrradianceSH);
+
+	for (auto& task : tasks) {
+		task.wait();
+	}
+	result.Valid = true;
+	return result;
+}
+
+bool EnvironmentMap::_LoadCache(const std::string& cachePath, const std::string& rootImagePath, FilteredEnvironment& result) {
+	std::error_code error;
+	if (!std::filesystem::exists(cachePath, error)) {
+		return false;
+	}
+	// If we still have the faces, make sure the cache isn't older than any of them
+	const auto cacheTime = std::filesystem::last_write_time(cachePath, error);
+	for (int ix = 0; ix < 6; ix++) {
+		const std::string facePath = TextureCubeMapData::GetFacePath(rootImagePath, (CubeMapFace)ix);
+		if (std::filesystem::exists(facePath, error) && cacheTime < std::filesystem::last_write_time(facePath, error)) {
+			return false;
+		}
+	}
+
+	MappedFile file;
+	if (!file.Open(cachePath) || file.GetSize() < sizeof(EnvironmentCacheHeader)) {
+		return false;
+	}
+
+	EnvironmentCacheHeader header;
+	memcpy(&header, file.GetData(), sizeof(EnvironmentCacheHeader));
+	if (memcmp(header.Magic, ENVIRONMENT_CACHE_MAGIC, 4) != 0 || header.Version != ENVIRONMENT_CACHE_VERSION ||
+		header.Size == 0 || header.Levels == 0 || header.Levels > 32) {
+		LOG_WARN("Environment cache \"{}\" is invalid, it will be rebuilt", cachePath);
+		return false;
+	}
+	size_t texelCount = 0;
+	for (uint32_t level = 0; level < header.Levels; level++) {
+		const size_t size = glm::max(header.Size >> level, 1u);
+		texelCount += size * size * 6;
+	}
+	if (file.GetSize() != sizeof(EnvironmentCacheHeader) + texelCount * 3 * sizeof(uint16_t)) {
+		LOG_WARN("Environment cache \"{}\" is the wrong size, it will be rebuilt", cachePath);
+		return false;
+	}
+
+	result.Size = header.Size;
+	result.Levels = header.Levels;
+	for (int ix = 0; ix < 9; ix++) {
+		result.IrradianceSH[ix] = glm::vec3(header.IrradianceSH[ix * 3], header.IrradianceSH[ix * 3 + 1], header.IrradianceSH[ix * 3 + 2]);
+	}
+	result.Texels.resize(texelCount * 3);
+	memcpy(result.Texels.data(), file.GetData() + sizeof(EnvironmentCacheHeader), result.Texels.size() * sizeof(uint16_t));
+	result.Valid = true;
+	return true;
+}
+
+void EnvironmentMap::_WriteCache(const std::string& cachePath, const FilteredEnvironment& environment) {
+	EnvironmentCacheHeader header;
+	memcpy(header.Magic, ENVIRONMENT_CACHE_MAGIC, 4);
+	header.Version = ENVIRONMENT_CACHE_VERSION;
+	header.Size = environment.Size;
+	header.Levels = environment.Levels;
+	for (int ix = 0; ix < 9; ix++) {
+		for (int c = 0; c < 3; c++) {
+			header.IrradianceSH[ix * 3 + c] = environment.IrradianceSH[ix][c];
+		}
+	}
+
+	std::ofstream file(cachePath, std::ios::binary);
+	if (!file.is_open()) {
+		LOG_WARN("Failed to write environment cache \"{}\"", cachePath);
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(EnvironmentCacheHeader));
+	file.write(reinterpret_cast<const char*>(environment.Texels.data()), environment.Texels.size() * sizeof(uint16_t));
+}
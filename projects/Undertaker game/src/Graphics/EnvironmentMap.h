@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "TextureCubeMap.h"
+#include "Shader.h"
+
+/// <summary>
+/// A cubemap prepared for image based lighting. The radiance map is prefiltered with the GGX distribution, with the
+/// roughness going up with each mip level, so a rough reflection is a single trilinear lookup at a mip picked from the
+/// roughness instead of a filter in the shader. Diffuse irradiance is stored as 9 (order 2) spherical harmonic
+/// coefficients, which is plenty for something as low frequency as irradiance and only costs a handful of uniforms.
+///
+/// Filtering happens on worker threads the first time an environment is loaded, and the result is cached next to the
+/// source images, so later runs only have to read it back. Until the result is ready, the radiance map is a flat grey
+/// placeholder, so materials can be set up with it right away.
+/// </summary>
+class EnvironmentMap final
+{
+public:
+	typedef std::shared_ptr<EnvironmentMap> sptr;
+	static inline sptr Create(const std::string& rootImagePath) {
+		return std::make_shared<EnvironmentMap>(rootImagePath);
+	}
+
+	/// <summary>
+	/// The size of the top (mirror-like) level of the prefiltered map, larger sources are filtered down to this
+	/// </summary>
+	static constexpr uint32_t PREFILTERED_SIZE = 128;
+	/// <summary>
+	/// The smallest mip we filter, which holds the roughest reflections
+	/// </summary>
+	static constexpr uint32_t MIN_LEVEL_SIZE = 4;
+	/// <summary>
+	/// The number of GGX samples taken for each texel of the rough levels
+	/// </summary>
+	static constexpr uint32_t SAMPLE_COUNT = 128;
+
+	/// <summary>
+	/// Starts loading and filtering an environment in the background
+	/// </summary>
+	/// <param name="rootImagePath">The base path of the faces, see TextureCubeMapData::LoadFromImages</param>
+	explicit EnvironmentMap(const std::string& rootImagePath);
+	~EnvironmentMap();
+
+	EnvironmentMap(const EnvironmentMap& other) = delete;
+	EnvironmentMap& operator=(const EnvironmentMap& other) = delete;
+
+	/// <summary>
+	/// Uploads the filtered environment once the workers are done, should be called once per frame
+	/// </summary>
+	/// <returns>True if the environment was uploaded during this call</returns>
+	bool Update();
+
+	/// <summary>
+	/// Gets whether the filtered environment has been uploaded
+	/// </summary>
+	bool IsReady() const { return _isReady; }
+
+	/// <summary>
+	/// Gets the prefiltered radiance map, this texture is the same object before and after filtering finishes
+	/// </summary>
+	const TextureCubeMap::sptr& GetRadiance() const { return _radiance; }
+	/// <summary>
+	/// Gets the irradiance spherical harmonic coefficients, already convolved with the cosine lobe (and divided by
+	/// pi), so that evaluating them at a normal gives the light a white diffuse surface reflects
+	/// </summary>
+	const glm::vec3* GetIrradianceSH() const { return _irradianceSH; }
+
+	/// <summary>
+	/// Sets the environment's uniforms on a shader (u_EnvironmentMaxLod and u_IrradianceSH). These are not
+	/// material parameters, so this needs to be called again whenever Update returns true
+	/// </summary>
+	void SetUniforms(const Shader::sptr& shader) const;
+
+private:
+	// What the workers hand back to the main thread
+	struct FilteredEnvironment
+	{
+		bool      Valid = false;
+		uint32_t  Size = 0;
+		uint32_t  Levels = 0;
+		// Half float RGB texels for every level, with the six faces of each level back to back
+		std::vector<uint16_t> Texels;
+		glm::vec3 IrradianceSH[9];
+	};
+
+	std::string              _path;
+	TextureCubeMap::sptr     _radiance;
+	glm::vec3                _irradianceSH[9];
+	std::future<FilteredEnvironment> _pending;
+	bool                     _isReady = false;
+
+	static FilteredEnvironment _Load(const std::string& rootImagePath);
+	static bool _LoadCache(const std::string& cachePath, const std::string& rootImagePath, FilteredEnvironment& result);
+	static void _WriteCache(const std::string& cachePath, const FilteredEnvironment& environment);
+	static FilteredEnvironment _Filter(const TextureCubeMapData::sptr& source);
+};
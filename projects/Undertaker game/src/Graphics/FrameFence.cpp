@@ -0,0 +1,52 @@
+#include "FrameFence.h"
+
+#include <chrono>
+#include "Logging.h"
+
+FrameFence::FrameFence() :
+	_frameIx(0),
+	_lastWaitMs(0.0f)
+{
+	for (uint32_t ix = 0; ix < MAX_FRAMES_IN_FLIGHT; ix++) {
+		_fences[ix] = nullptr;
+	}
+}
+
+FrameFence::~FrameFence() {
+	for (uint32_t ix = 0; ix < MAX_FRAMES_IN_FLIGHT; ix++) {
+		if (_fences[ix] != nullptr) {
+			glDeleteSync(_fences[ix]);
+		}
+	}
+}
+
+void FrameFence::Wait() {
+	GLsync& fence = _fences[_frameIx];
+	_lastWaitMs = 0.0f;
+	if (fence == nullptr) {
+		return;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	// Flush the first time around, so the fence is guaranteed to be submitted and we can't wait on it forever
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	while (result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(fence, 0, 1000000); // 1ms, in nanoseconds
+	}
+	if (result == GL_WAIT_FAILED) {
+		LOG_WARN("Failed to wait on a frame fence");
+	}
+	_lastWaitMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void FrameFence::Signal() {
+	GLsync& fence = _fences[_frameIx];
+	if (fence != nullptr) {
+		glDeleteSync(fence);
+	}
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	_frameIx = (_frameIx + 1) % MAX_FRAMES_IN_FLIGHT;
+}
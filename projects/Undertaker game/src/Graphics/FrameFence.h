@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <glad/glad.h>
+
+/// <summary>
+/// Keeps the CPU from queueing up too many frames ahead of the GPU. The driver will happily buffer several frames of
+/// commands, which adds a frame of latency for each one, so we put a fence after each frame and wait on the one from
+/// MAX_FRAMES_IN_FLIGHT frames ago before starting a new one
+/// </summary>
+class FrameFence final
+{
+public:
+	static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+
+	FrameFence();
+	~FrameFence();
+
+	FrameFence(const FrameFence& other) = delete;
+	FrameFence& operator=(const FrameFence& other) = delete;
+
+	/// <summary>
+	/// Waits until the GPU has finished the frame from MAX_FRAMES_IN_FLIGHT frames ago, call this before submitting any
+	/// work for a new frame
+	/// </summary>
+	void Wait();
+	/// <summary>
+	/// Marks the end of this frame's GPU work, call this after the frame's buffers are swapped
+	/// </summary>
+	void Signal();
+
+	/// <summary>
+	/// Gets how long the last call to Wait spent waiting on the GPU, in milliseconds
+	/// </summary>
+	float GetLastWaitMs() const { return _lastWaitMs; }
+
+private:
+	GLsync   _fences[MAX_FRAMES_IN_FLIGHT];
+	uint32_t _frameIx;
+	float    _lastWaitMs;
+};
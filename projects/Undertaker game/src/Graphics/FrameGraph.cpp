@@ -0,0 +1,333 @@
+#include "FrameGraph.h"
+
+#include <chrono>
+#include <queue>
+#include <functional>
+#include <imgui.h>
+#include "Logging.h"
+
+// How quickly our smoothed timings follow new samples
+static constexpr float TIMING_SMOOTHING = 0.1f;
+
+void FrameGraph::PassBuilder::Read(FrameGraphResource resource, bool depth) {
+	LOG_ASSERT(resource >= 0 && resource < (int)_graph._resources.size(), "Invalid frame graph resource");
+	_graph._passes[_pass].Reads.push_back(resource);
+	if (depth) {
+		_graph._passes[_pass].DepthReads.push_back(resource);
+	}
+	_graph._resources[resource].Readers.push_back(_pass);
+}
+
+void FrameGraph::PassBuilder::Write(FrameGraphResource resource) {
+	LOG_ASSERT(resource >= 0 && resource < (int)_graph._resources.size(), "Invalid frame graph resource");
+	_graph._passes[_pass].Writes.push_back(resource);
+	_graph._resources[resource].Writers.push_back(_pass);
+}
+
+FrameGraph::~FrameGraph() {
+	for (auto& kvp : _timings) {
+		if (kvp.second.Queries[0] != 0) {
+			glDeleteQueries(3, kvp.second.Queries);
+		}
+	}
+}
+
+FrameGraphResource FrameGraph::CreateTarget(const std::string& name, const RenderTargetDesc& desc) {
+	FrameGraphResource result = _AddResource(name, ResourceType::Transient);
+	_resources[result].Desc = desc;
+	return result;
+}
+
+FrameGraphResource FrameGraph::ImportTarget(const std::string& name, Framebuffer* target) {
+	FrameGraphResource result = _AddResource(name, ResourceType::ImportedTarget);
+	_resources[result].Target = target;
+	return result;
+}
+
+FrameGraphResource FrameGraph::ImportBackbuffer(const std::string& name, unsigned width, unsigned height) {
+	FrameGraphResource result = _AddResource(name, ResourceType::Backbuffer);
+	_resources[result].Desc = RenderTargetDesc(width, height);
+	return result;
+}
+
+FrameGraphResource FrameGraph::ImportResource(const std::string& name) {
+	return _AddResource(name, ResourceType::External);
+}
+
+void FrameGraph::AddPass(const std::string& name, const SetupCallback& setup, const ExecuteCallback& execute) {
+	LOG_ASSERT(!_isCompiled, "Passes cannot be added to a frame graph after it has been compiled");
+	Pass pass;
+	pass.Name = name;
+	pass.Execute = execute;
+	_passes.push_back(pass);
+
+	PassBuilder builder(*this, (int)_passes.size() - 1);
+	setup(builder);
+}
+
+void FrameGraph::Compile() {
+	const int passCount = (int)_passes.size();
+
+	// Work out which passes each pass depends on. Everything follows the order passes were added in: readers depend on
+	// the passes added before them that write what they read, and writers depend on the passes added before them that
+	// write what they write. Writers also have to wait for earlier readers of what they write, so a later write never
+	// overtakes an earlier read, but that only orders the passes and doesn't keep the reader alive
+	std::vector<std::vector<int>> dependencies(passCount);
+	std::vector<std::vector<int>> waitsFor(passCount);
+	for (int ix = 0; ix < passCount; ix++) {
+		for (FrameGraphResource read : _passes[ix].Reads) {
+			for (int writer : _resources[read].Writers) {
+				if (writer < ix) {
+					dependencies[ix].push_back(writer);
+				}
+			}
+		}
+		for (FrameGraphResource write : _passes[ix].Writes) {
+			for (int writer : _resources[write].Writers) {
+				if (writer < ix) {
+					dependencies[ix].push_back(writer);
+				}
+			}
+			for (int reader : _resources[write].Readers) {
+				if (reader < ix) {
+					waitsFor[ix].push_back(reader);
+				}
+			}
+		}
+	}
+
+	// Passes that write to something outside of the graph are our roots, anything they don't depend on gets culled
+	std::vector<int> stack;
+	for (int ix = 0; ix < passCount; ix++) {
+		Pass& pass = _passes[ix];
+		for (FrameGraphResource write : pass.Writes) {
+			pass.SideEffect |= _resources[write].Type != ResourceType::Transient;
+		}
+		if (pass.SideEffect) {
+			pass.Alive = true;
+			stack.push_back(ix);
+		}
+	}
+	while (!stack.empty()) {
+		const int ix = stack.back();
+		stack.pop_back();
+		for (int dependency : dependencies[ix]) {
+			if (!_passes[dependency].Alive) {
+				_passes[dependency].Alive = true;
+				stack.push_back(dependency);
+			}
+		}
+	}
+
+	// Order the live passes, preferring the order they were added in when there is a choice
+	std::vector<int> remaining(passCount, 0);
+	std::vector<std::vector<int>> dependents(passCount);
+	for (int ix = 0; ix < passCount; ix++) {
+		if (!_passes[ix].Alive) {
+			continue;
+		}
+		for (int dependency : dependencies[ix]) {
+			dependents[dependency].push_back(ix);
+			remaining[ix]++;
+		}
+		for (int reader : waitsFor[ix]) {
+			if (_passes[reader].Alive) {
+				dependents[reader].push_back(ix);
+				remaining[ix]++;
+			}
+		}
+	}
+	std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+	for (int ix = 0; ix < passCount; ix++) {
+		if (_passes[ix].Alive && remaining[ix] == 0) {
+			ready.push(ix);
+		}
+	}
+	_order.clear();
+	while (!ready.empty()) {
+		const int ix = ready.top();
+		ready.pop();
+		_order.push_back(ix);
+		for (int dependent : dependents[ix]) {
+			if (--remaining[dependent] == 0) {
+				ready.push(dependent);
+			}
+		}
+	}
+	int aliveCount = 0;
+	for (const Pass& pass : _passes) {
+		aliveCount += pass.Alive ? 1 : 0;
+	}
+	if ((int)_order.size() != aliveCount) {
+		LOG_ERROR("Frame graph has a cycle in it, falling back to the order that passes were added in");
+		_order.clear();
+		for (int ix = 0; ix < passCount; ix++) {
+			if (_passes[ix].Alive) {
+				_order.push_back(ix);
+			}
+		}
+	}
+
+	// Find the span of passes that use each resource, so we know when to acquire, invalidate and release targets
+	for (int ix = 0; ix < (int)_order.size(); ix++) {
+		const Pass& pass = _passes[_order[ix]];
+		auto use = [&](FrameGraphResource resource, bool depth) {
+			Resource& res = _resources[resource];
+			res.FirstUse = res.FirstUse == -1 ? ix : res.FirstUse;
+			res.LastUse = ix;
+			if (depth) {
+				res.LastDepthUse = ix;
+			}
+		};
+		for (FrameGraphResource read : pass.Reads) {
+			use(read, false);
+		}
+		for (FrameGraphResource read : pass.DepthReads) {
+			use(read, true);
+		}
+		for (FrameGraphResource write : pass.Writes) {
+			use(write, true);
+		}
+	}
+
+	_isCompiled = true;
+}
+
+void FrameGraph::Execute() {
+	if (!_isCompiled) {
+		Compile();
+	}
+
+	_lastExecuted.clear();
+	_lastCulled.clear();
+	for (const Pass& pass : _passes) {
+		if (!pass.Alive) {
+			_lastCulled.push_back(pass.Name);
+		}
+	}
+
+	for (int ix = 0; ix < (int)_order.size(); ix++) {
+		Pass& pass = _passes[_order[ix]];
+
+		// Transient targets are only pulled out of the pool right before their first use
+		for (Resource& resource : _resources) {
+			if (resource.Type == ResourceType::Transient && resource.FirstUse == ix) {
+				resource.Target = RenderTargetPool::Instance().Acquire(resource.Desc);
+			}
+		}
+
+		// Bind the first target the pass writes to, so that the pass only needs to draw
+		for (FrameGraphResource write : pass.Writes) {
+			const Resource& resource = _resources[write];
+			if (resource.Type == ResourceType::Backbuffer) {
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+				glViewport(0, 0, resource.Desc.Width, resource.Desc.Height);
+				break;
+			} else if (resource.Target != nullptr) {
+				resource.Target->Bind();
+				resource.Target->SetViewport();
+				break;
+			}
+		}
+
+		PassTiming& timing = _timings[pass.Name];
+		glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, pass.Name.c_str());
+		_BeginTiming(timing);
+		auto start = std::chrono::high_resolution_clock::now();
+
+		pass.Execute(*this);
+
+		auto end = std::chrono::high_resolution_clock::now();
+		_EndTiming(timing, std::chrono::duration<float, std::milli>(end - start).count());
+		glPopDebugGroup();
+		_lastExecuted.push_back(pass.Name);
+
+		// Let the driver know which contents are dead, and return targets we're done with to the pool
+		for (Resource& resource : _resources) {
+			if (resource.Type != ResourceType::Transient || resource.Target == nullptr) {
+				continue;
+			}
+			if (resource.LastUse == ix) {
+				resource.Target->Invalidate();
+				RenderTargetPool::Instance().Release(resource.Target);
+				resource.Target = nullptr;
+			} else if (resource.LastDepthUse == ix) {
+				resource.Target->Invalidate(false, true);
+			}
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	_totalGpuMs = 0.0f;
+	for (const std::string& name : _lastExecuted) {
+		_totalGpuMs += _timings[name].GpuMs;
+	}
+
+	// The graph gets rebuilt every frame
+	_resources.clear();
+	_passes.clear();
+	_order.clear();
+	_isCompiled = false;
+	_frame++;
+}
+
+const FrameGraph::PassTiming* FrameGraph::GetTiming(const std::string& name) const {
+	auto it = _timings.find(name);
+	return it == _timings.end() ? nullptr : &it->second;
+}
+
+void FrameGraph::RenderImGui() {
+	ImGui::Columns(3, "frame_graph");
+	ImGui::Text("Pass"); ImGui::NextColumn();
+	ImGui::Text("CPU (ms)"); ImGui::NextColumn();
+	ImGui::Text("GPU (ms)"); ImGui::NextColumn();
+	ImGui::Separator();
+	for (const std::string& name : _lastExecuted) {
+		const PassTiming& timing = _timings[name];
+		ImGui::Text("%s", name.c_str()); ImGui::NextColumn();
+		ImGui::Text("%.3f", timing.CpuMs); ImGui::NextColumn();
+		ImGui::Text("%.3f", timing.GpuMs); ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+	ImGui::Text("Total GPU: %.3f ms", _totalGpuMs);
+	for (const std::string& name : _lastCulled) {
+		ImGui::TextDisabled("Culled: %s", name.c_str());
+	}
+}
+
+FrameGraphResource FrameGraph::_AddResource(const std::string& name, ResourceType type) {
+	LOG_ASSERT(!_isCompiled, "Resources cannot be added to a frame graph after it has been compiled");
+	Resource resource;
+	resource.Name = name;
+	resource.Type = type;
+	_resources.push_back(resource);
+	return (FrameGraphResource)_resources.size() - 1;
+}
+
+void FrameGraph::_BeginTiming(PassTiming& timing) {
+	if (timing.Queries[0] == 0) {
+		glGenQueries(3, timing.Queries);
+	}
+
+	// Collect the result from the last time this query was used, if it's ready. If the pass was skipped for a few
+	// frames the result will be old, but still a reasonable estimate
+	const int slot = _frame % 3;
+	if (timing.Pending[slot]) {
+		GLint available = 0;
+		glGetQueryObjectiv(timing.Queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available) {
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(timing.Queries[slot], GL_QUERY_RESULT, &nanoseconds);
+			timing.GpuMs += (nanoseconds / 1000000.0f - timing.GpuMs) * TIMING_SMOOTHING;
+		}
+		timing.Pending[slot] = false;
+	}
+	glBeginQuery(GL_TIME_ELAPSED, timing.Queries[slot]);
+}
+
+void FrameGraph::_EndTiming(PassTiming& timing, float cpuMs) {
+	glEndQuery(GL_TIME_ELAPSED);
+	timing.Pending[_frame % 3] = true;
+	timing.CpuMs += (cpuMs - timing.CpuMs) * TIMING_SMOOTHING;
+	timing.LastFrame = _frame;
+}
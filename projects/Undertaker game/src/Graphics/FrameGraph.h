@@ -0,0 +1,183 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <glad/glad.h>
+
+#include "Framebuffer.h"
+#include "RenderTargetPool.h"
+
+/// <summary>
+/// A handle to a resource that passes in a frame graph read from and write to
+/// </summary>
+typedef int FrameGraphResource;
+
+/// <summary>
+/// Describes a frame as a list of passes, each declaring which resources it reads and writes. The graph is rebuilt
+/// every frame; when it is compiled, passes are ordered so that every read comes after the writes it depends on, and
+/// passes whose outputs are never used are culled. Transient render targets are only taken from the render target
+/// pool for the span of passes that use them, and are invalidated once their contents are dead. Each pass is timed on
+/// the CPU and the GPU.
+///
+/// Resources can be transient render targets, imported framebuffers (including the back buffer), or external
+/// resources like LUTs and buffers that are only used to express dependencies.
+/// </summary>
+class FrameGraph final
+{
+public:
+	/// <summary>
+	/// Passed to a pass's setup function, used to declare what the pass reads and writes
+	/// </summary>
+	class PassBuilder
+	{
+	public:
+		/// <summary>
+		/// Declares that the pass reads a resource. For render targets, only the color attachments are assumed to be
+		/// read unless depth is true
+		/// </summary>
+		void Read(FrameGraphResource resource, bool depth = false);
+		/// <summary>
+		/// Declares that the pass writes to a resource. The first render target written is bound for the pass
+		/// </summary>
+		void Write(FrameGraphResource resource);
+		/// <summary>
+		/// Marks the pass as having effects outside of the graph, so that it is never culled
+		/// </summary>
+		void SetSideEffect() { _graph._passes[_pass].SideEffect = true; }
+
+	private:
+		friend class FrameGraph;
+		PassBuilder(FrameGraph& graph, int pass) : _graph(graph), _pass(pass) { }
+		FrameGraph& _graph;
+		int _pass;
+	};
+
+	typedef std::function<void(PassBuilder&)> SetupCallback;
+	typedef std::function<void(FrameGraph&)> ExecuteCallback;
+
+	/// <summary>
+	/// The CPU and GPU time of a pass, smoothed over a few frames
+	/// </summary>
+	struct PassTiming
+	{
+		float CpuMs = 0.0f;
+		float GpuMs = 0.0f;
+		// GPU timings are read back a few frames late, so we don't stall waiting for them
+		GLuint   Queries[3] = { 0, 0, 0 };
+		bool     Pending[3] = { false, false, false };
+		uint32_t LastFrame = 0;
+	};
+
+	FrameGraph() = default;
+	~FrameGraph();
+
+	FrameGraph(const FrameGraph& other) = delete;
+	FrameGraph& operator=(const FrameGraph& other) = delete;
+
+	/// <summary>
+	/// Declares a render target that only lives for part of the frame, it will be taken from the render target pool
+	/// </summary>
+	FrameGraphResource CreateTarget(const std::string& name, const RenderTargetDesc& desc);
+	/// <summary>
+	/// Imports a framebuffer that lives outside the graph. Writing to an imported target keeps a pass alive
+	/// </summary>
+	FrameGraphResource ImportTarget(const std::string& name, Framebuffer* target);
+	/// <summary>
+	/// Imports the default framebuffer, with the given size
+	/// </summary>
+	FrameGraphResource ImportBackbuffer(const std::string& name, unsigned width, unsigned height);
+	/// <summary>
+	/// Imports a resource that is not a render target (ex: a LUT or buffer), used only to order passes
+	/// </summary>
+	FrameGraphResource ImportResource(const std::string& name);
+
+	/// <summary>
+	/// Adds a pass to the graph
+	/// </summary>
+	/// <param name="name">The name of the pass, used for timings and debug groups. Should be unique</param>
+	/// <param name="setup">Called immediately, to declare the pass's reads and writes</param>
+	/// <param name="execute">Called during Execute if the pass was not culled, with its output target bound</param>
+	void AddPass(const std::string& name, const SetupCallback& setup, const ExecuteCallback& execute);
+
+	/// <summary>
+	/// Orders and culls the passes, and works out when transient targets are first and last used
+	/// </summary>
+	void Compile();
+	/// <summary>
+	/// Runs all the passes that survived compilation, then resets the graph for the next frame
+	/// </summary>
+	void Execute();
+
+	/// <summary>
+	/// Gets the framebuffer for a render target, only valid while a pass that uses it is executing
+	/// </summary>
+	Framebuffer* GetTarget(FrameGraphResource resource) const { return _resources[resource].Target; }
+
+	/// <summary>
+	/// Gets the timings for a pass, or nullptr if the pass has never run
+	/// </summary>
+	const PassTiming* GetTiming(const std::string& name) const;
+	/// <summary>
+	/// Gets the sum of the GPU time of all passes last frame, in milliseconds
+	/// </summary>
+	float GetTotalGpuMs() const { return _totalGpuMs; }
+
+	/// <summary>
+	/// Draws the pass list and timings using ImGui, should be called inside of an ImGui window
+	/// </summary>
+	void RenderImGui();
+
+private:
+	enum class ResourceType
+	{
+		Transient,
+		ImportedTarget,
+		Backbuffer,
+		External
+	};
+
+	struct Resource
+	{
+		std::string      Name;
+		ResourceType     Type;
+		RenderTargetDesc Desc;
+		Framebuffer*     Target = nullptr;
+		std::vector<int> Writers;
+		std::vector<int> Readers;
+		// The range of (ordered) passes that use this resource, and the last one that needs its depth
+		int FirstUse = -1;
+		int LastUse = -1;
+		int LastDepthUse = -1;
+	};
+
+	struct Pass
+	{
+		std::string      Name;
+		ExecuteCallback  Execute;
+		std::vector<FrameGraphResource> Reads;
+		std::vector<FrameGraphResource> DepthReads;
+		std::vector<FrameGraphResource> Writes;
+		bool SideEffect = false;
+		bool Alive = false;
+	};
+
+	std::vector<Resource> _resources;
+	std::vector<Pass>     _passes;
+	// Indices into _passes, in the order they will run
+	std::vector<int>      _order;
+	bool                  _isCompiled = false;
+
+	// Timings are kept by pass name, so that they survive the graph being rebuilt each frame
+	std::unordered_map<std::string, PassTiming> _timings;
+	// The names of the passes that ran last frame, and the ones that were culled, for display
+	std::vector<std::string> _lastExecuted;
+	std::vector<std::string> _lastCulled;
+	float    _totalGpuMs = 0.0f;
+	uint32_t _frame = 0;
+
+	FrameGraphResource _AddResource(const std::string& name, ResourceType type);
+	void _BeginTiming(PassTiming& timing);
+	void _EndTiming(PassTiming& timing, float cpuMs);
+};
@@ -1,4 +1,5 @@
 #include "Framebuffer.h"
+#include "GpuMemoryTracker.h"
 
 GLuint Framebuffer::_fullscreenQuadVBO = 0;
 GLuint Framebuffer::_fullscreenQuadVAO = 0;
@@ -16,6 +17,15 @@ void DepthTarget::Unload()
 {
 	//Deletes the texture at the specific handle
 	glDeleteTextures(1, &_texture.GetHandle());
+	_texture.GetHandle() = 0;
+	//Deletes the renderbuffer, if we used one instead
+	glDeleteRenderbuffers(1, &_renderbuffer);
+	_renderbuffer = 0;
+}
+
+GLenum DepthTarget::GetAttachment() const
+{
+	return (_format == GL_DEPTH24_STENCIL8 || _format == GL_DEPTH32F_STENCIL8) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
 }
 
 ColorTarget::~ColorTarget()
@@ -26,7 +36,14 @@ ColorTarget::~ColorTarget()
 
 void ColorTarget::Unload()
 {
-	glDeleteTextures(_numAttachments, &_textures[0].GetHandle());
+	//Textures aren't stored contiguously, so we need to delete them one at a time
+	for (unsigned i = 0; i < _numAttachments; i++)
+	{
+		glDeleteTextures(1, &_textures[i].GetHandle());
+		_textures[i].GetHandle() = 0;
+		glDeleteRenderbuffers(1, &_renderbuffers[i]);
+		_renderbuffers[i] = 0;
+	}
 }
 
 Framebuffer::Framebuffer()
@@ -42,6 +59,8 @@ void Framebuffer::Unload()
 {
 	//Deletes the framebuffer
 	glDeleteFramebuffers(1, &_FBO);
+	//Our attachments are going away with it
+	GpuMemoryTracker::Instance().Unregister(this);
 	//Sets init to false
 	_isInit = false;
 }
@@ -62,17 +81,35 @@ void Framebuffer::Init()
 	//Bind it
 	glBindFramebuffer(GL_FRAMEBUFFER, _FBO);
 
-	if (_depthActive)
+	if (_depthActive && !_depth._sampleable)
+	{
+		//because we have depth we need to clear our depth bit (and stencil if we have it)
+		_clearFlag |= GL_DEPTH_BUFFER_BIT;
+		if (_depth.GetAttachment() == GL_DEPTH_STENCIL_ATTACHMENT)
+		{
+			_clearFlag |= GL_STENCIL_BUFFER_BIT;
+		}
+
+		//Nothing reads this depth, so it can live in a renderbuffer
+		glCreateRenderbuffers(1, &_depth._renderbuffer);
+		glNamedRenderbufferStorage(_depth._renderbuffer, _depth._format, _width, _height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, _depth.GetAttachment(), GL_RENDERBUFFER, _depth._renderbuffer);
+	}
+	else if (_depthActive)
 	{
-		//because we have depth we need to clear our depth bit
+		//because we have depth we need to clear our depth bit (and stencil if we have it)
 		_clearFlag |= GL_DEPTH_BUFFER_BIT;
+		if (_depth.GetAttachment() == GL_DEPTH_STENCIL_ATTACHMENT)
+		{
+			_clearFlag |= GL_STENCIL_BUFFER_BIT;
+		}
 
 		//Generate the texture
 		glGenTextures(1, &_depth._texture.GetHandle());
 		//Binds the texture
 		glBindTexture(GL_TEXTURE_2D, _depth._texture.GetHandle());
 		//Sets the texture data
-		glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, _width, _height);
+		glTexStorage2D(GL_TEXTURE_2D, 1, _depth._format, _width, _height);
 
 		//Set texture parameters
 		glTextureParameteri(_depth._texture.GetHandle(), GL_TEXTURE_MIN_FILTER, _filter);
@@ -81,7 +118,7 @@ void Framebuffer::Init()
 		glTextureParameteri(_depth._texture.GetHandle(), GL_TEXTURE_WRAP_T, _wrap);
 
 		//Sets up as a framebuffer texture
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _depth._texture.GetHandle(), 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, _depth.GetAttachment(), GL_TEXTURE_2D, _depth._texture.GetHandle(), 0);
 
 		glBindTexture(GL_TEXTURE_2D, GL_NONE);
 	}
@@ -92,15 +129,19 @@ void Framebuffer::Init()
 	{
 		//Because we have a color target we include a color buffer bit into clear flag
 		_clearFlag |= GL_COLOR_BUFFER_BIT;
-		//Creates the GLuints to hold the new texture handles;
-		GLuint* textureHandles = new GLuint[_color._numAttachments];
-
-		glGenTextures(_color._numAttachments, textureHandles);
-
 		//Loops through them
 		for (unsigned i = 0; i < _color._numAttachments; i++)
 		{
-			_color._textures[i].GetHandle() = textureHandles[i];
+			//Targets that are never sampled can live in renderbuffers
+			if (!_color._sampleable[i])
+			{
+				glCreateRenderbuffers(1, &_color._renderbuffers[i]);
+				glNamedRenderbufferStorage(_color._renderbuffers[i], _color._formats[i], _width, _height);
+				glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_RENDERBUFFER, _color._renderbuffers[i]);
+				continue;
+			}
+
+			glGenTextures(1, &_color._textures[i].GetHandle());
 
 			//Binds the texture
 			glBindTexture(GL_TEXTURE_2D, _color._textures[i].GetHandle());
@@ -116,9 +157,15 @@ void Framebuffer::Init()
 			//Sets up as a framebuffer texture
 			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, _color._textures[i].GetHandle(), 0);
 		}
+	}
 
-		delete[] textureHandles;
+	//Tracks the memory used by all of our attachments together
+	size_t bytes = _depthActive ? GetInternalFormatSize(_depth._format) : 0;
+	for (GLenum format : _color._formats)
+	{
+		bytes += GetInternalFormatSize(format);
 	}
+	GpuMemoryTracker::Instance().Register(this, GpuMemoryCategory::RenderTarget, GL_FRAMEBUFFER, _FBO, bytes * _width * _height);
 
 	//Make sure it's set up right
 	CheckFBO();
@@ -128,7 +175,7 @@ void Framebuffer::Init()
 	_isInit = true;
 }
 
-void Framebuffer::AddDepthTarget()
+void Framebuffer::AddDepthTarget(bool sampleable, GLenum format)
 {
 	//If there is a handle already, unload it
 	if (_depth._texture.GetHandle())
@@ -137,12 +184,16 @@ void Framebuffer::AddDepthTarget()
 	}
 	//Make depth active true
 	_depthActive = true;
+	_depth._sampleable = sampleable;
+	_depth._format = format;
 }
 
-void Framebuffer::AddColorTarget(GLenum format)
+void Framebuffer::AddColorTarget(GLenum format, bool sampleable)
 {
 	//Resizes the textures to number of attachments
 	_color._textures.resize(_color._numAttachments + 1);
+	_color._renderbuffers.push_back(0);
+	_color._sampleable.push_back(sampleable);
 	//Add the format
 	_color._formats.push_back(format);
 	//Add the color attachment buffer number
@@ -153,11 +204,13 @@ void Framebuffer::AddColorTarget(GLenum format)
 
 void Framebuffer::BindDepthAsTexture(int textureSlot) const
 {
+	LOG_ASSERT(_depth._sampleable, "This framebuffer's depth is a renderbuffer, and can't be bound as a texture");
 	_depth._texture.Bind(textureSlot);
 }
 
 void Framebuffer::BindColorAsTexture(unsigned colorBuffer, int textureSlot) const
 {
+	LOG_ASSERT(_color._sampleable[colorBuffer], "Color target {} is a renderbuffer, and can't be bound as a texture", colorBuffer);
 	_color._textures[colorBuffer].Bind(textureSlot);
 }
 
@@ -170,8 +223,17 @@ void Framebuffer::UnbindTexture(int textureSlot) const
 
 void Framebuffer::Reshape(unsigned width, unsigned height)
 {
+	//Small changes fit in the storage we already have, we just draw to more or less of it
+	const unsigned classWidth = RoundToSizeClass(width);
+	const unsigned classHeight = RoundToSizeClass(height);
+	if (_isInit && classWidth == _width && classHeight == _height)
+	{
+		SetViewportSize(width, height);
+		return;
+	}
+
 	//Set size
-	SetSize(width, height);
+	SetSize(classWidth, classHeight);
 	//Unloads the framebuffer
 	Unload();
 	//Unload the depth target
@@ -180,6 +242,8 @@ void Framebuffer::Reshape(unsigned width, unsigned height)
 	_color.Unload();
 	//Inits the framebuffer
 	Init();
+	//Only draw to the part we asked for
+	SetViewportSize(width, height);
 }
 
 void Framebuffer::SetSize(unsigned width, unsigned height)
@@ -187,11 +251,42 @@ void Framebuffer::SetSize(unsigned width, unsigned height)
 	//Sets the width and height
 	_width = width;
 	_height = height;
+	_viewportWidth = width;
+	_viewportHeight = height;
+}
+
+void Framebuffer::SetViewportSize(unsigned width, unsigned height)
+{
+	_viewportWidth = glm::min(width, _width);
+	_viewportHeight = glm::min(height, _height);
+}
+
+glm::vec2 Framebuffer::GetUvScale() const
+{
+	return glm::vec2(_viewportWidth, _viewportHeight) / glm::vec2(_width, _height);
 }
 
 void Framebuffer::SetViewport() const
 {
-	glViewport(0, 0, _width, _height);
+	glViewport(0, 0, _viewportWidth, _viewportHeight);
+}
+
+unsigned Framebuffer::RoundToSizeClass(unsigned size)
+{
+	//Tiny targets aren't worth splitting hairs over
+	const unsigned minSize = 64;
+	if (size <= minSize)
+	{
+		return minSize;
+	}
+
+	unsigned powerOfTwo = minSize;
+	while (powerOfTwo < size)
+	{
+		powerOfTwo <<= 1;
+	}
+	const unsigned step = powerOfTwo / 8;
+	return (size + step - 1) / step * step;
 }
 
 void Framebuffer::Bind() const
@@ -227,15 +322,58 @@ void Framebuffer::DrawToBackbuffer()
 	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, GL_NONE);
 
 	//Blits the framebuffer to the back buffer
-	glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBlitFramebuffer(0, 0, _viewportWidth, _viewportHeight, 0, 0, _viewportWidth, _viewportHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, GL_NONE);
 }
 
 void Framebuffer::Clear()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, _FBO);
-	glClear(_clearFlag);
-	glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+	Clear(_clearFlag);
+}
+
+void Framebuffer::Clear(GLbitfield mask)
+{
+	//Only clear attachments we actually have, one at a time so we don't need to bind
+	mask &= _clearFlag;
+	if (mask & GL_COLOR_BUFFER_BIT)
+	{
+		for (unsigned i = 0; i < _color._numAttachments; i++)
+		{
+			glClearNamedFramebufferfv(_FBO, GL_COLOR, i, &_clearColor[0]);
+		}
+	}
+	if ((mask & GL_DEPTH_BUFFER_BIT) && (mask & GL_STENCIL_BUFFER_BIT))
+	{
+		glClearNamedFramebufferfi(_FBO, GL_DEPTH_STENCIL, 0, 1.0f, 0);
+	}
+	else if (mask & GL_DEPTH_BUFFER_BIT)
+	{
+		const float depth = 1.0f;
+		glClearNamedFramebufferfv(_FBO, GL_DEPTH, 0, &depth);
+	}
+	else if (mask & GL_STENCIL_BUFFER_BIT)
+	{
+		const GLint stencil = 0;
+		glClearNamedFramebufferiv(_FBO, GL_STENCIL, 0, &stencil);
+	}
+}
+
+void Framebuffer::Invalidate(bool color, bool depth)
+{
+	std::vector<GLenum> attachments;
+	if (color)
+	{
+		attachments.insert(attachments.end(), _color._buffers.begin(), _color._buffers.end());
+	}
+	if (depth && _depthActive)
+	{
+		attachments.push_back(_depth.GetAttachment());
+	}
+
+	if (!attachments.empty())
+	{
+		glInvalidateNamedFramebufferData(_FBO, GLsizei(attachments.size()), &attachments[0]);
+	}
 }
 
 bool Framebuffer::CheckFBO()
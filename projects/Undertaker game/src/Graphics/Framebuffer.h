@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <GLM/glm.hpp>
 #include "Texture2D.h"
 #include "Shader.h"
 
@@ -8,10 +9,19 @@ struct DepthTarget
 	//Deconstructor for Depth Target
 	//*Unloads texture
 	~DepthTarget();
-	//Deletes the texture of the depth target
+	//Deletes the texture (or renderbuffer) of the depth target
 	void Unload();
 	//Holds the depth texture
 	Texture2D _texture;
+	//Holds the depth renderbuffer, used instead of the texture when depth is never sampled
+	GLuint _renderbuffer = 0;
+	//The depth format (GL_DEPTH24_STENCIL8 and GL_DEPTH32F_STENCIL8 include stencil)
+	GLenum _format = GL_DEPTH_COMPONENT24;
+	//Can the depth be bound as a texture
+	bool _sampleable = true;
+
+	//Gets which attachment point the depth goes in
+	GLenum GetAttachment() const;
 };
 
 struct ColorTarget
@@ -19,12 +29,15 @@ struct ColorTarget
 	//Deconstructor for Color Target
 	//*Unloads all the color targets
 	~ColorTarget();
-	//Deletes the texture of the color targets
+	//Deletes the textures (and renderbuffers) of the color targets
 	void Unload();
 	//Holds the color textures
 	std::vector<Texture2D> _textures;
+	//Holds the renderbuffers for targets that are never sampled (0 for textures)
+	std::vector<GLuint> _renderbuffers;
 	std::vector<GLenum> _formats;
 	std::vector<GLenum> _buffers;
+	std::vector<bool> _sampleable;
 	//Stores the number of color attachments this target has
 	unsigned int _numAttachments = 0;
 };
@@ -46,11 +59,16 @@ public:
 
 	//Adds depth target
 	//**ONLY EVER ONE**//
-	void AddDepthTarget();
+	//*If the depth is never read by a shader, pass sampleable = false to use a renderbuffer, which the driver can
+	//*keep compressed (or on chip) since it never has to be read as a texture
+	//*Use GL_DEPTH24_STENCIL8 for a stencil buffer
+	void AddDepthTarget(bool sampleable = true, GLenum format = GL_DEPTH_COMPONENT24);
 
 	//Adds a color target
 	//**You can have as many as you want**//
-	void AddColorTarget(GLenum format);
+	//*Packed formats like GL_R11F_G11F_B10F (HDR), GL_RGB10_A2 and GL_RG16F cost the same as GL_RGBA8
+	//*Pass sampleable = false for targets that are only ever blitted or resolved to use a renderbuffer
+	void AddColorTarget(GLenum format, bool sampleable = true);
 	
 	//Binds our depth buffer as a texture to specified slot
 	void BindDepthAsTexture(int textureSlot) const;
@@ -60,12 +78,24 @@ public:
 	void UnbindTexture(int textureSlot) const;
 
 	//Reshapes the framebuffer
+	//*Storage is allocated in size classes, so if the new size rounds to the size we already have, we only change
+	//*the viewport and nothing gets reallocated
 	void Reshape(unsigned width, unsigned height);
-	//Sets the size of the framebuffer
+	//Sets the size of the framebuffer (and resets the viewport to all of it)
 	void SetSize(unsigned width, unsigned height);
-
-	//Sets the viewport to fullscreen (using the size of framebuffer)
+	//Sets the part of the framebuffer that gets drawn to, from the bottom left
+	void SetViewportSize(unsigned width, unsigned height);
+	unsigned GetViewportWidth() const { return _viewportWidth; }
+	unsigned GetViewportHeight() const { return _viewportHeight; }
+	//Gets what UVs need to be multiplied by to only sample the viewport
+	glm::vec2 GetUvScale() const;
+
+	//Sets the viewport to the part of the framebuffer we're using
 	void SetViewport() const;
+
+	//Rounds a size up to the size class we allocate storage at
+	//*Classes are 1/8th of the next power of two apart, so at most ~12% of each axis goes unused
+	static unsigned RoundToSizeClass(unsigned size);
 	
 	//Binds the framebuffer
 	void Bind() const;
@@ -80,6 +110,15 @@ public:
 
 	//Clears the framebuffer using our clear flag
 	void Clear();
+	//Clears only the given buffers (ex: GL_DEPTH_BUFFER_BIT when every pixel of color will be drawn anyway)
+	//*Respects the scissor test, so only part of the framebuffer can be cleared
+	//*Does not change which framebuffer is bound
+	void Clear(GLbitfield mask);
+	//Sets the color that color attachments are cleared to
+	void SetClearColor(const glm::vec4& color) { _clearColor = color; }
+	//Tells the driver that the contents of our attachments are no longer needed
+	//*Lets tiled GPUs skip writing them back to memory, and lets pooled targets be reused without a copy
+	void Invalidate(bool color = true, bool depth = true);
 	//Checks to make sure the framebuffer is... OK
 	bool CheckFBO();
 
@@ -90,9 +129,17 @@ public:
 	//Draws our fullscreen quad
 	static void DrawFullscreenQuad();
 
+	//Gets the OpenGL framebuffer handle
+	GLuint GetHandle() const { return _FBO; }
+	//Does this framebuffer have a depth attachment
+	bool HasDepth() const { return _depthActive; }
+
 	//Initial width and height is zero
 	unsigned int _width = 0;
 	unsigned int _height = 0;
+	//The part of the framebuffer we're drawing to
+	unsigned int _viewportWidth = 0;
+	unsigned int _viewportHeight = 0;
 protected:
 	//OpenGL framebuffer handle
 	GLuint _FBO;
@@ -108,6 +155,8 @@ protected:
 
 	//Clearflag is nothing by default
 	GLbitfield _clearFlag = 0;
+	//The color we clear to
+	glm::vec4 _clearColor = glm::vec4(0.0f);
 
 	//Is the framebuffer initialized
 	bool _isInit = false;
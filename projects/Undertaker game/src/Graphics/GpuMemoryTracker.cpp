@@ -0,0 +1,186 @@
+#include "GpuMemoryTracker.h"
+
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <imgui.h>
+#include "Logging.h"
+
+// Converts a byte count to megabytes for display
+inline float ToMegabytes(size_t bytes) {
+	return bytes / (1024.0f * 1024.0f);
+}
+
+void GpuMemoryTracker::_CheckThread() const {
+	LOG_ASSERT(std::this_thread::get_id() == _owner, "The GPU memory tracker can only be used from the GL thread");
+}
+
+void GpuMemoryTracker::Register(const void* owner, GpuMemoryCategory category, GLenum objectType, GLuint handle, size_t bytes) {
+	_CheckThread();
+	auto it = _allocations.find(owner);
+	if (it != _allocations.end()) {
+		// Re-registering (ex: a texture being recreated at a new size), keep the label and eviction callback
+		_Remove(it->second.Category, it->second.Bytes);
+		it->second.Category = category;
+		it->second.ObjectType = objectType;
+		it->second.Handle = handle;
+		it->second.Bytes = bytes;
+	} else {
+		Allocation allocation;
+		allocation.Category = category;
+		allocation.ObjectType = objectType;
+		allocation.Handle = handle;
+		allocation.Bytes = bytes;
+		allocation.LastBoundFrame = _frame;
+		_allocations[owner] = allocation;
+	}
+	_Add(category, bytes);
+}
+
+void GpuMemoryTracker::Unregister(const void* owner) {
+	_CheckThread();
+	auto it = _allocations.find(owner);
+	if (it != _allocations.end()) {
+		_Remove(it->second.Category, it->second.Bytes);
+		_allocations.erase(it);
+	}
+}
+
+void GpuMemoryTracker::Resize(const void* owner, size_t bytes) {
+	_CheckThread();
+	auto it = _allocations.find(owner);
+	if (it != _allocations.end()) {
+		_Remove(it->second.Category, it->second.Bytes);
+		it->second.Bytes = bytes;
+		_Add(it->second.Category, bytes);
+	}
+}
+
+void GpuMemoryTracker::SetLabel(const void* owner, const std::string& label) {
+	auto it = _allocations.find(owner);
+	if (it != _allocations.end()) {
+		it->second.Label = label;
+	}
+}
+
+void GpuMemoryTracker::SetStreamable(const void* owner, const EvictCallback& evict) {
+	auto it = _allocations.find(owner);
+	if (it != _allocations.end()) {
+		it->second.Evict = evict;
+	}
+}
+
+void GpuMemoryTracker::Update() {
+	_CheckThread();
+	_frame++;
+	if (BudgetBytes == 0 || _totalBytes <= BudgetBytes) {
+		return;
+	}
+
+	// Collect all the streamable allocations that were not used last frame, oldest first
+	std::vector<Allocation*> candidates;
+	for (auto& kvp : _allocations) {
+		if (kvp.second.Evict && _frame - kvp.second.LastBoundFrame > 1) {
+			candidates.push_back(&kvp.second);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const Allocation* l, const Allocation* r) {
+		return l->LastBoundFrame < r->LastBoundFrame;
+	});
+
+	for (Allocation* allocation : candidates) {
+		if (_totalBytes <= BudgetBytes) {
+			break;
+		}
+		// The callback is expected to report its new size through Resize
+		_evictedBytes += allocation->Evict();
+	}
+
+	if (_totalBytes > BudgetBytes) {
+		LOG_WARN("GPU memory is over budget after eviction ({:.2f} MB / {:.2f} MB)", ToMegabytes(_totalBytes), ToMegabytes(BudgetBytes));
+	}
+}
+
+void GpuMemoryTracker::RenderImGui() {
+	ImGui::Columns(3, "gpu_memory");
+	ImGui::Text("Category"); ImGui::NextColumn();
+	ImGui::Text("Live (MB)"); ImGui::NextColumn();
+	ImGui::Text("Peak (MB)"); ImGui::NextColumn();
+	ImGui::Separator();
+	for (int ix = 0; ix < CATEGORY_COUNT; ix++) {
+		ImGui::Text("%s", (~(GpuMemoryCategory)ix).c_str()); ImGui::NextColumn();
+		ImGui::Text("%.2f", ToMegabytes(_categoryBytes[ix])); ImGui::NextColumn();
+		ImGui::Text("%.2f", ToMegabytes(_categoryPeaks[ix])); ImGui::NextColumn();
+	}
+	ImGui::Separator();
+	ImGui::Text("Total"); ImGui::NextColumn();
+	ImGui::Text("%.2f", ToMegabytes(_totalBytes)); ImGui::NextColumn();
+	ImGui::Text("%.2f", ToMegabytes(_peakBytes)); ImGui::NextColumn();
+	ImGui::Columns(1);
+
+	int budgetMb = (int)(BudgetBytes / (1024 * 1024));
+	if (ImGui::SliderInt("Budget (MB, 0 = none)", &budgetMb, 0, 2048)) {
+		BudgetBytes = (size_t)budgetMb * 1024 * 1024;
+	}
+	ImGui::Text("Allocations: %d Evicted: %.2f MB", (int)_allocations.size(), ToMegabytes(_evictedBytes));
+	if (ImGui::Button("Dump to gpu_memory.txt")) {
+		DumpToFile("gpu_memory.txt");
+	}
+}
+
+bool GpuMemoryTracker::DumpToFile(const std::string& path) const {
+	std::ofstream file(path);
+	if (!file.is_open()) {
+		LOG_WARN("Failed to open \"{}\" for writing the GPU memory report", path);
+		return false;
+	}
+
+	file << "==== GPU Memory ====\n";
+	for (int ix = 0; ix < CATEGORY_COUNT; ix++) {
+		file << ~(GpuMemoryCategory)ix << ": " << _categoryBytes[ix] << " bytes (peak " << _categoryPeaks[ix] << ")\n";
+	}
+	file << "Total: " << _totalBytes << " bytes (peak " << _peakBytes << ")\n";
+	file << "Budget: " << BudgetBytes << " bytes\n\n";
+
+	// Sort our allocations from largest to smallest so the big offenders are at the top
+	std::vector<const Allocation*> sorted;
+	sorted.reserve(_allocations.size());
+	for (const auto& kvp : _allocations) {
+		sorted.push_back(&kvp.second);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const Allocation* l, const Allocation* r) {
+		return l->Bytes > r->Bytes;
+	});
+
+	file << "Category\tHandle\tBytes\tLast Bound\tStreamable\tLabel\n";
+	for (const Allocation* allocation : sorted) {
+		file << allocation->Category << "\t" << allocation->Handle << "\t" << allocation->Bytes << "\t"
+			<< allocation->LastBoundFrame << "\t" << (allocation->Evict ? "yes" : "no") << "\t" << _GetLabel(*allocation) << "\n";
+	}
+
+	LOG_INFO("Wrote GPU memory report to \"{}\"", path);
+	return true;
+}
+
+void GpuMemoryTracker::_Add(GpuMemoryCategory category, size_t bytes) {
+	_categoryBytes[*category] += bytes;
+	_categoryPeaks[*category] = std::max(_categoryPeaks[*category], _categoryBytes[*category]);
+	_totalBytes += bytes;
+	_peakBytes = std::max(_peakBytes, _totalBytes);
+}
+
+void GpuMemoryTracker::_Remove(GpuMemoryCategory category, size_t bytes) {
+	_categoryBytes[*category] -= bytes;
+	_totalBytes -= bytes;
+}
+
+std::string GpuMemoryTracker::_GetLabel(const Allocation& allocation) {
+	if (!allocation.Label.empty()) {
+		return allocation.Label;
+	}
+	// Fall back to asking OpenGL, in case the label was set without going through the tracker
+	char buffer[256];
+	GLsizei length = 0;
+	glGetObjectLabel(allocation.ObjectType, allocation.Handle, sizeof(buffer), &length, buffer);
+	return length > 0 ? std::string(buffer, length) : "<unnamed>";
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <glad/glad.h>
+#include <EnumToString.h>
+
+// The broad types of GPU allocations that we keep totals for
+ENUM(GpuMemoryCategory, int,
+	Texture      = 0,
+	CubeMap      = 1,
+	LUT          = 2,
+	Buffer       = 3,
+	RenderTarget = 4
+);
+
+/// <summary>
+/// Keeps track of every GPU resource allocation made by the graphics classes, so that we can see where our VRAM is
+/// going. Allocations are keyed by the object that owns them, and record their size, category and debug label.
+/// The tracker also enforces a memory budget, by asking streamable resources that have not been bound recently to
+/// release some of their memory.
+///
+/// The tracker is not synchronized, and must only be used from the thread that owns the GL context (which is the only
+/// thread that can create, resize or bind the resources it tracks anyway). Worker threads, like the ones recording
+/// command buffers or running the game, should never touch it
+/// </summary>
+class GpuMemoryTracker final
+{
+public:
+	static GpuMemoryTracker& Instance() {
+		static GpuMemoryTracker instance;
+		return instance;
+	}
+
+	/// <summary>
+	/// A callback that asks a streamable resource to release memory, returning the number of bytes that were freed
+	/// </summary>
+	typedef std::function<size_t()> EvictCallback;
+
+	/// <summary>
+	/// The total number of bytes that we try to keep our allocations under, 0 for no budget
+	/// </summary>
+	size_t BudgetBytes = 0;
+
+	/// <summary>
+	/// Registers (or updates) an allocation for the given owner
+	/// </summary>
+	/// <param name="owner">The object that owns the allocation, used as a key</param>
+	/// <param name="category">The category to count the allocation under</param>
+	/// <param name="objectType">The OpenGL object type (GL_TEXTURE, GL_BUFFER, etc...), used to look up labels</param>
+	/// <param name="handle">The OpenGL handle of the object</param>
+	/// <param name="bytes">The size of the allocation, in bytes</param>
+	void Register(const void* owner, GpuMemoryCategory category, GLenum objectType, GLuint handle, size_t bytes);
+	/// <summary>
+	/// Removes the allocation for the given owner, if one exists
+	/// </summary>
+	void Unregister(const void* owner);
+	/// <summary>
+	/// Updates the number of bytes that an existing allocation is using (ex: for streamed textures)
+	/// </summary>
+	void Resize(const void* owner, size_t bytes);
+	/// <summary>
+	/// Sets the debug label for an allocation, this should match what was passed to glObjectLabel
+	/// </summary>
+	void SetLabel(const void* owner, const std::string& label);
+	/// <summary>
+	/// Marks an allocation as being streamable, so that it can be asked to release memory when we are over budget
+	/// </summary>
+	/// <param name="owner">The owner of the allocation</param>
+	/// <param name="evict">The callback to invoke to free memory, which should return the number of bytes freed</param>
+	void SetStreamable(const void* owner, const EvictCallback& evict);
+	/// <summary>
+	/// Notes that the given allocation was used this frame, this is cheap enough to call on every bind
+	/// </summary>
+	void MarkBound(const void* owner) {
+		auto it = _allocations.find(owner);
+		if (it != _allocations.end()) {
+			it->second.LastBoundFrame = _frame;
+		}
+	}
+
+	/// <summary>
+	/// Checks whether an allocation of the given size would fit within our budget
+	/// </summary>
+	bool CanAllocate(size_t bytes) const { return BudgetBytes == 0 || _totalBytes + bytes <= BudgetBytes; }
+
+	/// <summary>
+	/// Advances the frame counter, and evicts least recently bound streamable resources until we are back under budget.
+	/// Should be called once per frame
+	/// </summary>
+	void Update();
+
+	/// <summary>
+	/// Draws the memory totals and high water marks using ImGui, should be called inside of an ImGui window
+	/// </summary>
+	void RenderImGui();
+
+	/// <summary>
+	/// Writes a report of all the live allocations to a text file
+	/// </summary>
+	/// <param name="path">The path of the file to write</param>
+	/// <returns>True if the file was written, false if it could not be opened</returns>
+	bool DumpToFile(const std::string& path) const;
+
+	/// <summary>
+	/// Gets the total number of bytes that are allocated across all categories
+	/// </summary>
+	size_t GetTotalBytes() const { return _totalBytes; }
+	/// <summary>
+	/// Gets the highest total number of bytes that have been allocated at once
+	/// </summary>
+	size_t GetPeakBytes() const { return _peakBytes; }
+	/// <summary>
+	/// Gets the number of bytes allocated in a single category
+	/// </summary>
+	size_t GetCategoryBytes(GpuMemoryCategory category) const { return _categoryBytes[*category]; }
+
+private:
+	GpuMemoryTracker() : _owner(std::this_thread::get_id()) {}
+
+	static constexpr int CATEGORY_COUNT = 5;
+
+	struct Allocation
+	{
+		GpuMemoryCategory Category;
+		GLenum            ObjectType;
+		GLuint            Handle;
+		size_t            Bytes;
+		std::string       Label;
+		uint32_t          LastBoundFrame;
+		EvictCallback     Evict;
+	};
+
+	std::unordered_map<const void*, Allocation> _allocations;
+	size_t   _categoryBytes[CATEGORY_COUNT] = { 0 };
+	size_t   _categoryPeaks[CATEGORY_COUNT] = { 0 };
+	size_t   _totalBytes = 0;
+	size_t   _peakBytes = 0;
+	size_t   _evictedBytes = 0;
+	uint32_t _frame = 0;
+	// The thread the tracker was first used from, every other call must come from the same thread
+	std::thread::id _owner;
+
+	void _CheckThread() const;
+
+	void _Add(GpuMemoryCategory category, size_t bytes);
+	void _Remove(GpuMemoryCategory category, size_t bytes);
+	static std::string _GetLabel(const Allocation& allocation);
+};
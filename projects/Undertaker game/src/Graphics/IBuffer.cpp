@@ -1,8 +1,10 @@
 #include "IBuffer.h"
+#include "GpuMemoryTracker.h"
 
 IBuffer::IBuffer(GLenum type, GLenum usage) :
 	_elementCount(0),
 	_elementSize(0),
+	_capacity(0),
 	_handle(0)
 {
 	_type = type;
@@ -11,6 +13,7 @@ IBuffer::IBuffer(GLenum type, GLenum usage) :
 }
 
 IBuffer::~IBuffer() {
+	GpuMemoryTracker::Instance().Unregister(this);
 	if (_handle != 0) {
 		glDeleteBuffers(1, &_handle);
 		_handle = 0;
@@ -22,6 +25,30 @@ void IBuffer::LoadData(const void* data, size_t elementSize, size_t elementCount
 	glNamedBufferData(_handle, elementSize * elementCount, data, _usage);
 	_elementCount = elementCount;
 	_elementSize = elementSize;
+	GpuMemoryTracker::Instance().Register(this, GpuMemoryCategory::Buffer, GL_BUFFER, _handle, elementSize * elementCount);
+}
+
+void IBuffer::StreamData(const void* data, size_t elementSize, size_t elementCount) {
+	const size_t size = elementSize * elementCount;
+	if (size > _capacity) {
+		_capacity = _capacity == 0 ? size : _capacity;
+		while (_capacity < size) {
+			_capacity *= 2;
+		}
+		GpuMemoryTracker::Instance().Register(this, GpuMemoryCategory::Buffer, GL_BUFFER, _handle, _capacity);
+	}
+	// Re-specifying the storage with no data lets the driver hand us fresh memory instead of syncing with the GPU
+	glNamedBufferData(_handle, _capacity, nullptr, _usage);
+	if (size > 0) {
+		glNamedBufferSubData(_handle, 0, size, data);
+	}
+	_elementCount = elementCount;
+	_elementSize = elementSize;
+}
+
+void IBuffer::SetDebugName(const std::string& name) {
+	glObjectLabel(GL_BUFFER, _handle, name.length(), name.c_str());
+	GpuMemoryTracker::Instance().SetLabel(this, name);
 }
 
 void IBuffer::Bind() {
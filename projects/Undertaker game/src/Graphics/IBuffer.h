@@ -1,4 +1,5 @@
 #pragma once
+#include <string>
 #include <glad/glad.h>
 
 /// <summary>
@@ -38,6 +39,15 @@ public:
 		IBuffer::LoadData((const void*)(data), sizeof(T), count);
 	}
 
+	/// <summary>
+	/// Replaces the contents of a buffer that is refilled every frame. The storage only ever grows (doubling when it
+	/// runs out of room), and is orphaned before each upload so we never wait on draws still reading last frame's data
+	/// </summary>
+	/// <param name="data">The data that you want to load into the buffer</param>
+	/// <param name="elementSize">The size of a single element, in bytes</param>
+	/// <param name="elementCount">The number of elements to upload</param>
+	void StreamData(const void* data, size_t elementSize, size_t elementCount);
+
 	/// <summary>
 	/// Returns the number of elements that are loaded into this buffer
 	/// </summary>
@@ -63,6 +73,12 @@ public:
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
 
+	/// <summary>
+	/// Sets a debug name for this buffer, making debug messages and memory reports clearer
+	/// </summary>
+	/// <param name="name">The new name of the object</param>
+	void SetDebugName(const std::string& name);
+
 	/// <summary>
 	/// Binds this buffer for use to the slot returned by GetType()
 	/// </summary>
@@ -83,6 +99,7 @@ protected:
 	
 	size_t _elementSize; // The size or stride of our elements
 	size_t _elementCount; // The number of elements in the buffer
+	size_t _capacity; // The number of bytes allocated for the buffer, only used by StreamData
 	GLuint _handle; // The OpenGL handle for the underlying buffer
 	GLenum _usage; // The buffer usage mode (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
 	GLenum _type; // The buffer type (ex GL_ARRAY_BUFFER, GL_ARRAY_ELEMENT_BUFFER)
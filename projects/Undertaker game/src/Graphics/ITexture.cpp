@@ -1,6 +1,7 @@
 #include "ITexture.h"
 
 #include "Logging.h"
+#include "GpuMemoryTracker.h"
 
 ITexture::Limits ITexture::_limits = ITexture::Limits();
 bool ITexture::_isStaticInit = false;
@@ -30,6 +31,7 @@ ITexture::ITexture()
 }
 
 ITexture::~ITexture() {
+	GpuMemoryTracker::Instance().Unregister(this);
 	if (glIsTexture(_handle)) {
 		glDeleteTextures(1, &_handle);
 	}
@@ -39,9 +41,17 @@ void ITexture::Bind(int slot) const {
 	if (_handle != 0) {
 		//glActiveTexture(GL_TEXTURE0 + slot);
 		glBindTextureUnit(slot, _handle);
+		GpuMemoryTracker::Instance().MarkBound(this);
 	}
 }
 
+void ITexture::SetDebugName(const std::string& name) {
+	if (_handle != 0) {
+		glObjectLabel(GL_TEXTURE, _handle, name.length(), name.c_str());
+	}
+	GpuMemoryTracker::Instance().SetLabel(this, name);
+}
+
 void ITexture::Unbind(int slot)
 {
 	//glActiveTexture(GL_TEXTURE0 + slot);
@@ -1,6 +1,7 @@
 #pragma once
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <glad/glad.h>
 #include <GLM/glm.hpp>
 
@@ -37,6 +38,12 @@ public:
 	/// Gets the underlying OpenGL handle for this texture
 	/// </summary>
 	GLuint& GetHandle() { return _handle; }
+
+	/// <summary>
+	/// Sets the debug label for this texture, making debug messages and memory reports clearer
+	/// </summary>
+	/// <param name="name">The new name of the texture</param>
+	void SetDebugName(const std::string& name);
 	
 	/// <summary>
 	/// Clears this texture to a given color
@@ -0,0 +1,214 @@
+#include "Impostor.h"
+#include <cstddef>
+#include <imgui.h>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "IndexBuffer.h"
+
+namespace {
+	// Unfolds a point on the hemi-octahedral square (-1 to 1 on both axes) back into a direction on the upper
+	// hemisphere, must match DecodeHemiOct in vertex_impostor.glsl
+	glm::vec3 DecodeHemiOct(const glm::vec2& encoded) {
+		glm::vec3 dir((encoded.x + encoded.y) * 0.5f, 0.0f, (encoded.x - encoded.y) * 0.5f);
+		dir.y = 1.0f - glm::abs(dir.x) - glm::abs(dir.z);
+		return glm::normalize(dir);
+	}
+
+	// The direction a frame of the atlas was rendered from, frames sit on the corners of the grid so that the views
+	// straight down and along the horizon are all included
+	glm::vec3 GetFrameDirection(uint32_t x, uint32_t y, uint32_t framesPerSide) {
+		return DecodeHemiOct(glm::vec2(x, y) / float(framesPerSide - 1) * 2.0f - 1.0f);
+	}
+}
+
+ImpostorSystem::ImpostorSystem() {
+	// Baking reuses the regular vertex shader, with an identity model matrix so normals stay in model space
+	_bakeShader = Shader::Create();
+	_bakeShader->LoadShaderPartFromFiles({ "shaders/vertex_shader.glsl", "shaders/irradiance_volume.glsl" }, GL_VERTEX_SHADER);
+	_bakeShader->LoadShaderPartFromFile("shaders/frag_impostor_bake.glsl", GL_FRAGMENT_SHADER);
+	_bakeShader->Link();
+	_bakeShader->SetUniform("s_Diffuse", 0);
+
+	_shader = Shader::Create();
+	_shader->LoadShaderPartFromFiles({ "shaders/vertex_impostor.glsl", "shaders/irradiance_volume.glsl" }, GL_VERTEX_SHADER);
+	_shader->LoadShaderPartFromFile("shaders/frag_impostor.glsl", GL_FRAGMENT_SHADER);
+	_shader->Link();
+	_shader->SetUniform("s_ImpostorAlbedo", ALBEDO_SLOT);
+	_shader->SetUniform("s_ImpostorNormalDepth", NORMAL_DEPTH_SLOT);
+
+	// Every impostor is the same quad, expanded to face the camera in the vertex shader
+	const glm::vec2 corners[4] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+	const uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+	VertexBuffer::sptr vbo = VertexBuffer::Create();
+	vbo->LoadData(corners, 4);
+	IndexBuffer::sptr ebo = IndexBuffer::Create();
+	ebo->LoadData(indices, 6);
+
+	// The impostors themselves are streamed in every frame
+	_instances = VertexBuffer::Create(GL_STREAM_DRAW);
+	_instances->SetDebugName("Impostor Instances");
+
+	_quad = VertexArrayObject::Create();
+	_quad->AddVertexBuffer(vbo, { BufferAttribute(0, 2, GL_FLOAT, false, sizeof(glm::vec2), 0, AttribUsage::Position) });
+	_quad->AddVertexBuffer(_instances, {
+		BufferAttribute(1, 4, GL_FLOAT, false, sizeof(Instance), offsetof(Instance, Center), AttribUsage::User0, 1),
+		BufferAttribute(2, 1, GL_FLOAT, false, sizeof(Instance), offsetof(Instance, Yaw), AttribUsage::User1, 1)
+	});
+	_quad->SetIndexBuffer(ebo);
+}
+
+ImpostorAtlas::sptr ImpostorSystem::Bake(const VertexArrayObject::sptr& mesh, const ITexture::sptr& diffuse) {
+	ImpostorAtlas::sptr atlas = std::make_shared<ImpostorAtlas>();
+	atlas->FramesPerSide = glm::max(FramesPerSide, 2u);
+	atlas->FrameSize = glm::max(FrameSize, 1u);
+	atlas->Center = (mesh->GetBoundsMin() + mesh->GetBoundsMax()) * 0.5f;
+	atlas->Radius = glm::max(glm::length(mesh->GetBoundsMax() - mesh->GetBoundsMin()) * 0.5f, 0.0001f);
+
+	// No mips, neighbouring frames would bleed into each other, and frames are about the size they're drawn at anyways
+	const uint32_t size = atlas->FramesPerSide * atlas->FrameSize;
+	Texture2DDescription desc;
+	desc.Width = size;
+	desc.Height = size;
+	desc.Format = InternalFormat::RGBA8;
+	desc.HorizontalWrap = WrapMode::ClampToEdge;
+	desc.VerticalWrap = WrapMode::ClampToEdge;
+	desc.MinificationFilter = MinFilter::Linear;
+	desc.GenerateMipMaps = false;
+	atlas->Albedo = Texture2D::Create(desc);
+	atlas->Albedo->SetDebugName("Impostor Albedo");
+	atlas->NormalDepth = Texture2D::Create(desc);
+	atlas->NormalDepth->SetDebugName("Impostor Normal Depth");
+
+	// The framebuffer is only needed for the bake, so it's created and thrown away here
+	GLuint framebuffer, depth;
+	glCreateFramebuffers(1, &framebuffer);
+	glCreateRenderbuffers(1, &depth);
+	glNamedRenderbufferStorage(depth, GL_DEPTH_COMPONENT24, size, size);
+	glNamedFramebufferRenderbuffer(framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+	glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, atlas->Albedo->GetHandle(), 0);
+	glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT1, atlas->NormalDepth->GetHandle(), 0);
+	const GLenum buffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glNamedFramebufferDrawBuffers(framebuffer, 2, buffers);
+
+	const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const float clearDepth = 1.0f;
+	glClearNamedFramebufferfv(framebuffer, GL_COLOR, 0, clearColor);
+	glClearNamedFramebufferfv(framebuffer, GL_COLOR, 1, clearColor);
+	glClearNamedFramebufferfv(framebuffer, GL_DEPTH, 0, &clearDepth);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glEnable(GL_DEPTH_TEST);
+
+	_bakeShader->Bind();
+	_bakeShader->SetUniformMatrix("u_Model", glm::mat4(1.0f));
+	_bakeShader->SetUniformMatrix("u_NormalMatrix", glm::mat3(1.0f));
+	_bakeShader->SetUniform("u_ImpostorCenter", atlas->Center);
+	_bakeShader->SetUniform("u_ImpostorRadius", atlas->Radius);
+	_bakeShader->SetUniform("u_HasDiffuse", diffuse != nullptr ? 1 : 0);
+	if (diffuse != nullptr) {
+		diffuse->Bind(0);
+	}
+
+	// Each frame looks at the bounding sphere from twice its radius away, with an orthographic camera that just fits it
+	const float radius = atlas->Radius;
+	const glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, radius, 3.0f * radius);
+	for (uint32_t y = 0; y < atlas->FramesPerSide; y++) {
+		for (uint32_t x = 0; x < atlas->FramesPerSide; x++) {
+			// Must match FrameBasis in vertex_impostor.glsl, lookAt puts the up vector's projection along +Y
+			const glm::vec3 dir = GetFrameDirection(x, y, atlas->FramesPerSide);
+			const glm::vec3 up = glm::abs(dir.y) > 0.999f ? glm::vec3(0.0f, 0.0f, -1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			const glm::mat4 view = glm::lookAt(atlas->Center + dir * 2.0f * radius, atlas->Center, up);
+
+			glViewport(x * atlas->FrameSize, y * atlas->FrameSize, atlas->FrameSize, atlas->FrameSize);
+			_bakeShader->SetUniform("u_FrameDir", dir);
+			_bakeShader->SetUniformMatrix("u_ModelViewProjection", projection * view);
+			mesh->Render();
+		}
+	}
+
+	Shader::UnBind();
+	ITexture::Unbind(0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &depth);
+	return atlas;
+}
+
+float ImpostorSystem::ProjectedSize(const glm::vec3& center, float radius, const glm::mat4& viewProjection, const glm::mat4& projection, float viewportHeight) {
+	// Orthographic cameras don't shrink things with distance
+	const bool isOrtho = projection[3][3] == 1.0f;
+	const float depth = isOrtho ? 1.0f : glm::max((viewProjection * glm::vec4(center, 1.0f)).w, 0.1f);
+	return radius * viewportHeight * projection[1][1] / depth;
+}
+
+void ImpostorSystem::BeginFrame() {
+	// Drop atlases that had nothing queued last frame, so we don't hang on to the lists of deleted atlases
+	for (auto it = _queued.begin(); it != _queued.end();) {
+		if (it->second.empty()) {
+			it = _queued.erase(it);
+		} else {
+			it->second.clear();
+			++it;
+		}
+	}
+}
+
+bool ImpostorSystem::Submit(const ImpostorAtlas::sptr& atlas, const glm::mat4& model, float pixelSize) {
+	if (!Enabled || atlas == nullptr || pixelSize >= SwitchPixelSize) {
+		return false;
+	}
+
+	Instance instance;
+	instance.Center = glm::vec3(model * glm::vec4(atlas->Center, 1.0f));
+	instance.Scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+	// The Z axis of a rotation around Y is (sin, 0, cos)
+	instance.Yaw = glm::atan(model[2][0], model[2][2]);
+	_queued[atlas.get()].push_back(instance);
+	return true;
+}
+
+void ImpostorSystem::Render(const glm::mat4& view, const glm::mat4& projection) {
+	// Pack every atlas' impostors into one buffer, each atlas then draws its own slice of it
+	struct DrawCall
+	{
+		const ImpostorAtlas* Atlas;
+		uint32_t             FirstInstance;
+		uint32_t             Count;
+	};
+	std::vector<DrawCall> drawCalls;
+	_instanceData.clear();
+	for (const auto& kvp : _queued) {
+		if (!kvp.second.empty()) {
+			drawCalls.push_back({ kvp.first, static_cast<uint32_t>(_instanceData.size()), static_cast<uint32_t>(kvp.second.size()) });
+			_instanceData.insert(_instanceData.end(), kvp.second.begin(), kvp.second.end());
+		}
+	}
+	_stats.Impostors = static_cast<uint32_t>(_instanceData.size());
+	_stats.DrawCalls = static_cast<uint32_t>(drawCalls.size());
+	if (drawCalls.empty()) {
+		return;
+	}
+	_instances->StreamData(_instanceData.data(), sizeof(Instance), _instanceData.size());
+
+	_shader->Bind();
+	_shader->SetUniformMatrix("u_View", view);
+	_shader->SetUniformMatrix("u_ViewProjection", projection * view);
+	_shader->SetUniform("u_CamPos", glm::vec3(glm::inverse(view) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+	_shader->SetUniform("u_Orthographic", projection[3][3] == 1.0f ? 1 : 0);
+
+	for (const DrawCall& call : drawCalls) {
+		call.Atlas->Albedo->Bind(ALBEDO_SLOT);
+		call.Atlas->NormalDepth->Bind(NORMAL_DEPTH_SLOT);
+		_shader->SetUniform("u_FramesPerSide", static_cast<float>(call.Atlas->FramesPerSide));
+		_shader->SetUniform("u_ImpostorRadius", call.Atlas->Radius);
+		_shader->SetUniform("u_HalfTexel", 0.5f / call.Atlas->FrameSize);
+		_quad->RenderInstanced(call.Count, call.FirstInstance);
+	}
+	Shader::UnBind();
+}
+
+void ImpostorSystem::RenderImGui() {
+	ImGui::Checkbox("Enabled", &Enabled);
+	ImGui::SliderFloat("Switch Size (px)", &SwitchPixelSize, 0.0f, 256.0f);
+	ImGui::Text("Impostors: %d", (int)_stats.Impostors);
+	ImGui::Text("Draw calls: %d", (int)_stats.DrawCalls);
+}
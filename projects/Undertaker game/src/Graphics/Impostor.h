@@ -0,0 +1,178 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Shader.h"
+#include "ITexture.h"
+#include "Texture2D.h"
+#include "VertexArrayObject.h"
+#include "VertexBuffer.h"
+
+/// <summary>
+/// A mesh pre-rendered from a grid of directions over the upper hemisphere, for drawing it as a single quad once it's
+/// too small on screen for its triangles to matter. Directions are laid out with a hemi-octahedral mapping (the upper
+/// half of an octahedron, unfolded into a square), so they're spread evenly and the frame for any view direction can be
+/// found with a bit of arithmetic. The camera never looks up at anything, so the lower hemisphere is left out.
+///
+/// Each frame holds the mesh's albedo, and its model space normal and depth (along the frame's direction, relative to
+/// the center of its bounds), so impostors can be lit like the mesh and cut into the scene at the right depth. Both
+/// atlases are cleared to 0, so their filtered values are scaled by coverage (the albedo's alpha), and dividing by it
+/// gives clean edges without any dilation
+/// </summary>
+class ImpostorAtlas final
+{
+public:
+	typedef std::shared_ptr<ImpostorAtlas> sptr;
+
+	ImpostorAtlas() = default;
+	~ImpostorAtlas() = default;
+
+	ImpostorAtlas(const ImpostorAtlas& other) = delete;
+	ImpostorAtlas& operator=(const ImpostorAtlas& other) = delete;
+
+	// Albedo in RGB, coverage in A
+	Texture2D::sptr Albedo;
+	// Model space normal in RGB, depth in A
+	Texture2D::sptr NormalDepth;
+	// The number of frames along each side of the atlas, and the size of each frame in pixels
+	uint32_t FramesPerSide = 0;
+	uint32_t FrameSize = 0;
+	// The model space bounding sphere the frames were rendered around
+	glm::vec3 Center = glm::vec3(0.0f);
+	float     Radius = 0.0f;
+};
+
+/// <summary>
+/// Lets a renderer be swapped out for its impostor when it's far enough away. The ImpostorSystem decides which
+/// renderers use their impostor each frame
+/// </summary>
+struct ImpostorLOD
+{
+	ImpostorAtlas::sptr Atlas;
+	// True when the impostor is being drawn in place of the mesh this frame
+	bool IsActive = false;
+};
+
+/// <summary>
+/// Bakes impostor atlases, and draws every object that is small enough on screen as an impostor. Each frame, objects
+/// that pass the size test are queued by atlas, and each atlas is then drawn with a single instanced draw of a camera
+/// facing quad, so a distant forest or crowd costs two triangles per object.
+///
+/// To hide the jump between frames as the view direction changes, each impostor blends the three frames around its view
+/// direction. Every frame's UVs come from projecting the quad onto that frame's plane along the view ray, so the frames
+/// line up with each other (and parallax correctly) instead of being cross faded over the top of one another
+/// </summary>
+class ImpostorSystem final
+{
+public:
+	/// <summary>
+	/// How much work the last frame took
+	/// </summary>
+	struct Stats
+	{
+		uint32_t Impostors = 0;
+		uint32_t DrawCalls = 0;
+	};
+
+	// The texture slots the atlases are bound to while drawing
+	static constexpr int ALBEDO_SLOT = 0;
+	static constexpr int NORMAL_DEPTH_SLOT = 1;
+
+	/// <summary>
+	/// Objects whose bounds cover fewer pixels than this (across the screen) are drawn as impostors
+	/// </summary>
+	float SwitchPixelSize = 48.0f;
+	/// <summary>
+	/// Turns impostors off entirely, so everything draws its full mesh
+	/// </summary>
+	bool Enabled = true;
+	/// <summary>
+	/// The layout of atlases baked from now on. The defaults give 64 views at about the resolution they're swapped in at
+	/// </summary>
+	uint32_t FramesPerSide = 8;
+	uint32_t FrameSize = 64;
+
+	ImpostorSystem();
+	~ImpostorSystem() = default;
+
+	ImpostorSystem(const ImpostorSystem& other) = delete;
+	ImpostorSystem& operator=(const ImpostorSystem& other) = delete;
+
+	/// <summary>
+	/// Renders a mesh from every direction in the grid into a new atlas. This changes the bound framebuffer and viewport
+	/// </summary>
+	/// <param name="mesh">The mesh to bake</param>
+	/// <param name="diffuse">The mesh's albedo texture, or nullptr for plain white</param>
+	/// <returns>The baked atlas</returns>
+	ImpostorAtlas::sptr Bake(const VertexArrayObject::sptr& mesh, const ITexture::sptr& diffuse);
+
+	/// <summary>
+	/// Works out how many pixels across a bounding sphere is on screen, for either a perspective or orthographic camera
+	/// </summary>
+	/// <param name="center">The world space center of the sphere</param>
+	/// <param name="radius">The world space radius of the sphere</param>
+	/// <param name="viewProjection">The camera's view projection matrix</param>
+	/// <param name="projection">The camera's projection matrix</param>
+	/// <param name="viewportHeight">The height of the viewport we're rendering to, in pixels</param>
+	static float ProjectedSize(const glm::vec3& center, float radius, const glm::mat4& viewProjection, const glm::mat4& projection, float viewportHeight);
+
+	/// <summary>
+	/// Forgets every impostor that was queued last frame, call this before anything is submitted
+	/// </summary>
+	void BeginFrame();
+
+	/// <summary>
+	/// Queues an object to be drawn as an impostor if it's small enough on screen. Impostors assume the object is only
+	/// rotated around the Y axis, and use its largest axis scale
+	/// </summary>
+	/// <param name="atlas">The object's impostor</param>
+	/// <param name="model">The object's local to world transform</param>
+	/// <param name="pixelSize">How many pixels across the object is on screen, see ProjectedSize</param>
+	/// <returns>True if the impostor will be drawn, in which case the mesh should be skipped</returns>
+	bool Submit(const ImpostorAtlas::sptr& atlas, const glm::mat4& model, float pixelSize);
+
+	/// <summary>
+	/// Draws every impostor that was submitted this frame, with depth testing and writes
+	/// </summary>
+	/// <param name="view">The view matrix of the camera</param>
+	/// <param name="projection">The projection matrix of the camera</param>
+	void Render(const glm::mat4& view, const glm::mat4& projection);
+
+	/// <summary>
+	/// Draws the impostor settings and stats
+	/// </summary>
+	void RenderImGui();
+
+	/// <summary>
+	/// Gets the shader impostors are drawn with, so the scene's lighting uniforms can be set on it
+	/// </summary>
+	const Shader::sptr& GetShader() const { return _shader; }
+
+	const Stats& GetStats() const { return _stats; }
+
+private:
+	// What each impostor needs on the GPU, the rest comes from its atlas
+	struct Instance
+	{
+		// The world space center of the object's bounds
+		glm::vec3 Center;
+		// The object's largest axis scale
+		float     Scale;
+		// The object's rotation around the Y axis, in radians
+		float     Yaw;
+	};
+
+	Shader::sptr            _bakeShader;
+	Shader::sptr            _shader;
+	VertexArrayObject::sptr _quad;
+	VertexBuffer::sptr      _instances;
+	Stats                   _stats;
+
+	// This frame's impostors, grouped by atlas. The lists are kept around between frames so we aren't allocating
+	// every frame
+	std::unordered_map<ImpostorAtlas*, std::vector<Instance>> _queued;
+	std::vector<Instance> _instanceData;
+};
@@ -0,0 +1,81 @@
+#include "IrradianceVolume.h"
+
+#include <cstring>
+
+#include "GpuMemoryTracker.h"
+#include "ITexture.h"
+#include "Logging.h"
+#include "TextureEnums.h"
+#include "Utilities/MappedFile.h"
+
+const char     IrradianceVolume::FILE_MAGIC[4] = { 'I', 'R', 'V', '1' };
+const uint32_t IrradianceVolume::FILE_VERSION = 1;
+
+IrradianceVolume::~IrradianceVolume() {
+	if (_handle != GL_NONE) {
+		GpuMemoryTracker::Instance().Unregister(this);
+		glDeleteTextures(1, &_handle);
+	}
+}
+
+IrradianceVolume::sptr IrradianceVolume::LoadFromFile(const std::string& path) {
+	MappedFile file;
+	if (!file.Open(path)) {
+		return nullptr;
+	}
+	if (file.GetSize() < sizeof(FileHeader)) {
+		LOG_WARN("Irradiance volume \"{}\" is too small to be valid", path);
+		return nullptr;
+	}
+
+	FileHeader header;
+	memcpy(&header, file.GetData(), sizeof(FileHeader));
+	const glm::uvec3 resolution(header.Resolution[0], header.Resolution[1], header.Resolution[2]);
+	if (memcmp(header.Magic, FILE_MAGIC, 4) != 0 || header.Version != FILE_VERSION || glm::any(glm::lessThan(resolution, glm::uvec3(2)))) {
+		LOG_WARN("Irradiance volume \"{}\" is invalid, it needs to be rebaked", path);
+		return nullptr;
+	}
+	const int maxSize = ITexture::GetLimits().MAX_3D_TEXTURE_SIZE;
+	if ((int)resolution.x > maxSize || (int)resolution.y > maxSize || (int)(resolution.z * SLICE_COUNT) > maxSize) {
+		LOG_WARN("Irradiance volume \"{}\" is too big for this GPU ({}x{}x{})", path, resolution.x, resolution.y, resolution.z * SLICE_COUNT);
+		return nullptr;
+	}
+	const size_t texelCount = (size_t)resolution.x * resolution.y * resolution.z * SLICE_COUNT;
+	if (file.GetSize() != sizeof(FileHeader) + texelCount * 4 * sizeof(uint16_t)) {
+		LOG_WARN("Irradiance volume \"{}\" is the wrong size, it needs to be rebaked", path);
+		return nullptr;
+	}
+
+	IrradianceVolume::sptr result = std::make_shared<IrradianceVolume>();
+	result->_resolution = resolution;
+	result->_min = glm::vec3(header.Min[0], header.Min[1], header.Min[2]);
+	result->_max = glm::vec3(header.Max[0], header.Max[1], header.Max[2]);
+
+	// Clamp so that lookups outside of the grid use the closest probes, the shader keeps each slice from bleeding into
+	// the next one along Z
+	glCreateTextures(GL_TEXTURE_3D, 1, &result->_handle);
+	glTextureParameteri(result->_handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(result->_handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(result->_handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(result->_handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(result->_handle, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTextureStorage3D(result->_handle, 1, GL_RGBA16F, resolution.x, resolution.y, resolution.z * SLICE_COUNT);
+	glTextureSubImage3D(result->_handle, 0, 0, 0, 0, resolution.x, resolution.y, resolution.z * SLICE_COUNT,
+		GL_RGBA, GL_HALF_FLOAT, file.GetData() + sizeof(FileHeader));
+
+	glObjectLabel(GL_TEXTURE, result->_handle, -1, path.c_str());
+	GpuMemoryTracker::Instance().Register(result.get(), GpuMemoryCategory::Texture, GL_TEXTURE, result->_handle, texelCount * GetInternalFormatSize(GL_RGBA16F));
+	LOG_INFO("Loaded irradiance volume \"{}\", {}x{}x{} probes", path, resolution.x, resolution.y, resolution.z);
+	return result;
+}
+
+void IrradianceVolume::Bind() const {
+	glBindTextureUnit(TEXTURE_SLOT, _handle);
+}
+
+void IrradianceVolume::SetUniforms(const Shader::sptr& shader) const {
+	shader->SetUniform("u_IrradianceVolumeMin", _min);
+	shader->SetUniform("u_IrradianceVolumeSize", _max - _min);
+	shader->SetUniform("u_IrradianceVolumeResolution", glm::vec3(_resolution));
+	shader->SetUniform("u_UseIrradianceVolume", 1);
+}
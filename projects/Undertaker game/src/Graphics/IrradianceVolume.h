@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <glad/glad.h>
+#include <GLM/glm.hpp>
+
+#include "Shader.h"
+
+/// <summary>
+/// A grid of light probes covering the level, baked by the LightmapBaker, that dynamic objects (the player and the
+/// enemies) use for their ambient light instead of a flat color. Each probe stores the light arriving from every
+/// direction as L2 spherical harmonics, and the vertex shader looks up the probes around each vertex once, so the
+/// cost doesn't change no matter how many enemies are on screen.
+///
+/// The 27 floats of each probe are packed into 7 RGBA texels, stored as 7 stacked copies of the grid in one 3D
+/// texture, so that the hardware blends between the 8 probes around a point for us
+/// </summary>
+class IrradianceVolume final
+{
+public:
+	typedef std::shared_ptr<IrradianceVolume> sptr;
+
+	/// <summary>
+	/// The header at the start of a baked irradiance volume. It is followed by SLICE_COUNT * Z * Y * X half float RGBA
+	/// texels, with X varying fastest
+	/// </summary>
+	struct FileHeader
+	{
+		char     Magic[4];
+		uint32_t Version;
+		uint32_t Resolution[3];
+		// The world space positions of the first and last probes, the rest are spread evenly between them
+		float    Min[3];
+		float    Max[3];
+	};
+	static const char     FILE_MAGIC[4];
+	static const uint32_t FILE_VERSION;
+	// The number of RGBA texels it takes to hold one probe's coefficients
+	static constexpr uint32_t SLICE_COUNT = 7;
+	// The texture slot the volume is bound to, kept clear of the material textures (and the reflection probes). This
+	// must match the binding of s_IrradianceVolume in irradiance_volume.glsl
+	static constexpr int TEXTURE_SLOT = 13;
+
+	IrradianceVolume() = default;
+	~IrradianceVolume();
+
+	IrradianceVolume(const IrradianceVolume& other) = delete;
+	IrradianceVolume& operator=(const IrradianceVolume& other) = delete;
+
+	/// <summary>
+	/// Loads a baked irradiance volume
+	/// </summary>
+	/// <param name="path">The path of the .vol file</param>
+	/// <returns>The volume, or nullptr if it is missing or invalid</returns>
+	static sptr LoadFromFile(const std::string& path);
+
+	/// <summary>
+	/// Gets the path that the irradiance volume is saved to
+	/// </summary>
+	static std::string GetPath(const std::string& directory) {
+		return directory + "/irradiance.vol";
+	}
+
+	/// <summary>
+	/// Binds the volume to TEXTURE_SLOT
+	/// </summary>
+	void Bind() const;
+
+	/// <summary>
+	/// Points a shader at the volume, and switches it over from the flat ambient color
+	/// </summary>
+	void SetUniforms(const Shader::sptr& shader) const;
+
+	const glm::uvec3& GetResolution() const { return _resolution; }
+	const glm::vec3& GetMin() const { return _min; }
+	const glm::vec3& GetMax() const { return _max; }
+
+private:
+	GLuint     _handle = GL_NONE;
+	glm::uvec3 _resolution = glm::uvec3(0);
+	glm::vec3  _min = glm::vec3(0.0f);
+	glm::vec3  _max = glm::vec3(0.0f);
+};
@@ -1,5 +1,78 @@
 #include "LUT.h"
-#pragma warning(disable : 4996)
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <thread>
+#include <GLM/gtc/packing.hpp>
+#include "Logging.h"
+#include "GpuMemoryTracker.h"
+#include "TextureEnums.h"
+#include "Utilities/MappedFile.h"
+
+//Header at the start of our binary LUT caches, followed directly by the packed texels
+struct LutCacheHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t Size;
+	uint32_t Format;
+	float DomainMin[3];
+	float DomainMax[3];
+};
+static const char LUT_CACHE_MAGIC[4] = { 'L', 'U', 'T', '3' };
+static const uint32_t LUT_CACHE_VERSION = 1;
+
+//Files smaller than this aren't worth spinning up threads for
+static const size_t LUT_PARALLEL_THRESHOLD = 256 * 1024;
+
+//Gets the size of a single packed texel in the formats we store
+static size_t GetTexelSize(GLenum format)
+{
+	return format == GL_RGB16F ? 3 * sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+//Skips to the character after the next newline
+static const char* SkipLine(const char* p, const char* end)
+{
+	while (p < end && *p != '\n')
+		p++;
+	return p < end ? p + 1 : end;
+}
+
+//Parses all the numbers between begin and end, skipping comments and anything that isn't a number
+static void ParseFloats(const char* begin, const char* end, std::vector<float>& out)
+{
+	out.reserve((end - begin) / 8);
+	const char* p = begin;
+	while (p < end)
+	{
+		const char c = *p;
+		if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+		{
+			p++;
+			continue;
+		}
+		if (c == '#')
+		{
+			p = SkipLine(p, end);
+			continue;
+		}
+
+		float value;
+		std::from_chars_result result = std::from_chars(p, end, value);
+		if (result.ec != std::errc())
+		{
+			p = SkipLine(p, end);
+			continue;
+		}
+		out.push_back(value);
+		p = result.ptr;
+	}
+}
+
 LUT3D::LUT3D()
 {
 }
@@ -9,39 +82,282 @@ LUT3D::LUT3D(std::string path)
 	loadFromFile(path);
 }
 
+LUT3D::~LUT3D()
+{
+	GpuMemoryTracker::Instance().Unregister(this);
+	if (_handle != GL_NONE)
+	{
+		glDeleteTextures(1, &_handle);
+	}
+}
+
 void LUT3D::loadFromFile(std::string path)
 {
-	std::string filePath = path;
-	std::ifstream LUTstream;
-	LUTstream.open(filePath);
+	auto start = std::chrono::high_resolution_clock::now();
+	const std::string cachePath = path + ".bin";
 
-	while (!LUTstream.eof())
+	if (_loadCache(cachePath, path))
 	{
-		std::string _line;
-		std::getline(LUTstream, _line);
+		auto end = std::chrono::high_resolution_clock::now();
+		LOG_INFO("Loaded LUT \"{}\" ({}^3) from cache in {:.2f} ms", path, _size, std::chrono::duration<float, std::milli>(end - start).count());
+		return;
+	}
 
-		if (_line.empty())
-			continue;
+	std::vector<uint8_t> texels;
+	if (!_parseCube(path, texels))
+	{
+		return;
+	}
+	_upload(texels.data(), path);
+	_writeCache(cachePath, texels);
 
-		glm::vec3 lineData;
-		if (sscanf(_line.c_str(), "%f %f %f", &lineData.x, &lineData.y, &lineData.z) == 3)
-			data.push_back(lineData);
+	auto end = std::chrono::high_resolution_clock::now();
+	LOG_INFO("Parsed LUT \"{}\" ({}^3) in {:.2f} ms", path, _size, std::chrono::duration<float, std::milli>(end - start).count());
+}
+
+void LUT3D::create(int size, GLenum format, const std::string& label)
+{
+	_size = size;
+	_format = format;
+	_domainMin = glm::vec3(0.0f);
+	_domainMax = glm::vec3(1.0f);
+	_upload(nullptr, label);
+}
+
+bool LUT3D::_parseCube(const std::string& path, std::vector<uint8_t>& texels)
+{
+	//Read the whole file in one go, rather than a line at a time
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		LOG_ERROR("Failed to open LUT \"{}\"", path);
+		return false;
 	}
+	std::string contents;
+	contents.resize((size_t)file.tellg());
+	file.seekg(0);
+	file.read(&contents[0], contents.size());
+	file.close();
 
-	glEnable(GL_TEXTURE_3D);
+	const char* p = contents.data();
+	const char* end = p + contents.size();
 
-	glGenTextures(1, &_handle);
-	bind();
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+	//Read the header keywords, the data starts at the first line that begins with a number
+	int size = 0;
+	_domainMin = glm::vec3(0.0f);
+	_domainMax = glm::vec3(1.0f);
+	while (p < end)
+	{
+		while (p < end && (*p == ' ' || *p == '\t'))
+			p++;
+		if (p == end || *p == '-' || *p == '.' || (*p >= '0' && *p <= '9'))
+			break;
 
-	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB, 64, 64, 64, 0, GL_RGB, GL_FLOAT, &data[0]);
-	unbind();
+		const char* lineEnd = SkipLine(p, end);
+		std::string line(p, lineEnd);
+		if (line.compare(0, 11, "LUT_3D_SIZE") == 0)
+		{
+			size = std::atoi(line.c_str() + 11);
+		}
+		else if (line.compare(0, 10, "DOMAIN_MIN") == 0)
+		{
+			std::vector<float> values;
+			ParseFloats(line.data() + 10, line.data() + line.size(), values);
+			if (values.size() == 3)
+				_domainMin = glm::vec3(values[0], values[1], values[2]);
+		}
+		else if (line.compare(0, 10, "DOMAIN_MAX") == 0)
+		{
+			std::vector<float> values;
+			ParseFloats(line.data() + 10, line.data() + line.size(), values);
+			if (values.size() == 3)
+				_domainMax = glm::vec3(values[0], values[1], values[2]);
+		}
+		else if (line.compare(0, 11, "LUT_1D_SIZE") == 0)
+		{
+			LOG_ERROR("LUT \"{}\" is a 1D LUT, only 3D LUTs are supported", path);
+			return false;
+		}
+		p = lineEnd;
+	}
+
+	//Split the data into chunks on line boundaries, and parse them all at once
+	const size_t dataSize = end - p;
+	size_t chunkCount = dataSize < LUT_PARALLEL_THRESHOLD ? 1 : std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 16);
+	std::vector<const char*> bounds(chunkCount + 1);
+	bounds[0] = p;
+	for (size_t i = 1; i < chunkCount; i++)
+	{
+		bounds[i] = SkipLine(std::max(p + dataSize * i / chunkCount, bounds[i - 1]), end);
+	}
+	bounds[chunkCount] = end;
+
+	std::vector<std::vector<float>> chunks(chunkCount);
+	std::vector<std::future<void>> tasks;
+	for (size_t i = 1; i < chunkCount; i++)
+	{
+		tasks.push_back(std::async(std::launch::async, ParseFloats, bounds[i], bounds[i + 1], std::ref(chunks[i])));
+	}
+	ParseFloats(bounds[0], bounds[1], chunks[0]);
+	for (auto& task : tasks)
+	{
+		task.wait();
+	}
+
+	size_t valueCount = 0;
+	for (const auto& chunk : chunks)
+	{
+		valueCount += chunk.size();
+	}
+
+	//Older files don't always say how big they are, so work it out from the number of entries
+	if (size == 0)
+	{
+		size = (int)glm::round(glm::pow((float)(valueCount / 3), 1.0f / 3.0f));
+		LOG_WARN("LUT \"{}\" has no LUT_3D_SIZE, assuming {}", path, size);
+	}
+	const size_t texelCount = (size_t)size * size * size;
+	if (size < 2 || valueCount != texelCount * 3)
+	{
+		LOG_ERROR("LUT \"{}\" should have {} entries, but has {}", path, texelCount, valueCount / 3);
+		return false;
+	}
+
+	//10 bits per channel is plenty for colors in 0-1, but HDR grades need floats
+	_size = size;
+	_format = GL_RGB10_A2;
+	for (const auto& chunk : chunks)
+	{
+		for (float value : chunk)
+		{
+			if (value < 0.0f || value > 1.0f)
+				_format = GL_RGB16F;
+		}
+	}
+
+	//Pack the texels, .cube files are stored with red changing fastest which is the same order OpenGL wants
+	texels.resize(texelCount * GetTexelSize(_format));
+	size_t component = 0;
+	uint32_t* packed = reinterpret_cast<uint32_t*>(texels.data());
+	uint16_t* halves = reinterpret_cast<uint16_t*>(texels.data());
+	glm::vec3 texel;
+	for (const auto& chunk : chunks)
+	{
+		for (float value : chunk)
+		{
+			texel[component % 3] = value;
+			if (component % 3 == 2)
+			{
+				const size_t index = component / 3;
+				if (_format == GL_RGB16F)
+				{
+					halves[index * 3 + 0] = glm::packHalf1x16(texel.r);
+					halves[index * 3 + 1] = glm::packHalf1x16(texel.g);
+					halves[index * 3 + 2] = glm::packHalf1x16(texel.b);
+				}
+				else
+				{
+					//GL_UNSIGNED_INT_2_10_10_10_REV puts red in the lowest bits
+					const glm::uvec3 bits = glm::uvec3(glm::round(glm::clamp(texel, 0.0f, 1.0f) * 1023.0f));
+					packed[index] = bits.r | (bits.g << 10) | (bits.b << 20) | (3u << 30);
+				}
+			}
+			component++;
+		}
+	}
+
+	return true;
+}
+
+bool LUT3D::_loadCache(const std::string& cachePath, const std::string& sourcePath)
+{
+	std::error_code error;
+	if (!std::filesystem::exists(cachePath, error))
+		return false;
+	//If we still have the .cube, make sure the cache isn't older than it
+	if (std::filesystem::exists(sourcePath, error) &&
+		std::filesystem::last_write_time(cachePath, error) < std::filesystem::last_write_time(sourcePath, error))
+		return false;
+
+	MappedFile file;
+	if (!file.Open(cachePath) || file.GetSize() < sizeof(LutCacheHeader))
+		return false;
+
+	LutCacheHeader header;
+	memcpy(&header, file.GetData(), sizeof(LutCacheHeader));
+	if (memcmp(header.Magic, LUT_CACHE_MAGIC, 4) != 0 || header.Version != LUT_CACHE_VERSION ||
+		(header.Format != GL_RGB10_A2 && header.Format != GL_RGB16F))
+	{
+		LOG_WARN("LUT cache \"{}\" is invalid, it will be rebuilt", cachePath);
+		return false;
+	}
+	const size_t texelCount = (size_t)header.Size * header.Size * header.Size;
+	if (file.GetSize() != sizeof(LutCacheHeader) + texelCount * GetTexelSize(header.Format))
+	{
+		LOG_WARN("LUT cache \"{}\" is the wrong size, it will be rebuilt", cachePath);
+		return false;
+	}
+
+	_size = header.Size;
+	_format = header.Format;
+	_domainMin = glm::vec3(header.DomainMin[0], header.DomainMin[1], header.DomainMin[2]);
+	_domainMax = glm::vec3(header.DomainMax[0], header.DomainMax[1], header.DomainMax[2]);
+	//Upload straight out of the mapping, no copies needed
+	_upload(file.GetData() + sizeof(LutCacheHeader), sourcePath);
+	return true;
+}
+
+void LUT3D::_writeCache(const std::string& cachePath, const std::vector<uint8_t>& texels) const
+{
+	LutCacheHeader header;
+	memcpy(header.Magic, LUT_CACHE_MAGIC, 4);
+	header.Version = LUT_CACHE_VERSION;
+	header.Size = _size;
+	header.Format = _format;
+	for (int i = 0; i < 3; i++)
+	{
+		header.DomainMin[i] = _domainMin[i];
+		header.DomainMax[i] = _domainMax[i];
+	}
+
+	std::ofstream file(cachePath, std::ios::binary);
+	if (!file.is_open())
+	{
+		LOG_WARN("Failed to write LUT cache \"{}\"", cachePath);
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(LutCacheHeader));
+	file.write(reinterpret_cast<const char*>(texels.data()), texels.size());
+}
+
+void LUT3D::_upload(const void* texels, const std::string& label)
+{
+	if (_handle != GL_NONE)
+	{
+		glDeleteTextures(1, &_handle);
+	}
+
+	glCreateTextures(GL_TEXTURE_3D, 1, &_handle);
+	glTextureParameteri(_handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(_handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_R, GL_REPEAT);
+	glTextureStorage3D(_handle, 1, _format, _size, _size, _size);
+
+	if (texels != nullptr)
+	{
+		//Half float rows are only 2 byte aligned for odd sizes (ex: 33^3)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, _format == GL_RGB16F ? 2 : 4);
+		if (_format == GL_RGB16F)
+			glTextureSubImage3D(_handle, 0, 0, 0, 0, _size, _size, _size, GL_RGB, GL_HALF_FLOAT, texels);
+		else
+			glTextureSubImage3D(_handle, 0, 0, 0, 0, _size, _size, _size, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, texels);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
 
-	glDisable(GL_TEXTURE_3D);
+	glObjectLabel(GL_TEXTURE, _handle, label.length(), label.c_str());
+	GpuMemoryTracker::Instance().Register(this, GpuMemoryCategory::LUT, GL_TEXTURE, _handle, (size_t)_size * _size * _size * GetInternalFormatSize(_format));
 }
 
 void LUT3D::bind()
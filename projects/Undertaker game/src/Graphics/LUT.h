@@ -4,19 +4,52 @@
 #include <string>
 #include <glad/glad.h>
 #include "glm/common.hpp"
+#include "glm/vec3.hpp"
 
 class LUT3D
 {
 public:
 	LUT3D();
 	LUT3D(std::string path);
+	~LUT3D();
+
+	LUT3D(const LUT3D& other) = delete;
+	LUT3D& operator=(const LUT3D& other) = delete;
+
+	//Loads a .cube file
+	//*Uses the binary cache next to the file (path + ".bin") if it is newer than the .cube, otherwise the .cube is
+	//*parsed and the cache is written for next time
 	void loadFromFile(std::string path);
+	//Creates an empty LUT covering 0-1, to be filled in on the GPU (ex: by a LutMixer)
+	void create(int size, GLenum format, const std::string& label);
 	void bind();
 	void unbind();
 
 	void bind(int textureSlot);
 	void unbind(int textureSlot);
+
+	//Gets the number of entries along each axis (LUT_3D_SIZE)
+	int getSize() const { return _size; }
+	//Gets the range of input colors the LUT covers (DOMAIN_MIN and DOMAIN_MAX)
+	const glm::vec3& getDomainMin() const { return _domainMin; }
+	const glm::vec3& getDomainMax() const { return _domainMax; }
+	//Gets the texture's internal format, for loaded LUTs this is GL_RGB10_A2, or GL_RGB16F if the LUT has values outside of 0-1
+	GLenum getFormat() const { return _format; }
+	GLuint getHandle() const { return _handle; }
+
 private:
 	GLuint _handle = GL_NONE;
-	std::vector<glm::vec3> data;
+	int _size = 0;
+	GLenum _format = GL_NONE;
+	glm::vec3 _domainMin = glm::vec3(0.0f);
+	glm::vec3 _domainMax = glm::vec3(1.0f);
+
+	//Parses a .cube file into a packed texel buffer, returns false if the file is invalid
+	bool _parseCube(const std::string& path, std::vector<uint8_t>& texels);
+	//Tries to load our binary cache, returns false if it is missing, stale or invalid
+	bool _loadCache(const std::string& cachePath, const std::string& sourcePath);
+	//Writes a binary cache of the packed texels
+	void _writeCache(const std::string& cachePath, const std::vector<uint8_t>& texels) const;
+	//Creates the texture from packed texels (or leaves it empty if texels is nullptr)
+	void _upload(const void* texels, const std::string& label);
 };
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "Lightmap.h"
+
+#include <cstring>
+
+#include "Logging.h"
+#include "Utilities/MappedFile.h"
+#include "Utilities/MeshBuilder.h"
+#include "Utilities/VertexTypes.h"
+
+const char     Lightmap::FILE_MAGIC[4] = { 'L', 'M', 'P', '1' };
+const uint32_t Lightmap::FILE_VERSION = 1;
+
+Lightmap::sptr Lightmap::LoadFromFile(const std::string& path, const glm::mat4& transform) {
+	MappedFile file;
+	if (!file.Open(path)) {
+		return nullptr;
+	}
+	if (file.GetSize() < sizeof(FileHeader)) {
+		LOG_WARN("Lightmap \"{}\" is too small to be valid", path);
+		return nullptr;
+	}
+
+	FileHeader header;
+	memcpy(&header, file.GetData(), sizeof(FileHeader));
+	if (memcmp(header.Magic, FILE_MAGIC, 4) != 0 || header.Version != FILE_VERSION ||
+		header.Width == 0 || header.Height == 0 || (header.VertexCount == 0) != (header.IndexCount == 0)) {
+		LOG_WARN("Lightmap \"{}\" is invalid, it needs to be rebaked", path);
+		return nullptr;
+	}
+	const size_t vertexBytes = header.VertexCount * sizeof(VertexPosNormTexColLm);
+	const size_t indexBytes = header.IndexCount * sizeof(uint32_t);
+	const size_t texelBytes = (size_t)header.Width * header.Height * 4 * sizeof(uint16_t);
+	if (file.GetSize() != sizeof(FileHeader) + vertexBytes + indexBytes + texelBytes) {
+		LOG_WARN("Lightmap \"{}\" is the wrong size, it needs to be rebaked", path);
+		return nullptr;
+	}
+
+	// Lighting baked for a different spot is worse than no baked lighting at all
+	for (int ix = 0; ix < 16; ix++) {
+		const float expected = transform[ix / 4][ix % 4];
+		if (glm::abs(header.Transform[ix] - expected) > 1e-3f * glm::max(1.0f, glm::abs(expected))) {
+			LOG_WARN("Lightmap \"{}\" was baked for a different transform, it needs to be rebaked", path);
+			return nullptr;
+		}
+	}
+
+	const uint8_t* data = file.GetData() + sizeof(FileHeader);
+	MeshBuilder<VertexPosNormTexColLm> mesh;
+	mesh.ReserveVertexSpace(header.VertexCount);
+	mesh.ReserveIndexSpace(header.IndexCount);
+	const VertexPosNormTexColLm* vertices = reinterpret_cast<const VertexPosNormTexColLm*>(data);
+	for (uint32_t ix = 0; ix < header.VertexCount; ix++) {
+		mesh.AddVertex(vertices[ix]);
+	}
+	const uint32_t* indices = reinterpret_cast<const uint32_t*>(data + vertexBytes);
+	for (uint32_t ix = 0; ix < header.IndexCount; ix++) {
+		if (indices[ix] >= header.VertexCount) {
+			LOG_WARN("Lightmap \"{}\" has an index out of range, it needs to be rebaked", path);
+			return nullptr;
+		}
+		mesh.AddIndex(indices[ix]);
+	}
+
+	// Charts are packed tightly, so we can't mip without lighting bleeding between them
+	Texture2DDescription desc;
+	desc.Width = header.Width;
+	desc.Height = header.Height;
+	desc.Format = InternalFormat::RGBA16F;
+	desc.HorizontalWrap = WrapMode::ClampToEdge;
+	desc.VerticalWrap = WrapMode::ClampToEdge;
+	desc.MinificationFilter = MinFilter::Linear;
+	desc.MagnificationFilter = MagFilter::Linear;
+	desc.GenerateMipMaps = false;
+
+	Texture2DData::sptr texels = std::make_shared<Texture2DData>(header.Width, header.Height, PixelFormat::RGBA, PixelType::HalfFloat,
+		(void*)(data + vertexBytes + indexBytes), InternalFormat::RGBA16F);
+	texels->DebugName = path;
+
+	Lightmap::sptr result = std::make_shared<Lightmap>();
+	result->_mesh = header.VertexCount > 0 ? mesh.Bake() : nullptr;
+	result->_texture = Texture2D::Create(desc);
+	result->_texture->LoadData(texels);
+	return result;
+}
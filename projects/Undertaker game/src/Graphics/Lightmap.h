@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <GLM/glm.hpp>
+
+#include "Texture2D.h"
+#include "VertexArrayObject.h"
+
+/// <summary>
+/// Baked lighting for a single static object, as produced by the LightmapBaker. Holds a copy of the object's mesh with
+/// a second UV set that gives every triangle its own space in the lightmap, and the lightmap itself (RGBA16F, with the
+/// baked direct + indirect lighting in RGB and ambient occlusion in A).
+///
+/// Heightfields (see Terrain) have UVs that already cover them without overlapping, so their lightmaps are just the
+/// texture, without a mesh
+/// </summary>
+class Lightmap final
+{
+public:
+	typedef std::shared_ptr<Lightmap> sptr;
+
+	/// <summary>
+	/// The header at the start of a baked lightmap file. It is followed by VertexCount VertexPosNormTexColLm, then
+	/// IndexCount uint32 indices, then Width * Height half float RGBA texels. Both counts are 0 for lightmaps without a
+	/// mesh
+	/// </summary>
+	struct FileHeader
+	{
+		char     Magic[4];
+		uint32_t Version;
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t VertexCount;
+		uint32_t IndexCount;
+		// The object's transform when it was baked, the lighting is only valid if it hasn't moved since
+		float    Transform[16];
+	};
+	static const char     FILE_MAGIC[4];
+	static const uint32_t FILE_VERSION;
+
+	Lightmap() = default;
+	~Lightmap() = default;
+
+	Lightmap(const Lightmap& other) = delete;
+	Lightmap& operator=(const Lightmap& other) = delete;
+
+	/// <summary>
+	/// Loads a baked lightmap
+	/// </summary>
+	/// <param name="path">The path of the .lmap file</param>
+	/// <param name="transform">The transform of the object we want to light, if it doesn't match the one the file was baked with the bake is stale</param>
+	/// <returns>The lightmap, or nullptr if it is missing, invalid, or stale</returns>
+	static sptr LoadFromFile(const std::string& path, const glm::mat4& transform);
+
+	/// <summary>
+	/// Gets the path that the lightmap for an object is saved to
+	/// </summary>
+	static std::string GetPath(const std::string& directory, const std::string& objectName) {
+		return directory + "/" + objectName + ".lmap";
+	}
+
+	/// <summary>
+	/// Gets the object's mesh, with the lightmap UVs in attribute slot 4, or nullptr if the lightmap has no mesh
+	/// </summary>
+	const VertexArrayObject::sptr& GetMesh() const { return _mesh; }
+	/// <summary>
+	/// Gets the baked lighting texture
+	/// </summary>
+	const Texture2D::sptr& GetTexture() const { return _texture; }
+
+private:
+	VertexArrayObject::sptr _mesh;
+	Texture2D::sptr         _texture;
+};
@@ -0,0 +1,82 @@
+#include "LutMixer.h"
+
+#include "Logging.h"
+
+// Must match the local size in lut_mix_comp.glsl
+static constexpr int LUT_MIX_GROUP_SIZE = 4;
+// The first texture slot our sources are bound to
+static constexpr int LUT_MIX_FIRST_SLOT = 0;
+
+LutMixer::LutMixer(int size) {
+	_output.create(size, GL_RGBA16F, "Mixed LUT");
+
+	_shader = Shader::Create();
+	_shader->LoadShaderPartFromFile("shaders/Post/lut_mix_comp.glsl", GL_COMPUTE_SHADER);
+	_shader->Link();
+}
+
+int LutMixer::AddSource(LUT3D* lut, float weight) {
+	LOG_ASSERT(_sources.size() < MAX_SOURCES, "LUT mixers can only blend up to {} LUTs", MAX_SOURCES);
+	_sources.push_back({ lut, weight });
+	_isDirty = true;
+	return (int)_sources.size() - 1;
+}
+
+void LutMixer::SetWeight(int index, float weight) {
+	if (_sources[index].Weight != weight) {
+		_sources[index].Weight = weight;
+		_isDirty = true;
+	}
+}
+
+bool LutMixer::Update() {
+	if (!_isDirty) {
+		return false;
+	}
+
+	int samplers[MAX_SOURCES];
+	float weights[MAX_SOURCES];
+	float sizes[MAX_SOURCES];
+	glm::vec3 domainMins[MAX_SOURCES];
+	glm::vec3 domainMaxs[MAX_SOURCES];
+	const int count = (int)_sources.size();
+	for (int ix = 0; ix < MAX_SOURCES; ix++) {
+		samplers[ix] = LUT_MIX_FIRST_SLOT + ix;
+		if (ix < count) {
+			const Source& source = _sources[ix];
+			weights[ix] = glm::max(source.Weight, 0.0f);
+			sizes[ix] = (float)source.Lut->getSize();
+			domainMins[ix] = source.Lut->getDomainMin();
+			domainMaxs[ix] = source.Lut->getDomainMax();
+			source.Lut->bind(LUT_MIX_FIRST_SLOT + ix);
+		} else {
+			weights[ix] = 0.0f;
+			sizes[ix] = 1.0f;
+			domainMins[ix] = glm::vec3(0.0f);
+			domainMaxs[ix] = glm::vec3(1.0f);
+		}
+	}
+
+	_shader->SetUniform(_shader->GetUniformLocation("u_Sources"), samplers, MAX_SOURCES);
+	_shader->SetUniform(_shader->GetUniformLocation("u_Weights"), weights, MAX_SOURCES);
+	_shader->SetUniform(_shader->GetUniformLocation("u_SourceSizes"), sizes, MAX_SOURCES);
+	_shader->SetUniform(_shader->GetUniformLocation("u_DomainMins"), domainMins, MAX_SOURCES);
+	_shader->SetUniform(_shader->GetUniformLocation("u_DomainMaxs"), domainMaxs, MAX_SOURCES);
+	_shader->SetUniform("u_SourceCount", count);
+
+	glBindImageTexture(0, _output.getHandle(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+	const GLuint groups = (_output.getSize() + LUT_MIX_GROUP_SIZE - 1) / LUT_MIX_GROUP_SIZE;
+	_shader->Dispatch(groups, groups, groups);
+	// The grading pass samples the result as a texture
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	glBindImageTexture(0, 0, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+	Shader::UnBind();
+
+	for (int ix = 0; ix < count; ix++) {
+		_sources[ix].Lut->unbind(LUT_MIX_FIRST_SLOT + ix);
+	}
+
+	_isDirty = false;
+	_bakeCount++;
+	return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <vector>
+
+#include "LUT.h"
+#include "Shader.h"
+
+/// <summary>
+/// Blends any number of grading LUTs into a single LUT on the GPU, so that stacking grades still only costs one LUT
+/// lookup per pixel. The blended LUT is only rebuilt (with a single compute dispatch) when the weights change.
+/// Weights that add up to less than one blend towards the neutral grade, weights that add up to more are normalized
+/// </summary>
+class LutMixer final
+{
+public:
+	/// <summary>
+	/// The most LUTs that can be blended at once
+	/// </summary>
+	static constexpr int MAX_SOURCES = 8;
+
+	/// <summary>
+	/// Creates a new mixer, with an output LUT of the given size
+	/// </summary>
+	/// <param name="size">The number of entries along each axis of the output</param>
+	explicit LutMixer(int size = 64);
+
+	LutMixer(const LutMixer& other) = delete;
+	LutMixer& operator=(const LutMixer& other) = delete;
+
+	/// <summary>
+	/// Adds a LUT to blend (the mixer does not take ownership)
+	/// </summary>
+	/// <param name="lut">The LUT to add</param>
+	/// <param name="weight">The starting weight of the LUT</param>
+	/// <returns>The index of the source, for use with SetWeight</returns>
+	int AddSource(LUT3D* lut, float weight = 0.0f);
+
+	/// <summary>
+	/// Sets the weight of a source, the output will be rebuilt on the next Update if it changed
+	/// </summary>
+	void SetWeight(int index, float weight);
+	float GetWeight(int index) const { return _sources[index].Weight; }
+	int GetSourceCount() const { return (int)_sources.size(); }
+
+	/// <summary>
+	/// Rebuilds the blended LUT if any weights have changed since the last update
+	/// </summary>
+	/// <returns>True if the LUT was rebuilt</returns>
+	bool Update();
+
+	/// <summary>
+	/// Gets the blended LUT, this is what the grading shader should sample
+	/// </summary>
+	LUT3D& GetOutput() { return _output; }
+
+	/// <summary>
+	/// Gets the number of times the blended LUT has been rebuilt
+	/// </summary>
+	uint32_t GetBakeCount() const { return _bakeCount; }
+
+private:
+	struct Source
+	{
+		LUT3D* Lut;
+		float  Weight;
+	};
+
+	std::vector<Source> _sources;
+	LUT3D        _output;
+	Shader::sptr _shader;
+	bool         _isDirty = true;
+	uint32_t     _bakeCount = 0;
+};
@@ -0,0 +1,361 @@
+#include "ParticleSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <thread>
+#include <xmmintrin.h>
+#include <imgui.h>
+#include "IndexBuffer.h"
+#include "Gameplay/Transform.h"
+
+namespace {
+	// A small, fast random number generator, each emitter keeps its own state so they can be updated in parallel
+	inline uint32_t XorShift(uint32_t& state) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	// Returns a random float between -1 and 1
+	inline float RandomSigned(uint32_t& state) {
+		return (XorShift(state) & 0xFFFFFF) / float(0x7FFFFF) - 1.0f;
+	}
+
+	// Returns a random float between 0 and 1
+	inline float RandomUnit(uint32_t& state) {
+		return (XorShift(state) & 0xFFFFFF) / float(0xFFFFFF);
+	}
+
+	inline uint32_t RoundUp4(uint32_t value) {
+		return (value + 3) & ~3u;
+	}
+
+	void MoveParticle(ParticleEmitter& emitter, uint32_t from, uint32_t to) {
+		emitter.PosX[to] = emitter.PosX[from];
+		emitter.PosY[to] = emitter.PosY[from];
+		emitter.PosZ[to] = emitter.PosZ[from];
+		emitter.VelX[to] = emitter.VelX[from];
+		emitter.VelY[to] = emitter.VelY[from];
+		emitter.VelZ[to] = emitter.VelZ[from];
+		emitter.Age[to] = emitter.Age[from];
+		emitter.AgeRate[to] = emitter.AgeRate[from];
+	}
+
+	void UpdateEmitter(ParticleEmitter& emitter, const glm::vec3& origin, float deltaTime) {
+		// Keep the arrays padded to a multiple of 4, so the SIMD loop can always work on whole blocks
+		const uint32_t capacity = RoundUp4(emitter.MaxParticles);
+		if (emitter.PosX.size() != capacity) {
+			for (std::vector<float>* array : { &emitter.PosX, &emitter.PosY, &emitter.PosZ, &emitter.VelX, &emitter.VelY,
+				&emitter.VelZ, &emitter.Age, &emitter.AgeRate }) {
+				array->resize(capacity, 0.0f);
+			}
+		}
+		emitter.Count = std::min(emitter.Count, emitter.MaxParticles);
+		if (emitter.Seed == 0) {
+			emitter.Seed = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&emitter)) | 1u;
+		}
+
+		// Step the living particles 4 at a time. The padding past Count holds old (but finite) values, so it's safe
+		// to step along with everything else
+		const __m128 dt = _mm_set1_ps(deltaTime);
+		const __m128 accelX = _mm_set1_ps(emitter.Acceleration.x * deltaTime);
+		const __m128 accelY = _mm_set1_ps(emitter.Acceleration.y * deltaTime);
+		const __m128 accelZ = _mm_set1_ps(emitter.Acceleration.z * deltaTime);
+		const __m128 drag = _mm_set1_ps(1.0f / (1.0f + emitter.Drag * deltaTime));
+		const uint32_t blockEnd = RoundUp4(emitter.Count);
+		for (uint32_t ix = 0; ix < blockEnd; ix += 4) {
+			__m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&emitter.VelX[ix]), accelX), drag);
+			__m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&emitter.VelY[ix]), accelY), drag);
+			__m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&emitter.VelZ[ix]), accelZ), drag);
+			_mm_storeu_ps(&emitter.VelX[ix], vx);
+			_mm_storeu_ps(&emitter.VelY[ix], vy);
+			_mm_storeu_ps(&emitter.VelZ[ix], vz);
+			_mm_storeu_ps(&emitter.PosX[ix], _mm_add_ps(_mm_loadu_ps(&emitter.PosX[ix]), _mm_mul_ps(vx, dt)));
+			_mm_storeu_ps(&emitter.PosY[ix], _mm_add_ps(_mm_loadu_ps(&emitter.PosY[ix]), _mm_mul_ps(vy, dt)));
+			_mm_storeu_ps(&emitter.PosZ[ix], _mm_add_ps(_mm_loadu_ps(&emitter.PosZ[ix]), _mm_mul_ps(vz, dt)));
+			_mm_storeu_ps(&emitter.Age[ix], _mm_add_ps(_mm_loadu_ps(&emitter.Age[ix]), _mm_mul_ps(_mm_loadu_ps(&emitter.AgeRate[ix]), dt)));
+		}
+
+		// Remove the dead particles by moving the last living particle into their place. Most blocks have nothing
+		// dying in them, so we check 4 at a time and skip over blocks that are entirely alive
+		const __m128 one = _mm_set1_ps(1.0f);
+		uint32_t ix = 0;
+		while (ix < emitter.Count) {
+			if ((ix & 3) == 0 && ix + 4 <= emitter.Count &&
+				_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(&emitter.Age[ix]), one)) == 0) {
+				ix += 4;
+				continue;
+			}
+			if (emitter.Age[ix] >= 1.0f) {
+				emitter.Count--;
+				MoveParticle(emitter, emitter.Count, ix);
+			} else {
+				ix++;
+			}
+		}
+
+		// Spawn the new particles at the end of the arrays
+		uint32_t spawnCount = emitter.PendingBurst;
+		emitter.PendingBurst = 0;
+		if (emitter.Emitting) {
+			emitter.SpawnAccumulator += emitter.SpawnRate * deltaTime;
+			const float whole = std::floor(emitter.SpawnAccumulator);
+			emitter.SpawnAccumulator -= whole;
+			spawnCount += static_cast<uint32_t>(whole);
+		}
+		spawnCount = std::min(spawnCount, emitter.MaxParticles - emitter.Count);
+		for (uint32_t spawned = 0; spawned < spawnCount; spawned++) {
+			const uint32_t p = emitter.Count++;
+			uint32_t& seed = emitter.Seed;
+			emitter.PosX[p] = origin.x + RandomSigned(seed) * emitter.SpawnRadius;
+			emitter.PosY[p] = origin.y + RandomSigned(seed) * emitter.SpawnRadius;
+			emitter.PosZ[p] = origin.z + RandomSigned(seed) * emitter.SpawnRadius;
+			emitter.VelX[p] = emitter.Velocity.x + RandomSigned(seed) * emitter.VelocityRandomness.x;
+			emitter.VelY[p] = emitter.Velocity.y + RandomSigned(seed) * emitter.VelocityRandomness.y;
+			emitter.VelZ[p] = emitter.Velocity.z + RandomSigned(seed) * emitter.VelocityRandomness.z;
+			emitter.Age[p] = 0.0f;
+			const float lifetime = glm::mix(emitter.Lifetime.x, emitter.Lifetime.y, RandomUnit(seed));
+			emitter.AgeRate[p] = 1.0f / glm::max(lifetime, 0.001f);
+		}
+	}
+}
+
+ParticleEmitter ParticleEmitter::MuzzleFlash() {
+	ParticleEmitter result;
+	result.Emitting = false;
+	result.MaxParticles = 256;
+	result.SpawnRadius = 0.05f;
+	result.Lifetime = glm::vec2(0.05f, 0.15f);
+	result.Velocity = glm::vec3(0.0f);
+	result.VelocityRandomness = glm::vec3(4.0f);
+	result.Drag = 4.0f;
+	result.Size = glm::vec2(0.15f, 0.02f);
+	result.StartColor = glm::vec4(1.0f, 0.85f, 0.4f, 1.0f);
+	result.EndColor = glm::vec4(1.0f, 0.3f, 0.0f, 0.0f);
+	result.Additive = true;
+	return result;
+}
+
+ParticleEmitter ParticleEmitter::Blood() {
+	ParticleEmitter result;
+	result.Emitting = false;
+	result.MaxParticles = 512;
+	result.Lifetime = glm::vec2(0.4f, 0.8f);
+	result.Velocity = glm::vec3(0.0f, 2.0f, 0.0f);
+	result.VelocityRandomness = glm::vec3(2.0f, 1.5f, 2.0f);
+	result.Acceleration = glm::vec3(0.0f, -9.8f, 0.0f);
+	result.Drag = 0.5f;
+	result.Size = glm::vec2(0.08f, 0.04f);
+	result.StartColor = glm::vec4(0.5f, 0.0f, 0.0f, 1.0f);
+	result.EndColor = glm::vec4(0.3f, 0.0f, 0.0f, 0.8f);
+	return result;
+}
+
+ParticleEmitter ParticleEmitter::Dust() {
+	ParticleEmitter result;
+	result.SpawnRate = 6.0f;
+	result.MaxParticles = 256;
+	result.SpawnRadius = 2.0f;
+	result.Lifetime = glm::vec2(3.0f, 5.0f);
+	result.Velocity = glm::vec3(0.2f, 0.05f, 0.0f);
+	result.VelocityRandomness = glm::vec3(0.2f, 0.05f, 0.2f);
+	result.Drag = 0.2f;
+	result.Size = glm::vec2(0.8f, 2.0f);
+	result.StartColor = glm::vec4(0.5f, 0.45f, 0.4f, 0.25f);
+	result.EndColor = glm::vec4(0.5f, 0.45f, 0.4f, 0.0f);
+	return result;
+}
+
+ParticleEmitter ParticleEmitter::Ectoplasm() {
+	ParticleEmitter result;
+	result.SpawnRate = 30.0f;
+	result.MaxParticles = 512;
+	result.SpawnRadius = 0.4f;
+	result.Lifetime = glm::vec2(1.5f, 3.0f);
+	result.Velocity = glm::vec3(0.0f, 0.6f, 0.0f);
+	result.VelocityRandomness = glm::vec3(0.3f, 0.2f, 0.3f);
+	result.Acceleration = glm::vec3(0.0f, 0.3f, 0.0f);
+	result.Drag = 0.3f;
+	result.Size = glm::vec2(0.25f, 0.05f);
+	result.StartColor = glm::vec4(0.4f, 1.0f, 0.5f, 0.8f);
+	result.EndColor = glm::vec4(0.1f, 0.6f, 0.3f, 0.0f);
+	result.Additive = true;
+	return result;
+}
+
+ParticleSystem::ParticleSystem() :
+	_softDistance(0.5f)
+{
+	_shader = Shader::Create();
+	_shader->LoadShaderPartFromFile("shaders/vertex_particle.glsl", GL_VERTEX_SHADER);
+	_shader->LoadShaderPartFromFile("shaders/frag_particle.glsl", GL_FRAGMENT_SHADER);
+	_shader->Link();
+	_shader->SetUniform("s_Depth", DEPTH_SLOT);
+	_shader->SetUniform("s_Texture", TEXTURE_SLOT);
+
+	// Every particle is the same quad, expanded to face the camera in the vertex shader
+	const glm::vec2 corners[4] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+	const uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+	VertexBuffer::sptr vbo = VertexBuffer::Create();
+	vbo->LoadData(corners, 4);
+	IndexBuffer::sptr ebo = IndexBuffer::Create();
+	ebo->LoadData(indices, 6);
+
+	// The particles themselves are streamed in every frame, as (position, age)
+	_instances = VertexBuffer::Create(GL_STREAM_DRAW);
+	_instances->SetDebugName("Particle Instances");
+
+	_quad = VertexArrayObject::Create();
+	_quad->AddVertexBuffer(vbo, { BufferAttribute(0, 2, GL_FLOAT, false, sizeof(glm::vec2), 0, AttribUsage::Position) });
+	_quad->AddVertexBuffer(_instances, { BufferAttribute(1, 4, GL_FLOAT, false, sizeof(glm::vec4), 0, AttribUsage::User0, 1) });
+	_quad->SetIndexBuffer(ebo);
+}
+
+void ParticleSystem::Update(entt::registry& registry, float deltaTime) {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	_emitters.clear();
+	_origins.clear();
+	uint32_t totalParticles = 0;
+	registry.view<ParticleEmitter, Transform>().each([&](entt::entity, ParticleEmitter& emitter, Transform& transform) {
+		_emitters.push_back(&emitter);
+		_origins.push_back(transform.GetLocalPosition());
+		totalParticles += emitter.Count;
+	});
+
+	// Split the emitters into runs with about the same number of particles in each, and hand all but the first run
+	// to other threads. Every emitter has its own particles and random numbers, so there is nothing to lock
+	uint32_t threadCount = 1;
+	if (totalParticles >= PARALLEL_THRESHOLD && _emitters.size() > 1) {
+		threadCount = glm::clamp(std::thread::hardware_concurrency(), 1u, MAX_THREADS);
+		threadCount = std::min(threadCount, static_cast<uint32_t>(_emitters.size()));
+	}
+	std::vector<size_t> bounds = { 0 };
+	if (threadCount > 1) {
+		const uint32_t perThread = totalParticles / threadCount + 1;
+		uint32_t running = 0;
+		for (size_t ix = 0; ix < _emitters.size() && bounds.size() < threadCount; ix++) {
+			running += _emitters[ix]->Count;
+			if (running >= perThread * bounds.size()) {
+				bounds.push_back(ix + 1);
+			}
+		}
+	}
+	bounds.push_back(_emitters.size());
+
+	auto updateRange = [&](size_t begin, size_t end) {
+		for (size_t ix = begin; ix < end; ix++) {
+			UpdateEmitter(*_emitters[ix], _origins[ix], deltaTime);
+		}
+	};
+	std::vector<std::future<void>> tasks;
+	for (size_t ix = 1; ix + 1 < bounds.size(); ix++) {
+		if (bounds[ix] < bounds[ix + 1]) {
+			tasks.push_back(std::async(std::launch::async, updateRange, bounds[ix], bounds[ix + 1]));
+		}
+	}
+	updateRange(bounds[0], bounds[1]);
+	for (std::future<void>& task : tasks) {
+		task.get();
+	}
+
+	_stats.Emitters = static_cast<uint32_t>(_emitters.size());
+	_stats.Particles = 0;
+	for (ParticleEmitter* emitter : _emitters) {
+		_stats.Particles += emitter->Count;
+	}
+	_stats.Threads = static_cast<uint32_t>(tasks.size() + 1);
+	auto end = std::chrono::high_resolution_clock::now();
+	_stats.UpdateMs = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void ParticleSystem::Render(entt::registry& registry, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane) {
+	// Sort the emitters back to front, particles within an emitter are drawn in whatever order they're in
+	_drawCalls.clear();
+	uint32_t instanceCount = 0;
+	registry.view<ParticleEmitter, Transform>().each([&](entt::entity, ParticleEmitter& emitter, Transform& transform) {
+		if (emitter.Count == 0) {
+			return;
+		}
+		const float depth = (view * glm::vec4(transform.GetLocalPosition(), 1.0f)).z;
+		_drawCalls.push_back({ &emitter, depth, instanceCount });
+		instanceCount += RoundUp4(emitter.Count);
+	});
+	_stats.DrawCalls = static_cast<uint32_t>(_drawCalls.size());
+	if (_drawCalls.empty()) {
+		return;
+	}
+	std::sort(_drawCalls.begin(), _drawCalls.end(), [](const DrawCall& a, const DrawCall& b) {
+		return a.Depth < b.Depth;
+	});
+
+	// Interleave the particles into (position, age) for the GPU, turning 4 particles of SoA data into 4 AoS
+	// vertices with a single transpose
+	_instanceData.resize(instanceCount);
+	for (const DrawCall& call : _drawCalls) {
+		const ParticleEmitter& emitter = *call.Emitter;
+		float* out = &_instanceData[call.FirstInstance].x;
+		for (uint32_t ix = 0; ix < emitter.Count; ix += 4) {
+			__m128 x = _mm_loadu_ps(&emitter.PosX[ix]);
+			__m128 y = _mm_loadu_ps(&emitter.PosY[ix]);
+			__m128 z = _mm_loadu_ps(&emitter.PosZ[ix]);
+			__m128 age = _mm_loadu_ps(&emitter.Age[ix]);
+			_MM_TRANSPOSE4_PS(x, y, z, age);
+			_mm_storeu_ps(out + ix * 4, x);
+			_mm_storeu_ps(out + ix * 4 + 4, y);
+			_mm_storeu_ps(out + ix * 4 + 8, z);
+			_mm_storeu_ps(out + ix * 4 + 12, age);
+		}
+	}
+	_instances->StreamData(_instanceData.data(), sizeof(glm::vec4), _instanceData.size());
+
+	_shader->Bind();
+	_shader->SetUniformMatrix("u_View", view);
+	_shader->SetUniformMatrix("u_Projection", projection);
+	_shader->SetUniform("u_NearPlane", nearPlane);
+	_shader->SetUniform("u_FarPlane", farPlane);
+	_shader->SetUniform("u_SoftDistance", _softDistance);
+
+	glDepthMask(GL_FALSE);
+	glDisable(GL_CULL_FACE);
+	glEnable(GL_BLEND);
+	for (const DrawCall& call : _drawCalls) {
+		const ParticleEmitter& emitter = *call.Emitter;
+		glBlendFunc(GL_SRC_ALPHA, emitter.Additive ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+		_shader->SetUniform("u_StartColor", emitter.StartColor);
+		_shader->SetUniform("u_EndColor", emitter.EndColor);
+		_shader->SetUniform("u_Size", emitter.Size);
+		_shader->SetUniform("u_HasTexture", emitter.Texture != nullptr ? 1 : 0);
+		if (emitter.Texture != nullptr) {
+			emitter.Texture->Bind(TEXTURE_SLOT);
+		}
+		_quad->RenderInstanced(emitter.Count, call.FirstInstance);
+	}
+	glDisable(GL_BLEND);
+	glEnable(GL_CULL_FACE);
+	glDepthMask(GL_TRUE);
+}
+
+void ParticleSystem::RenderImGui(entt::registry& registry) {
+	ImGui::Text("Emitters: %d", (int)_stats.Emitters);
+	ImGui::Text("Particles: %d", (int)_stats.Particles);
+	ImGui::Text("Update: %.3f ms on %d thread(s)", _stats.UpdateMs, (int)_stats.Threads);
+	ImGui::Text("Draw calls: %d", (int)_stats.DrawCalls);
+	ImGui::SliderFloat("Soft Distance", &_softDistance, 0.01f, 2.0f);
+
+	// Spreads 100k particles across the emitters, making room for them if they need it
+	if (ImGui::Button("Stress Test (+100k)")) {
+		auto view = registry.view<ParticleEmitter>();
+		const uint32_t emitterCount = static_cast<uint32_t>(view.size());
+		if (emitterCount > 0) {
+			const uint32_t perEmitter = 100000 / emitterCount;
+			for (entt::entity entity : view) {
+				ParticleEmitter& emitter = view.get<ParticleEmitter>(entity);
+				emitter.MaxParticles = std::max(emitter.MaxParticles, emitter.Count + perEmitter);
+				emitter.Burst(perEmitter);
+			}
+		}
+	}
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <entt.hpp>
+#include <GLM/glm.hpp>
+
+#include "Shader.h"
+#include "Texture2D.h"
+#include "VertexArrayObject.h"
+#include "VertexBuffer.h"
+
+/// <summary>
+/// A component that spits out particles from the position of its GameObject. The settings describe what the particles
+/// look like and how they move, the ParticleSystem does all of the actual work.
+///
+/// Particles are stored as a structure of arrays (one array per attribute), so the simulation can step 4 particles at
+/// a time with SSE, and the arrays are always padded out to a multiple of 4 so it never needs a scalar tail loop
+/// </summary>
+struct ParticleEmitter
+{
+	// How many particles to spawn each second, while Emitting is set
+	float     SpawnRate = 20.0f;
+	bool      Emitting = true;
+	// The most particles this emitter can have alive at once, new particles are dropped when it is full
+	uint32_t  MaxParticles = 1024;
+	// How far from the emitter particles can spawn
+	float     SpawnRadius = 0.1f;
+	// The min and max time a particle lives for, in seconds
+	glm::vec2 Lifetime = glm::vec2(1.0f, 2.0f);
+	// The starting velocity of each particle, and how far each axis can be randomly pushed away from it
+	glm::vec3 Velocity = glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 VelocityRandomness = glm::vec3(0.5f);
+	// Constant acceleration (ex: gravity), and how much of its velocity a particle loses per second
+	glm::vec3 Acceleration = glm::vec3(0.0f);
+	float     Drag = 0.0f;
+	// The world space size of a particle at the start and end of its life
+	glm::vec2 Size = glm::vec2(0.2f, 0.0f);
+	// The color of a particle at the start and end of its life, alpha included
+	glm::vec4 StartColor = glm::vec4(1.0f);
+	glm::vec4 EndColor = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+	// Additive blending for glowing particles (fire, magic), otherwise they are alpha blended
+	bool      Additive = false;
+	// The texture for each particle, or nullptr for a soft round dot
+	Texture2D::sptr Texture = nullptr;
+
+	/// <summary>
+	/// Spawns a number of particles all at once, the next time the emitter is updated
+	/// </summary>
+	void Burst(uint32_t count) { PendingBurst += count; }
+
+	/// <summary>
+	/// Gets the number of particles that are currently alive
+	/// </summary>
+	uint32_t GetParticleCount() const { return Count; }
+
+	/// <summary>
+	/// A quick flash of sparks, meant to be burst rather than emitted
+	/// </summary>
+	static ParticleEmitter MuzzleFlash();
+	/// <summary>
+	/// A spray of droplets that fall under gravity, meant to be burst rather than emitted
+	/// </summary>
+	static ParticleEmitter Blood();
+	/// <summary>
+	/// Slow, wide puffs of dust that hang around the ground
+	/// </summary>
+	static ParticleEmitter Dust();
+	/// <summary>
+	/// Glowing green wisps that drift upwards
+	/// </summary>
+	static ParticleEmitter Ectoplasm();
+
+	// The particles themselves, owned by the ParticleSystem. Age goes from 0 to 1 over the particle's life, at AgeRate
+	// per second, so particles with different lifetimes can be faded and killed the same way
+	std::vector<float> PosX, PosY, PosZ;
+	std::vector<float> VelX, VelY, VelZ;
+	std::vector<float> Age, AgeRate;
+	uint32_t Count = 0;
+	float    SpawnAccumulator = 0.0f;
+	uint32_t PendingBurst = 0;
+	uint32_t Seed = 0;
+};
+
+/// <summary>
+/// Simulates and draws every ParticleEmitter in a scene. Emitters are spread across a few threads each frame, with
+/// each emitter's particles stepped 4 at a time with SSE. Dead particles are removed by swapping the last living
+/// particle into their place, so the arrays stay tightly packed without shuffling everything down.
+///
+/// For drawing, every emitter's particles are streamed into one instance buffer, and each emitter is then drawn with a
+/// single instanced draw of a camera facing quad. Emitters are sorted back to front so their blending comes out right,
+/// and particles fade out as they get close to the scene behind them, so they don't show hard lines where they cut
+/// into the ground or walls
+/// </summary>
+class ParticleSystem final
+{
+public:
+	/// <summary>
+	/// How much work the last frame took
+	/// </summary>
+	struct Stats
+	{
+		uint32_t Emitters = 0;
+		uint32_t Particles = 0;
+		uint32_t DrawCalls = 0;
+		float    UpdateMs = 0.0f;
+		uint32_t Threads = 0;
+	};
+
+	// The texture slot the scene's depth buffer should be bound to for soft particles
+	static constexpr int DEPTH_SLOT = 0;
+	// The texture slot that particle textures are bound to
+	static constexpr int TEXTURE_SLOT = 1;
+
+	ParticleSystem();
+	~ParticleSystem() = default;
+
+	ParticleSystem(const ParticleSystem& other) = delete;
+	ParticleSystem& operator=(const ParticleSystem& other) = delete;
+
+	/// <summary>
+	/// Steps every emitter forward, spawning new particles and removing dead ones
+	/// </summary>
+	/// <param name="registry">The registry holding the emitters, they also need a Transform</param>
+	/// <param name="deltaTime">The time since the last update, in seconds</param>
+	void Update(entt::registry& registry, float deltaTime);
+
+	/// <summary>
+	/// Draws every emitter, testing against (but not writing to) the bound target's depth. The scene's depth buffer
+	/// should also be bound to DEPTH_SLOT, for soft particles
+	/// </summary>
+	/// <param name="registry">The registry holding the emitters, they also need a Transform</param>
+	/// <param name="view">The view matrix of the camera</param>
+	/// <param name="projection">The projection matrix of the camera</param>
+	/// <param name="nearPlane">The camera's near plane, used to linearize the scene depth</param>
+	/// <param name="farPlane">The camera's far plane, used to linearize the scene depth</param>
+	void Render(entt::registry& registry, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane);
+
+	/// <summary>
+	/// Draws the particle settings and stats
+	/// </summary>
+	void RenderImGui(entt::registry& registry);
+
+	const Stats& GetStats() const { return _stats; }
+
+	/// <summary>
+	/// Sets how far in front of the scene particles start to fade out
+	/// </summary>
+	void SetSoftDistance(float distance) { _softDistance = distance; }
+	float GetSoftDistance() const { return _softDistance; }
+
+private:
+	// Below this many particles, the update isn't worth handing to other threads
+	static constexpr uint32_t PARALLEL_THRESHOLD = 4096;
+	static constexpr uint32_t MAX_THREADS = 8;
+
+	// One emitter's slice of the instance buffer
+	struct DrawCall
+	{
+		ParticleEmitter* Emitter;
+		float            Depth;
+		uint32_t         FirstInstance;
+	};
+
+	Shader::sptr            _shader;
+	VertexArrayObject::sptr _quad;
+	VertexBuffer::sptr      _instances;
+	float                   _softDistance;
+	Stats                   _stats;
+
+	// Scratch space, kept around between frames so we aren't allocating every frame
+	std::vector<ParticleEmitter*> _emitters;
+	std::vector<glm::vec3>        _origins;
+	std::vector<DrawCall>         _drawCalls;
+	std::vector<glm::vec4>        _instanceData;
+};
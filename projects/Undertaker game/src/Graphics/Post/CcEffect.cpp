@@ -2,14 +2,12 @@
 
 void CcEffect::Init(unsigned width, unsigned height)
 {
-    int index = int(_buffers.size());
-    _buffers.push_back(new Framebuffer());
-    _buffers[index]->AddColorTarget(GL_RGBA8);
-    _buffers[index]->AddDepthTarget();
-    _buffers[index]->Init(width, height);
+    //Fullscreen passes never depth test, so we only need a color buffer
+    Reshape(width, height);
+    AddBuffer(GL_RGBA8);
 
     //Set up shaders
-    index = int(_shaders.size());
+    int index = int(_shaders.size());
     _shaders.push_back(Shader::Create());
     _shaders[index]->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
     _shaders[index]->LoadShaderPartFromFile("shaders/Post/color_correction_frag.glsl", GL_FRAGMENT_SHADER);
@@ -19,17 +17,40 @@ void CcEffect::Init(unsigned width, unsigned height)
 void CcEffect::ApplyEffect(PostEffect* buffer)
 {
     BindShader(0);
-    _shaders[0]->SetUniform("u_Intensity", _intensity);
+    SetUniforms(_shaders[0], "u_");
+    _shaders[0]->SetUniform("u_UvScale", buffer->GetUvScale(0));
 
     buffer->BindColorAsTexture(0, 0, 0);
 
+    AcquireBuffers();
     _buffers[0]->RenderToFSQ();
 
     buffer->UnbindTexture(0);
+    buffer->ReleaseBuffers();
 
     UnbindShader();
 }
 
+const char* CcEffect::GetFusedSnippetPath() const
+{
+    return "shaders/Post/color_correction_fused.glsl";
+}
+
+void CcEffect::SetUniforms(const Shader::sptr& shader, const std::string& prefix)
+{
+    shader->SetUniform(prefix + "Intensity", _intensity);
+
+    //The standalone shader is hardwired to slot 30, fused shaders get told where to look
+    if (_lut != nullptr)
+    {
+        _lut->bind(30);
+        shader->SetUniform(prefix + "Lut", 30);
+        shader->SetUniform(prefix + "LutSize", float(_lut->getSize()));
+        shader->SetUniform(prefix + "DomainMin", _lut->getDomainMin());
+        shader->SetUniform(prefix + "DomainMax", _lut->getDomainMax());
+    }
+}
+
 float CcEffect::GetIntensity() const
 {
 	return _intensity;
@@ -39,3 +60,8 @@ void CcEffect::SetIntensity(float intensity)
 {
 	_intensity = intensity;
 }
+
+void CcEffect::SetLUT(LUT3D* lut)
+{
+	_lut = lut;
+}
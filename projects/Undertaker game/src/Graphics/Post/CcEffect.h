@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Graphics/Post/PostEffect.h"
+#include "Graphics/LUT.h"
 
 class CcEffect : public PostEffect
 {
@@ -11,14 +12,22 @@ public:
 	//Applies effect to this buffer
 	void ApplyEffect(PostEffect* buffer) override;
 
+	//Gets the snippet used to fuse this effect with others
+	const char* GetFusedSnippetPath() const override;
+	//Sets the intensity uniform, and binds our LUT
+	void SetUniforms(const Shader::sptr& shader, const std::string& prefix) override;
+
 	//Getters
 	float GetIntensity() const;
 
 	//Setters
 	void SetIntensity(float intensity);
+	//Sets the LUT to grade with (the effect does not own it)
+	void SetLUT(LUT3D* lut);
 
 private:
 	float _intensity = 1.0f;
+	LUT3D* _lut = nullptr;
 
 };
 
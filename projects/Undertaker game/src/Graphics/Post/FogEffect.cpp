@@ -0,0 +1,55 @@
+#include "FogEffect.h"
+
+void FogEffect::Init(unsigned width, unsigned height)
+{
+    Reshape(width, height);
+
+    //Loads the shaders
+    int index = int(_shaders.size());
+    _shaders.push_back(Shader::Create());
+    _shaders[index]->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
+    _shaders[index]->LoadShaderPartFromFile("shaders/Post/fog_frag.glsl", GL_FRAGMENT_SHADER);
+    _shaders[index]->Link();
+}
+
+unsigned FogEffect::GetResolutionDivisor() const
+{
+    return 2;
+}
+
+void FogEffect::SetUniforms(const Shader::sptr& shader, const std::string& prefix)
+{
+    shader->SetUniform(prefix + "Color", _color);
+    shader->SetUniform(prefix + "Density", _density);
+    shader->SetUniform(prefix + "Start", _start);
+}
+
+const glm::vec3& FogEffect::GetColor() const
+{
+    return _color;
+}
+
+float FogEffect::GetDensity() const
+{
+    return _density;
+}
+
+float FogEffect::GetStart() const
+{
+    return _start;
+}
+
+void FogEffect::SetColor(const glm::vec3& color)
+{
+    _color = color;
+}
+
+void FogEffect::SetDensity(float density)
+{
+    _density = density;
+}
+
+void FogEffect::SetStart(float start)
+{
+    _start = start;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Graphics/Post/PostEffect.h"
+
+//Distance fog, based on the depth of the scene
+//*Fog changes slowly across the screen, so it runs at half resolution and is scaled back up by the PostProcessChain
+class FogEffect : public PostEffect
+{
+public:
+	//Loads our shader, we only ever draw into the chain's targets so we don't need any buffers
+	void Init(unsigned width, unsigned height) override;
+
+	//Runs at half resolution
+	unsigned GetResolutionDivisor() const override;
+	//Sets the fog uniforms
+	void SetUniforms(const Shader::sptr& shader, const std::string& prefix) override;
+
+	//Getters
+	const glm::vec3& GetColor() const;
+	float GetDensity() const;
+	float GetStart() const;
+
+	//Setters
+	void SetColor(const glm::vec3& color);
+	void SetDensity(float density);
+	void SetStart(float start);
+private:
+	glm::vec3 _color = glm::vec3(0.35f, 0.4f, 0.5f);
+	float _density = 0.03f;
+	float _start = 8.0f;
+
+};
\ No newline at end of file
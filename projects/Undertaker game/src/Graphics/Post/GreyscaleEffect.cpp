@@ -2,14 +2,12 @@
 
 void GreyscaleEffect::Init(unsigned width, unsigned height)
 {
-    int index = int(_buffers.size());
-    _buffers.push_back(new Framebuffer());
-    _buffers[index]->AddColorTarget(GL_RGBA8);
-    _buffers[index]->AddDepthTarget();
-    _buffers[index]->Init(width, height);
+    //Fullscreen passes never depth test, so we only need a color buffer
+    Reshape(width, height);
+    AddBuffer(GL_RGBA8);
 
     //Loads the shaders
-    index = int(_shaders.size());
+    int index = int(_shaders.size());
     _shaders.push_back(Shader::Create());
     _shaders[index]->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
     _shaders[index]->LoadShaderPartFromFile("shaders/Post/greyscale_frag.glsl", GL_FRAGMENT_SHADER);
@@ -19,17 +17,30 @@ void GreyscaleEffect::Init(unsigned width, unsigned height)
 void GreyscaleEffect::ApplyEffect(PostEffect* buffer)
 {
     BindShader(0);
-    _shaders[0]->SetUniform("u_Intensity", _intensity);
+    SetUniforms(_shaders[0], "u_");
+    _shaders[0]->SetUniform("u_UvScale", buffer->GetUvScale(0));
 
     buffer->BindColorAsTexture(0, 0, 0);
 
+    AcquireBuffers();
     _buffers[0]->RenderToFSQ();
 
     buffer->UnbindTexture(0);
+    buffer->ReleaseBuffers();
 
     UnbindShader();
 }
 
+const char* GreyscaleEffect::GetFusedSnippetPath() const
+{
+    return "shaders/Post/greyscale_fused.glsl";
+}
+
+void GreyscaleEffect::SetUniforms(const Shader::sptr& shader, const std::string& prefix)
+{
+    shader->SetUniform(prefix + "Intensity", _intensity);
+}
+
 float GreyscaleEffect::GetIntensity() const
 {
     return _intensity;
@@ -13,6 +13,11 @@ public:
 	//Passes the previous framebuffer with the texture to apply as parameter
 	void ApplyEffect(PostEffect* buffer) override;
 
+	//Gets the snippet used to fuse this effect with others
+	const char* GetFusedSnippetPath() const override;
+	//Sets the intensity uniform
+	void SetUniforms(const Shader::sptr& shader, const std::string& prefix) override;
+
 	//Getters
 	float GetIntensity() const;
 
@@ -3,13 +3,11 @@
 void PostEffect::Init(unsigned width, unsigned height)
 {
 	//Set up framebuffers
-	int index = int(_buffers.size());
-	_buffers.push_back(new Framebuffer());
-	_buffers[index]->AddColorTarget(GL_RGBA8);
-	_buffers[index]->AddDepthTarget();
-	_buffers[index]->Init(width, height);
+	Reshape(width, height);
+	//The basic effect is what the scene gets drawn into, so it keeps its depth buffer
+	AddBuffer(GL_RGBA8, true);
 
-	index = int(_shaders.size());
+	int index = int(_shaders.size());
 	_shaders.push_back(Shader::Create());
 	_shaders[index]->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
 	_shaders[index]->LoadShaderPartFromFile("shaders/passthrough_frag.glsl", GL_FRAGMENT_SHADER);
@@ -19,19 +17,38 @@ void PostEffect::Init(unsigned width, unsigned height)
 void PostEffect::ApplyEffect(PostEffect* previousBuffer)
 {
 	BindShader(0);
+	_shaders[0]->SetUniform("u_UvScale", previousBuffer->GetUvScale(0));
 
 	previousBuffer->BindColorAsTexture(0, 0, 0);
 
+	AcquireBuffers();
 	_buffers[0]->RenderToFSQ();
 
 	previousBuffer->UnbindTexture(0);
+	previousBuffer->ReleaseBuffers();
 	
 	UnbindShader();
 }
 
+void PostEffect::Draw(Framebuffer* input)
+{
+	BindShader(0);
+	SetUniforms(_shaders[0], "u_");
+	_shaders[0]->SetUniform("u_UvScale", input->GetUvScale());
+
+	input->BindColorAsTexture(0, 0);
+
+	Framebuffer::DrawFullscreenQuad();
+
+	UnbindTexture(0);
+
+	UnbindShader();
+}
+
 void PostEffect::DrawToScreen()
 {
 	BindShader(0);
+	_shaders[0]->SetUniform("u_UvScale", GetUvScale(0));
 
 	BindColorAsTexture(0, 0, 0);
 
@@ -40,18 +57,28 @@ void PostEffect::DrawToScreen()
 	UnbindTexture(0);
 
 	UnbindShader();
+
+	ReleaseBuffers();
 }
 
 void PostEffect::Reshape(unsigned width, unsigned height)
 {
-	for (unsigned int i = 0; i < _buffers.size(); ++i)
+	//Buffers of the old size go back to the pool, we'll pick up new ones next time we draw
+	ReleaseBuffers();
+
+	for (unsigned int i = 0; i < _bufferDescs.size(); ++i)
 	{
-		_buffers[i]->Reshape(width, height);
+		_bufferDescs[i].Width = width;
+		_bufferDescs[i].Height = height;
 	}
+	_width = width;
+	_height = height;
 }
 
 void PostEffect::Clear()
 {
+	AcquireBuffers();
+
 	for (unsigned int i = 0; i < _buffers.size(); ++i)
 	{
 		_buffers[i]->Clear();
@@ -59,22 +86,47 @@ void PostEffect::Clear()
 }
 
 void PostEffect::Unload()
+{
+	ReleaseBuffers();
+
+	_buffers.clear();
+	_bufferDescs.clear();
+	_shaders.clear();
+}
+
+void PostEffect::AcquireBuffers()
+{
+	for (unsigned int i = 0; i < _buffers.size(); ++i)
+	{
+		if (_buffers[i] == nullptr)
+		{
+			_buffers[i] = RenderTargetPool::Instance().Acquire(_bufferDescs[i]);
+		}
+	}
+}
+
+void PostEffect::ReleaseBuffers()
 {
 	for (unsigned int i = 0; i < _buffers.size(); ++i)
 	{
 		if (_buffers[i] != nullptr)
 		{
-			_buffers[i]->Unload();
-			delete _buffers[i];
+			RenderTargetPool::Instance().Release(_buffers[i]);
 			_buffers[i] = nullptr;
 		}
 	}
+}
 
-	_shaders.clear();
+void PostEffect::AddBuffer(GLenum format, bool depth)
+{
+	_buffers.push_back(nullptr);
+	//Effects can bind their depth as a texture, so it has to stay sampleable
+	_bufferDescs.push_back(RenderTargetDesc(_width, _height, format, depth, depth));
 }
 
 void PostEffect::BindBuffer(int index)
 {
+	AcquireBuffers();
 	_buffers[index]->Bind();
 }
 
@@ -88,6 +140,11 @@ void PostEffect::BindColorAsTexture(int index, int colorBuffer, int textureSlot)
 	_buffers[index]->BindColorAsTexture(colorBuffer, textureSlot);
 }
 
+glm::vec2 PostEffect::GetUvScale(int index) const
+{
+	return _buffers[index]->GetUvScale();
+}
+
 void PostEffect::BindDepthAsTexture(int index, int textureSlot)
 {
 	_buffers[index]->BindDepthAsTexture(textureSlot);
@@ -109,3 +166,18 @@ void PostEffect::UnbindShader()
 {
 	glUseProgram(GL_NONE);
 }
+
+const char* PostEffect::GetFusedSnippetPath() const
+{
+	//The basic effect is just a passthrough, so there's nothing to fuse
+	return nullptr;
+}
+
+void PostEffect::SetUniforms(const Shader::sptr& shader, const std::string& prefix)
+{
+}
+
+unsigned PostEffect::GetResolutionDivisor() const
+{
+	return 1;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Graphics/Framebuffer.h"
+#include "Graphics/RenderTargetPool.h"
 #include "Graphics/Shader.h"
 
 class PostEffect
@@ -10,18 +11,28 @@ public:
 	virtual void Init(unsigned width, unsigned height);
 
 	//Applies the effect
+	//*Releases the previous effect's buffers, since they have been consumed
 	virtual void ApplyEffect(PostEffect* previousBuffer);
+	//Draws the effect into the bound framebuffer, using the color of input as the source
+	virtual void Draw(Framebuffer* input);
+	//*Releases this effect's buffers once drawn
 	virtual void DrawToScreen();
 
 	//Reshapes the buffer
 	virtual void Reshape(unsigned width, unsigned height);
 
 	//Clears the buffers
+	//*Acquires them from the render target pool if we don't have them yet
 	void Clear();
 
 	//Unloads all the buffers
 	void Unload();
 
+	//Acquires any buffers we don't have yet from the render target pool
+	void AcquireBuffers();
+	//Returns our buffers to the render target pool, so later passes can reuse the memory
+	void ReleaseBuffers();
+
 	//Binds buffers
 	void BindBuffer(int index);
 	void UnbindBuffer();
@@ -30,15 +41,47 @@ public:
 	void BindColorAsTexture(int index, int colorBuffer, int textureSlot);
 	void BindDepthAsTexture(int index, int textureSlot);
 	void UnbindTexture(int textureSlot);
+	//Gets what to scale UVs by to sample a buffer, since pooled buffers can be bigger than the part we drew to
+	glm::vec2 GetUvScale(int index) const;
 
 	//Bind shaders
 	void BindShader(int index);
 	void UnbindShader();
 
+	//Per pixel effects can return the path of a GLSL snippet, so that a PostProcessChain can fuse them into one pass
+	//*The snippet defines vec4 $Apply(vec4 color), and any uniforms it needs, with $ in place of a prefix
+	//*Returns nullptr if the effect can't be fused (ex: it samples neighbouring pixels)
+	virtual const char* GetFusedSnippetPath() const;
+	//Sets this effect's uniforms on a shader, with their names starting with prefix
+	//*Standalone shaders use a prefix of "u_"
+	virtual void SetUniforms(const Shader::sptr& shader, const std::string& prefix);
+
+	//Blurry and low frequency effects (ex: fog, bloom) can return 2 or 4 to run at that fraction of the resolution
+	//*Draw is then given a downsampled copy of the image, and the min and max linear depth under each of its pixels
+	//*is bound to LOW_RES_DEPTH_SLOT (in R and G)
+	//*The effect draws a premultiplied layer, which a PostProcessChain scales back up with a filter that keeps depth
+	//*edges sharp, then blends over the full resolution image as color * (1 - layer.a) + layer.rgb
+	//*Effects that run at a lower resolution can't be fused
+	virtual unsigned GetResolutionDivisor() const;
+	static constexpr int LOW_RES_DEPTH_SLOT = 1;
+
+	//Disabled effects are skipped by post process chains
+	bool Enabled = true;
+
 protected:
-	//Holds all our buffers for the effects
+	//Adds a buffer to be acquired from the render target pool
+	//*Most effects only draw fullscreen quads, so they don't need depth
+	void AddBuffer(GLenum format = GL_RGBA8, bool depth = false);
+
+	//Holds all our buffers for the effects (nullptr when not acquired)
 	std::vector<Framebuffer*> _buffers;
+	//Describes what each of our buffers needs from the pool
+	std::vector<RenderTargetDesc> _bufferDescs;
 
 	//Holds all our shaders for the effects
 	std::vector<Shader::sptr> _shaders;
+
+	//The size to request our buffers at
+	unsigned _width = 0;
+	unsigned _height = 0;
 };
\ No newline at end of file
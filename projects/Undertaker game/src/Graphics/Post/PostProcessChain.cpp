@@ -0,0 +1,378 @@
+#include "PostProcessChain.h"
+
+#include <fstream>
+#include <sstream>
+#include "Logging.h"
+
+//Reads the input for a fused shader. The vertex shader has already scaled the UVs to the used part of the input, this
+//*keeps us from bleeding past its edges, and when the input was rendered at a lower resolution sharpens it with an
+//*unsharp mask to make up for the lost detail
+static const char* SAMPLE_SOURCE_GLSL = R"(
+uniform vec2 u_UvClamp = vec2(1.0);
+uniform float u_Sharpness = 0.0;
+
+vec4 SampleSource(vec2 uv)
+{
+	vec2 scaledUv = min(uv, u_UvClamp);
+	vec4 center = texture(s_screenTex, scaledUv);
+	if (u_Sharpness <= 0.0)
+		return center;
+
+	vec2 texel = 1.0 / vec2(textureSize(s_screenTex, 0));
+	vec3 neighbours = texture(s_screenTex, min(scaledUv + vec2(texel.x, 0.0), u_UvClamp)).rgb +
+		texture(s_screenTex, scaledUv - vec2(texel.x, 0.0)).rgb +
+		texture(s_screenTex, min(scaledUv + vec2(0.0, texel.y), u_UvClamp)).rgb +
+		texture(s_screenTex, scaledUv - vec2(0.0, texel.y)).rgb;
+	return vec4(max(center.rgb + (center.rgb * 4.0 - neighbours) * 0.25 * u_Sharpness, 0.0), center.a);
+}
+
+)";
+
+std::unordered_map<std::string, Shader::sptr> PostProcessChain::_shaderCache;
+std::unordered_map<std::string, std::string> PostProcessChain::_snippetCache;
+
+//Effects that run at a lower resolution need their own passes around them, so they can't be fused
+static bool IsFusable(const PostEffect* effect)
+{
+	return effect->GetFusedSnippetPath() != nullptr && effect->GetResolutionDivisor() <= 1;
+}
+
+//Gets the size of a target at a fraction of the resolution, rounding up so no pixels are left uncovered
+static unsigned DivideSize(unsigned size, unsigned divisor)
+{
+	return glm::max((size + divisor - 1) / divisor, 1u);
+}
+
+void PostProcessChain::AddEffect(PostEffect* effect)
+{
+	_effects.push_back(effect);
+}
+
+void PostProcessChain::SetInputRect(unsigned width, unsigned height)
+{
+	_inputWidth = width;
+	_inputHeight = height;
+}
+
+void PostProcessChain::SetDepthPlanes(float nearPlane, float farPlane)
+{
+	_nearPlane = nearPlane;
+	_farPlane = farPlane;
+}
+
+void PostProcessChain::AddPasses(FrameGraph& graph, FrameGraphResource input, FrameGraphResource output, unsigned width, unsigned height)
+{
+	//Split the enabled effects into runs, fusable effects are grouped together and everything else stands alone
+	std::vector<std::vector<PostEffect*>> groups;
+	bool lastFusable = false;
+	for (PostEffect* effect : _effects)
+	{
+		if (!effect->Enabled)
+		{
+			continue;
+		}
+
+		const bool fusable = IsFusable(effect);
+		if (groups.empty() || !fusable || !lastFusable)
+		{
+			groups.emplace_back();
+		}
+		groups.back().push_back(effect);
+		lastFusable = fusable;
+	}
+
+	//Work out how much of the input is in use, only fused shaders know how to scale it up
+	const unsigned inputWidth = _inputWidth == 0 ? width : glm::min(_inputWidth, width);
+	const unsigned inputHeight = _inputHeight == 0 ? height : glm::min(_inputHeight, height);
+	const bool isScaled = inputWidth != width || inputHeight != height;
+
+	//With nothing enabled we still need to copy our input to the output, which an empty fused shader does
+	if (groups.empty() || (isScaled && !IsFusable(groups[0][0])))
+	{
+		groups.insert(groups.begin(), std::vector<PostEffect*>());
+	}
+
+	//The first pass scales up the part of the input we're using, and sharpens it to make up for lost detail
+	const float sharpness = isScaled ? Sharpness : 0.0f;
+
+	FrameGraphResource source = input;
+	std::vector<FrameGraphResource> depthLevels;
+	_passCount = 0;
+	for (int i = 0; i < int(groups.size()); i++)
+	{
+		const std::vector<PostEffect*>& group = groups[i];
+		const bool isLast = i == int(groups.size()) - 1;
+		FrameGraphResource target = isLast ? output : graph.CreateTarget("Post Chain " + std::to_string(i), RenderTargetDesc(width, height, GL_RGBA8));
+
+		//Fused groups get a generated shader, effects that can't be fused draw themselves
+		const bool fused = group.empty() || IsFusable(group[0]);
+		if (!fused && group[0]->GetResolutionDivisor() > 1)
+		{
+			_passCount += _AddLowResPasses(graph, group[0], "Post " + std::to_string(i), input, source, target, width, height, depthLevels);
+			source = target;
+			continue;
+		}
+		Shader::sptr shader = fused ? _GetFusedShader(group) : nullptr;
+
+		graph.AddPass("Post " + std::to_string(i), [=](FrameGraph::PassBuilder& builder) {
+			builder.Read(source);
+			builder.Write(target);
+		}, [=](FrameGraph& frame) {
+			Framebuffer* inputBuffer = frame.GetTarget(source);
+			if (shader == nullptr)
+			{
+				group[0]->Draw(inputBuffer);
+				return;
+			}
+
+			//Pooled targets are allocated in size classes, so even full size inputs may only fill part of their texture
+			const glm::vec2 textureSize = glm::vec2(inputBuffer->_width, inputBuffer->_height);
+			const glm::vec2 usedSize = i == 0 ? glm::vec2(inputWidth, inputHeight) :
+				glm::vec2(inputBuffer->GetViewportWidth(), inputBuffer->GetViewportHeight());
+
+			shader->Bind();
+			shader->SetUniform("u_UvScale", usedSize / textureSize);
+			shader->SetUniform("u_UvClamp", (usedSize - 0.5f) / textureSize);
+			shader->SetUniform("u_Sharpness", i == 0 ? sharpness : 0.0f);
+			for (int j = 0; j < int(group.size()); j++)
+			{
+				group[j]->SetUniforms(shader, _GetPrefix(j));
+			}
+			inputBuffer->BindColorAsTexture(0, 0);
+			Framebuffer::DrawFullscreenQuad();
+			inputBuffer->UnbindTexture(0);
+			Shader::UnBind();
+		});
+
+		source = target;
+		_passCount++;
+	}
+}
+
+int PostProcessChain::_AddLowResPasses(FrameGraph& graph, PostEffect* effect, const std::string& name, FrameGraphResource input,
+	FrameGraphResource source, FrameGraphResource target, unsigned width, unsigned height, std::vector<FrameGraphResource>& depthLevels)
+{
+	//Each level of the chains halves the resolution, so only 2 and 4 are supported
+	const int levels = effect->GetResolutionDivisor() >= 4 ? 2 : 1;
+	const unsigned lowWidth = DivideSize(width, 1u << levels);
+	const unsigned lowHeight = DivideSize(height, 1u << levels);
+	int passCount = 0;
+
+	//The scene may have been rendered into only part of the input, its depth hasn't been scaled up like its color
+	const glm::vec2 inputUsed = glm::vec2(_inputWidth == 0 ? width : glm::min(_inputWidth, width),
+		_inputHeight == 0 ? height : glm::min(_inputHeight, height));
+	const float nearPlane = _nearPlane;
+	const float farPlane = _farPlane;
+
+	//Halve the depth until we reach the effect's resolution, keeping the nearest and furthest depth under each pixel
+	//*The depth doesn't change between effects, so every low resolution effect in the frame shares these levels
+	Shader::sptr depthShader = _GetShader("shaders/Post/depth_downsample_frag.glsl");
+	while (int(depthLevels.size()) < levels)
+	{
+		const unsigned divisor = 2u << depthLevels.size();
+		const bool fromInput = depthLevels.empty();
+		const FrameGraphResource previous = fromInput ? input : depthLevels.back();
+		const std::string levelName = "Post Depth /" + std::to_string(divisor);
+		const FrameGraphResource next = graph.CreateTarget(levelName, RenderTargetDesc(DivideSize(width, divisor), DivideSize(height, divisor), GL_RG16F));
+
+		graph.AddPass(levelName, [=](FrameGraph::PassBuilder& builder) {
+			builder.Read(previous, fromInput);
+			builder.Write(next);
+		}, [=](FrameGraph& frame) {
+			Framebuffer* previousBuffer = frame.GetTarget(previous);
+			const glm::vec2 textureSize = glm::vec2(previousBuffer->_width, previousBuffer->_height);
+			const glm::vec2 usedSize = fromInput ? inputUsed :
+				glm::vec2(previousBuffer->GetViewportWidth(), previousBuffer->GetViewportHeight());
+
+			depthShader->Bind();
+			depthShader->SetUniform("u_UvScale", usedSize / textureSize);
+			depthShader->SetUniform("u_FromDepthBuffer", fromInput ? 1 : 0);
+			depthShader->SetUniform("u_NearPlane", nearPlane);
+			depthShader->SetUniform("u_FarPlane", farPlane);
+			if (fromInput)
+				previousBuffer->BindDepthAsTexture(0);
+			else
+				previousBuffer->BindColorAsTexture(0, 0);
+			Framebuffer::DrawFullscreenQuad();
+			previousBuffer->UnbindTexture(0);
+			Shader::UnBind();
+		});
+
+		depthLevels.push_back(next);
+		passCount++;
+	}
+
+	//Halve the color the same way, averaging each 2x2 block
+	Shader::sptr colorShader = _GetShader("shaders/Post/color_downsample_frag.glsl");
+	FrameGraphResource color = source;
+	for (int level = 0; level < levels; level++)
+	{
+		const unsigned divisor = 2u << level;
+		const FrameGraphResource previous = color;
+		const FrameGraphResource next = graph.CreateTarget(name + " Color /" + std::to_string(divisor),
+			RenderTargetDesc(DivideSize(width, divisor), DivideSize(height, divisor), GL_R11F_G11F_B10F));
+
+		graph.AddPass(name + " Downsample /" + std::to_string(divisor), [=](FrameGraph::PassBuilder& builder) {
+			builder.Read(previous);
+			builder.Write(next);
+		}, [=](FrameGraph& frame) {
+			Framebuffer* previousBuffer = frame.GetTarget(previous);
+			colorShader->Bind();
+			colorShader->SetUniform("u_UvScale", previousBuffer->GetUvScale());
+			previousBuffer->BindColorAsTexture(0, 0);
+			Framebuffer::DrawFullscreenQuad();
+			previousBuffer->UnbindTexture(0);
+			Shader::UnBind();
+		});
+
+		color = next;
+		passCount++;
+	}
+
+	//Run the effect itself, at a fraction of the cost
+	const FrameGraphResource depth = depthLevels[levels - 1];
+	const FrameGraphResource layer = graph.CreateTarget(name + " Layer", RenderTargetDesc(lowWidth, lowHeight, GL_RGBA16F));
+	graph.AddPass(name, [=](FrameGraph::PassBuilder& builder) {
+		builder.Read(color);
+		builder.Read(depth);
+		builder.Write(layer);
+	}, [=](FrameGraph& frame) {
+		Framebuffer* depthBuffer = frame.GetTarget(depth);
+		depthBuffer->BindColorAsTexture(0, PostEffect::LOW_RES_DEPTH_SLOT);
+		effect->Draw(frame.GetTarget(color));
+		depthBuffer->UnbindTexture(PostEffect::LOW_RES_DEPTH_SLOT);
+	});
+	passCount++;
+
+	//Scale the layer back up, only blending in low resolution pixels that are at about the same depth as the full
+	//*resolution pixel, so the layer doesn't bleed across the edges of objects
+	Shader::sptr upsampleShader = _GetShader("shaders/Post/bilateral_upsample_frag.glsl");
+	const float depthSharpness = DepthSharpness;
+	graph.AddPass(name + " Upsample", [=](FrameGraph::PassBuilder& builder) {
+		builder.Read(source);
+		builder.Read(layer);
+		builder.Read(depth);
+		builder.Read(input, true);
+		builder.Write(target);
+	}, [=](FrameGraph& frame) {
+		Framebuffer* sourceBuffer = frame.GetTarget(source);
+		Framebuffer* layerBuffer = frame.GetTarget(layer);
+		Framebuffer* depthBuffer = frame.GetTarget(depth);
+		Framebuffer* inputBuffer = frame.GetTarget(input);
+
+		upsampleShader->Bind();
+		upsampleShader->SetUniform("u_UvScale", sourceBuffer->GetUvScale());
+		upsampleShader->SetUniform("u_LayerSize", glm::vec2(layerBuffer->GetViewportWidth(), layerBuffer->GetViewportHeight()));
+		upsampleShader->SetUniform("u_DepthUvScale", inputUsed / glm::vec2(inputBuffer->_width, inputBuffer->_height));
+		upsampleShader->SetUniform("u_NearPlane", nearPlane);
+		upsampleShader->SetUniform("u_FarPlane", farPlane);
+		upsampleShader->SetUniform("u_DepthSharpness", depthSharpness);
+		sourceBuffer->BindColorAsTexture(0, 0);
+		layerBuffer->BindColorAsTexture(0, 1);
+		depthBuffer->BindColorAsTexture(0, 2);
+		inputBuffer->BindDepthAsTexture(3);
+		Framebuffer::DrawFullscreenQuad();
+		for (int slot = 0; slot < 4; slot++)
+		{
+			sourceBuffer->UnbindTexture(slot);
+		}
+		Shader::UnBind();
+	});
+	passCount++;
+
+	return passCount;
+}
+
+void PostProcessChain::ClearCache()
+{
+	_shaderCache.clear();
+	_snippetCache.clear();
+}
+
+Shader::sptr PostProcessChain::_GetFusedShader(const std::vector<PostEffect*>& effects)
+{
+	std::string key;
+	for (PostEffect* effect : effects)
+	{
+		key += effect->GetFusedSnippetPath();
+		key += ";";
+	}
+
+	auto it = _shaderCache.find(key);
+	if (it != _shaderCache.end())
+	{
+		return it->second;
+	}
+
+	//Generate a fragment shader that samples the screen once, and runs every effect's function on the result
+	std::stringstream source;
+	source << "#version 420\n\n";
+	source << "layout(location = 0) in vec2 inUV;\n\n";
+	source << "out vec4 frag_color;\n\n";
+	source << "layout (binding = 0) uniform sampler2D s_screenTex;\n\n";
+	source << SAMPLE_SOURCE_GLSL;
+	for (int i = 0; i < int(effects.size()); i++)
+	{
+		const std::string path = effects[i]->GetFusedSnippetPath();
+		auto snippet = _snippetCache.find(path);
+		if (snippet == _snippetCache.end())
+		{
+			std::ifstream file(path);
+			if (!file.is_open())
+			{
+				LOG_ERROR("File not found: {}", path);
+				throw std::runtime_error("File not found, see logs for more information");
+			}
+			std::stringstream stream;
+			stream << file.rdbuf();
+			snippet = _snippetCache.emplace(path, stream.str()).first;
+		}
+
+		//Give every effect its own names, so two effects can both have an intensity (or be the same effect twice)
+		std::string body = snippet->second;
+		const std::string prefix = _GetPrefix(i);
+		for (size_t pos = body.find('$'); pos != std::string::npos; pos = body.find('$', pos + prefix.length()))
+		{
+			body.replace(pos, 1, prefix);
+		}
+		source << "// ---- " << path << " ----\n" << body << "\n\n";
+	}
+	source << "void main()\n{\n";
+	source << "\tvec4 color = SampleSource(inUV);\n";
+	for (int i = 0; i < int(effects.size()); i++)
+	{
+		source << "\tcolor = " << _GetPrefix(i) << "Apply(color);\n";
+	}
+	source << "\tfrag_color = color;\n}\n";
+
+	Shader::sptr shader = Shader::Create();
+	shader->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
+	shader->LoadShaderPart(source.str().c_str(), GL_FRAGMENT_SHADER);
+	shader->Link();
+
+	LOG_INFO("Generated post processing shader for {} fused effects", effects.size());
+	_shaderCache[key] = shader;
+	return shader;
+}
+
+Shader::sptr PostProcessChain::_GetShader(const std::string& fragmentPath)
+{
+	//Fused shaders are keyed by lists of snippets that each end in a ';', so a plain path can't collide with them
+	auto it = _shaderCache.find(fragmentPath);
+	if (it != _shaderCache.end())
+	{
+		return it->second;
+	}
+
+	Shader::sptr shader = Shader::Create();
+	shader->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
+	shader->LoadShaderPartFromFile(fragmentPath.c_str(), GL_FRAGMENT_SHADER);
+	shader->Link();
+	_shaderCache[fragmentPath] = shader;
+	return shader;
+}
+
+std::string PostProcessChain::_GetPrefix(int index)
+{
+	return "u_Fx" + std::to_string(index) + "_";
+}
\ No newline at end of file
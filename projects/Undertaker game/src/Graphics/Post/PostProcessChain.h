@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "Graphics/FrameGraph.h"
+#include "Graphics/Post/PostEffect.h"
+
+//Runs a list of post effects as frame graph passes
+//*Runs of consecutive fusable effects are drawn in a single pass, using a shader generated from their snippets
+//*Generated shaders are cached by the list of snippets they were made from, so toggling effects only builds a
+//*shader the first time a combination is seen
+//*Effects with a resolution divisor run on downsampled color and min/max depth chains, and their result is scaled
+//*back up with a joint bilateral filter (see PostEffect::GetResolutionDivisor)
+class PostProcessChain
+{
+public:
+	//Adds an effect to the end of the chain (the chain does not own the effect)
+	void AddEffect(PostEffect* effect);
+
+	//Adds the passes needed to run every enabled effect from input to output
+	//*input must be a render target, output may be the back buffer
+	//*If any effects run at a lower resolution, input's depth must be sampleable
+	void AddPasses(FrameGraph& graph, FrameGraphResource input, FrameGraphResource output, unsigned width, unsigned height);
+
+	//Gets the number of passes the chain used the last time it was added to a graph
+	int GetPassCount() const { return _passCount; }
+
+	//Sets the part of the input that holds the image (from the bottom left), for when the scene was rendered at a
+	//*lower resolution than the target. The first pass scales it up to fill the output
+	void SetInputRect(unsigned width, unsigned height);
+
+	//Sets the camera's clipping planes, so the input's depth can be made linear for low resolution effects
+	void SetDepthPlanes(float nearPlane, float farPlane);
+
+	//How much to sharpen the input by when it is being scaled up (0 for none)
+	float Sharpness = 0.5f;
+	//How quickly low resolution pixels stop counting towards a full resolution one as their depths differ, relative
+	//*to the pixel's depth. Higher keeps edges sharper, but lets more of the low resolution blockiness through
+	float DepthSharpness = 20.0f;
+
+	//Releases all the generated shaders, should be called before the OpenGL context is destroyed
+	static void ClearCache();
+
+private:
+	std::vector<PostEffect*> _effects;
+	int _passCount = 0;
+	unsigned _inputWidth = 0;
+	unsigned _inputHeight = 0;
+	float _nearPlane = 0.1f;
+	float _farPlane = 1000.0f;
+
+	//Generated shaders, keyed by the snippet paths they were made from
+	static std::unordered_map<std::string, Shader::sptr> _shaderCache;
+	//Snippet sources, keyed by path
+	static std::unordered_map<std::string, std::string> _snippetCache;
+
+	//Gets (or generates) the shader that runs all the given effects in order
+	static Shader::sptr _GetFusedShader(const std::vector<PostEffect*>& effects);
+	//Gets (or loads) one of the chain's own fullscreen shaders
+	static Shader::sptr _GetShader(const std::string& fragmentPath);
+	//Adds the passes to run a low resolution effect on source, and scale its layer up into target
+	//*depthLevels holds the min/max depth chain, shared between every low resolution effect in the frame
+	int _AddLowResPasses(FrameGraph& graph, PostEffect* effect, const std::string& name, FrameGraphResource input,
+		FrameGraphResource source, FrameGraphResource target, unsigned width, unsigned height, std::vector<FrameGraphResource>& depthLevels);
+	//Gets the uniform prefix for an effect in a fused shader
+	static std::string _GetPrefix(int index);
+};
\ No newline at end of file
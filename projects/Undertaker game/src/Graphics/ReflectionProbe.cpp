@@ -0,0 +1,249 @@
+#include "ReflectionProbe.h"
+
+#include <cfloat>
+#include <vector>
+#include <imgui.h>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "Logging.h"
+#include "Gameplay/RendererComponent.h"
+#include "Gameplay/Transform.h"
+#include "Utilities/Frustum.h"
+
+// Must match the local size in probe_prefilter_comp.glsl
+static constexpr int PROBE_FILTER_GROUP_SIZE = 8;
+// The number of GGX samples per texel, probes are small and blurry so we can get away with fewer than offline filtering
+static constexpr int PROBE_FILTER_SAMPLES = 32;
+
+// The direction and up vector for each face, in CubeMapFace order
+static const glm::vec3 FACE_DIRECTIONS[6] = {
+	glm::vec3( 1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+	glm::vec3( 0.0f, 1.0f, 0.0f), glm::vec3( 0.0f,-1.0f, 0.0f),
+	glm::vec3( 0.0f, 0.0f, 1.0f), glm::vec3( 0.0f, 0.0f,-1.0f)
+};
+static const glm::vec3 FACE_UPS[6] = {
+	glm::vec3(0.0f,-1.0f, 0.0f), glm::vec3(0.0f,-1.0f, 0.0f),
+	glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f,-1.0f),
+	glm::vec3(0.0f,-1.0f, 0.0f), glm::vec3(0.0f,-1.0f, 0.0f)
+};
+
+ReflectionProbeSystem::ReflectionProbeSystem() {
+	_filteredLevels = 1;
+	while ((PROBE_SIZE >> _filteredLevels) >= MIN_LEVEL_SIZE) {
+		_filteredLevels++;
+	}
+
+	// Every probe face is the same size, so they can all share one framebuffer and depth buffer
+	glCreateFramebuffers(1, &_framebuffer);
+	glCreateRenderbuffers(1, &_depth);
+	glNamedRenderbufferStorage(_depth, GL_DEPTH_COMPONENT24, PROBE_SIZE, PROBE_SIZE);
+	glNamedFramebufferRenderbuffer(_framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depth);
+
+	_captureShader = Shader::Create();
+	_captureShader->LoadShaderPartFromFiles({ "shaders/vertex_shader.glsl", "shaders/irradiance_volume.glsl" }, GL_VERTEX_SHADER);
+	_captureShader->LoadShaderPartFromFile("shaders/frag_probe_capture.glsl", GL_FRAGMENT_SHADER);
+	_captureShader->Link();
+
+	_filterShader = Shader::Create();
+	_filterShader->LoadShaderPartFromFile("shaders/probe_prefilter_comp.glsl", GL_COMPUTE_SHADER);
+	_filterShader->Link();
+}
+
+ReflectionProbeSystem::~ReflectionProbeSystem() {
+	glDeleteFramebuffers(1, &_framebuffer);
+	glDeleteRenderbuffers(1, &_depth);
+}
+
+void ReflectionProbeSystem::_InitProbe(ReflectionProbe& probe) {
+	TextureCubeDesc desc;
+	desc.Size = PROBE_SIZE;
+	desc.Format = InternalFormat::R11G11B10F;
+	desc.MinificationFilter = MinFilter::LinearMipLinear;
+
+	// The capture keeps a full mip chain, so filtering can read blurrier mips for wide samples
+	desc.GenerateMipMaps = true;
+	probe.Capture = TextureCubeMap::Create(desc);
+	probe.Capture->SetDebugName("Probe Capture");
+
+	desc.GenerateMipMaps = false;
+	desc.MipLevels = _filteredLevels;
+	for (int ix = 0; ix < 2; ix++) {
+		probe.Filtered[ix] = TextureCubeMap::Create(desc);
+		probe.Filtered[ix]->SetDebugName("Probe Filtered");
+	}
+}
+
+void ReflectionProbeSystem::Update(entt::registry& registry) {
+	auto probes = registry.view<ReflectionProbe, Transform>();
+	std::vector<entt::entity> entities;
+	for (entt::entity entity : probes) {
+		entities.push_back(entity);
+	}
+	if (entities.empty()) {
+		return;
+	}
+
+	for (int step = 0; step < StepsPerFrame; step++) {
+		if (_currentProbe >= entities.size()) {
+			_currentProbe = 0;
+		}
+		entt::entity entity = entities[_currentProbe];
+		ReflectionProbe& probe = probes.get<ReflectionProbe>(entity);
+		const Transform& transform = probes.get<Transform>(entity);
+		if (probe.Capture == nullptr) {
+			_InitProbe(probe);
+		}
+
+		if (probe.CurrentState == ReflectionProbe::State::Capturing) {
+			_CaptureFace(registry, probe, transform.GetLocalPosition(), probe.NextStep);
+			_facesCaptured++;
+			if (++probe.NextStep == 6) {
+				// Filtering needs the capture's mips to pick from
+				glGenerateTextureMipmap(probe.Capture->GetHandle());
+				probe.CurrentState = ReflectionProbe::State::Filtering;
+				probe.NextStep = 0;
+			}
+		} else {
+			_FilterLevel(probe, probe.NextStep);
+			_levelsFiltered++;
+			if (++probe.NextStep == _filteredLevels) {
+				// Every level is done, so shaders can start using it, and we can move on to the next probe
+				probe.Front = 1 - probe.Front;
+				probe.IsReady = true;
+				probe.CurrentState = ReflectionProbe::State::Capturing;
+				probe.NextStep = 0;
+				_currentProbe++;
+			}
+		}
+	}
+}
+
+void ReflectionProbeSystem::_CaptureFace(entt::registry& registry, ReflectionProbe& probe, const glm::vec3& position, int face) {
+	glNamedFramebufferTextureLayer(_framebuffer, GL_COLOR_ATTACHMENT0, probe.Capture->GetHandle(), 0, face);
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+	glViewport(0, 0, PROBE_SIZE, PROBE_SIZE);
+	const float clearColor[4] = { 0.08f, 0.17f, 0.31f, 1.0f };
+	const float clearDepth = 1.0f;
+	glClearNamedFramebufferfv(_framebuffer, GL_COLOR, 0, clearColor);
+	glClearNamedFramebufferfv(_framebuffer, GL_DEPTH, 0, &clearDepth);
+	glEnable(GL_DEPTH_TEST);
+
+	const glm::mat4 view = glm::lookAt(position, position + FACE_DIRECTIONS[face], FACE_UPS[face]);
+	const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, probe.NearPlane, probe.FarPlane);
+	const glm::mat4 viewProjection = projection * view;
+	const Frustum frustum(viewProjection);
+	// How many pixels of the face a unit covers at a distance of one unit
+	const float pixelsPerUnit = 0.5f * PROBE_SIZE * projection[1][1];
+
+	_captureShader->Bind();
+	registry.view<RendererComponent, Transform>().each([&](entt::entity, RendererComponent& renderer, Transform& transform) {
+		// Only static objects are in the probe's version of the scene, anything that moves would be out of date
+		// before the probe got back around to this face anyways
+		if (!renderer.IsStatic || renderer.Mesh == nullptr || renderer.Material == nullptr) {
+			return;
+		}
+
+		const glm::mat4& model = transform.LocalTransform();
+		glm::vec3 center;
+		const float radius = Frustum::BoundingSphere(renderer.Mesh->GetBoundsMin(), renderer.Mesh->GetBoundsMax(), model, center);
+		if (!frustum.TestSphere(center, radius)) {
+			return;
+		}
+		// Skip anything too small to make out in a low resolution reflection
+		const float distance = glm::max(glm::distance(center, position) - radius, 0.1f);
+		if (radius * pixelsPerUnit / distance < MinPixelSize) {
+			return;
+		}
+
+		auto diffuse = renderer.Material->Textures.find(ShaderParamName("s_Diffuse"));
+		if (diffuse != renderer.Material->Textures.end() && diffuse->second != nullptr) {
+			diffuse->second->Bind(0);
+		} else {
+			ITexture::Unbind(0);
+		}
+
+		_captureShader->SetUniformMatrix("u_ModelViewProjection", viewProjection * model);
+		_captureShader->SetUniformMatrix("u_Model", model);
+		_captureShader->SetUniformMatrix("u_NormalMatrix", transform.NormalMatrix());
+		renderer.Mesh->Render();
+	});
+	Shader::UnBind();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ReflectionProbeSystem::_FilterLevel(ReflectionProbe& probe, int level) {
+	const TextureCubeMap::sptr& target = probe.Filtered[1 - probe.Front];
+	const uint32_t size = glm::max(PROBE_SIZE >> level, 1u);
+	const float roughness = _filteredLevels > 1 ? (float)level / (_filteredLevels - 1) : 0.0f;
+
+	probe.Capture->Bind(0);
+	glBindImageTexture(0, target->GetHandle(), level, GL_TRUE, 0, GL_WRITE_ONLY, GL_R11F_G11F_B10F);
+	_filterShader->SetUniform("u_Roughness", roughness);
+	_filterShader->SetUniform("u_OutputSize", (int)size);
+	_filterShader->SetUniform("u_SourceSize", (float)PROBE_SIZE);
+	_filterShader->SetUniform("u_SampleCount", PROBE_FILTER_SAMPLES);
+
+	const GLuint groups = (size + PROBE_FILTER_GROUP_SIZE - 1) / PROBE_FILTER_GROUP_SIZE;
+	_filterShader->Dispatch(groups, groups, 6);
+	// The scene samples the result as a texture
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	glBindImageTexture(0, 0, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R11F_G11F_B10F);
+	Shader::UnBind();
+	ITexture::Unbind(0);
+}
+
+void ReflectionProbeSystem::BindNearest(entt::registry& registry, const Shader::sptr& shader, const glm::vec3& position) const {
+	// Find the two closest probes that have something to show
+	const ReflectionProbe* nearest[2] = { nullptr, nullptr };
+	float distances[2] = { FLT_MAX, FLT_MAX };
+	registry.view<ReflectionProbe, Transform>().each([&](entt::entity, ReflectionProbe& probe, Transform& transform) {
+		if (!probe.IsReady) {
+			return;
+		}
+		const float distance = glm::distance(transform.GetLocalPosition(), position);
+		if (distance < distances[0]) {
+			nearest[1] = nearest[0];
+			distances[1] = distances[0];
+			nearest[0] = &probe;
+			distances[0] = distance;
+		} else if (distance < distances[1]) {
+			nearest[1] = &probe;
+			distances[1] = distance;
+		}
+	});
+
+	if (nearest[0] == nullptr) {
+		shader->SetUniform("u_ProbeWeight", 0.0f);
+		return;
+	}
+	if (nearest[1] == nullptr) {
+		nearest[1] = nearest[0];
+		distances[1] = distances[0];
+	}
+
+	nearest[0]->Filtered[nearest[0]->Front]->Bind(PROBE_SLOT_A);
+	nearest[1]->Filtered[nearest[1]->Front]->Bind(PROBE_SLOT_B);
+	// Weight each probe by how close it is compared to the other, so we fade smoothly as we move between them
+	const float total = distances[0] + distances[1];
+	shader->SetUniform("u_ProbeBlend", total > 0.0f ? distances[0] / total : 0.0f);
+	shader->SetUniform("u_ProbeWeight", 1.0f);
+}
+
+void ReflectionProbeSystem::SetUniforms(const Shader::sptr& shader) const {
+	shader->SetUniform("s_ProbeA", PROBE_SLOT_A);
+	shader->SetUniform("s_ProbeB", PROBE_SLOT_B);
+	shader->SetUniform("u_ProbeMaxLod", (float)(_filteredLevels - 1));
+	shader->SetUniform("u_ProbeWeight", 0.0f);
+}
+
+void ReflectionProbeSystem::RenderImGui(entt::registry& registry) {
+	int count = 0, ready = 0;
+	registry.view<ReflectionProbe>().each([&](ReflectionProbe& probe) {
+		count++;
+		ready += probe.IsReady ? 1 : 0;
+	});
+	ImGui::SliderInt("Steps Per Frame", &StepsPerFrame, 0, 12);
+	ImGui::SliderFloat("Min Pixel Size", &MinPixelSize, 0.0f, 8.0f);
+	ImGui::Text("Probes: %d (%d ready)", count, ready);
+	ImGui::Text("Faces captured: %u, levels filtered: %u", _facesCaptured, _levelsFiltered);
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <entt.hpp>
+#include <GLM/glm.hpp>
+
+#include "TextureCubeMap.h"
+#include "Shader.h"
+
+/// <summary>
+/// A point in the scene that captures its surroundings into a cubemap for reflective materials to sample. Probes
+/// are updated by a ReflectionProbeSystem, a few faces at a time
+/// </summary>
+struct ReflectionProbe
+{
+	/// <summary>
+	/// The near and far planes to capture with
+	/// </summary>
+	float NearPlane = 0.1f;
+	float FarPlane = 100.0f;
+
+	/// <summary>
+	/// The state of the probe's capture, managed by the ReflectionProbeSystem
+	/// </summary>
+	enum class State
+	{
+		Capturing,
+		Filtering
+	};
+
+	// The cubemap faces are rendered into, with a full mip chain for filtering from
+	TextureCubeMap::sptr Capture;
+	// The prefiltered results, we filter into one while shaders sample the other
+	TextureCubeMap::sptr Filtered[2];
+	int   Front = 0;
+	State CurrentState = State::Capturing;
+	// The next face to capture, or the next level to filter
+	int   NextStep = 0;
+	// Only true once the probe has been captured and filtered at least once
+	bool  IsReady = false;
+};
+
+/// <summary>
+/// Keeps reflection probes up to date without a spike in frame time. Rather than re-rendering all six faces of
+/// every probe every frame (six extra scene passes per probe), each frame does a fixed amount of work on one probe at
+/// a time, in round robin: rendering the next face, or prefiltering the next mip level once all six are done. The
+/// filtered result only replaces the one shaders sample once every level is done, so reflections never show a half
+/// updated probe.
+///
+/// Faces are drawn with a cheap capture shader, and only static renderers that would cover a couple of pixels of the
+/// probe are drawn, since reflections are rarely looked at closely.
+/// </summary>
+class ReflectionProbeSystem final
+{
+public:
+	/// <summary>
+	/// The size of each probe face
+	/// </summary>
+	static constexpr uint32_t PROBE_SIZE = 64;
+	/// <summary>
+	/// The smallest mip we filter, which holds the roughest reflections
+	/// </summary>
+	static constexpr uint32_t MIN_LEVEL_SIZE = 4;
+	/// <summary>
+	/// The texture slots that the two nearest probes are bound to
+	/// </summary>
+	static constexpr int PROBE_SLOT_A = 14;
+	static constexpr int PROBE_SLOT_B = 15;
+
+	/// <summary>
+	/// The number of faces (or filter levels) to update each frame
+	/// </summary>
+	int StepsPerFrame = 1;
+	/// <summary>
+	/// Renderers that would cover fewer pixels than this in a probe face are skipped
+	/// </summary>
+	float MinPixelSize = 2.0f;
+
+	ReflectionProbeSystem();
+	~ReflectionProbeSystem();
+
+	ReflectionProbeSystem(const ReflectionProbeSystem& other) = delete;
+	ReflectionProbeSystem& operator=(const ReflectionProbeSystem& other) = delete;
+
+	/// <summary>
+	/// Does this frame's slice of probe updates. Changes the bound framebuffer, shader, and viewport
+	/// </summary>
+	/// <param name="registry">The registry holding the probes and the renderers to capture</param>
+	void Update(entt::registry& registry);
+
+	/// <summary>
+	/// Binds the two ready probes closest to a position, and sets how to blend between them
+	/// </summary>
+	/// <param name="registry">The registry holding the probes</param>
+	/// <param name="shader">The shader to set the blend uniforms on</param>
+	/// <param name="position">The world position of the object being drawn</param>
+	void BindNearest(entt::registry& registry, const Shader::sptr& shader, const glm::vec3& position) const;
+
+	/// <summary>
+	/// Sets the uniforms that don't change between objects (sampler slots and max LOD), should be called once for
+	/// each shader that samples probes
+	/// </summary>
+	void SetUniforms(const Shader::sptr& shader) const;
+
+	/// <summary>
+	/// Draws the probe settings using ImGui, should be called inside of an ImGui window
+	/// </summary>
+	void RenderImGui(entt::registry& registry);
+
+private:
+	GLuint       _framebuffer = 0;
+	GLuint       _depth = 0;
+	Shader::sptr _captureShader;
+	Shader::sptr _filterShader;
+	int          _filteredLevels;
+	// The probe we are currently working on, probes are visited in the order of the registry's view
+	size_t       _currentProbe = 0;
+	uint32_t     _facesCaptured = 0;
+	uint32_t     _levelsFiltered = 0;
+
+	void _InitProbe(ReflectionProbe& probe);
+	void _CaptureFace(entt::registry& registry, ReflectionProbe& probe, const glm::vec3& position, int face);
+	void _FilterLevel(ReflectionProbe& probe, int level);
+};
@@ -0,0 +1,71 @@
+#include "RenderTargetPool.h"
+
+#include <algorithm>
+#include "Logging.h"
+
+Framebuffer* RenderTargetPool::Acquire(const RenderTargetDesc& desc) {
+	LOG_ASSERT(desc.Width > 0 && desc.Height > 0, "Render targets must have a non-zero size");
+
+	_activeCount++;
+	_peakActiveCount = std::max(_peakActiveCount, _activeCount);
+
+	// Storage is matched by size class, so nearby sizes share targets
+	RenderTargetDesc allocDesc = desc;
+	allocDesc.Width = Framebuffer::RoundToSizeClass(desc.Width);
+	allocDesc.Height = Framebuffer::RoundToSizeClass(desc.Height);
+
+	// Prefer handing back memory that a previous pass has finished with
+	for (PooledTarget& pooled : _targets) {
+		if (!pooled.InUse && pooled.Desc == allocDesc) {
+			pooled.InUse = true;
+			pooled.LastUsedFrame = _frame;
+			pooled.Target->SetViewportSize(desc.Width, desc.Height);
+			return pooled.Target.get();
+		}
+	}
+
+	PooledTarget pooled;
+	pooled.Desc = allocDesc;
+	pooled.Target = std::make_unique<Framebuffer>();
+	pooled.Target->AddColorTarget(desc.Format);
+	if (desc.Depth) {
+		pooled.Target->AddDepthTarget(desc.SampleDepth);
+	}
+	pooled.Target->Init(allocDesc.Width, allocDesc.Height);
+	pooled.Target->SetViewportSize(desc.Width, desc.Height);
+	pooled.InUse = true;
+	pooled.LastUsedFrame = _frame;
+	_targets.push_back(std::move(pooled));
+
+	LOG_INFO("Allocated pooled render target {}x{} (format 0x{:x}, depth: {}), {} targets total", allocDesc.Width, allocDesc.Height, desc.Format, desc.Depth, _targets.size());
+	return _targets.back().Target.get();
+}
+
+void RenderTargetPool::Release(Framebuffer* target) {
+	if (target == nullptr) {
+		return;
+	}
+	for (PooledTarget& pooled : _targets) {
+		if (pooled.Target.get() == target) {
+			LOG_ASSERT(pooled.InUse, "Render target was released twice");
+			pooled.InUse = false;
+			pooled.LastUsedFrame = _frame;
+			_activeCount--;
+			return;
+		}
+	}
+	LOG_WARN("Tried to release a render target that does not belong to the pool");
+}
+
+void RenderTargetPool::EndFrame() {
+	_frame++;
+	_targets.erase(std::remove_if(_targets.begin(), _targets.end(), [&](const PooledTarget& pooled) {
+		return !pooled.InUse && _frame - pooled.LastUsedFrame > KeepFrames;
+	}), _targets.end());
+}
+
+void RenderTargetPool::Clear() {
+	LOG_ASSERT(_activeCount == 0, "Clearing the render target pool while {} targets are still in use", _activeCount);
+	_targets.clear();
+	_activeCount = 0;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+
+#include "Framebuffer.h"
+
+/// <summary>
+/// Describes a transient render target that a pass wants to draw into
+/// </summary>
+struct RenderTargetDesc
+{
+	unsigned Width;
+	unsigned Height;
+	GLenum   Format;
+	// Only passes that depth test (like the main scene pass) need a depth attachment
+	bool     Depth;
+	// Depth is kept in a renderbuffer unless a later pass needs to read it as a texture
+	bool     SampleDepth;
+
+	RenderTargetDesc() : Width(0), Height(0), Format(GL_RGBA8), Depth(false), SampleDepth(false) { }
+	RenderTargetDesc(unsigned width, unsigned height, GLenum format = GL_RGBA8, bool depth = false, bool sampleDepth = false) :
+		Width(width), Height(height), Format(format), Depth(depth), SampleDepth(sampleDepth) { }
+
+	bool operator ==(const RenderTargetDesc& other) const {
+		return Width == other.Width && Height == other.Height && Format == other.Format && Depth == other.Depth &&
+			SampleDepth == other.SampleDepth;
+	}
+};
+
+/// <summary>
+/// Hands out framebuffers for passes that only need them for part of a frame. Passes acquire a target with a given
+/// size, format and usage, and release it once the next pass has consumed it. Released targets are handed to the next
+/// pass that asks for a matching description, so passes whose lifetimes don't overlap end up sharing the same memory,
+/// and a long post processing chain only ever needs a couple of full screen buffers. Targets are allocated in rounded
+/// size classes (see Framebuffer::RoundToSizeClass) and handed out with their viewport set to the requested size, so
+/// resizing the window by a few pixels reuses the same storage. Targets that go unused for a few frames (ex: after
+/// the window has been resized into a new size class) are freed.
+///
+/// Reuse is whole framebuffers only: a target is only handed back for a request with exactly the same rounded size,
+/// format and depth usage. Targets with different formats or size classes never share memory, even when their
+/// lifetimes don't overlap, since OpenGL has no way to place two textures in the same allocation
+/// </summary>
+class RenderTargetPool final
+{
+public:
+	static RenderTargetPool& Instance() {
+		static RenderTargetPool instance;
+		return instance;
+	}
+
+	/// <summary>
+	/// The number of frames a free target can go unused before it is destroyed
+	/// </summary>
+	uint32_t KeepFrames = 3;
+
+	/// <summary>
+	/// Gets a target matching the given description, creating one if none are free. The contents of the target are
+	/// undefined, the caller is expected to clear it or overwrite every pixel. The target may be larger than asked
+	/// for, its viewport will be the requested size and readers should scale their UVs by its GetUvScale
+	/// </summary>
+	/// <param name="desc">The size, format and usage of the target</param>
+	/// <returns>A framebuffer owned by the pool, valid until it is passed to Release</returns>
+	Framebuffer* Acquire(const RenderTargetDesc& desc);
+	/// <summary>
+	/// Returns a target to the pool, so that later passes may reuse its memory
+	/// </summary>
+	/// <param name="target">A target that was returned from Acquire</param>
+	void Release(Framebuffer* target);
+
+	/// <summary>
+	/// Frees targets that have not been used in a while, should be called once at the end of every frame
+	/// </summary>
+	void EndFrame();
+	/// <summary>
+	/// Destroys all the pooled targets, should be called before the OpenGL context is destroyed
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Gets the number of targets that the pool has allocated
+	/// </summary>
+	size_t GetTargetCount() const { return _targets.size(); }
+	/// <summary>
+	/// Gets the number of targets that are currently acquired
+	/// </summary>
+	size_t GetActiveCount() const { return _activeCount; }
+	/// <summary>
+	/// Gets the highest number of targets that were acquired at once
+	/// </summary>
+	size_t GetPeakActiveCount() const { return _peakActiveCount; }
+
+private:
+	RenderTargetPool() = default;
+
+	struct PooledTarget
+	{
+		RenderTargetDesc             Desc;
+		std::unique_ptr<Framebuffer> Target;
+		bool                         InUse;
+		uint32_t                     LastUsedFrame;
+	};
+
+	std::vector<PooledTarget> _targets;
+	size_t   _activeCount = 0;
+	size_t   _peakActiveCount = 0;
+	uint32_t _frame = 0;
+};
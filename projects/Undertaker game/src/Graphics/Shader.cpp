@@ -2,10 +2,13 @@
 #include "Logging.h"
 #include <fstream>
 #include <sstream>
+#include <vector>
 
 Shader::Shader() :
 	_vs(0),
 	_fs(0),
+	_cs(0),
+	_isCompute(false),
 	_handle(0)
 {
 	_handle = glCreateProgram();
@@ -20,12 +23,17 @@ Shader::~Shader() {
 }
 
 bool Shader::LoadShaderPart(const char* source, GLenum type)
+{
+	return LoadShaderPart(&source, 1, type);
+}
+
+bool Shader::LoadShaderPart(const char* const* sources, int count, GLenum type)
 {
 	// Creates a new shader part (VS, FS, GS, etc...)
 	GLuint handle = glCreateShader(type);
 
-	// Load the GLSL source and compile it
-	glShaderSource(handle, 1, &source, nullptr);
+	// Load the GLSL source and compile it, GL joins the pieces together for us
+	glShaderSource(handle, count, sources, nullptr);
 	glCompileShader(handle);
 
 	// Get the compilation status for the shader part
@@ -57,6 +65,7 @@ bool Shader::LoadShaderPart(const char* source, GLenum type)
 	switch (type) {
 		case GL_VERTEX_SHADER: _vs = handle; break;
 		case GL_FRAGMENT_SHADER: _fs = handle; break;
+		case GL_COMPUTE_SHADER: _cs = handle; break;
 		default: LOG_WARN("Not implemented"); break;
 	}
 
@@ -64,34 +73,60 @@ bool Shader::LoadShaderPart(const char* source, GLenum type)
 }
 
 bool Shader::LoadShaderPartFromFile(const char* path, GLenum type) {
-	std::ifstream file(path);
-	if (!file.is_open()) {
-		LOG_ERROR("File not found: {}", path);
-		throw std::runtime_error("File not found, see logs for more information");
+	return LoadShaderPartFromFiles({ path }, type);
+}
+
+bool Shader::LoadShaderPartFromFiles(std::initializer_list<const char*> paths, GLenum type) {
+	std::vector<std::string> sources;
+	sources.reserve(paths.size());
+	for (const char* path : paths) {
+		std::ifstream file(path);
+		if (!file.is_open()) {
+			LOG_ERROR("File not found: {}", path);
+			throw std::runtime_error("File not found, see logs for more information");
+		}
+		std::stringstream stream;
+		stream << file.rdbuf();
+		// Make sure the next piece starts on a line of its own, in case this file doesn't end with a newline
+		sources.push_back(stream.str() + "\n");
+		file.close();
 	}
-	std::stringstream stream;
-	stream << file.rdbuf();
-	bool result = LoadShaderPart(stream.str().c_str(), type);
-	file.close();
-	return result;
+
+	std::vector<const char*> pointers;
+	pointers.reserve(sources.size());
+	for (const std::string& source : sources) {
+		pointers.push_back(source.c_str());
+	}
+	return LoadShaderPart(pointers.data(), (int)pointers.size(), type);
 }
 
 bool Shader::Link()
 {
-	LOG_ASSERT(_vs != 0 && _fs != 0, "Must attach both a vertex and fragment shader!");
-
-	// Attach our two shaders
-	glAttachShader(_handle, _vs);
-	glAttachShader(_handle, _fs);
-
-	// Perform linking
-	glLinkProgram(_handle);
-
-	// Remove shader parts to save space (we can do this since we only needed the shader parts to compile an actual shader program)
-	glDetachShader(_handle, _vs);
-	glDeleteShader(_vs);
-	glDetachShader(_handle, _fs);
-	glDeleteShader(_fs);
+	if (_cs != 0) {
+		// Compute shaders live in a program on their own
+		LOG_ASSERT(_vs == 0 && _fs == 0, "Compute shaders cannot be linked with other stages!");
+		glAttachShader(_handle, _cs);
+		glLinkProgram(_handle);
+		glDetachShader(_handle, _cs);
+		glDeleteShader(_cs);
+		_cs = 0;
+		_isCompute = true;
+	} else {
+		LOG_ASSERT(_vs != 0 && _fs != 0, "Must attach both a vertex and fragment shader!");
+
+		// Attach our two shaders
+		glAttachShader(_handle, _vs);
+		glAttachShader(_handle, _fs);
+
+		// Perform linking
+		glLinkProgram(_handle);
+
+		// Remove shader parts to save space (we can do this since we only needed the shader parts to compile an actual shader program)
+		glDetachShader(_handle, _vs);
+		glDeleteShader(_vs);
+		glDetachShader(_handle, _fs);
+		glDeleteShader(_fs);
+	}
 
 	GLint status = 0;
 	glGetProgramiv(_handle, GL_LINK_STATUS, &status);
@@ -124,6 +159,12 @@ void Shader::UnBind() {
 	glUseProgram(0);
 }
 
+void Shader::Dispatch(GLuint groupsX, GLuint groupsY, GLuint groupsZ) {
+	LOG_ASSERT(_isCompute, "Only compute shaders can be dispatched!");
+	glUseProgram(_handle);
+	glDispatchCompute(groupsX, groupsY, groupsZ);
+}
+
 void Shader::SetUniformMatrix(int location, const glm::mat3* value, int count, bool transposed) {
 	glProgramUniformMatrix3fv(_handle, location, count, transposed, glm::value_ptr(*value));
 }
@@ -3,6 +3,7 @@
 #include <memory>
 
 #include <string>               // for std::string
+#include <initializer_list>     // for std::initializer_list
 #include <unordered_map>        // for std::unordered_map
 #include <GLM/glm.hpp>          // for our GLM types
 #include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
@@ -40,19 +41,36 @@ public:
 	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader)
 	/// </summary>
 	/// <param name="source">The source code of the shader to load</param>
-	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
+	/// <param name="type">The stage to load (GL_VERTEX_SHADER, GL_FRAGMENT_SHADER or GL_COMPUTE_SHADER)</param>
 	/// <returns>True if the shader is loaded, false if there was an issue</returns>
 	bool LoadShaderPart(const char* source, GLenum type);
 	/// <summary>
+	/// Loads a single shader stage from several pieces of source, compiled as if they were one after another. Only the
+	/// first piece should have a #version, the rest are snippets shared between shaders
+	/// </summary>
+	/// <param name="sources">The pieces of source code, in order</param>
+	/// <param name="count">The number of pieces</param>
+	/// <param name="type">The stage to load (GL_VERTEX_SHADER, GL_FRAGMENT_SHADER or GL_COMPUTE_SHADER)</param>
+	/// <returns>True if the shader is loaded, false if there was an issue</returns>
+	bool LoadShaderPart(const char* const* sources, int count, GLenum type);
+	/// <summary>
 	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader) from an external file (in res)
 	/// </summary>
 	/// <param name="path">The relative path to the file containing the source</param>
-	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
+	/// <param name="type">The stage to load (GL_VERTEX_SHADER, GL_FRAGMENT_SHADER or GL_COMPUTE_SHADER)</param>
 	/// <returns>True if the shader is loaded, false if there was an issue</returns>
 	bool LoadShaderPartFromFile(const char* path, GLenum type);
+	/// <summary>
+	/// Loads a single shader stage from several files (in res), compiled as if they were one after another (ex: a shader
+	/// followed by a snippet of functions it shares with other shaders)
+	/// </summary>
+	/// <param name="paths">The relative paths to the files, the first one should have the #version</param>
+	/// <param name="type">The stage to load (GL_VERTEX_SHADER, GL_FRAGMENT_SHADER or GL_COMPUTE_SHADER)</param>
+	/// <returns>True if the shader is loaded, false if there was an issue</returns>
+	bool LoadShaderPartFromFiles(std::initializer_list<const char*> paths, GLenum type);
 
 	/// <summary>
-	/// Links the vertex and fragment shader, and allows this shader program to be used
+	/// Links the vertex and fragment shader (or the compute shader on its own), and allows this shader program to be used
 	/// </summary>
 	/// <returns>True if the linking was sucessful, false if otherwise</returns>
 	bool Link();
@@ -66,6 +84,16 @@ public:
 	/// </summary>
 	static void UnBind();
 
+	/// <summary>
+	/// Binds this compute shader and dispatches the given number of work groups. Callers are responsible for issuing
+	/// the glMemoryBarrier needed by whatever reads the results
+	/// </summary>
+	void Dispatch(GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1);
+	/// <summary>
+	/// Returns true if this shader was linked from a compute shader
+	/// </summary>
+	bool IsCompute() const { return _isCompute; }
+
 	/// <summary>
 	/// Gets the underlying OpenGL handle that this class is wrapping
 	/// </summary>
@@ -119,6 +147,8 @@ public:
 protected:
 	GLuint _vs;
 	GLuint _fs;
+	GLuint _cs;
+	bool   _isCompute;
 	
 	GLuint _handle;
 
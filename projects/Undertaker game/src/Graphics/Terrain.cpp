@@ -0,0 +1,258 @@
+#include "Terrain.h"
+
+#include <cfloat>
+#include <imgui.h>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "Logging.h"
+#include "IndexBuffer.h"
+#include "VertexBuffer.h"
+
+// How far a point is from the closest point of a box
+static float DistanceToBox(const glm::vec3& point, const glm::vec3& min, const glm::vec3& max) {
+	return glm::distance(point, glm::clamp(point, min, max));
+}
+
+Terrain::Terrain(const Settings& settings, const Heightmap::sptr& heightmap, const Texture2D::sptr& splatmap, const Texture2DArray::sptr& layers) :
+	_settings(settings), _heightmap(heightmap), _splatmap(splatmap), _layers(layers)
+{
+	LOG_ASSERT(_heightmap != nullptr, "Terrain needs a heightmap");
+	LOG_ASSERT(_settings.GridSize >= 2 && _settings.GridSize % 2 == 0, "Terrain grid size must be even, got {}", _settings.GridSize);
+	LOG_ASSERT(_settings.LodLevels >= 1, "Terrain needs at least one LOD level");
+	LOG_ASSERT(_layers == nullptr || _layers->GetLayerCount() <= MAX_LAYERS, "Terrain can only blend {} layers", MAX_LAYERS);
+
+	// Heights are filtered in the vertex shader, so keep all 16 bits and don't wrap around at the edges
+	Texture2DDescription desc;
+	desc.Width = _heightmap->GetWidth();
+	desc.Height = _heightmap->GetHeight();
+	desc.Format = InternalFormat::R16;
+	desc.HorizontalWrap = WrapMode::ClampToEdge;
+	desc.VerticalWrap = WrapMode::ClampToEdge;
+	desc.MinificationFilter = MinFilter::Linear;
+	desc.MagnificationFilter = MagFilter::Linear;
+	desc.GenerateMipMaps = false;
+	Texture2DData::sptr heights = std::make_shared<Texture2DData>(desc.Width, desc.Height, PixelFormat::Red, PixelType::UShort,
+		(void*)_heightmap->GetSamples().data(), InternalFormat::R16);
+	heights->DebugName = "Terrain Heightmap";
+	_heightTexture = Texture2D::Create(desc);
+	_heightTexture->LoadData(heights);
+
+	_BuildGrid();
+	_BuildRanges();
+	_BuildQuadtree();
+
+	const float leafSize = glm::length(glm::vec2(_settings.Size.x, _settings.Size.z)) / (float)(1u << (_settings.LodLevels - 1));
+	if (_settings.LodDistance < leafSize * 2.0f) {
+		LOG_WARN("Terrain LOD distance {} is too short for chunks {} across, there may be cracks between levels", _settings.LodDistance, leafSize);
+	}
+}
+
+glm::mat4 Terrain::GetTransform() const {
+	return glm::scale(glm::translate(glm::mat4(1.0f), _settings.Position), _settings.Size);
+}
+
+float Terrain::GetHeight(float x, float z) const {
+	const glm::vec2 uv = (glm::vec2(x, z) - glm::vec2(_settings.Position.x, _settings.Position.z)) / glm::vec2(_settings.Size.x, _settings.Size.z);
+	return _settings.Position.y + _heightmap->Sample(uv) * _settings.Size.y;
+}
+
+void Terrain::_BuildGrid() {
+	// Vertices are stored as whole numbers of quads, so the shader can tell exactly which ones are odd
+	const uint32_t size = _settings.GridSize;
+	const uint32_t half = size / 2;
+	std::vector<glm::vec2> vertices;
+	vertices.reserve((size_t)(size + 1) * (size + 1));
+	for (uint32_t y = 0; y <= size; y++) {
+		for (uint32_t x = 0; x <= size; x++) {
+			vertices.emplace_back((float)x, (float)y);
+		}
+	}
+
+	// Group the indices by quarter, so that a chunk whose children are only partly drawn can fill in the rest
+	std::vector<uint32_t> indices;
+	indices.reserve((size_t)size * size * 6);
+	for (uint32_t quarter = 0; quarter < 4; quarter++) {
+		const uint32_t startX = (quarter % 2) * half;
+		const uint32_t startY = (quarter / 2) * half;
+		_quarterRanges[quarter].x = (uint32_t)indices.size();
+		for (uint32_t y = startY; y < startY + half; y++) {
+			for (uint32_t x = startX; x < startX + half; x++) {
+				const uint32_t a = y * (size + 1) + x;
+				const uint32_t b = a + 1;
+				const uint32_t c = a + size + 1;
+				const uint32_t d = c + 1;
+				indices.insert(indices.end(), { a, c, b, b, c, d });
+			}
+		}
+		_quarterRanges[quarter].y = (uint32_t)indices.size() - _quarterRanges[quarter].x;
+	}
+
+	VertexBuffer::sptr vbo = VertexBuffer::Create();
+	vbo->LoadData(vertices.data(), vertices.size());
+	IndexBuffer::sptr ebo = IndexBuffer::Create();
+	ebo->LoadData(indices.data(), indices.size());
+	_grid = VertexArrayObject::Create();
+	_grid->AddVertexBuffer(vbo, { BufferAttribute(0, 2, GL_FLOAT, false, sizeof(glm::vec2), 0, AttribUsage::Position) });
+	_grid->SetIndexBuffer(ebo);
+	_grid->SetDebugName("Terrain Grid");
+}
+
+void Terrain::_BuildRanges() {
+	_lodRanges.resize(_settings.LodLevels);
+	_morphStarts.resize(_settings.LodLevels);
+	float previous = 0.0f;
+	for (uint32_t level = 0; level < _settings.LodLevels; level++) {
+		_lodRanges[level] = _settings.LodDistance * (float)(1u << level);
+		_morphStarts[level] = glm::mix(_lodRanges[level], previous, glm::clamp(_settings.MorphRegion, 0.01f, 1.0f));
+		previous = _lodRanges[level];
+	}
+}
+
+void Terrain::_BuildQuadtree() {
+	// Find the height range of the smallest chunks from the heightmap, and build the rest up from their children
+	_heightRanges.resize(_settings.LodLevels);
+	for (uint32_t level = 0; level < _settings.LodLevels; level++) {
+		const uint32_t count = 1u << (_settings.LodLevels - 1 - level);
+		std::vector<glm::vec2>& ranges = _heightRanges[level];
+		ranges.resize((size_t)count * count);
+		for (uint32_t y = 0; y < count; y++) {
+			for (uint32_t x = 0; x < count; x++) {
+				glm::vec2 range;
+				if (level == 0) {
+					const float size = 1.0f / count;
+					range = _heightmap->GetRange(glm::vec2(x, y) * size, glm::vec2(x + 1, y + 1) * size);
+					range = _settings.Position.y + range * _settings.Size.y;
+				} else {
+					const std::vector<glm::vec2>& children = _heightRanges[level - 1];
+					const uint32_t childCount = count * 2;
+					range = glm::vec2(FLT_MAX, -FLT_MAX);
+					for (uint32_t child = 0; child < 4; child++) {
+						const glm::vec2& childRange = children[(size_t)(y * 2 + child / 2) * childCount + x * 2 + child % 2];
+						range = glm::vec2(glm::min(range.x, childRange.x), glm::max(range.y, childRange.y));
+					}
+				}
+				ranges[(size_t)y * count + x] = range;
+			}
+		}
+	}
+}
+
+void Terrain::_GetChunkBounds(uint32_t level, uint32_t x, uint32_t y, glm::vec3& min, glm::vec3& max) const {
+	const uint32_t count = 1u << (_settings.LodLevels - 1 - level);
+	const glm::vec2 size = glm::vec2(_settings.Size.x, _settings.Size.z) / (float)count;
+	const glm::vec2& range = _heightRanges[level][(size_t)y * count + x];
+	min = glm::vec3(_settings.Position.x + x * size.x, range.x, _settings.Position.z + y * size.y);
+	max = glm::vec3(min.x + size.x, range.y, min.z + size.y);
+}
+
+void Terrain::Select(const glm::vec3& cameraPosition, const Frustum& frustum) {
+	_draws.clear();
+	_stats = Stats();
+	// Past the last level's range there's nothing bigger to fall back on, so the whole terrain is one chunk
+	if (!_SelectChunk(_settings.LodLevels - 1, 0, 0, cameraPosition, frustum)) {
+		_AddDraw(_settings.LodLevels - 1, 0, 0, 0xF);
+	}
+}
+
+bool Terrain::_SelectChunk(uint32_t level, uint32_t x, uint32_t y, const glm::vec3& cameraPosition, const Frustum& frustum) {
+	glm::vec3 min, max;
+	_GetChunkBounds(level, x, y, min, max);
+	// Chunks we can't see are taken care of, there's just nothing to draw
+	if (!frustum.TestBox(min, max)) {
+		return true;
+	}
+	const float distance = DistanceToBox(cameraPosition, min, max);
+	if (distance > _lodRanges[level]) {
+		return false;
+	}
+	if (level == 0 || distance > _lodRanges[level - 1]) {
+		_AddDraw(level, x, y, 0xF);
+		return true;
+	}
+
+	// Part of the chunk needs more detail, let the children that do draw themselves, and fill in the rest
+	uint32_t quarters = 0;
+	for (uint32_t child = 0; child < 4; child++) {
+		if (!_SelectChunk(level - 1, x * 2 + child % 2, y * 2 + child / 2, cameraPosition, frustum)) {
+			quarters |= 1u << child;
+		}
+	}
+	if (quarters != 0) {
+		_AddDraw(level, x, y, quarters);
+	}
+	return true;
+}
+
+void Terrain::_AddDraw(uint32_t level, uint32_t x, uint32_t y, uint32_t quarters) {
+	_draws.push_back({ level, x, y, quarters });
+	const uint32_t half = _settings.GridSize / 2;
+	_stats.Chunks++;
+	_stats.Vertices += quarters == 0xF ? (half * 2 + 1) * (half * 2 + 1) : 0;
+	for (uint32_t quarter = 0; quarter < 4; quarter++) {
+		if (quarters & (1u << quarter)) {
+			_stats.Triangles += half * half * 2;
+			_stats.Vertices += quarters == 0xF ? 0 : (half + 1) * (half + 1);
+			// Quarters that are next to each other in the index buffer go out in one call
+			_stats.DrawCalls += quarter > 0 && (quarters & (1u << (quarter - 1))) ? 0 : 1;
+		}
+	}
+}
+
+void Terrain::Render(const Shader::sptr& shader) const {
+	_heightTexture->Bind(HEIGHTMAP_SLOT);
+	shader->SetUniform("s_Heightmap", HEIGHTMAP_SLOT);
+	if (_splatmap != nullptr) {
+		_splatmap->Bind(SPLATMAP_SLOT);
+	}
+	shader->SetUniform("s_Splatmap", SPLATMAP_SLOT);
+	if (_layers != nullptr) {
+		_layers->Bind(LAYERS_SLOT);
+	}
+	shader->SetUniform("s_Layers", LAYERS_SLOT);
+	shader->SetUniform("u_LayerCount", _layers != nullptr ? (int)_layers->GetLayerCount() : 0);
+	shader->SetUniform("u_LayerTiling", _settings.LayerTiling);
+	if (_lightmap != nullptr) {
+		_lightmap->Bind(LIGHTMAP_SLOT);
+	}
+	shader->SetUniform("s_Lightmap", LIGHTMAP_SLOT);
+	shader->SetUniform("u_UseLightmap", _lightmap != nullptr ? 1 : 0);
+	shader->SetUniform("u_TerrainPosition", _settings.Position);
+	shader->SetUniform("u_TerrainSize", _settings.Size);
+	shader->SetUniform("u_HeightmapSize", glm::vec2(_heightmap->GetWidth(), _heightmap->GetHeight()));
+	shader->SetUniform("u_GridSize", (float)_settings.GridSize);
+
+	for (const Draw& draw : _draws) {
+		const float size = 1.0f / (float)(1u << (_settings.LodLevels - 1 - draw.Level));
+		shader->SetUniform("u_ChunkOffset", glm::vec2(draw.X, draw.Y) * size);
+		shader->SetUniform("u_ChunkSize", size);
+		shader->SetUniform("u_MorphRange", glm::vec2(_morphStarts[draw.Level], _lodRanges[draw.Level]));
+
+		if (draw.Quarters == 0xF) {
+			_grid->RenderRange(0, _quarterRanges[3].x + _quarterRanges[3].y);
+			continue;
+		}
+		for (uint32_t quarter = 0; quarter < 4; quarter++) {
+			if (!(draw.Quarters & (1u << quarter))) {
+				continue;
+			}
+			uint32_t last = quarter;
+			while (last + 1 < 4 && (draw.Quarters & (1u << (last + 1)))) {
+				last++;
+			}
+			_grid->RenderRange(_quarterRanges[quarter].x, _quarterRanges[last].x + _quarterRanges[last].y - _quarterRanges[quarter].x);
+			quarter = last;
+		}
+	}
+}
+
+void Terrain::RenderImGui() {
+	bool changed = false;
+	changed |= ImGui::SliderFloat("LOD Distance", &_settings.LodDistance, 4.0f, 256.0f);
+	changed |= ImGui::SliderFloat("Morph Region", &_settings.MorphRegion, 0.05f, 1.0f);
+	ImGui::SliderFloat("Layer Tiling", &_settings.LayerTiling, 0.5f, 32.0f);
+	if (changed) {
+		_BuildRanges();
+	}
+	ImGui::Text("Chunks: %u (%u draw calls)", _stats.Chunks, _stats.DrawCalls);
+	ImGui::Text("Vertices: %u, triangles: %u", _stats.Vertices, _stats.Triangles);
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Shader.h"
+#include "Texture2D.h"
+#include "Texture2DArray.h"
+#include "VertexArrayObject.h"
+#include "Utilities/Frustum.h"
+#include "Utilities/Heightmap.h"
+
+/// <summary>
+/// A heightmap terrain, drawn with continuous distance-dependent level of detail (CDLOD, see
+/// https://github.com/fstrugar/CDLOD). The terrain is split into a quadtree of chunks, where each level's chunks are
+/// twice the size of the last, and every chunk is drawn with the same small grid mesh, displaced by the heightmap in
+/// the vertex shader. Each frame we pick the biggest chunks that are detailed enough for how far they are from the
+/// camera (culling them against the frustum as we go), so the number of vertices we draw stays about the same no
+/// matter how big the terrain is. Vertices near the edge of a chunk's range slide into place on the next LOD's
+/// grid, so there are no cracks or popping between them.
+///
+/// The surface is a blend of up to 4 layers from a texture array, weighted by the RGBA channels of a splat map
+/// stretched over the terrain
+/// </summary>
+class Terrain final
+{
+public:
+	typedef std::shared_ptr<Terrain> sptr;
+
+	struct Settings
+	{
+		// The world space corner of the terrain at (0, 0) of the heightmap, and its size. Y is the height of a white sample
+		glm::vec3 Position = glm::vec3(0.0f);
+		glm::vec3 Size = glm::vec3(128.0f, 16.0f, 128.0f);
+		// The number of quads along each side of the grid mesh, must be even so it can be drawn a quarter at a time
+		uint32_t  GridSize = 16;
+		// The number of levels in the quadtree, the smallest chunks are 1 / 2^(LodLevels - 1) of the terrain across
+		uint32_t  LodLevels = 5;
+		// How far out the smallest chunks are used, each level after that reaches twice as far. This needs to be a few
+		// times the size of the smallest chunks, so vertices finish morphing before they meet the next level
+		float     LodDistance = 48.0f;
+		// The fraction of each level's range that its vertices spend morphing into the next level
+		float     MorphRegion = 0.3f;
+		// The size of one repeat of the layer textures, in world units
+		float     LayerTiling = 6.0f;
+	};
+
+	/// <summary>
+	/// How much work the last call to Select came up with
+	/// </summary>
+	struct Stats
+	{
+		uint32_t Chunks = 0;
+		uint32_t DrawCalls = 0;
+		uint32_t Vertices = 0;
+		uint32_t Triangles = 0;
+	};
+
+	// The texture slots the terrain binds its textures to, the same slots our materials use
+	static constexpr int HEIGHTMAP_SLOT = 1;
+	static constexpr int SPLATMAP_SLOT = 2;
+	static constexpr int LAYERS_SLOT = 3;
+	static constexpr int LIGHTMAP_SLOT = 4;
+	// One layer for each channel of the splat map
+	static constexpr uint32_t MAX_LAYERS = 4;
+
+	/// <summary>
+	/// Creates a terrain, and uploads its heightmap
+	/// </summary>
+	/// <param name="settings">Where the terrain is, and how to split it up</param>
+	/// <param name="heightmap">The heights to displace the terrain by</param>
+	/// <param name="splatmap">How much of each layer to use across the terrain, in its RGBA channels</param>
+	/// <param name="layers">The textures to blend between, one per channel of the splat map</param>
+	static inline sptr Create(const Settings& settings, const Heightmap::sptr& heightmap, const Texture2D::sptr& splatmap, const Texture2DArray::sptr& layers) {
+		return std::make_shared<Terrain>(settings, heightmap, splatmap, layers);
+	}
+
+	Terrain(const Settings& settings, const Heightmap::sptr& heightmap, const Texture2D::sptr& splatmap, const Texture2DArray::sptr& layers);
+	~Terrain() = default;
+
+	Terrain(const Terrain& other) = delete;
+	Terrain& operator=(const Terrain& other) = delete;
+
+	/// <summary>
+	/// Sets the baked lighting for the terrain. Unlike other objects the terrain's lightmap is laid straight over the
+	/// heightmap, so it uses the same UVs (see LightmapBaker::AddHeightfield)
+	/// </summary>
+	void SetLightmap(const Texture2D::sptr& lightmap) { _lightmap = lightmap; }
+
+	/// <summary>
+	/// Gets the transform that stretches the unit sized heightmap over the terrain's area, what the LightmapBaker and
+	/// the mesh from Heightmap::BuildMesh expect
+	/// </summary>
+	glm::mat4 GetTransform() const;
+
+	/// <summary>
+	/// Gets the height of the ground at a world position
+	/// </summary>
+	float GetHeight(float x, float z) const;
+
+	const Settings& GetSettings() const { return _settings; }
+	const Heightmap::sptr& GetHeightmap() const { return _heightmap; }
+	const Stats& GetStats() const { return _stats; }
+
+	/// <summary>
+	/// Picks the chunks to draw this frame
+	/// </summary>
+	/// <param name="cameraPosition">The world position of the camera, which needs to match the shader's u_CamPos</param>
+	/// <param name="frustum">The camera's frustum, chunks entirely outside of it are skipped</param>
+	void Select(const glm::vec3& cameraPosition, const Frustum& frustum);
+
+	/// <summary>
+	/// Draws the chunks picked by the last call to Select. The shader must already be bound, with its per frame
+	/// uniforms (see SetupShaderForFrame) set
+	/// </summary>
+	/// <param name="shader">The terrain shader, made from vertex_terrain.glsl and frag_terrain.glsl</param>
+	void Render(const Shader::sptr& shader) const;
+
+	/// <summary>
+	/// Draws the LOD settings and stats using ImGui, should be called inside of an ImGui window
+	/// </summary>
+	void RenderImGui();
+
+private:
+	// A chunk to draw, and which of its quarters to draw (a bit per quarter, in the order of _quarterRanges)
+	struct Draw
+	{
+		uint32_t Level;
+		uint32_t X;
+		uint32_t Y;
+		uint32_t Quarters;
+	};
+
+	Settings                 _settings;
+	Heightmap::sptr          _heightmap;
+	Texture2D::sptr          _heightTexture;
+	Texture2D::sptr          _splatmap;
+	Texture2DArray::sptr     _layers;
+	Texture2D::sptr          _lightmap;
+	VertexArrayObject::sptr  _grid;
+	// The first index and index count of each quarter of the grid
+	glm::uvec2               _quarterRanges[4];
+	// The lowest and highest point of every chunk, in world space, for each level (0 being the smallest chunks)
+	std::vector<std::vector<glm::vec2>> _heightRanges;
+	// How far out each level is used, and where its vertices start morphing into the next
+	std::vector<float>       _lodRanges;
+	std::vector<float>       _morphStarts;
+	std::vector<Draw>        _draws;
+	Stats                    _stats;
+
+	void _BuildGrid();
+	void _BuildRanges();
+	void _BuildQuadtree();
+	// Returns false if the chunk is too far away for its level, and should be drawn by its parent instead
+	bool _SelectChunk(uint32_t level, uint32_t x, uint32_t y, const glm::vec3& cameraPosition, const Frustum& frustum);
+	void _AddDraw(uint32_t level, uint32_t x, uint32_t y, uint32_t quarters);
+	void _GetChunkBounds(uint32_t level, uint32_t x, uint32_t y, glm::vec3& min, glm::vec3& max) const;
+};
@@ -1,4 +1,5 @@
 #include "Texture2D.h"
+#include "GpuMemoryTracker.h"
 
 Texture2D::Texture2D(const Texture2DDescription& description) :
 	ITexture(), _description(description)
@@ -21,7 +22,18 @@ void Texture2D::_RecreateTexture() {
 
 	if (_description.Width * _description.Height > 0 && _description.Format != InternalFormat::Unknown)
 	{
-		glTextureStorage2D(_handle, 1, *_description.Format, _description.Width, _description.Height);
+		// Allocate the entire mip chain up front if we will be using mips, otherwise minified textures will only
+		// ever be able to sample from the full resolution image
+		_mipLevels = _description.GenerateMipMaps ? CalculateMipLevelCount(_description.Width, _description.Height) : 1;
+		_baseMipLevel = 0;
+		glTextureStorage2D(_handle, _mipLevels, *_description.Format, _description.Width, _description.Height);
+
+		// Add up the size of every level in the mip chain we just allocated
+		size_t bytes = 0;
+		for (int level = 0; level < _mipLevels; level++) {
+			bytes += (size_t)glm::max(_description.Width >> level, 1u) * glm::max(_description.Height >> level, 1u);
+		}
+		GpuMemoryTracker::Instance().Register(this, GpuMemoryCategory::Texture, GL_TEXTURE, _handle, bytes * GetInternalFormatSize(*_description.Format));
 
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
@@ -47,7 +59,7 @@ void Texture2D::LoadData(const Texture2DData::sptr& data) {
 	
 	// We can get better error logs by attaching an object label!
 	if (!data->DebugName.empty()) {
-		glObjectLabel(GL_TEXTURE, _handle, data->DebugName.length(), data->DebugName.c_str());
+		SetDebugName(data->DebugName);
 	}
 	
 	// Align the data store to the size of a single component in
@@ -63,6 +75,35 @@ void Texture2D::LoadData(const Texture2DData::sptr& data) {
 	}
 }
 
+void Texture2D::LoadMipData(int level, const Texture2DData::sptr& data) {
+	LOG_ASSERT(level >= 0 && level < _mipLevels, "Mip level {} is out of range, texture has {} levels", level, _mipLevels);
+	LOG_ASSERT(data->GetWidth() == glm::max(_description.Width >> level, 1u) && data->GetHeight() == glm::max(_description.Height >> level, 1u),
+		"Data size {}x{} does not match mip level {}", data->GetWidth(), data->GetHeight(), level);
+
+	// Lower mip levels will almost never have rows that are a multiple of 4 bytes, so we need to tell OpenGL the real alignment
+	int componentSize = (GLint)GetTexelComponentSize(data->GetPixelType());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, componentSize);
+	glTextureSubImage2D(_handle, level, 0, 0, data->GetWidth(), data->GetHeight(), *data->GetFormat(), *data->GetPixelType(), data->GetDataPtr());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void Texture2D::SetBaseMipLevel(int level) {
+	_baseMipLevel = glm::clamp(level, 0, _mipLevels - 1);
+	if (_handle != 0) {
+		glTextureParameteri(_handle, GL_TEXTURE_BASE_LEVEL, _baseMipLevel);
+	}
+}
+
+int Texture2D::CalculateMipLevelCount(uint32_t width, uint32_t height) {
+	int levels = 1;
+	uint32_t size = glm::max(width, height);
+	while (size > 1) {
+		size >>= 1;
+		levels++;
+	}
+	return levels;
+}
+
 Texture2D::sptr Texture2D::LoadFromFile(const std::string& path) {
 	Texture2DData::sptr data = Texture2DData::LoadFromFile(path);
 	LOG_ASSERT(data != nullptr, "Failed to load image from file!");
@@ -68,6 +68,34 @@ public:
 	/// <param name="path">The path to load the image from</param>
 	/// <returns>A pointer to the loaded image</returns>
 	static Texture2D::sptr LoadFromFile(const std::string& path);
+
+	/// <summary>
+	/// Uploads data into a single mip level of this texture, without regenerating any other mip levels. The data
+	/// must match the dimensions of the given level
+	/// </summary>
+	/// <param name="level">The mip level to upload into, where 0 is the full resolution image</param>
+	/// <param name="data">The texture data to upload into the mip level</param>
+	void LoadMipData(int level, const Texture2DData::sptr& data);
+
+	/// <summary>
+	/// Sets the finest mip level that may be sampled from this texture. Levels below this one (higher resolution)
+	/// are ignored by OpenGL, which lets us leave them empty or discard them
+	/// </summary>
+	/// <param name="level">The new base level for sampling</param>
+	void SetBaseMipLevel(int level);
+	/// <summary>
+	/// Gets the finest mip level that may be sampled from this texture
+	/// </summary>
+	int GetBaseMipLevel() const { return _baseMipLevel; }
+	/// <summary>
+	/// Gets the number of mip levels allocated for this texture
+	/// </summary>
+	int GetMipLevelCount() const { return _mipLevels; }
+
+	/// <summary>
+	/// Calculates the number of mip levels in a full mip chain for a texture of the given size
+	/// </summary>
+	static int CalculateMipLevelCount(uint32_t width, uint32_t height);
 	
 	uint32_t GetWidth() const { return _description.Width; }
 	uint32_t GetHeight() const { return _description.Height; }
@@ -87,6 +115,8 @@ public:
 	
 private:
 	Texture2DDescription _description;
+	int _mipLevels = 1;
+	int _baseMipLevel = 0;
 
 	void _RecreateTexture();
 };
@@ -0,0 +1,57 @@
+#include "Texture2DArray.h"
+#include "GpuMemoryTracker.h"
+#include "Texture2D.h"
+
+Texture2DArray::Texture2DArray(const Texture2DArrayDescription& description) :
+	ITexture(), _description(description)
+{
+	LOG_ASSERT(_description.Width * _description.Height * _description.Layers > 0 && _description.Format != InternalFormat::Unknown,
+		"Texture arrays need a size, layer count and format up front");
+
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &_handle);
+
+	if (_description.MaxAnisotropic < 0.0f) {
+		_description.MaxAnisotropic = ITexture::GetLimits().MAX_ANISOTROPY;
+	}
+
+	_mipLevels = _description.GenerateMipMaps ? Texture2D::CalculateMipLevelCount(_description.Width, _description.Height) : 1;
+	glTextureStorage3D(_handle, _mipLevels, *_description.Format, _description.Width, _description.Height, _description.Layers);
+
+	size_t bytes = 0;
+	for (int level = 0; level < _mipLevels; level++) {
+		bytes += (size_t)glm::max(_description.Width >> level, 1u) * glm::max(_description.Height >> level, 1u);
+	}
+	GpuMemoryTracker::Instance().Register(this, GpuMemoryCategory::Texture, GL_TEXTURE, _handle, bytes * _description.Layers * GetInternalFormatSize(*_description.Format));
+
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
+	glTextureParameteri(_handle, GL_TEXTURE_MIN_FILTER, (GLenum)_description.MinificationFilter);
+	glTextureParameteri(_handle, GL_TEXTURE_MAG_FILTER, (GLenum)_description.MagnificationFilter);
+	glTextureParameterf(_handle, GL_TEXTURE_MAX_ANISOTROPY, _description.MaxAnisotropic);
+}
+
+void Texture2DArray::LoadLayer(uint32_t layer, const Texture2DData::sptr& data) {
+	LOG_ASSERT(layer < _description.Layers, "Layer {} is out of range, texture array has {} layers", layer, _description.Layers);
+
+	// Halve big images first, bilinear resampling only looks at the 4 closest pixels so it would alias
+	Texture2DData::sptr image = data;
+	while (image->GetWidth() >= _description.Width * 2 && image->GetHeight() >= _description.Height * 2) {
+		image = image->GenerateNextMip();
+		LOG_ASSERT(image != nullptr, "Failed to shrink layer {} down to fit", layer);
+	}
+	if (image->GetWidth() != _description.Width || image->GetHeight() != _description.Height) {
+		image = image->Resample(_description.Width, _description.Height);
+		LOG_ASSERT(image != nullptr, "Failed to resize layer {} to {}x{}", layer, _description.Width, _description.Height);
+	}
+
+	int componentSize = (GLint)GetTexelComponentSize(image->GetPixelType());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, componentSize);
+	glTextureSubImage3D(_handle, 0, 0, 0, layer, _description.Width, _description.Height, 1, *image->GetFormat(), *image->GetPixelType(), image->GetDataPtr());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void Texture2DArray::GenerateMipMaps() {
+	if (_mipLevels > 1) {
+		glGenerateTextureMipmap(_handle);
+	}
+}
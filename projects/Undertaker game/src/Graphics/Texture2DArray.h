@@ -0,0 +1,87 @@
+#pragma once
+#include <memory>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "ITexture.h"
+#include "TextureEnums.h"
+#include "Texture2DData.h"
+
+struct Texture2DArrayDescription
+{
+	uint32_t       Width;
+	uint32_t       Height;
+	uint32_t       Layers;
+	InternalFormat Format;
+	WrapMode       HorizontalWrap;
+	WrapMode       VerticalWrap;
+	MinFilter      MinificationFilter;
+	MagFilter      MagnificationFilter;
+	float          MaxAnisotropic;
+	bool           GenerateMipMaps;
+
+	Texture2DArrayDescription() :
+		Width(0), Height(0), Layers(0),
+		Format(InternalFormat::Unknown),
+		HorizontalWrap(WrapMode::Repeat),
+		VerticalWrap(WrapMode::Repeat),
+		MinificationFilter(MinFilter::LinearMipLinear),
+		MagnificationFilter(MagFilter::Linear),
+		MaxAnisotropic(-1.0f),
+		GenerateMipMaps(true)
+	{ }
+};
+
+/// <summary>
+/// Represents a wrapper around an OpenGL 2D texture array, a stack of same sized images that a shader can pick
+/// between with a third texture coordinate. Used where one draw needs to blend between a handful of materials (ex:
+/// the layers of the terrain), without using up a texture slot for each
+/// </summary>
+class Texture2DArray final : public ITexture
+{
+public:
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	Texture2DArray(const Texture2DArray& other) = delete;
+	Texture2DArray(Texture2DArray&& other) = delete;
+	Texture2DArray& operator=(const Texture2DArray& other) = delete;
+	Texture2DArray& operator=(Texture2DArray&& other) = delete;
+
+	typedef std::shared_ptr<Texture2DArray> sptr;
+	static inline sptr Create(const Texture2DArrayDescription& description) {
+		return std::make_shared<Texture2DArray>(description);
+	}
+
+public:
+	/// <summary>
+	/// Creates a new texture array with the given description, every layer is allocated up front
+	/// </summary>
+	/// <param name="description">The description for the texture, the size, layer count and format must be set</param>
+	Texture2DArray(const Texture2DArrayDescription& description);
+	// ITexture handles destroying the OpenGL data, so we can use the default destructor
+	~Texture2DArray() = default;
+
+	/// <summary>
+	/// Uploads an image into one layer of the array. Images that aren't the same size as the array are resampled to
+	/// fit. If the array has mips, call GenerateMipMaps once every layer is loaded
+	/// </summary>
+	/// <param name="layer">The index of the layer to upload into</param>
+	/// <param name="data">The image to upload</param>
+	void LoadLayer(uint32_t layer, const Texture2DData::sptr& data);
+
+	/// <summary>
+	/// Rebuilds the mip chain for every layer from the full resolution images
+	/// </summary>
+	void GenerateMipMaps();
+
+	uint32_t GetWidth() const { return _description.Width; }
+	uint32_t GetHeight() const { return _description.Height; }
+	uint32_t GetLayerCount() const { return _description.Layers; }
+	InternalFormat GetFormat() const { return _description.Format; }
+
+	const Texture2DArrayDescription& GetDescription() const { return _description; }
+
+private:
+	Texture2DArrayDescription _description;
+	int _mipLevels = 1;
+};
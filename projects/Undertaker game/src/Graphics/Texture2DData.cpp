@@ -1,7 +1,10 @@
 #include "Texture2DData.h"
 
+#include <cstring>
 #include <filesystem>
+#include <vector>
 #include <stb_image.h>
+#include <GLM/glm.hpp>
 
 Texture2DData::Texture2DData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat) :
 	_width(width), _height(height), _format(format), _type(type), _data(nullptr), _recommendedFormat(recommendedFormat)
@@ -81,3 +84,94 @@ Texture2DData::sptr Texture2DData::LoadFromFile(const std::string& file, bool fo
 
 	return result;
 }
+
+
+Texture2DData::sptr Texture2DData::GenerateNextMip() const
+{
+	// We only have to deal with the 8 bit images that STBI gives us for now
+	if (_type != PixelType::UByte) {
+		LOG_WARN("Mip generation is only supported for unsigned byte images, got {}", _type);
+		return nullptr;
+	}
+
+	const uint32_t width  = _width  > 1 ? _width  / 2 : 1;
+	const uint32_t height = _height > 1 ? _height / 2 : 1;
+	const int channels = GetTexelComponentCount(_format);
+
+	Texture2DData::sptr result = std::make_shared<Texture2DData>(width, height, _format, _type, nullptr, _recommendedFormat);
+	result->DebugName = DebugName;
+
+	const uint8_t* source = static_cast<const uint8_t*>(_data);
+	uint8_t* dest = static_cast<uint8_t*>(result->_data);
+
+	for (uint32_t y = 0; y < height; y++) {
+		// Clamp our source rows so that 1 pixel tall images (and odd heights) don't read past the end
+		const uint32_t y0 = glm::min(y * 2,     _height - 1);
+		const uint32_t y1 = glm::min(y * 2 + 1, _height - 1);
+		for (uint32_t x = 0; x < width; x++) {
+			const uint32_t x0 = glm::min(x * 2,     _width - 1);
+			const uint32_t x1 = glm::min(x * 2 + 1, _width - 1);
+			for (int c = 0; c < channels; c++) {
+				const uint32_t sum =
+					source[((size_t)y0 * _width + x0) * channels + c] +
+					source[((size_t)y0 * _width + x1) * channels + c] +
+					source[((size_t)y1 * _width + x0) * channels + c] +
+					source[((size_t)y1 * _width + x1) * channels + c];
+				dest[((size_t)y * width + x) * channels + c] = static_cast<uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+
+	return result;
+}
+
+Texture2DData::sptr Texture2DData::Resample(uint32_t width, uint32_t height) const
+{
+	if (_type != PixelType::UByte) {
+		LOG_WARN("Resampling is only supported for unsigned byte images, got {}", _type);
+		return nullptr;
+	}
+
+	const int channels = GetTexelComponentCount(_format);
+	Texture2DData::sptr result = std::make_shared<Texture2DData>(width, height, _format, _type, nullptr, _recommendedFormat);
+	result->DebugName = DebugName;
+
+	const uint8_t* source = static_cast<const uint8_t*>(_data);
+	uint8_t* dest = static_cast<uint8_t*>(result->_data);
+
+	// Line up pixel centers rather than corners, so the image doesn't shift by half a pixel
+	const glm::vec2 scale(_width / (float)width, _height / (float)height);
+	for (uint32_t y = 0; y < height; y++) {
+		const float sy = glm::clamp((y + 0.5f) * scale.y - 0.5f, 0.0f, (float)(_height - 1));
+		const uint32_t y0 = (uint32_t)sy;
+		const uint32_t y1 = glm::min(y0 + 1, _height - 1);
+		const float ty = sy - y0;
+		for (uint32_t x = 0; x < width; x++) {
+			const float sx = glm::clamp((x + 0.5f) * scale.x - 0.5f, 0.0f, (float)(_width - 1));
+			const uint32_t x0 = (uint32_t)sx;
+			const uint32_t x1 = glm::min(x0 + 1, _width - 1);
+			const float tx = sx - x0;
+			for (int c = 0; c < channels; c++) {
+				const float top = glm::mix((float)source[((size_t)y0 * _width + x0) * channels + c], (float)source[((size_t)y0 * _width + x1) * channels + c], tx);
+				const float bottom = glm::mix((float)source[((size_t)y1 * _width + x0) * channels + c], (float)source[((size_t)y1 * _width + x1) * channels + c], tx);
+				dest[((size_t)y * width + x) * channels + c] = static_cast<uint8_t>(glm::mix(top, bottom, ty) + 0.5f);
+			}
+		}
+	}
+
+	return result;
+}
+
+void Texture2DData::FlipVertical()
+{
+	const size_t rowSize = _dataSize / _height;
+	std::vector<uint8_t> temp(rowSize);
+	uint8_t* data = static_cast<uint8_t*>(_data);
+	for (uint32_t y = 0; y < _height / 2; y++) {
+		uint8_t* top = data + y * rowSize;
+		uint8_t* bottom = data + (size_t)(_height - 1 - y) * rowSize;
+		memcpy(temp.data(), top, rowSize);
+		memcpy(top, bottom, rowSize);
+		memcpy(bottom, temp.data(), rowSize);
+	}
+}
@@ -38,6 +38,27 @@ public:
 	/// <returns>A pointer to the data loaded from the file, or nullptr if the file failed to load</returns>
 	static Texture2DData::sptr LoadFromFile(const std::string& file, bool forceRgba = false);
 
+	/// <summary>
+	/// Creates the next mip level down from this image using a 2x2 box filter. Odd dimensions are clamped to the
+	/// edge, and each dimension is never reduced below 1 pixel
+	/// </summary>
+	/// <returns>A new image that is half the size of this one along each axis, or nullptr if the pixel type is unsupported</returns>
+	Texture2DData::sptr GenerateNextMip() const;
+
+	/// <summary>
+	/// Creates a copy of this image stretched to a new size with bilinear filtering, for when images need to share a
+	/// size (ex: the layers of a texture array). Shrinking by more than half skips pixels, so use GenerateNextMip first
+	/// </summary>
+	/// <param name="width">The width of the new image, in pixels</param>
+	/// <param name="height">The height of the new image, in pixels</param>
+	/// <returns>The resized image, or nullptr if the pixel type is unsupported</returns>
+	Texture2DData::sptr Resample(uint32_t width, uint32_t height) const;
+
+	/// <summary>
+	/// Flips the image upside down, in place
+	/// </summary>
+	void FlipVertical();
+
 	/// <summary>
 	/// Gets the width of the texture data, in pixels
 	/// </summary>
@@ -1,4 +1,6 @@
 #include "TextureCubeMap.h"
+#include "Texture2D.h"
+#include "GpuMemoryTracker.h"
 
 TextureCubeMap::TextureCubeMap(const TextureCubeDesc& description) :
 	ITexture(), _description(description) {
@@ -6,21 +8,93 @@ TextureCubeMap::TextureCubeMap(const TextureCubeDesc& description) :
 }
 
 void TextureCubeMap::_RecreateTexture() {
+	if (_handle != 0) {
+		glDeleteTextures(1, &_handle);
+		_handle = 0;
+		// The new texture registers itself again below, if it has any storage
+		GpuMemoryTracker::Instance().Unregister(this);
+	}
+
+	glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &_handle);
 
+	if (_description.Size > 0 && _description.Format != InternalFormat::Unknown) {
+		_mipLevels = _description.MipLevels > 0 ? (int)_description.MipLevels :
+			(_description.GenerateMipMaps ? Texture2D::CalculateMipLevelCount(_description.Size, _description.Size) : 1);
+		glTextureStorage2D(_handle, _mipLevels, *_description.Format, _description.Size, _description.Size);
+
+		size_t bytes = 0;
+		for (int level = 0; level < _mipLevels; level++) {
+			const size_t size = glm::max(_description.Size >> level, 1u);
+			bytes += size * size * 6;
+		}
+		GpuMemoryTracker::Instance().Register(this, GpuMemoryCategory::CubeMap, GL_TEXTURE, _handle, bytes * GetInternalFormatSize(*_description.Format));
+
+		// Cubemaps are sampled by direction, so we never want to wrap around a face
+		glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(_handle, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(_handle, GL_TEXTURE_MIN_FILTER, (GLenum)_description.MinificationFilter);
+		glTextureParameteri(_handle, GL_TEXTURE_MAG_FILTER, (GLenum)_description.MagnificationFilter);
+		glTextureParameteri(_handle, GL_TEXTURE_MAX_LEVEL, _mipLevels - 1);
+	}
 }
 
 void TextureCubeMap::LoadData(const TextureCubeMapData::sptr& data) {
+	if (data == nullptr) {
+		LOG_WARN("Tried to load null data into a cubemap, ignoring");
+		return;
+	}
+
+	if (_description.Size != data->GetSize() || _handle == 0 || _description.Format == InternalFormat::Unknown) {
+		_description.Size = data->GetSize();
+		if (_description.Format == InternalFormat::Unknown) {
+			_description.Format = data->GetRecommendedFormat();
+		}
+		_RecreateTexture();
+	}
 
+	if (!data->DebugName.empty()) {
+		SetDebugName(data->DebugName);
+	}
+
+	// All six faces are stored back to back, so we can upload them as the layers of a single image
+	int componentSize = (GLint)GetTexelComponentSize(data->GetPixelType());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, componentSize);
+	glTextureSubImage3D(_handle, 0, 0, 0, 0, _description.Size, _description.Size, 6, *data->GetFormat(), *data->GetPixelType(), data->GetDataPtr());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	if (_description.GenerateMipMaps) {
+		glGenerateTextureMipmap(_handle);
+	}
+}
+
+void TextureCubeMap::LoadMipData(int level, PixelFormat format, PixelType type, const void* data) {
+	LOG_ASSERT(level >= 0 && level < _mipLevels, "Mip level {} is out of range, cubemap has {} levels", level, _mipLevels);
+	const uint32_t size = glm::max(_description.Size >> level, 1u);
+
+	int componentSize = (GLint)GetTexelComponentSize(type);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, componentSize);
+	glTextureSubImage3D(_handle, level, 0, 0, 0, size, size, 6, *format, *type, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
 TextureCubeMap::sptr TextureCubeMap::LoadFromImages(const std::string& path)
 {
 	TextureCubeMapData::sptr data = TextureCubeMapData::LoadFromImages(path);
-	TextureCubeMap::sptr result = TextureCubeMap::Create();
+	LOG_ASSERT(data != nullptr, "Failed to load cubemap from \"{}\"", path);
+	TextureCubeDesc desc;
+	desc.GenerateMipMaps = true;
+	desc.MinificationFilter = MinFilter::LinearMipLinear;
+	TextureCubeMap::sptr result = TextureCubeMap::Create(desc);
 	result->LoadData(data);
 	return result;
 }
 
+void TextureCubeMap::Recreate(const TextureCubeDesc& description) {
+	_description = description;
+	_RecreateTexture();
+}
+
 void TextureCubeMap::SetMinFilter(MinFilter filter) {
 	_description.MinificationFilter = filter;
 	if (_handle != 0) {
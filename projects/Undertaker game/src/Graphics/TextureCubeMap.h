@@ -11,13 +11,16 @@ struct TextureCubeDesc {
 	MinFilter      MinificationFilter;
 	MagFilter      MagnificationFilter;
 	bool           GenerateMipMaps;
+	// The number of mip levels to allocate, 0 will allocate the full chain if GenerateMipMaps is set and 1 otherwise
+	uint32_t       MipLevels;
 
 	TextureCubeDesc() :
 		Size(0),
 		Format(InternalFormat::Unknown),
 		MinificationFilter(MinFilter::Linear),
 		MagnificationFilter(MagFilter::Linear),
-		GenerateMipMaps(false)
+		GenerateMipMaps(false),
+		MipLevels(0)
 	{ }
 };
 
@@ -50,9 +53,20 @@ public:
 	/// <param name="data">The texture data to upload into this texture</param>
 	void LoadData(const TextureCubeMapData::sptr& data);
 
+	/// <summary>
+	/// Uploads all six faces of a single mip level, for textures whose mips are generated offline (ex: prefiltered
+	/// environment maps)
+	/// </summary>
+	/// <param name="level">The mip level to upload to</param>
+	/// <param name="format">The layout of the pixels in data</param>
+	/// <param name="type">The component type of the pixels in data</param>
+	/// <param name="data">The faces, one after another in CubeMapFace order</param>
+	void LoadMipData(int level, PixelFormat format, PixelType type, const void* data);
+
 	static TextureCubeMap::sptr LoadFromImages(const std::string& path);
 
 	uint32_t GetSize() const { return _description.Size; }
+	int GetMipLevelCount() const { return _mipLevels; }
 	InternalFormat GetFormat() const { return _description.Format; }
 	MinFilter GetMinFilter() const { return _description.MinificationFilter; }
 	MagFilter GetMagFilter() const { return _description.MagnificationFilter; }
@@ -60,10 +74,16 @@ public:
 	void SetMinFilter(MinFilter filter);
 	void SetMagFilter(MagFilter filter);
 
+	/// <summary>
+	/// Reallocates this texture with a new description, the contents will need to be uploaded again
+	/// </summary>
+	void Recreate(const TextureCubeDesc& description);
+
 	const TextureCubeDesc& GetDescription() const { return _description; }
 
 private:
 	TextureCubeDesc _description;
+	int _mipLevels = 1;
 
 	void _RecreateTexture();
 };
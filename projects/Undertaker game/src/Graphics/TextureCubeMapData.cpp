@@ -1,5 +1,6 @@
 #include "TextureCubeMapData.h"
 #include <filesystem>
+#include <future>
 
 TextureCubeMapData::TextureCubeMapData(uint32_t size, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat) :
 	_size(size), _format(format), _type(type), _data(nullptr), _recommendedFormat(recommendedFormat)
@@ -20,10 +21,32 @@ TextureCubeMapData::~TextureCubeMapData() {
 
 TextureCubeMapData::sptr TextureCubeMapData::CreateFromImages(const std::vector<Texture2DData::sptr>& images)
 {
-	return nullptr;
+	if (images.size() != 6) {
+		LOG_WARN("Cubemaps need 6 images, got {}", images.size());
+		return nullptr;
+	}
+	for (int ix = 0; ix < 6; ix++) {
+		if (images[ix] == nullptr) {
+			LOG_WARN("Image for face {} is missing, cannot create cubemap", (CubeMapFace)ix);
+			return nullptr;
+		}
+	}
+
+	// Every face needs to match the first one, LoadFaceData will let us know if any don't
+	const Texture2DData::sptr& first = images[0];
+	if (first->GetWidth() != first->GetHeight()) {
+		LOG_WARN("Cubemap faces must be square, got {}x{}", first->GetWidth(), first->GetHeight());
+		return nullptr;
+	}
+	TextureCubeMapData::sptr result = std::make_shared<TextureCubeMapData>(first->GetWidth(), first->GetFormat(), first->GetPixelType(), nullptr, first->GetRecommendedFormat());
+	for (int ix = 0; ix < 6; ix++) {
+		result->LoadFaceData(images[ix], (CubeMapFace)ix);
+	}
+	result->DebugName = first->DebugName;
+	return result;
 }
 
-TextureCubeMapData::sptr TextureCubeMapData::LoadFromImages(const std::string& rootImagePath) {
+std::string TextureCubeMapData::GetFacePath(const std::string& rootImagePath, CubeMapFace face) {
 	namespace fs = std::filesystem;
 	fs::path imagePath = fs::path(rootImagePath);
 	fs::path directory = imagePath.parent_path();
@@ -39,21 +62,43 @@ TextureCubeMapData::sptr TextureCubeMapData::LoadFromImages(const std::string& r
 		"_neg_z"
 	};
 
-	std::vector<Texture2DData::sptr> data;
-	data.resize(6);
+	fs::path result = rootFile;
+	result += PATHS[*face];
+	result += extension;
+	return result.string();
+}
 
+TextureCubeMapData::sptr TextureCubeMapData::LoadFromImages(const std::string& rootImagePath) {
+	namespace fs = std::filesystem;
+
+	// Decoding is by far the slowest part of loading, so we decode all six faces at once
+	std::future<Texture2DData::sptr> tasks[6];
 	for(int ix = 0; ix < 6; ix++) {
-		fs::path imagePath = rootFile;
-		imagePath += PATHS[ix];
-		imagePath += extension;
+		fs::path imagePath = GetFacePath(rootImagePath, (CubeMapFace)ix);
 		if (fs::exists(imagePath)) {
-			data[ix] = Texture2DData::LoadFromFile(imagePath.string());
+			tasks[ix] = std::async(std::launch::async, [](const std::string& path) {
+				Texture2DData::sptr face = Texture2DData::LoadFromFile(path);
+				// Our image loading flips everything to match OpenGL's 2D texture origin, but cubemap faces are
+				// addressed from the top left, so we need to flip them back
+				if (face != nullptr) {
+					face->FlipVertical();
+				}
+				return face;
+			}, imagePath.string());
 		}
 		else {
 			LOG_WARN("Image \"{}\" could not be found!", imagePath.string());
 		}
 	}
 
+	std::vector<Texture2DData::sptr> data;
+	data.resize(6);
+	for (int ix = 0; ix < 6; ix++) {
+		if (tasks[ix].valid()) {
+			data[ix] = tasks[ix].get();
+		}
+	}
+
 	return CreateFromImages(data);
 }
 
@@ -65,11 +65,19 @@ public:
 	/// image_pos_y.png --> CubeMapFace::PosY
 	/// image_neg_z.png --> CubeMapFace::NegZ
 	/// image_pos_z.png --> CubeMapFace::PosZ
+	/// The faces are decoded in parallel
 	/// </summary>
 	/// <param name="rootImagePath">The base path for images, including extension. This file name will be appended with _pos_x, _neg_x, etc...</param>
 	/// <returns>A pointer to the data created from the images</returns>
 	static TextureCubeMapData::sptr LoadFromImages(const std::string& rootImagePath);
 
+	/// <summary>
+	/// Gets the path of the image for a single face, following the naming scheme used by LoadFromImages
+	/// </summary>
+	/// <param name="rootImagePath">The base path for images, including extension</param>
+	/// <param name="face">The face to get the path for</param>
+	static std::string GetFacePath(const std::string& rootImagePath, CubeMapFace face);
+
 	/// <summary>
 	/// Loads 2D image data into this cubemap data for the given face. Dimensions and format must match the existing size and formats
 	/// </summary>
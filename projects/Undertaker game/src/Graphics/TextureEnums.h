@@ -18,7 +18,10 @@ ENUM(InternalFormat, GLint,
 	RGB10        = GL_RGB10,
 	RGB16        = GL_RGB16,
 	RGBA8        = GL_RGBA8,
-	RGBA16       = GL_RGBA16
+	RGBA16       = GL_RGBA16,
+	// Packed HDR, same size as RGBA8
+	R11G11B10F   = GL_R11F_G11F_B10F,
+	RGBA16F      = GL_RGBA16F
 
 	// Note: There are sized internal formats but there is a LOT of them
 );
@@ -44,6 +47,7 @@ ENUM(PixelType, GLint,
 	Short  = GL_SHORT,
 	UInt   = GL_UNSIGNED_INT,
 	Int    = GL_INT,
+	HalfFloat = GL_HALF_FLOAT,
 	Float  = GL_FLOAT
 );
 
@@ -83,9 +87,11 @@ constexpr size_t GetTexelComponentSize(PixelType type)
 		return 1;
 	case PixelType::UShort:
 	case PixelType::Short:
+	case PixelType::HalfFloat:
 		return 2;
 	case PixelType::Int:
 	case PixelType::UInt:
+	case PixelType::Float:
 		return 4;
 	default:
 		LOG_ASSERT(false, "Unknown type: {}", type);
@@ -118,6 +124,48 @@ constexpr GLint GetTexelComponentCount(PixelFormat format)
 	}
 }
 
+/*
+ * Gets the approximate number of bytes a single texel of a sized internal format takes up in GPU memory. 3 component
+ * formats are assumed to be padded out to 4 components, since that is what most drivers do
+ * @param format The sized internal format (ex: GL_RGBA8)
+ * @returns The size of a single texel in GPU memory, in bytes
+ */
+constexpr size_t GetInternalFormatSize(GLenum format) {
+	switch (format) {
+	case GL_R8:
+		return 1;
+	case GL_R16:
+	case GL_RG8:
+	case GL_R16F:
+		return 2;
+	case GL_RGB8:
+	case GL_RGBA8:
+	case GL_RGB10:
+	case GL_RGB10_A2:
+	case GL_R11F_G11F_B10F:
+	case GL_RG16F:
+	case GL_R32F:
+	case GL_DEPTH_COMPONENT:
+	case GL_DEPTH_COMPONENT24:
+	case GL_DEPTH_COMPONENT32F:
+	case GL_DEPTH_STENCIL:
+	case GL_DEPTH24_STENCIL8:
+		return 4;
+	case GL_RGB16:
+	case GL_RGBA16:
+	case GL_RGB16F:
+	case GL_RGBA16F:
+	case GL_RG32F:
+	case GL_DEPTH32F_STENCIL8:
+		return 8;
+	case GL_RGB32F:
+	case GL_RGBA32F:
+		return 16;
+	default:
+		return 4;
+	}
+}
+
 /*
  * Gets the number of bytes needed to represent a single texel of the given format and type
  * @param format The format of the texel
@@ -0,0 +1,193 @@
+#include "TextureStreamer.h"
+
+#include <climits>
+#include <queue>
+#include "Logging.h"
+#include "GpuMemoryTracker.h"
+
+Texture2D::sptr TextureStreamer::LoadFromFile(const std::string& path) {
+	Texture2DData::sptr data = Texture2DData::LoadFromFile(path);
+	if (data == nullptr) {
+		return nullptr;
+	}
+
+	StreamedTexture entry;
+	entry.Mips.push_back(data);
+	while (entry.Mips.back()->GetWidth() > 1 || entry.Mips.back()->GetHeight() > 1) {
+		Texture2DData::sptr next = entry.Mips.back()->GenerateNextMip();
+		if (next == nullptr) {
+			break;
+		}
+		entry.Mips.push_back(next);
+	}
+
+	// Allocate storage for the whole mip chain, but don't upload anything yet
+	Texture2DDescription desc;
+	desc.Width = data->GetWidth();
+	desc.Height = data->GetHeight();
+	desc.Format = data->GetRecommendedFormat();
+	desc.GenerateMipMaps = true;
+	Texture2D::sptr result = Texture2D::Create(desc);
+	if (!data->DebugName.empty()) {
+		result->SetDebugName(data->DebugName);
+	}
+
+	// We can only stream mips that we have data for, anything past that is left as undefined
+	const int levels = glm::min(result->GetMipLevelCount(), (int)entry.Mips.size());
+	entry.BootMip = levels - 1;
+	while (entry.BootMip > 0 && glm::max(entry.Mips[entry.BootMip - 1]->GetWidth(), entry.Mips[entry.BootMip - 1]->GetHeight()) <= BootMipSize) {
+		entry.BootMip--;
+	}
+	for (int level = levels - 1; level >= entry.BootMip; level--) {
+		result->LoadMipData(level, entry.Mips[level]);
+		_residentBytes += _GetMipSize(entry, level);
+	}
+	result->SetBaseMipLevel(entry.BootMip);
+	// Make sure we never sample from levels that we don't have data for
+	glTextureParameteri(result->GetHandle(), GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+	entry.Texture = result;
+	entry.ResidentMip = entry.BootMip;
+	entry.RequestedMip = INT_MAX;
+	entry.LastRequested.resize(levels, 0);
+
+	// Only the resident mips count against our memory budget, and let the tracker take them back if needed
+	const ITexture* key = result.get();
+	GpuMemoryTracker::Instance().Resize(key, _GetResidentSize(entry));
+	GpuMemoryTracker::Instance().SetStreamable(key, [this, key]() { return _EvictToBoot(key); });
+
+	LOG_INFO("Streaming texture \"{}\" ({}x{}, {} mips, {} resident)", path, desc.Width, desc.Height, levels, levels - entry.BootMip);
+	_textures[result.get()] = std::move(entry);
+	return result;
+}
+
+void TextureStreamer::Request(const ITexture* texture, float uvPerPixel) {
+	auto it = _textures.find(texture);
+	if (it == _textures.end()) {
+		return;
+	}
+	StreamedTexture& entry = it->second;
+
+	// The number of texels we step across per pixel tells us which mip the sampler will pick
+	const float texelsPerPixel = uvPerPixel * (float)glm::max(entry.Mips[0]->GetWidth(), entry.Mips[0]->GetHeight());
+	const float mip = glm::log2(glm::max(texelsPerPixel, 1.0f)) + MipBias;
+	const int level = glm::clamp((int)glm::floor(mip), 0, entry.BootMip);
+
+	entry.RequestedMip = glm::min(entry.RequestedMip, level);
+	for (int ix = level; ix < (int)entry.LastRequested.size(); ix++) {
+		entry.LastRequested[ix] = _frame;
+	}
+}
+
+void TextureStreamer::Update() {
+	_frame++;
+	_uploadedBytes = 0;
+
+	// Candidates are ordered by how many mips they are missing, so the most blurry textures get served first
+	typedef std::pair<int, StreamedTexture*> Candidate;
+	std::priority_queue<Candidate> uploads;
+
+	for (auto it = _textures.begin(); it != _textures.end(); ) {
+		StreamedTexture& entry = it->second;
+		Texture2D::sptr texture = entry.Texture.lock();
+
+		// Drop textures that the rest of the game has released
+		if (texture == nullptr) {
+			for (int level = entry.ResidentMip; level < (int)entry.LastRequested.size(); level++) {
+				_residentBytes -= _GetMipSize(entry, level);
+			}
+			it = _textures.erase(it);
+			continue;
+		}
+
+		// Evict the finest resident mip if nothing has needed it in a while, one level per frame
+		if (entry.ResidentMip < entry.BootMip && _frame - entry.LastRequested[entry.ResidentMip] > EvictAfterFrames) {
+			const int level = entry.ResidentMip;
+			entry.ResidentMip++;
+			texture->SetBaseMipLevel(entry.ResidentMip);
+			// Let the driver know it can discard the contents of the evicted level
+			glInvalidateTexImage(texture->GetHandle(), level);
+			_residentBytes -= _GetMipSize(entry, level);
+			GpuMemoryTracker::Instance().Resize(it->first, _GetResidentSize(entry));
+		}
+
+		if (entry.RequestedMip < entry.ResidentMip) {
+			uploads.push(Candidate(entry.ResidentMip - entry.RequestedMip, &entry));
+		}
+		++it;
+	}
+
+	// Upload one mip at a time, always allowing at least one upload per frame so large mips can't starve
+	while (!uploads.empty()) {
+		Candidate candidate = uploads.top();
+		uploads.pop();
+		StreamedTexture& entry = *candidate.second;
+
+		const int level = entry.ResidentMip - 1;
+		const size_t size = _GetMipSize(entry, level);
+		if (_uploadedBytes > 0 && _uploadedBytes + size > UploadBudgetBytes) {
+			break;
+		}
+		// Don't stream in detail that would just push us over the memory budget, it would be evicted again next frame
+		if (!GpuMemoryTracker::Instance().CanAllocate(size)) {
+			continue;
+		}
+
+		Texture2D::sptr texture = entry.Texture.lock();
+		texture->LoadMipData(level, entry.Mips[level]);
+		texture->SetBaseMipLevel(level);
+		entry.ResidentMip = level;
+		_uploadedBytes += size;
+		_residentBytes += size;
+		GpuMemoryTracker::Instance().Resize(texture.get(), _GetResidentSize(entry));
+
+		if (entry.RequestedMip < entry.ResidentMip) {
+			uploads.push(Candidate(entry.ResidentMip - entry.RequestedMip, &entry));
+		}
+	}
+
+	for (auto& kvp : _textures) {
+		kvp.second.RequestedMip = INT_MAX;
+	}
+}
+
+void TextureStreamer::Clear() {
+	_textures.clear();
+	_residentBytes = 0;
+	_uploadedBytes = 0;
+}
+
+size_t TextureStreamer::_GetMipSize(const StreamedTexture& texture, int level) {
+	return texture.Mips[level]->GetDataSize();
+}
+
+size_t TextureStreamer::_GetResidentSize(const StreamedTexture& texture) {
+	size_t result = 0;
+	for (int level = texture.ResidentMip; level < (int)texture.LastRequested.size(); level++) {
+		result += _GetMipSize(texture, level);
+	}
+	return result;
+}
+
+size_t TextureStreamer::_EvictToBoot(const ITexture* key) {
+	auto it = _textures.find(key);
+	if (it == _textures.end()) {
+		return 0;
+	}
+	StreamedTexture& entry = it->second;
+	Texture2D::sptr texture = entry.Texture.lock();
+	if (texture == nullptr || entry.ResidentMip >= entry.BootMip) {
+		return 0;
+	}
+
+	size_t freed = 0;
+	for (int level = entry.ResidentMip; level < entry.BootMip; level++) {
+		glInvalidateTexImage(texture->GetHandle(), level);
+		freed += _GetMipSize(entry, level);
+	}
+	entry.ResidentMip = entry.BootMip;
+	texture->SetBaseMipLevel(entry.BootMip);
+	_residentBytes -= freed;
+	GpuMemoryTracker::Instance().Resize(key, _GetResidentSize(entry));
+	return freed;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "Texture2D.h"
+#include "Texture2DData.h"
+
+/// <summary>
+/// Streams mip levels of 2D textures into the GPU on demand. Streamed textures have their entire mip chain allocated,
+/// but only the smallest mips are uploaded when they are loaded. Each frame, the renderer reports how many texels per
+/// screen pixel each visible texture needs, and the streamer uploads finer mips within a per-frame byte budget. Mips
+/// that have not been needed for a while are evicted again.
+/// </summary>
+class TextureStreamer final
+{
+public:
+	static TextureStreamer& Instance() {
+		static TextureStreamer instance;
+		return instance;
+	}
+
+	/// <summary>
+	/// The maximum number of bytes that may be uploaded to the GPU in a single call to Update
+	/// </summary>
+	size_t UploadBudgetBytes = 4 * 1024 * 1024;
+	/// <summary>
+	/// Mips that are this size or smaller (along their largest axis) are uploaded when the texture is loaded
+	/// </summary>
+	uint32_t BootMipSize = 64;
+	/// <summary>
+	/// The number of frames that a mip level can go unrequested before it is evicted
+	/// </summary>
+	uint32_t EvictAfterFrames = 300;
+	/// <summary>
+	/// Bias added to the calculated mip level, positive values will stream in less detail
+	/// </summary>
+	float MipBias = 0.0f;
+
+	/// <summary>
+	/// Loads a texture from a file, and registers it for streaming. Only the lowest mips will be resident after loading
+	/// </summary>
+	/// <param name="path">The path of the image file to load</param>
+	/// <returns>The new texture, or nullptr if the image could not be loaded</returns>
+	Texture2D::sptr LoadFromFile(const std::string& path);
+
+	/// <summary>
+	/// Reports that a texture is visible this frame, with the given screen space density. Textures that are not
+	/// streamed are ignored, so this may be called for any texture
+	/// </summary>
+	/// <param name="texture">The texture that is being drawn</param>
+	/// <param name="uvPerPixel">The number of UV units covered by a single screen pixel (smaller values need more detail)</param>
+	void Request(const ITexture* texture, float uvPerPixel);
+
+	/// <summary>
+	/// Uploads requested mips within the upload budget, and evicts mips that have not been requested in a while. Should
+	/// be called once per frame, after all requests for the frame have been made
+	/// </summary>
+	void Update();
+
+	/// <summary>
+	/// Stops streaming all textures, and releases our CPU side copies of the image data
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Returns the number of texture bytes currently resident on the GPU for streamed textures
+	/// </summary>
+	size_t GetResidentBytes() const { return _residentBytes; }
+	/// <summary>
+	/// Returns the number of bytes that were uploaded during the last update
+	/// </summary>
+	size_t GetUploadedBytes() const { return _uploadedBytes; }
+	/// <summary>
+	/// Returns the number of textures being streamed
+	/// </summary>
+	size_t GetTextureCount() const { return _textures.size(); }
+
+private:
+	TextureStreamer() = default;
+
+	struct StreamedTexture
+	{
+		std::weak_ptr<Texture2D>         Texture;
+		// CPU side copies of every mip level, level 0 is the full resolution image
+		std::vector<Texture2DData::sptr> Mips;
+		// The finest mip level that is currently uploaded
+		int      ResidentMip;
+		// The finest mip level that was requested since the last update
+		int      RequestedMip;
+		// The coarsest mip that we never evict, and that was uploaded when loading
+		int      BootMip;
+		// The last frame that each mip level was requested on
+		std::vector<uint32_t> LastRequested;
+	};
+
+	std::unordered_map<const ITexture*, StreamedTexture> _textures;
+	uint32_t _frame = 0;
+	size_t   _residentBytes = 0;
+	size_t   _uploadedBytes = 0;
+
+	static size_t _GetMipSize(const StreamedTexture& texture, int level);
+	static size_t _GetResidentSize(const StreamedTexture& texture);
+	// Drops a texture back down to its boot mip, called by the memory tracker when we are over budget
+	size_t _EvictToBoot(const ITexture* key);
+};
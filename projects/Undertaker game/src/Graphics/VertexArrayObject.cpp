@@ -6,7 +6,10 @@
 VertexArrayObject::VertexArrayObject() :
 	_indexBuffer(nullptr),
 	_handle(0),
-	_vertexCount(0)
+	_vertexCount(0),
+	_boundsMin(glm::vec3(0.0f)),
+	_boundsMax(glm::vec3(0.0f)),
+	_uvDensity(1.0f)
 {
 	glCreateVertexArrays(1, &_handle);
 }
@@ -33,10 +36,14 @@ void VertexArrayObject::SetIndexBuffer(const IndexBuffer::sptr& ibo) {
 
 void VertexArrayObject::AddVertexBuffer(const VertexBuffer::sptr& buffer, const std::vector<BufferAttribute>& attributes)
 {
-	if (_vertexCount == 0) {
-		_vertexCount = buffer->GetElementCount();
-	} else {
-		LOG_ASSERT(buffer->GetElementCount() == _vertexCount, "All buffers bound to a VAO should be of the same size in our implementation!");
+	// Instance data doesn't line up with the vertices, so it doesn't have to match their count
+	const bool perInstance = !attributes.empty() && attributes[0].Divisor > 0;
+	if (!perInstance) {
+		if (_vertexCount == 0) {
+			_vertexCount = buffer->GetElementCount();
+		} else {
+			LOG_ASSERT(buffer->GetElementCount() == _vertexCount, "All buffers bound to a VAO should be of the same size in our implementation!");
+		}
 	}
 	VertexBufferBinding binding;
 	binding.Buffer = buffer;
@@ -48,6 +55,7 @@ void VertexArrayObject::AddVertexBuffer(const VertexBuffer::sptr& buffer, const
 	for (const BufferAttribute& attrib : attributes) {
 		glEnableVertexArrayAttrib(_handle, attrib.Slot);
 		glVertexAttribPointer(attrib.Slot, attrib.Size, attrib.Type, attrib.Normalized, attrib.Stride, (void*)attrib.Offset);
+		glVertexAttribDivisor(attrib.Slot, attrib.Divisor);
 	}
 	UnBind();
 
@@ -70,3 +78,21 @@ void VertexArrayObject::Render() const {
 	}
 	UnBind();
 }
+
+void VertexArrayObject::RenderRange(uint32_t firstIndex, uint32_t indexCount) const {
+	LOG_ASSERT(_indexBuffer != nullptr, "Can only render a range of an indexed mesh");
+	const size_t indexSize = _indexBuffer->GetElementType() == GL_UNSIGNED_BYTE ? 1 : (_indexBuffer->GetElementType() == GL_UNSIGNED_SHORT ? 2 : 4);
+	Bind();
+	glDrawElements(GL_TRIANGLES, indexCount, _indexBuffer->GetElementType(), reinterpret_cast<const void*>(firstIndex * indexSize));
+	UnBind();
+}
+
+void VertexArrayObject::RenderInstanced(uint32_t instanceCount, uint32_t baseInstance) const {
+	Bind();
+	if (_indexBuffer != nullptr) {
+		glDrawElementsInstancedBaseInstance(GL_TRIANGLES, _indexBuffer->GetElementCount(), _indexBuffer->GetElementType(), nullptr, instanceCount, baseInstance);
+	} else {
+		glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, _vertexCount, instanceCount, baseInstance);
+	}
+	UnBind();
+}
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <GLM/glm.hpp>
 
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
@@ -65,9 +66,13 @@ struct BufferAttribute
 	/// The approximate usage for this attribute, does not get passed to OpenGL at all
 	/// </summary>
 	AttribUsage Usage;
+	/// <summary>
+	/// How many instances to draw before moving to the next element, 0 for per vertex data
+	/// </summary>
+	GLuint  Divisor;
 
-	BufferAttribute(uint32_t slot, uint32_t size, GLenum type, bool normalized, GLsizei stride, size_t offset, AttribUsage usage = AttribUsage::Unknown) :
-		Slot(slot), Size(size), Type(type), Normalized(normalized), Stride(stride), Offset(offset), Usage(usage) { }
+	BufferAttribute(uint32_t slot, uint32_t size, GLenum type, bool normalized, GLsizei stride, size_t offset, AttribUsage usage = AttribUsage::Unknown, GLuint divisor = 0) :
+		Slot(slot), Size(size), Type(type), Normalized(normalized), Stride(stride), Offset(offset), Usage(usage), Divisor(divisor) { }
 };
 
 /// <summary>
@@ -111,7 +116,8 @@ public:
 	/// Adds a vertex buffer to this VAO, with the specified attributes
 	/// </summary>
 	/// <param name="buffer">The buffer to add (note, does not take ownership, you will still need to delete later)</param>
-	/// <param name="attributes">A list of vertex attributes that will be fed by this buffer</param>
+	/// <param name="attributes">A list of vertex attributes that will be fed by this buffer, if they have a divisor
+	/// the buffer holds per instance data, and can be any size</param>
 	void AddVertexBuffer(const VertexBuffer::sptr& buffer, const std::vector<BufferAttribute>& attributes);
 
 	/// <summary>
@@ -128,7 +134,54 @@ public:
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
 
+	/// <summary>
+	/// Gets the index buffer bound to this VAO, or nullptr if it draws its vertices in order
+	/// </summary>
+	const IndexBuffer::sptr& GetIndexBuffer() const { return _indexBuffer; }
+	/// <summary>
+	/// Gets the number of vertices in this VAO's vertex buffers
+	/// </summary>
+	GLsizei GetVertexCount() const { return _vertexCount; }
+
+	/// <summary>
+	/// Sets the local space bounding box of the geometry in this VAO, used for culling
+	/// </summary>
+	/// <param name="min">The minimum corner of the bounding box</param>
+	/// <param name="max">The maximum corner of the bounding box</param>
+	void SetBounds(const glm::vec3& min, const glm::vec3& max) { _boundsMin = min; _boundsMax = max; }
+	/// <summary>
+	/// Gets the minimum corner of the local space bounding box
+	/// </summary>
+	const glm::vec3& GetBoundsMin() const { return _boundsMin; }
+	/// <summary>
+	/// Gets the maximum corner of the local space bounding box
+	/// </summary>
+	const glm::vec3& GetBoundsMax() const { return _boundsMax; }
+
+	/// <summary>
+	/// Sets the average number of UV units per local space unit across the surface of this mesh. Multiplying this by
+	/// a texture's size gives us the number of texels per world unit, which drives texture streaming
+	/// </summary>
+	void SetUvDensity(float density) { _uvDensity = density; }
+	/// <summary>
+	/// Gets the average number of UV units per local space unit across the surface of this mesh
+	/// </summary>
+	float GetUvDensity() const { return _uvDensity; }
+
 	void Render() const;
+	/// <summary>
+	/// Draws part of the index buffer, for meshes that are laid out in sections (ex: the terrain's grid, which can be
+	/// drawn a quarter at a time)
+	/// </summary>
+	/// <param name="firstIndex">The first index to draw</param>
+	/// <param name="indexCount">The number of indices to draw</param>
+	void RenderRange(uint32_t firstIndex, uint32_t indexCount) const;
+	/// <summary>
+	/// Draws the mesh many times in one call, with per instance data coming from buffers added with a divisor
+	/// </summary>
+	/// <param name="instanceCount">The number of copies to draw</param>
+	/// <param name="baseInstance">The first element of the instance buffers to read from</param>
+	void RenderInstanced(uint32_t instanceCount, uint32_t baseInstance = 0) const;
 	
 protected:
 	// Helper structure to store a buffer and the attributes
@@ -144,6 +197,10 @@ protected:
 	std::vector<VertexBufferBinding> _vertexBuffers;
 
 	GLsizei _vertexCount;
+
+	glm::vec3 _boundsMin;
+	glm::vec3 _boundsMax;
+	float     _uvDensity;
 	
 	// The underlying OpenGL handle that this class is wrapping around
 	GLuint _handle;
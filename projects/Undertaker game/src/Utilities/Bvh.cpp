@@ -0,0 +1,272 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <numeric>
+
+#include "Logging.h"
+
+// The number of buckets we sort centroids into when looking for the cheapest split
+static const int BIN_COUNT = 12;
+// Deep enough for any tree we'll build, each level of the tree can leave at most one node waiting on the stack
+static const int TRAVERSAL_STACK_SIZE = 128;
+
+namespace {
+	struct BuildTriangle
+	{
+		glm::vec3 Min;
+		glm::vec3 Max;
+		glm::vec3 Centroid;
+	};
+
+	struct Bin
+	{
+		glm::vec3 Min = glm::vec3(FLT_MAX);
+		glm::vec3 Max = glm::vec3(-FLT_MAX);
+		uint32_t  Count = 0;
+	};
+}
+
+static float SurfaceArea(const glm::vec3& min, const glm::vec3& max) {
+	const glm::vec3 extents = glm::max(max - min, glm::vec3(0.0f));
+	return 2.0f * (extents.x * extents.y + extents.y * extents.z + extents.z * extents.x);
+}
+
+// Gets the distance along a ray that it enters a box, or FLT_MAX if it misses it (or only hits it past maxDistance)
+static float BoxEntry(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance) {
+	const glm::vec3 t0 = (min - origin) * invDirection;
+	const glm::vec3 t1 = (max - origin) * invDirection;
+	const glm::vec3 tMin = glm::min(t0, t1);
+	const glm::vec3 tMax = glm::max(t0, t1);
+	const float enter = glm::max(glm::max(tMin.x, tMin.y), glm::max(tMin.z, 0.0f));
+	const float exit = glm::min(glm::min(tMax.x, tMax.y), glm::min(tMax.z, maxDistance));
+	return enter <= exit ? enter : FLT_MAX;
+}
+
+// Moller-Trumbore ray/triangle intersection, hits from either side
+static bool IntersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3* corners, float& t, float& u, float& v) {
+	const glm::vec3 edge1 = corners[1] - corners[0];
+	const glm::vec3 edge2 = corners[2] - corners[0];
+	const glm::vec3 p = glm::cross(direction, edge2);
+	const float det = glm::dot(edge1, p);
+	if (glm::abs(det) < 1e-12f) {
+		return false;
+	}
+	const float invDet = 1.0f / det;
+	const glm::vec3 s = origin - corners[0];
+	u = glm::dot(s, p) * invDet;
+	if (u < 0.0f || u > 1.0f) {
+		return false;
+	}
+	const glm::vec3 q = glm::cross(s, edge1);
+	v = glm::dot(direction, q) * invDet;
+	if (v < 0.0f || u + v > 1.0f) {
+		return false;
+	}
+	t = glm::dot(edge2, q) * invDet;
+	return t > 0.0f;
+}
+
+void TriangleBvh::Build(const std::vector<glm::vec3>& corners) {
+	LOG_ASSERT(corners.size() % 3 == 0, "Triangle corners must come in sets of 3, got {}", corners.size());
+	const uint32_t triCount = (uint32_t)(corners.size() / 3);
+
+	_nodes.clear();
+	_corners.clear();
+	_triangleIds.resize(triCount);
+	std::iota(_triangleIds.begin(), _triangleIds.end(), 0u);
+	if (triCount == 0) {
+		return;
+	}
+
+	std::vector<BuildTriangle> triangles(triCount);
+	for (uint32_t ix = 0; ix < triCount; ix++) {
+		const glm::vec3& a = corners[ix * 3];
+		const glm::vec3& b = corners[ix * 3 + 1];
+		const glm::vec3& c = corners[ix * 3 + 2];
+		triangles[ix].Min = glm::min(a, glm::min(b, c));
+		triangles[ix].Max = glm::max(a, glm::max(b, c));
+		triangles[ix].Centroid = (a + b + c) / 3.0f;
+	}
+
+	_nodes.reserve((size_t)triCount * 2);
+	_nodes.push_back({ glm::vec3(0.0f), 0, glm::vec3(0.0f), triCount });
+
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty()) {
+		const uint32_t nodeIx = stack.back();
+		stack.pop_back();
+		const uint32_t first = _nodes[nodeIx].First;
+		const uint32_t count = _nodes[nodeIx].Count;
+
+		glm::vec3 min(FLT_MAX), max(-FLT_MAX), centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+		for (uint32_t ix = first; ix < first + count; ix++) {
+			const BuildTriangle& tri = triangles[_triangleIds[ix]];
+			min = glm::min(min, tri.Min);
+			max = glm::max(max, tri.Max);
+			centroidMin = glm::min(centroidMin, tri.Centroid);
+			centroidMax = glm::max(centroidMax, tri.Centroid);
+		}
+		_nodes[nodeIx].Min = min;
+		_nodes[nodeIx].Max = max;
+		if (count <= MAX_LEAF_SIZE) {
+			continue;
+		}
+
+		// Bin the centroids along each axis, and find the split with the lowest surface area cost
+		int   bestAxis = -1;
+		float bestSplit = 0.0f;
+		float bestCost = FLT_MAX;
+		for (int axis = 0; axis < 3; axis++) {
+			const float extent = centroidMax[axis] - centroidMin[axis];
+			if (extent <= 0.0f) {
+				continue;
+			}
+			const float scale = BIN_COUNT / extent;
+			Bin bins[BIN_COUNT];
+			for (uint32_t ix = first; ix < first + count; ix++) {
+				const BuildTriangle& tri = triangles[_triangleIds[ix]];
+				const int bin = glm::min((int)((tri.Centroid[axis] - centroidMin[axis]) * scale), BIN_COUNT - 1);
+				bins[bin].Min = glm::min(bins[bin].Min, tri.Min);
+				bins[bin].Max = glm::max(bins[bin].Max, tri.Max);
+				bins[bin].Count++;
+			}
+
+			// Sweep from both ends, so every split can be costed in one pass
+			float    leftArea[BIN_COUNT - 1], rightArea[BIN_COUNT - 1];
+			uint32_t leftCount[BIN_COUNT - 1], rightCount[BIN_COUNT - 1];
+			Bin left, right;
+			for (int ix = 0; ix < BIN_COUNT - 1; ix++) {
+				left.Min = glm::min(left.Min, bins[ix].Min);
+				left.Max = glm::max(left.Max, bins[ix].Max);
+				left.Count += bins[ix].Count;
+				leftArea[ix] = SurfaceArea(left.Min, left.Max);
+				leftCount[ix] = left.Count;
+
+				const int rightIx = BIN_COUNT - 1 - ix;
+				right.Min = glm::min(right.Min, bins[rightIx].Min);
+				right.Max = glm::max(right.Max, bins[rightIx].Max);
+				right.Count += bins[rightIx].Count;
+				rightArea[rightIx - 1] = SurfaceArea(right.Min, right.Max);
+				rightCount[rightIx - 1] = right.Count;
+			}
+			for (int ix = 0; ix < BIN_COUNT - 1; ix++) {
+				if (leftCount[ix] == 0 || rightCount[ix] == 0) {
+					continue;
+				}
+				const float cost = leftCount[ix] * leftArea[ix] + rightCount[ix] * rightArea[ix];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = centroidMin[axis] + (ix + 1) / scale;
+				}
+			}
+		}
+
+		// Every centroid is in the same place, there's no way to split these
+		if (bestAxis == -1) {
+			continue;
+		}
+		// Only stop early if the node is small, otherwise a bad split is still better than a huge leaf
+		if (bestCost >= count * SurfaceArea(min, max) && count <= MAX_LEAF_SIZE * 4) {
+			continue;
+		}
+
+		uint32_t* begin = _triangleIds.data() + first;
+		uint32_t* middle = std::partition(begin, begin + count, [&](uint32_t tri) {
+			return triangles[tri].Centroid[bestAxis] < bestSplit;
+		});
+		uint32_t leftCount = (uint32_t)(middle - begin);
+		if (leftCount == 0 || leftCount == count) {
+			// Floating point put everything on one side, fall back to splitting at the median
+			leftCount = count / 2;
+			std::nth_element(begin, begin + leftCount, begin + count, [&](uint32_t a, uint32_t b) {
+				return triangles[a].Centroid[bestAxis] < triangles[b].Centroid[bestAxis];
+			});
+		}
+
+		const uint32_t leftIx = (uint32_t)_nodes.size();
+		_nodes.push_back({ glm::vec3(0.0f), first, glm::vec3(0.0f), leftCount });
+		_nodes.push_back({ glm::vec3(0.0f), first + leftCount, glm::vec3(0.0f), count - leftCount });
+		_nodes[nodeIx].First = leftIx;
+		_nodes[nodeIx].Count = 0;
+		stack.push_back(leftIx);
+		stack.push_back(leftIx + 1);
+	}
+
+	// Store the corners in leaf order, so each leaf reads one contiguous block
+	_corners.resize(corners.size());
+	for (uint32_t ix = 0; ix < triCount; ix++) {
+		const uint32_t source = _triangleIds[ix];
+		_corners[ix * 3] = corners[source * 3];
+		_corners[ix * 3 + 1] = corners[source * 3 + 1];
+		_corners[ix * 3 + 2] = corners[source * 3 + 2];
+	}
+}
+
+bool TriangleBvh::Intersect(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Hit& hit) const {
+	return _Trace<false>(origin, direction, maxDistance, &hit);
+}
+
+bool TriangleBvh::IsOccluded(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const {
+	return _Trace<true>(origin, direction, maxDistance, nullptr);
+}
+
+template <bool AnyHit>
+bool TriangleBvh::_Trace(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Hit* hit) const {
+	if (_nodes.empty()) {
+		return false;
+	}
+
+	// Avoid dividing by zero, a tiny component behaves the same as a zero one for the slab test
+	glm::vec3 invDirection;
+	for (int axis = 0; axis < 3; axis++) {
+		const float d = direction[axis];
+		invDirection[axis] = 1.0f / (glm::abs(d) > 1e-12f ? d : (d < 0.0f ? -1e-12f : 1e-12f));
+	}
+
+	float closest = maxDistance;
+	bool found = false;
+	uint32_t stack[TRAVERSAL_STACK_SIZE];
+	int top = 0;
+	if (BoxEntry(_nodes[0].Min, _nodes[0].Max, origin, invDirection, closest) != FLT_MAX) {
+		stack[top++] = 0;
+	}
+
+	while (top > 0) {
+		const Node& node = _nodes[stack[--top]];
+		if (node.Count > 0) {
+			for (uint32_t ix = node.First; ix < node.First + node.Count; ix++) {
+				float t, u, v;
+				if (IntersectTriangle(origin, direction, &_corners[(size_t)ix * 3], t, u, v) && t < closest) {
+					if constexpr (AnyHit) {
+						return true;
+					}
+					closest = t;
+					found = true;
+					hit->Distance = t;
+					hit->Triangle = _triangleIds[ix];
+					hit->U = u;
+					hit->V = v;
+				}
+			}
+		} else {
+			// Visit the nearer child first, so the closest hit shrinks the search as early as possible
+			uint32_t nearIx = node.First, farIx = node.First + 1;
+			float nearEntry = BoxEntry(_nodes[nearIx].Min, _nodes[nearIx].Max, origin, invDirection, closest);
+			float farEntry = BoxEntry(_nodes[farIx].Min, _nodes[farIx].Max, origin, invDirection, closest);
+			if (farEntry < nearEntry) {
+				std::swap(nearIx, farIx);
+				std::swap(nearEntry, farEntry);
+			}
+			LOG_ASSERT(top + 2 <= TRAVERSAL_STACK_SIZE, "BVH is too deep to traverse");
+			if (farEntry != FLT_MAX) {
+				stack[top++] = farIx;
+			}
+			if (nearEntry != FLT_MAX) {
+				stack[top++] = nearIx;
+			}
+		}
+	}
+	return found;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// A bounding volume hierarchy over a list of triangles, for tracing rays against static geometry on the CPU. The
+/// tree is built once with the surface area heuristic, and is read only afterwards, so any number of threads can trace
+/// against it at the same time
+/// </summary>
+class TriangleBvh final
+{
+public:
+	/// <summary>
+	/// The closest intersection along a ray
+	/// </summary>
+	struct Hit
+	{
+		float    Distance = 0.0f;
+		// The index of the triangle that was hit, in the order they were given to Build
+		uint32_t Triangle = 0;
+		// The barycentric coordinates of the hit, relative to the triangle's second and third corners
+		float    U = 0.0f;
+		float    V = 0.0f;
+	};
+
+	/// <summary>
+	/// The most triangles we leave in a single leaf
+	/// </summary>
+	static constexpr uint32_t MAX_LEAF_SIZE = 4;
+
+	TriangleBvh() = default;
+	~TriangleBvh() = default;
+
+	/// <summary>
+	/// Builds the tree, replacing any existing one
+	/// </summary>
+	/// <param name="corners">The corners of every triangle, 3 per triangle</param>
+	void Build(const std::vector<glm::vec3>& corners);
+
+	/// <summary>
+	/// Finds the closest triangle along a ray
+	/// </summary>
+	/// <param name="origin">The start of the ray</param>
+	/// <param name="direction">The normalized direction of the ray</param>
+	/// <param name="maxDistance">The furthest along the ray to look</param>
+	/// <param name="hit">Receives the closest hit, if there was one</param>
+	/// <returns>True if anything was hit</returns>
+	bool Intersect(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Hit& hit) const;
+
+	/// <summary>
+	/// Checks if there is anything along a ray, this is cheaper than Intersect since it stops at the first hit
+	/// </summary>
+	bool IsOccluded(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+
+	size_t GetTriangleCount() const { return _triangleIds.size(); }
+	size_t GetNodeCount() const { return _nodes.size(); }
+
+private:
+	// Leaves have a Count above zero and store their triangles from First, inner nodes store their left child in First,
+	// with the right child directly after it
+	struct Node
+	{
+		glm::vec3 Min;
+		uint32_t  First;
+		glm::vec3 Max;
+		uint32_t  Count;
+	};
+
+	// Triangle corners, in leaf order
+	std::vector<glm::vec3> _corners;
+	// The original index of each triangle, in leaf order
+	std::vector<uint32_t>  _triangleIds;
+	std::vector<Node>      _nodes;
+
+	template <bool AnyHit>
+	bool _Trace(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Hit* hit) const;
+};
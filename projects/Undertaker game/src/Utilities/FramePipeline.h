@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+/// <summary>
+/// Hands frame packets from a producer thread (the game simulation) to a consumer thread (the renderer), so one frame
+/// can be simulated while the last one is drawn. Packets live in a small ring of slots and are reused, so nothing is
+/// allocated per frame.
+///
+/// Every packet is consumed, in order, and the producer waits when the ring is full. This keeps the simulation in step
+/// with the renderer (the game's simulation runs in fixed steps per frame, so it can't drop frames), and bounds how far
+/// ahead of what's on screen it can get to SlotCount - 1 frames
+/// </summary>
+/// <typeparam name="Packet">The type of data handed over each frame, this is reused, so it should be fully overwritten by each frame</typeparam>
+/// <typeparam name="SlotCount">The number of packets in the ring, 3 lets one be drawn, one wait, and one be written</typeparam>
+template <typename Packet, size_t SlotCount = 3>
+class FramePipeline final
+{
+public:
+	static_assert(SlotCount >= 2, "The producer and consumer each need a slot of their own");
+
+	FramePipeline() = default;
+	~FramePipeline() = default;
+
+	FramePipeline(const FramePipeline& other) = delete;
+	FramePipeline& operator=(const FramePipeline& other) = delete;
+
+	/// <summary>
+	/// Gets the next packet to write into, waiting for the consumer to free one up if the ring is full. Only the
+	/// producer thread should call this
+	/// </summary>
+	/// <returns>The packet to fill in, or nullptr if the pipeline was stopped</returns>
+	Packet* BeginWrite() {
+		std::unique_lock<std::mutex> lock(_lock);
+		const auto start = std::chrono::high_resolution_clock::now();
+		_changed.wait(lock, [this]() { return _stopped || _inUse < SlotCount; });
+		_writeWaitMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return _stopped ? nullptr : &_slots[_writeIx];
+	}
+	/// <summary>
+	/// Hands the packet from BeginWrite to the consumer, it must not be touched again after this
+	/// </summary>
+	void EndWrite() {
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_writeIx = (_writeIx + 1) % SlotCount;
+			_inUse++;
+			_ready++;
+		}
+		_changed.notify_all();
+	}
+
+	/// <summary>
+	/// Gets the oldest packet that hasn't been read yet, waiting for the producer if there isn't one. Only the consumer
+	/// thread should call this
+	/// </summary>
+	/// <returns>The packet to read, or nullptr if the pipeline was stopped</returns>
+	const Packet* BeginRead() {
+		std::unique_lock<std::mutex> lock(_lock);
+		const auto start = std::chrono::high_resolution_clock::now();
+		_changed.wait(lock, [this]() { return _stopped || _ready > 0; });
+		_readWaitMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if (_stopped) {
+			return nullptr;
+		}
+		_ready--;
+		return &_slots[_readIx];
+	}
+	/// <summary>
+	/// Gives the packet from BeginRead back to the producer, once nothing is reading from it anymore
+	/// </summary>
+	void EndRead() {
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_readIx = (_readIx + 1) % SlotCount;
+			_inUse--;
+		}
+		_changed.notify_all();
+	}
+
+	/// <summary>
+	/// Wakes up both threads, and makes every call to BeginWrite and BeginRead from now on return nullptr
+	/// </summary>
+	void Stop() {
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_stopped = true;
+		}
+		_changed.notify_all();
+	}
+
+	/// <summary>
+	/// Gets how long the producer waited for a free slot the last time it asked for one. A producer that is always
+	/// waiting is faster than the consumer
+	/// </summary>
+	float GetWriteWaitMs() const { std::lock_guard<std::mutex> lock(_lock); return _writeWaitMs; }
+	/// <summary>
+	/// Gets how long the consumer waited for a packet the last time it asked for one. A consumer that is always waiting
+	/// is faster than the producer
+	/// </summary>
+	float GetReadWaitMs() const { std::lock_guard<std::mutex> lock(_lock); return _readWaitMs; }
+	/// <summary>
+	/// Gets the number of packets that are written and waiting to be read
+	/// </summary>
+	size_t GetReadyCount() const { std::lock_guard<std::mutex> lock(_lock); return _ready; }
+
+private:
+	std::array<Packet, SlotCount> _slots;
+
+	mutable std::mutex      _lock;
+	std::condition_variable _changed;
+
+	size_t _writeIx = 0;
+	size_t _readIx = 0;
+	// Packets that are written and waiting, and packets that are written and not yet given back (waiting or being read)
+	size_t _ready = 0;
+	size_t _inUse = 0;
+	bool   _stopped = false;
+
+	float _writeWaitMs = 0.0f;
+	float _readWaitMs = 0.0f;
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// Represents the 6 planes of a camera's view volume, extracted from a view-projection matrix. Used to cull
+/// objects that are entirely off screen before we submit them
+/// </summary>
+struct Frustum
+{
+	// Planes are stored as (normal, distance), with the normals pointing into the view volume
+	glm::vec4 Planes[6];
+
+	Frustum() : Planes() { }
+	/// <summary>
+	/// Extracts the frustum planes from a view projection matrix (Gribb & Hartmann)
+	/// </summary>
+	/// <param name="viewProjection">The combined view and projection matrix of the camera</param>
+	explicit Frustum(const glm::mat4& viewProjection) {
+		const glm::mat4 m = glm::transpose(viewProjection);
+		Planes[0] = m[3] + m[0]; // Left
+		Planes[1] = m[3] - m[0]; // Right
+		Planes[2] = m[3] + m[1]; // Bottom
+		Planes[3] = m[3] - m[1]; // Top
+		Planes[4] = m[3] + m[2]; // Near
+		Planes[5] = m[3] - m[2]; // Far
+		for (glm::vec4& plane : Planes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+	}
+
+	/// <summary>
+	/// Tests whether a world space sphere is at least partially inside the frustum
+	/// </summary>
+	/// <param name="center">The center of the sphere, in world space</param>
+	/// <param name="radius">The radius of the sphere</param>
+	/// <returns>True if the sphere may be visible, false if it is entirely outside</returns>
+	bool TestSphere(const glm::vec3& center, float radius) const {
+		for (const glm::vec4& plane : Planes) {
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Tests whether a world space axis aligned box is at least partially inside the frustum. Tighter than a sphere
+	/// for flat boxes, like the chunks of a terrain
+	/// </summary>
+	/// <param name="min">The minimum corner of the box, in world space</param>
+	/// <param name="max">The maximum corner of the box, in world space</param>
+	/// <returns>True if the box may be visible, false if it is entirely outside</returns>
+	bool TestBox(const glm::vec3& min, const glm::vec3& max) const {
+		for (const glm::vec4& plane : Planes) {
+			// Only the corner furthest along the plane's normal matters
+			const glm::vec3 corner = glm::mix(min, max, glm::greaterThan(glm::vec3(plane), glm::vec3(0.0f)));
+			if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Calculates a world space bounding sphere for a local space bounding box under a transform
+	/// </summary>
+	/// <param name="min">The minimum corner of the local bounding box</param>
+	/// <param name="max">The maximum corner of the local bounding box</param>
+	/// <param name="transform">The local to world transformation matrix</param>
+	/// <param name="outCenter">Receives the world space center of the sphere</param>
+	/// <returns>The radius of the world space sphere</returns>
+	static float BoundingSphere(const glm::vec3& min, const glm::vec3& max, const glm::mat4& transform, glm::vec3& outCenter) {
+		outCenter = glm::vec3(transform * glm::vec4((min + max) * 0.5f, 1.0f));
+		// Use the largest axis scale so that non-uniformly scaled objects stay conservative
+		const float scale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+		return glm::length(max - min) * 0.5f * scale;
+	}
+};
@@ -0,0 +1,96 @@
+#include "Heightmap.h"
+
+#include <stb_image.h>
+
+#include "Logging.h"
+
+Heightmap::sptr Heightmap::LoadFromFile(const std::string& path) {
+	// Flip like Texture2DData does, so the heightmap lines up with images drawn over it (ex: the splat map)
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load(true);
+	uint16_t* data = stbi_load_16(path.c_str(), &width, &height, &channels, 1);
+	if (data == nullptr) {
+		LOG_WARN("STBI Failed to load heightmap from \"{}\"", path);
+		return nullptr;
+	}
+	if (width < 2 || height < 2) {
+		LOG_WARN("Heightmap \"{}\" needs at least 2x2 samples", path);
+		stbi_image_free(data);
+		return nullptr;
+	}
+
+	Heightmap::sptr result = std::make_shared<Heightmap>();
+	result->_width = width;
+	result->_height = height;
+	result->_samples.assign(data, data + (size_t)width * height);
+	stbi_image_free(data);
+	return result;
+}
+
+float Heightmap::Sample(const glm::vec2& uv) const {
+	const glm::vec2 point = glm::clamp(uv, 0.0f, 1.0f) * glm::vec2(_width - 1, _height - 1);
+	const glm::ivec2 base = glm::min(glm::ivec2(point), glm::ivec2(_width - 2, _height - 2));
+	const glm::vec2 t = point - glm::vec2(base);
+	// Follow the same triangles as BuildMesh, so points we sample are exactly on the mesh
+	if (t.x + t.y <= 1.0f) {
+		const float a = GetSample(base.x, base.y);
+		return a + (GetSample(base.x + 1, base.y) - a) * t.x + (GetSample(base.x, base.y + 1) - a) * t.y;
+	} else {
+		const float d = GetSample(base.x + 1, base.y + 1);
+		return d + (GetSample(base.x, base.y + 1) - d) * (1.0f - t.x) + (GetSample(base.x + 1, base.y) - d) * (1.0f - t.y);
+	}
+}
+
+glm::vec3 Heightmap::SampleNormal(const glm::vec2& uv, const glm::vec3& scale) const {
+	// Central differences, one sample either side
+	const glm::vec2 texel(1.0f / (_width - 1), 1.0f / (_height - 1));
+	const float dx = (Sample(uv + glm::vec2(texel.x, 0.0f)) - Sample(uv - glm::vec2(texel.x, 0.0f))) * scale.y;
+	const float dz = (Sample(uv + glm::vec2(0.0f, texel.y)) - Sample(uv - glm::vec2(0.0f, texel.y))) * scale.y;
+	return glm::normalize(glm::vec3(-dx / (2.0f * texel.x * scale.x), 1.0f, -dz / (2.0f * texel.y * scale.z)));
+}
+
+glm::vec2 Heightmap::GetRange(const glm::vec2& uvMin, const glm::vec2& uvMax) const {
+	// Take every sample the region touches, bilinear filtering never goes outside of them
+	const glm::vec2 last(_width - 1, _height - 1);
+	const glm::ivec2 min = glm::ivec2(glm::floor(glm::clamp(uvMin, 0.0f, 1.0f) * last));
+	const glm::ivec2 max = glm::ivec2(glm::ceil(glm::clamp(uvMax, 0.0f, 1.0f) * last));
+	uint16_t low = UINT16_MAX, high = 0;
+	for (int y = min.y; y <= max.y; y++) {
+		for (int x = min.x; x <= max.x; x++) {
+			const uint16_t sample = _samples[(size_t)y * _width + x];
+			low = glm::min(low, sample);
+			high = glm::max(high, sample);
+		}
+	}
+	return glm::vec2(low, high) * (1.0f / 65535.0f);
+}
+
+MeshBuilder<VertexPosNormTexCol> Heightmap::BuildMesh(uint32_t step, const glm::vec2& uvScale, const glm::vec3& scale) const {
+	step = glm::max(step, 1u);
+	const uint32_t columns = (_width - 1 + step - 1) / step + 1;
+	const uint32_t rows = (_height - 1 + step - 1) / step + 1;
+
+	MeshBuilder<VertexPosNormTexCol> mesh;
+	mesh.ReserveVertexSpace((size_t)columns * rows);
+	mesh.ReserveIndexSpace((size_t)(columns - 1) * (rows - 1) * 6);
+	for (uint32_t row = 0; row < rows; row++) {
+		for (uint32_t column = 0; column < columns; column++) {
+			// The last row and column always land on the edge, even if the step doesn't divide the size evenly
+			const glm::vec2 uv(glm::min(column * step, _width - 1) / (float)(_width - 1), glm::min(row * step, _height - 1) / (float)(_height - 1));
+			const glm::vec3 normal = SampleNormal(uv, scale);
+			// The mesh gets scaled to size, so undo that on the normal so the normal matrix puts it back
+			mesh.AddVertex(glm::vec3(uv.x, Sample(uv), uv.y), glm::normalize(normal * scale), uv * uvScale, glm::vec4(1.0f));
+		}
+	}
+	for (uint32_t row = 0; row + 1 < rows; row++) {
+		for (uint32_t column = 0; column + 1 < columns; column++) {
+			const uint32_t a = row * columns + column;
+			const uint32_t b = a + 1;
+			const uint32_t c = a + columns;
+			const uint32_t d = c + 1;
+			mesh.AddIndexTri(a, c, b);
+			mesh.AddIndexTri(b, c, d);
+		}
+	}
+	return mesh;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "MeshBuilder.h"
+#include "VertexTypes.h"
+
+/// <summary>
+/// A grid of heights loaded from a greyscale image, kept on the CPU so that the terrain can work out the bounds of its
+/// chunks, and the LightmapBaker can trace against it, without touching the GPU.
+///
+/// Heights are in the 0-1 range, and samples sit on the corners of the grid: (0, 0) is the first sample and (1, 1) the
+/// last, so a 2^n+1 image splits evenly into chunks that share their edge samples. Like our other images, the bottom
+/// row of the image is at v = 0
+/// </summary>
+class Heightmap final
+{
+public:
+	typedef std::shared_ptr<Heightmap> sptr;
+
+	Heightmap() = default;
+	~Heightmap() = default;
+
+	Heightmap(const Heightmap& other) = delete;
+	Heightmap& operator=(const Heightmap& other) = delete;
+
+	/// <summary>
+	/// Loads a heightmap from an 8 or 16 bit greyscale image, 16 bits per sample is strongly recommended since 8 bits
+	/// leaves visible steps on gentle slopes
+	/// </summary>
+	/// <param name="path">The path of the image to load</param>
+	/// <returns>The heightmap, or nullptr if the image could not be loaded</returns>
+	static sptr LoadFromFile(const std::string& path);
+
+	uint32_t GetWidth() const { return _width; }
+	uint32_t GetHeight() const { return _height; }
+	/// <summary>
+	/// Gets the raw samples, row by row from v = 0, for uploading to the GPU
+	/// </summary>
+	const std::vector<uint16_t>& GetSamples() const { return _samples; }
+
+	/// <summary>
+	/// Gets the height of a single sample, clamped to the edge of the grid
+	/// </summary>
+	float GetSample(int x, int y) const {
+		x = glm::clamp(x, 0, (int)_width - 1);
+		y = glm::clamp(y, 0, (int)_height - 1);
+		return _samples[(size_t)y * _width + x] * (1.0f / 65535.0f);
+	}
+
+	/// <summary>
+	/// Gets the height at a point, blending between the closest samples along the triangles of BuildMesh
+	/// </summary>
+	/// <param name="uv">The point to sample, from (0, 0) to (1, 1)</param>
+	float Sample(const glm::vec2& uv) const;
+
+	/// <summary>
+	/// Gets the surface normal at a point, once the heightmap is stretched over an area
+	/// </summary>
+	/// <param name="uv">The point to sample, from (0, 0) to (1, 1)</param>
+	/// <param name="scale">The size of the area along X and Z, and the height of a sample of 1 along Y</param>
+	glm::vec3 SampleNormal(const glm::vec2& uv, const glm::vec3& scale) const;
+
+	/// <summary>
+	/// Finds the lowest and highest samples in a region, for building bounding boxes
+	/// </summary>
+	/// <param name="uvMin">The corner of the region closest to (0, 0)</param>
+	/// <param name="uvMax">The corner of the region closest to (1, 1)</param>
+	/// <returns>The lowest height in X, and the highest in Y</returns>
+	glm::vec2 GetRange(const glm::vec2& uvMin, const glm::vec2& uvMax) const;
+
+	/// <summary>
+	/// Builds a mesh of the heightmap in the unit cube, with one vertex every few samples. Scaling it by the size of
+	/// the terrain (and the height along Y) puts it in place
+	/// </summary>
+	/// <param name="step">How many samples apart to put the vertices, 1 to use every sample</param>
+	/// <param name="uvScale">How many times to repeat the UVs across the mesh</param>
+	/// <param name="scale">The size the mesh will be scaled to, which the normals need to account for</param>
+	MeshBuilder<VertexPosNormTexCol> BuildMesh(uint32_t step, const glm::vec2& uvScale, const glm::vec3& scale) const;
+
+private:
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	std::vector<uint16_t> _samples;
+};
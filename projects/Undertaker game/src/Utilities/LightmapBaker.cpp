@@ -0,0 +1,856 @@
+#include "LightmapBaker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <json.hpp>
+#include <GLM/gtc/constants.hpp>
+#include <GLM/gtc/packing.hpp>
+
+#include "Logging.h"
+#include "Bvh.h"
+#include "ObjLoader.h"
+#include "SphericalHarmonics.h"
+#include "Gameplay/Transform.h"
+#include "Graphics/IrradianceVolume.h"
+#include "Graphics/Lightmap.h"
+
+// How far to push rays off of surfaces, so they don't hit the triangle they started on
+static const float RAY_OFFSET = 0.01f;
+// How many rays each probe sends towards the sun to find out how shadowed it is
+static const uint32_t SUN_SAMPLES_PER_PROBE = 32;
+
+namespace {
+	// A small, fast random number generator (PCG32), each texel gets its own so results don't depend on threading
+	struct Random
+	{
+		uint64_t State;
+
+		explicit Random(uint64_t seed) : State(seed + 1442695040888963407ull) { Next(); }
+
+		uint32_t Next() {
+			const uint64_t old = State;
+			State = old * 6364136223846793005ull + 1442695040888963407ull;
+			const uint32_t xorShifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+			const uint32_t rotation = (uint32_t)(old >> 59u);
+			return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+		}
+		// A float in [0, 1)
+		float NextFloat() {
+			return (Next() >> 8) * (1.0f / 16777216.0f);
+		}
+	};
+
+	// A group of connected triangles that face along the same axis, flattened onto that axis' plane
+	struct Chart
+	{
+		std::vector<uint32_t> Triangles;
+		int        Axis = 0;
+		// The bounds of the flattened chart, in world units
+		glm::vec2  Min = glm::vec2(FLT_MAX);
+		glm::vec2  Max = glm::vec2(-FLT_MAX);
+		// The chart's rectangle in the lightmap, in texels (including padding)
+		glm::uvec2 Size = glm::uvec2(0);
+		glm::uvec2 Offset = glm::uvec2(0);
+	};
+
+	// Everything we work out about an object while baking it
+	struct BakeObject
+	{
+		// The source mesh, moved into world space
+		std::vector<glm::vec3> WorldPositions;
+		std::vector<glm::vec3> WorldNormals;
+		std::vector<uint32_t>  Indices;
+		// The output mesh, split wherever charts meet
+		std::vector<VertexPosNormTexColLm> Vertices;
+		std::vector<uint32_t>  LightmapIndices;
+		std::vector<uint32_t>  SourceVertex;
+		std::vector<glm::vec2> LightmapTexels;
+		// The lightmap, and the surface under the center of each texel
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		std::vector<glm::vec3> TexelPositions;
+		std::vector<glm::vec3> TexelNormals;
+		std::vector<uint8_t>   TexelValid;
+		std::vector<glm::vec4> Result;
+	};
+
+	// Everything the tracing threads need to look at
+	struct Scene
+	{
+		TriangleBvh            Bvh;
+		std::vector<glm::vec3> Normals;
+		std::vector<glm::vec3> Albedos;
+	};
+}
+
+static float Cross2(const glm::vec2& a, const glm::vec2& b) {
+	return a.x * b.y - a.y * b.x;
+}
+
+// Flattens a point onto the plane facing along an axis
+static glm::vec2 Project(const glm::vec3& point, int axis) {
+	return glm::vec2(point[(axis + 1) % 3], point[(axis + 2) % 3]);
+}
+
+// Mixes a texel's location into a seed, see https://xoshiro.di.unimi.it/splitmix64.c
+static uint64_t HashTexel(uint32_t object, uint32_t x, uint32_t y) {
+	uint64_t hash = ((uint64_t)object << 40) ^ ((uint64_t)y << 20) ^ x;
+	hash ^= hash >> 30;
+	hash *= 0xbf58476d1ce4e5b9ull;
+	hash ^= hash >> 27;
+	hash *= 0x94d049bb133111ebull;
+	hash ^= hash >> 31;
+	return hash;
+}
+
+// Builds two tangents perpendicular to a normal, see https://graphics.pixar.com/library/OrthonormalB/paper.pdf
+static void OrthonormalBasis(const glm::vec3& n, glm::vec3& tangent, glm::vec3& bitangent) {
+	const float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+	const float a = -1.0f / (sign + n.z);
+	const float b = n.x * n.y * a;
+	tangent = glm::vec3(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+	bitangent = glm::vec3(b, sign + n.y * n.y * a, -n.y);
+}
+
+// Picks a direction around a normal, weighted by the cosine of the angle to it. This matches how much diffuse
+// surfaces care about each direction, so the cosine term cancels out of our estimate
+static glm::vec3 SampleCosine(const glm::vec3& normal, Random& random) {
+	const float u1 = random.NextFloat();
+	const float u2 = random.NextFloat();
+	const float radius = glm::sqrt(u1);
+	const float phi = glm::two_pi<float>() * u2;
+	glm::vec3 tangent, bitangent;
+	OrthonormalBasis(normal, tangent, bitangent);
+	return glm::normalize(tangent * (radius * glm::cos(phi)) + bitangent * (radius * glm::sin(phi)) + normal * glm::sqrt(glm::max(0.0f, 1.0f - u1)));
+}
+
+// Picks a direction towards a random point on the sun's disk, for soft shadows
+static glm::vec3 SampleSunDirection(const LightmapBaker::Settings& settings, Random& random) {
+	const glm::vec3 toSun = -settings.SunDirection;
+	glm::vec3 tangent, bitangent;
+	OrthonormalBasis(toSun, tangent, bitangent);
+	const float radius = glm::tan(settings.SunAngle) * glm::sqrt(random.NextFloat());
+	const float phi = glm::two_pi<float>() * random.NextFloat();
+	return glm::normalize(toSun + tangent * (radius * glm::cos(phi)) + bitangent * (radius * glm::sin(phi)));
+}
+
+// The sun's light arriving at a point
+static glm::vec3 SampleSun(const LightmapBaker::Settings& settings, const Scene& scene, const glm::vec3& position, const glm::vec3& normal, Random& random) {
+	const glm::vec3 direction = SampleSunDirection(settings, random);
+	const float nDotL = glm::dot(normal, direction);
+	if (nDotL <= 0.0f || scene.Bvh.IsOccluded(position, direction, FLT_MAX)) {
+		return glm::vec3(0.0f);
+	}
+	return settings.SunColor * nDotL;
+}
+
+// Follows a path through the scene, picking up the sun and sky along the way. Returns the light arriving back along
+// the ray, and how far away the first thing it hit was (FLT_MAX if it escaped to the sky)
+static glm::vec3 TracePath(const LightmapBaker::Settings& settings, const Scene& scene, const glm::vec3& origin, const glm::vec3& firstDirection, Random& random, float& firstHit) {
+	glm::vec3 light(0.0f);
+	glm::vec3 throughput(1.0f);
+	glm::vec3 rayOrigin = origin;
+	glm::vec3 direction = firstDirection;
+	firstHit = FLT_MAX;
+	for (uint32_t bounce = 0; bounce <= settings.Bounces; bounce++) {
+		TriangleBvh::Hit hit;
+		if (!scene.Bvh.Intersect(rayOrigin, direction, FLT_MAX, hit)) {
+			light += throughput * settings.SkyColor;
+			break;
+		}
+		if (bounce == 0) {
+			firstHit = hit.Distance;
+		}
+		if (bounce == settings.Bounces) {
+			break;
+		}
+
+		// Treat everything as double sided, some of our meshes (like the spiderweb) are just a single sheet
+		glm::vec3 hitNormal = scene.Normals[hit.Triangle];
+		if (glm::dot(hitNormal, direction) > 0.0f) {
+			hitNormal = -hitNormal;
+		}
+		rayOrigin = rayOrigin + direction * hit.Distance + hitNormal * RAY_OFFSET;
+		throughput *= scene.Albedos[hit.Triangle];
+		light += throughput * SampleSun(settings, scene, rayOrigin, hitNormal, random);
+		direction = SampleCosine(hitNormal, random);
+	}
+	return light;
+}
+
+// Works out the lighting for one texel. RGB is the light reaching the surface (what the shader multiplies the albedo
+// by) and A is how unoccluded it is
+static glm::vec4 ShadeTexel(const LightmapBaker::Settings& settings, const Scene& scene, const glm::vec3& position, const glm::vec3& normal, Random& random) {
+	const glm::vec3 origin = position + normal * RAY_OFFSET;
+	glm::vec3 light(0.0f);
+	uint32_t occluded = 0;
+
+	for (uint32_t sample = 0; sample < settings.SamplesPerTexel; sample++) {
+		light += SampleSun(settings, scene, origin, normal, random);
+		float firstHit;
+		light += TracePath(settings, scene, origin, SampleCosine(normal, random), random, firstHit);
+		if (firstHit < settings.AoDistance) {
+			occluded++;
+		}
+	}
+
+	const float invSamples = 1.0f / glm::max(settings.SamplesPerTexel, 1u);
+	return glm::vec4(light * invSamples, 1.0f - occluded * invSamples);
+}
+
+// Works out the light arriving at a probe from every direction, as irradiance SH coefficients (see SphericalHarmonics)
+static void ShadeProbe(const LightmapBaker::Settings& settings, const Scene& scene, const glm::vec3& position, Random& random, glm::vec3 sh[9]) {
+	for (int ix = 0; ix < 9; ix++) {
+		sh[ix] = glm::vec3(0.0f);
+	}
+
+	// Sky and bounced light, from directions spread evenly over the sphere
+	const uint32_t samples = glm::max(settings.SamplesPerProbe, 1u);
+	const float weight = 4.0f * glm::pi<float>() / samples;
+	for (uint32_t sample = 0; sample < samples; sample++) {
+		const float z = 1.0f - 2.0f * random.NextFloat();
+		const float radius = glm::sqrt(glm::max(0.0f, 1.0f - z * z));
+		const float phi = glm::two_pi<float>() * random.NextFloat();
+		const glm::vec3 direction(radius * glm::cos(phi), radius * glm::sin(phi), z);
+		float firstHit;
+		SphericalHarmonics::AddSample(sh, direction, TracePath(settings, scene, position, direction, random, firstHit) * weight);
+	}
+
+	// The sun is far too small to find by chance, so add it directly. Our sun color is the light it gives a surface
+	// facing it, which is pi times what the cosine lobe turns it back into
+	uint32_t visible = 0;
+	for (uint32_t sample = 0; sample < SUN_SAMPLES_PER_PROBE; sample++) {
+		visible += scene.Bvh.IsOccluded(position, SampleSunDirection(settings, random), FLT_MAX) ? 0 : 1;
+	}
+	SphericalHarmonics::AddSample(sh, -settings.SunDirection, settings.SunColor * (glm::pi<float>() * visible / SUN_SAMPLES_PER_PROBE));
+
+	SphericalHarmonics::ConvolveCosineLobe(sh);
+}
+
+// Runs a function for every index from 0 to count on a pool of threads, handing out indices as threads free up
+template <typename Func>
+static void ParallelFor(uint32_t threadCount, size_t count, const Func& func) {
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		for (size_t ix = next++; ix < count; ix = next++) {
+			func(ix);
+		}
+	};
+	std::vector<std::thread> threads;
+	for (uint32_t ix = 0; ix < threadCount; ix++) {
+		threads.emplace_back(worker);
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+// Splits an object into charts of connected triangles that face along the same axis. Projecting each chart onto its
+// axis' plane keeps the distortion low, and since every triangle faces within ~55 degrees of the axis, none of them
+// collapse to a line
+static std::vector<Chart> BuildCharts(const BakeObject& object) {
+	const size_t triCount = object.Indices.size() / 3;
+
+	// The OBJ loader splits vertices wherever their UVs or normals change, so weld them by position to find neighbours
+	std::unordered_map<uint64_t, uint32_t> weldMap;
+	std::vector<uint32_t> welded(object.WorldPositions.size());
+	for (size_t ix = 0; ix < object.WorldPositions.size(); ix++) {
+		const glm::ivec3 q = glm::ivec3(glm::round(object.WorldPositions[ix] * 1000.0f));
+		const uint64_t mask = 0x1FFFFF;
+		const uint64_t key = (((uint64_t)q.x & mask) << 42) | (((uint64_t)q.y & mask) << 21) | ((uint64_t)q.z & mask);
+		welded[ix] = weldMap.emplace(key, (uint32_t)weldMap.size()).first->second;
+	}
+
+	// Bucket each triangle by the axis (and direction along it) that its normal is closest to
+	std::vector<int> buckets(triCount);
+	for (size_t tri = 0; tri < triCount; tri++) {
+		const glm::vec3& a = object.WorldPositions[object.Indices[tri * 3]];
+		const glm::vec3& b = object.WorldPositions[object.Indices[tri * 3 + 1]];
+		const glm::vec3& c = object.WorldPositions[object.Indices[tri * 3 + 2]];
+		const glm::vec3 normal = glm::cross(b - a, c - a);
+		const glm::vec3 absNormal = glm::abs(normal);
+		const int axis = absNormal.x >= absNormal.y && absNormal.x >= absNormal.z ? 0 : (absNormal.y >= absNormal.z ? 1 : 2);
+		buckets[tri] = axis * 2 + (normal[axis] < 0.0f ? 1 : 0);
+	}
+
+	// Join up triangles that share an edge and are in the same bucket
+	std::vector<uint32_t> parents(triCount);
+	std::iota(parents.begin(), parents.end(), 0u);
+	auto find = [&](uint32_t tri) {
+		while (parents[tri] != tri) {
+			parents[tri] = parents[parents[tri]];
+			tri = parents[tri];
+		}
+		return tri;
+	};
+	std::unordered_map<uint64_t, uint32_t> edges;
+	for (uint32_t tri = 0; tri < (uint32_t)triCount; tri++) {
+		for (int corner = 0; corner < 3; corner++) {
+			const uint32_t a = welded[object.Indices[tri * 3 + corner]];
+			const uint32_t b = welded[object.Indices[tri * 3 + (corner + 1) % 3]];
+			if (a == b) {
+				continue;
+			}
+			const uint64_t key = ((uint64_t)glm::min(a, b) << 32) | glm::max(a, b);
+			auto result = edges.emplace(key, tri);
+			if (!result.second && buckets[result.first->second] == buckets[tri]) {
+				const uint32_t rootA = find(result.first->second);
+				const uint32_t rootB = find(tri);
+				// Always keep the lower index as the root, so charts come out in the same order every time
+				parents[glm::max(rootA, rootB)] = glm::min(rootA, rootB);
+			}
+		}
+	}
+
+	std::vector<Chart> charts;
+	std::unordered_map<uint32_t, uint32_t> chartIndices;
+	for (uint32_t tri = 0; tri < (uint32_t)triCount; tri++) {
+		const uint32_t root = find(tri);
+		auto it = chartIndices.find(root);
+		if (it == chartIndices.end()) {
+			it = chartIndices.emplace(root, (uint32_t)charts.size()).first;
+			charts.emplace_back();
+			charts.back().Axis = buckets[tri] / 2;
+		}
+		Chart& chart = charts[it->second];
+		chart.Triangles.push_back(tri);
+		for (int corner = 0; corner < 3; corner++) {
+			const glm::vec2 point = Project(object.WorldPositions[object.Indices[tri * 3 + corner]], chart.Axis);
+			chart.Min = glm::min(chart.Min, point);
+			chart.Max = glm::max(chart.Max, point);
+		}
+	}
+	return charts;
+}
+
+// Packs charts into rows (tallest first) at the given density, returns false if they don't fit within maxSize
+static bool PackCharts(std::vector<Chart>& charts, float texelsPerUnit, uint32_t padding, uint32_t maxSize, uint32_t& width, uint32_t& height) {
+	uint64_t area = 0;
+	uint32_t widest = 0;
+	for (Chart& chart : charts) {
+		chart.Size = glm::uvec2(glm::ceil((chart.Max - chart.Min) * texelsPerUnit)) + glm::uvec2(1 + padding * 2);
+		area += (uint64_t)chart.Size.x * chart.Size.y;
+		widest = glm::max(widest, chart.Size.x);
+	}
+
+	// Aim for a roughly square lightmap, with a bit of room for the gaps at the end of each row
+	width = 4;
+	while (width < widest || (uint64_t)width * width < area + area / 4) {
+		width *= 2;
+	}
+	if (width > maxSize) {
+		return false;
+	}
+
+	std::vector<uint32_t> order(charts.size());
+	std::iota(order.begin(), order.end(), 0u);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return charts[a].Size.y > charts[b].Size.y;
+	});
+	uint32_t x = 0, y = 0, rowHeight = 0, usedWidth = 0;
+	for (uint32_t ix : order) {
+		Chart& chart = charts[ix];
+		if (x + chart.Size.x > width) {
+			y += rowHeight;
+			x = 0;
+			rowHeight = 0;
+		}
+		chart.Offset = glm::uvec2(x, y);
+		x += chart.Size.x;
+		usedWidth = glm::max(usedWidth, x);
+		rowHeight = glm::max(rowHeight, chart.Size.y);
+	}
+	// Trim off any columns we didn't use, which happens when there are only a couple of big charts
+	width = (usedWidth + 3) & ~3u;
+	height = (y + rowHeight + 3) & ~3u;
+	return height <= maxSize;
+}
+
+// Finds the surface under the center of every texel that a triangle covers
+static void Rasterize(BakeObject& object) {
+	const size_t texelCount = (size_t)object.Width * object.Height;
+	object.TexelPositions.assign(texelCount, glm::vec3(0.0f));
+	object.TexelNormals.assign(texelCount, glm::vec3(0.0f));
+	object.TexelValid.assign(texelCount, 0);
+
+	for (size_t tri = 0; tri < object.LightmapIndices.size() / 3; tri++) {
+		glm::vec2 texels[3];
+		glm::vec3 positions[3], normals[3];
+		for (int corner = 0; corner < 3; corner++) {
+			const uint32_t vertex = object.LightmapIndices[tri * 3 + corner];
+			texels[corner] = object.LightmapTexels[vertex];
+			positions[corner] = object.WorldPositions[object.SourceVertex[vertex]];
+			normals[corner] = object.WorldNormals[object.SourceVertex[vertex]];
+		}
+		const float area = Cross2(texels[1] - texels[0], texels[2] - texels[0]);
+		if (glm::abs(area) < 1e-8f) {
+			continue;
+		}
+		const glm::vec3 faceNormal = glm::normalize(glm::cross(positions[1] - positions[0], positions[2] - positions[0]));
+
+		const glm::ivec2 min = glm::max(glm::ivec2(glm::floor(glm::min(texels[0], glm::min(texels[1], texels[2])))), glm::ivec2(0));
+		const glm::ivec2 max = glm::min(glm::ivec2(glm::ceil(glm::max(texels[0], glm::max(texels[1], texels[2])))), glm::ivec2(object.Width - 1, object.Height - 1));
+		for (int y = min.y; y <= max.y; y++) {
+			for (int x = min.x; x <= max.x; x++) {
+				const glm::vec2 center(x + 0.5f, y + 0.5f);
+				const float w0 = Cross2(texels[2] - texels[1], center - texels[1]) / area;
+				const float w1 = Cross2(texels[0] - texels[2], center - texels[2]) / area;
+				const float w2 = 1.0f - w0 - w1;
+				if (w0 < -1e-4f || w1 < -1e-4f || w2 < -1e-4f) {
+					continue;
+				}
+				const size_t ix = (size_t)y * object.Width + x;
+				if (object.TexelValid[ix]) {
+					continue;
+				}
+				glm::vec3 normal = normals[0] * w0 + normals[1] * w1 + normals[2] * w2;
+				const float length = glm::length(normal);
+				object.TexelPositions[ix] = positions[0] * w0 + positions[1] * w1 + positions[2] * w2;
+				object.TexelNormals[ix] = length > 1e-6f ? normal / length : faceNormal;
+				object.TexelValid[ix] = 1;
+			}
+		}
+	}
+}
+
+// Finds the surface under the center of every texel of a heightfield's lightmap, which is stretched over the
+// heightmap edge to edge
+static void RasterizeHeightfield(BakeObject& object, const Heightmap& heightmap, const glm::mat4& transform, const glm::mat3& normalMatrix) {
+	const size_t texelCount = (size_t)object.Width * object.Height;
+	object.TexelPositions.resize(texelCount);
+	object.TexelNormals.resize(texelCount);
+	object.TexelValid.assign(texelCount, 1);
+
+	const glm::vec3 scale(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])));
+	for (uint32_t y = 0; y < object.Height; y++) {
+		for (uint32_t x = 0; x < object.Width; x++) {
+			const glm::vec2 uv((x + 0.5f) / object.Width, (y + 0.5f) / object.Height);
+			const size_t ix = (size_t)y * object.Width + x;
+			object.TexelPositions[ix] = glm::vec3(transform * glm::vec4(uv.x, heightmap.Sample(uv), uv.y, 1.0f));
+			// SampleNormal gives us the normal once scaled, undo that so the normal matrix can handle any rotation too
+			object.TexelNormals[ix] = glm::normalize(normalMatrix * (heightmap.SampleNormal(uv, scale) * scale));
+		}
+	}
+}
+
+// Grows the lighting out from the covered texels into the padding around them, so bilinear filtering at the edge
+// of a chart doesn't blend in black
+static void Dilate(BakeObject& object, uint32_t iterations) {
+	std::vector<uint8_t> valid = object.TexelValid;
+	for (uint32_t iteration = 0; iteration < iterations; iteration++) {
+		std::vector<uint8_t> next = valid;
+		for (int y = 0; y < (int)object.Height; y++) {
+			for (int x = 0; x < (int)object.Width; x++) {
+				const size_t ix = (size_t)y * object.Width + x;
+				if (valid[ix]) {
+					continue;
+				}
+				glm::vec4 sum(0.0f);
+				int count = 0;
+				for (int dy = -1; dy <= 1; dy++) {
+					for (int dx = -1; dx <= 1; dx++) {
+						const int nx = x + dx, ny = y + dy;
+						if (nx < 0 || ny < 0 || nx >= (int)object.Width || ny >= (int)object.Height) {
+							continue;
+						}
+						const size_t neighbour = (size_t)ny * object.Width + nx;
+						if (valid[neighbour]) {
+							sum += object.Result[neighbour];
+							count++;
+						}
+					}
+				}
+				if (count > 0) {
+					object.Result[ix] = sum / (float)count;
+					next[ix] = 1;
+				}
+			}
+		}
+		valid = std::move(next);
+	}
+}
+
+static bool WriteLightmap(const std::string& path, const BakeObject& object, const glm::mat4& transform) {
+	Lightmap::FileHeader header;
+	memcpy(header.Magic, Lightmap::FILE_MAGIC, 4);
+	header.Version = Lightmap::FILE_VERSION;
+	header.Width = object.Width;
+	header.Height = object.Height;
+	header.VertexCount = (uint32_t)object.Vertices.size();
+	header.IndexCount = (uint32_t)object.LightmapIndices.size();
+	for (int ix = 0; ix < 16; ix++) {
+		header.Transform[ix] = transform[ix / 4][ix % 4];
+	}
+
+	std::vector<uint16_t> texels(object.Result.size() * 4);
+	for (size_t ix = 0; ix < object.Result.size(); ix++) {
+		for (int c = 0; c < 4; c++) {
+			texels[ix * 4 + c] = glm::packHalf1x16(object.Result[ix][c]);
+		}
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(Lightmap::FileHeader));
+	file.write(reinterpret_cast<const char*>(object.Vertices.data()), object.Vertices.size() * sizeof(VertexPosNormTexColLm));
+	file.write(reinterpret_cast<const char*>(object.LightmapIndices.data()), object.LightmapIndices.size() * sizeof(uint32_t));
+	file.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(uint16_t));
+	return file.good();
+}
+
+// Writes the probes out in the layout IrradianceVolume expects, the 27 floats of each probe are spread over 7 RGBA
+// slices of the grid
+static bool WriteVolume(const std::string& path, const LightmapBaker::Settings& settings, const std::vector<glm::vec3>& probes) {
+	IrradianceVolume::FileHeader header;
+	memcpy(header.Magic, IrradianceVolume::FILE_MAGIC, 4);
+	header.Version = IrradianceVolume::FILE_VERSION;
+	for (int axis = 0; axis < 3; axis++) {
+		header.Resolution[axis] = settings.VolumeResolution[axis];
+		header.Min[axis] = settings.VolumeMin[axis];
+		header.Max[axis] = settings.VolumeMax[axis];
+	}
+
+	const size_t probeCount = probes.size() / 9;
+	std::vector<uint16_t> texels(probeCount * IrradianceVolume::SLICE_COUNT * 4, glm::packHalf1x16(0.0f));
+	for (size_t probe = 0; probe < probeCount; probe++) {
+		for (uint32_t component = 0; component < 27; component++) {
+			const size_t slice = component / 4;
+			texels[(slice * probeCount + probe) * 4 + component % 4] = glm::packHalf1x16(probes[probe * 9 + component / 3][component % 3]);
+		}
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(IrradianceVolume::FileHeader));
+	file.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(uint16_t));
+	return file.good();
+}
+
+void LightmapBaker::AddObject(const std::string& name, MeshBuilder<VertexPosNormTexCol>&& mesh, const glm::mat4& transform, const glm::vec3& albedo) {
+	Object object;
+	object.Name = name;
+	object.Mesh = std::move(mesh);
+	object.Transform = transform;
+	object.Albedo = albedo;
+	_objects.push_back(std::move(object));
+}
+
+void LightmapBaker::AddHeightfield(const std::string& name, const Heightmap::sptr& heightmap, const glm::mat4& transform, const glm::vec3& albedo) {
+	// The mesh is only there for rays to hit, so it can use every sample
+	const glm::vec3 scale(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])));
+	AddObject(name, heightmap->BuildMesh(1, glm::vec2(1.0f), scale), transform, albedo);
+	_objects.back().Heightfield = heightmap;
+}
+
+void LightmapBaker::AddOccluder(const std::string& name, MeshBuilder<VertexPosNormTexCol>&& mesh, const glm::mat4& transform, const glm::vec3& albedo) {
+	AddObject(name, std::move(mesh), transform, albedo);
+	_objects.back().Occluder = true;
+}
+
+bool LightmapBaker::Bake(const std::string& outputDirectory) {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// Move everything into world space, and give each object its lightmap UVs
+	std::vector<BakeObject> objects(_objects.size());
+	for (size_t objectIx = 0; objectIx < _objects.size(); objectIx++) {
+		const Object& source = _objects[objectIx];
+		BakeObject& object = objects[objectIx];
+		const VertexPosNormTexCol* vertices = source.Mesh.GetVertexDataPtr();
+		const size_t vertexCount = source.Mesh.GetVertexCount();
+
+		// Objects that are flattened on an axis (like our terrain) have no normal matrix, we use face normals for those
+		const glm::mat3 linear = glm::mat3(source.Transform);
+		const bool hasNormalMatrix = glm::abs(glm::determinant(linear)) > 1e-8f;
+		const glm::mat3 normalMatrix = hasNormalMatrix ? glm::transpose(glm::inverse(linear)) : glm::mat3(0.0f);
+		object.WorldPositions.resize(vertexCount);
+		object.WorldNormals.resize(vertexCount);
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			object.WorldPositions[ix] = glm::vec3(source.Transform * glm::vec4(vertices[ix].Position, 1.0f));
+			const glm::vec3 normal = normalMatrix * vertices[ix].Normal;
+			object.WorldNormals[ix] = glm::length(normal) > 1e-6f ? glm::normalize(normal) : glm::vec3(0.0f);
+		}
+		if (source.Mesh.GetIndexCount() > 0) {
+			object.Indices.assign(source.Mesh.GetIndexDataPtr(), source.Mesh.GetIndexDataPtr() + source.Mesh.GetIndexCount());
+		} else {
+			object.Indices.resize(vertexCount - vertexCount % 3);
+			std::iota(object.Indices.begin(), object.Indices.end(), 0u);
+		}
+		if (object.Indices.empty()) {
+			LOG_ERROR("Cannot bake a lightmap for \"{}\", it has no triangles", source.Name);
+			return false;
+		}
+
+		// Occluders only need to be in the BVH, so they're left with an empty lightmap
+		if (source.Occluder) {
+			continue;
+		}
+
+		// Heightfields don't need charts, their UVs already cover them without overlapping
+		if (source.Heightfield != nullptr) {
+			const glm::vec2 extent(glm::length(glm::vec3(source.Transform[0])), glm::length(glm::vec3(source.Transform[2])));
+			const glm::uvec2 size = glm::uvec2(glm::ceil(extent * _settings.TexelsPerUnit));
+			object.Width = glm::clamp(size.x, 4u, _settings.MaxSize);
+			object.Height = glm::clamp(size.y, 4u, _settings.MaxSize);
+			RasterizeHeightfield(object, *source.Heightfield, source.Transform, normalMatrix);
+			object.Result.assign((size_t)object.Width * object.Height, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+			LOG_INFO("Lightmap for \"{}\": {}x{}, heightfield", source.Name, object.Width, object.Height);
+			continue;
+		}
+
+		// Drop the density until everything fits
+		std::vector<Chart> charts = BuildCharts(object);
+		float texelsPerUnit = _settings.TexelsPerUnit;
+		while (!PackCharts(charts, texelsPerUnit, _settings.Padding, _settings.MaxSize, object.Width, object.Height)) {
+			texelsPerUnit *= 0.8f;
+			if (texelsPerUnit < 0.01f) {
+				LOG_ERROR("Cannot fit \"{}\" into a {}x{} lightmap", source.Name, _settings.MaxSize, _settings.MaxSize);
+				return false;
+			}
+		}
+		if (texelsPerUnit != _settings.TexelsPerUnit) {
+			LOG_WARN("Lowered the lightmap density of \"{}\" to {} texels per unit to fit it into {}x{}", source.Name, texelsPerUnit, _settings.MaxSize, _settings.MaxSize);
+		}
+
+		// Split the vertices wherever charts meet, since each side needs a different lightmap UV
+		std::unordered_map<uint64_t, uint32_t> remap;
+		const glm::vec2 size((float)object.Width, (float)object.Height);
+		for (uint32_t chartIx = 0; chartIx < (uint32_t)charts.size(); chartIx++) {
+			const Chart& chart = charts[chartIx];
+			for (uint32_t tri : chart.Triangles) {
+				for (int corner = 0; corner < 3; corner++) {
+					const uint32_t vertex = object.Indices[tri * 3 + corner];
+					const uint64_t key = ((uint64_t)chartIx << 32) | vertex;
+					auto it = remap.find(key);
+					if (it == remap.end()) {
+						const glm::vec2 point = Project(object.WorldPositions[vertex], chart.Axis);
+						const glm::vec2 texel = glm::vec2(chart.Offset) + (float)_settings.Padding + 0.5f + (point - chart.Min) * texelsPerUnit;
+						it = remap.emplace(key, (uint32_t)object.Vertices.size()).first;
+						object.Vertices.emplace_back(vertices[vertex], texel / size);
+						object.LightmapTexels.push_back(texel);
+						object.SourceVertex.push_back(vertex);
+					}
+					object.LightmapIndices.push_back(it->second);
+				}
+			}
+		}
+		Rasterize(object);
+		object.Result.assign((size_t)object.Width * object.Height, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		LOG_INFO("Lightmap for \"{}\": {}x{}, {} charts", source.Name, object.Width, object.Height, charts.size());
+	}
+
+	// Every object blocks and bounces light for every other one, so they all go in one BVH
+	Scene scene;
+	{
+		std::vector<glm::vec3> corners;
+		for (size_t objectIx = 0; objectIx < objects.size(); objectIx++) {
+			const BakeObject& object = objects[objectIx];
+			for (size_t tri = 0; tri < object.Indices.size() / 3; tri++) {
+				const glm::vec3& a = object.WorldPositions[object.Indices[tri * 3]];
+				const glm::vec3& b = object.WorldPositions[object.Indices[tri * 3 + 1]];
+				const glm::vec3& c = object.WorldPositions[object.Indices[tri * 3 + 2]];
+				corners.push_back(a);
+				corners.push_back(b);
+				corners.push_back(c);
+				const glm::vec3 normal = glm::cross(b - a, c - a);
+				const float length = glm::length(normal);
+				scene.Normals.push_back(length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f));
+				scene.Albedos.push_back(_objects[objectIx].Albedo);
+			}
+		}
+		scene.Bvh.Build(corners);
+		LOG_INFO("Built lightmap BVH over {} triangles ({} nodes)", scene.Bvh.GetTriangleCount(), scene.Bvh.GetNodeCount());
+	}
+
+	// Hand out rows to every core, any texel can be traced independently of the others
+	struct Row
+	{
+		uint32_t Object;
+		uint32_t Y;
+	};
+	std::vector<Row> rows;
+	for (uint32_t objectIx = 0; objectIx < (uint32_t)objects.size(); objectIx++) {
+		for (uint32_t y = 0; y < objects[objectIx].Height; y++) {
+			rows.push_back({ objectIx, y });
+		}
+	}
+	const uint32_t threadCount = _settings.ThreadCount > 0 ? _settings.ThreadCount : glm::max(std::thread::hardware_concurrency(), 1u);
+	ParallelFor(threadCount, rows.size(), [&](size_t rowIx) {
+		const Row& row = rows[rowIx];
+		BakeObject& object = objects[row.Object];
+		for (uint32_t x = 0; x < object.Width; x++) {
+			const size_t ix = (size_t)row.Y * object.Width + x;
+			if (object.TexelValid[ix]) {
+				Random random(HashTexel(row.Object, x, row.Y));
+				object.Result[ix] = ShadeTexel(_settings, scene, object.TexelPositions[ix], object.TexelNormals[ix], random);
+			}
+		}
+	});
+
+	bool success = true;
+	uint32_t lightmapCount = 0;
+	for (size_t objectIx = 0; objectIx < objects.size(); objectIx++) {
+		if (_objects[objectIx].Occluder) {
+			continue;
+		}
+		lightmapCount++;
+		Dilate(objects[objectIx], _settings.Padding + 1);
+		const std::string path = Lightmap::GetPath(outputDirectory, _objects[objectIx].Name);
+		if (!WriteLightmap(path, objects[objectIx], _objects[objectIx].Transform)) {
+			LOG_ERROR("Failed to write lightmap \"{}\"", path);
+			success = false;
+		}
+	}
+
+	// The probes are evenly spread from one corner of the volume to the other, so the outermost ones sit right on it
+	const glm::uvec3 resolution = _settings.VolumeResolution;
+	if (glm::all(glm::greaterThanEqual(resolution, glm::uvec3(2)))) {
+		const glm::vec3 spacing = (_settings.VolumeMax - _settings.VolumeMin) / glm::vec3(resolution - glm::uvec3(1));
+		std::vector<glm::vec3> probes((size_t)resolution.x * resolution.y * resolution.z * 9);
+		ParallelFor(threadCount, probes.size() / 9, [&](size_t probe) {
+			const uint32_t x = (uint32_t)(probe % resolution.x);
+			const uint32_t y = (uint32_t)((probe / resolution.x) % resolution.y);
+			const uint32_t z = (uint32_t)(probe / ((size_t)resolution.x * resolution.y));
+			// Seed the probes as if they were the texels of one more object after the last one
+			Random random(HashTexel((uint32_t)objects.size(), x, y * resolution.z + z));
+			ShadeProbe(_settings, scene, _settings.VolumeMin + spacing * glm::vec3(x, y, z), random, &probes[probe * 9]);
+		});
+
+		const std::string path = IrradianceVolume::GetPath(outputDirectory);
+		if (WriteVolume(path, _settings, probes)) {
+			LOG_INFO("Baked a {}x{}x{} irradiance volume", resolution.x, resolution.y, resolution.z);
+		} else {
+			LOG_ERROR("Failed to write irradiance volume \"{}\"", path);
+			success = false;
+		}
+	} else if (glm::any(glm::greaterThan(resolution, glm::uvec3(0)))) {
+		LOG_WARN("Skipping the irradiance volume, it needs at least 2 probes along each axis");
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	LOG_INFO("Baked {} lightmaps on {} threads in {} ms", lightmapCount, threadCount, std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+	return success;
+}
+
+static glm::vec3 ReadVec3(const nlohmann::json& object, const char* key, const glm::vec3& fallback) {
+	auto it = object.find(key);
+	if (it == object.end() || !it->is_array() || it->size() != 3) {
+		return fallback;
+	}
+	return glm::vec3((*it)[0].get<float>(), (*it)[1].get<float>(), (*it)[2].get<float>());
+}
+
+int LightmapBaker::RunFromManifest(const std::string& manifestPath) {
+	std::ifstream file(manifestPath);
+	if (!file.is_open()) {
+		LOG_ERROR("Could not open lightmap manifest \"{}\"", manifestPath);
+		return 1;
+	}
+
+	nlohmann::json manifest;
+	try {
+		file >> manifest;
+	} catch (const std::exception& e) {
+		LOG_ERROR("Failed to parse lightmap manifest \"{}\": {}", manifestPath, e.what());
+		return 1;
+	}
+
+	Settings settings;
+	settings.TexelsPerUnit = manifest.value("TexelsPerUnit", settings.TexelsPerUnit);
+	settings.MaxSize = manifest.value("MaxSize", settings.MaxSize);
+	settings.Padding = manifest.value("Padding", settings.Padding);
+	settings.SamplesPerTexel = manifest.value("SamplesPerTexel", settings.SamplesPerTexel);
+	settings.Bounces = manifest.value("Bounces", settings.Bounces);
+	settings.AoDistance = manifest.value("AoDistance", settings.AoDistance);
+	settings.SunDirection = glm::normalize(ReadVec3(manifest, "SunDirection", settings.SunDirection));
+	settings.SunColor = ReadVec3(manifest, "SunColor", settings.SunColor);
+	settings.SunAngle = manifest.value("SunAngle", settings.SunAngle);
+	settings.SkyColor = ReadVec3(manifest, "SkyColor", settings.SkyColor);
+	settings.ThreadCount = manifest.value("ThreadCount", settings.ThreadCount);
+	auto volume = manifest.find("Volume");
+	if (volume != manifest.end() && volume->is_object()) {
+		settings.VolumeMin = ReadVec3(*volume, "Min", settings.VolumeMin);
+		settings.VolumeMax = ReadVec3(*volume, "Max", settings.VolumeMax);
+		settings.VolumeResolution = glm::uvec3(ReadVec3(*volume, "Resolution", glm::vec3(settings.VolumeResolution)));
+		settings.SamplesPerProbe = volume->value("SamplesPerProbe", settings.SamplesPerProbe);
+	}
+
+	LightmapBaker baker(settings);
+	for (const nlohmann::json& object : manifest["Objects"]) {
+		const std::string name = object.value("Name", "");
+		const std::string model = object.value("Model", "");
+		const std::string heightmap = object.value("Heightmap", "");
+		if (name.empty() || (model.empty() && heightmap.empty())) {
+			LOG_ERROR("Lightmap manifest \"{}\" has an object without a Name, or a Model or Heightmap", manifestPath);
+			return 1;
+		}
+
+		// Build the transform the same way the game does, so the bake matches what's on screen
+		Transform transform;
+		transform.SetLocalPosition(ReadVec3(object, "Position", glm::vec3(0.0f)));
+		transform.SetLocalRotation(ReadVec3(object, "Rotation", glm::vec3(0.0f)));
+		transform.SetLocalScale(ReadVec3(object, "Scale", glm::vec3(1.0f)));
+
+		// Occluders can be placed many times, each instance overrides the object's placement
+		if (object.value("Occluder", false)) {
+			if (model.empty()) {
+				LOG_ERROR("Occluder \"{}\" in lightmap manifest \"{}\" needs a Model", name, manifestPath);
+				return 1;
+			}
+			MeshBuilder<VertexPosNormTexCol> mesh;
+			try {
+				mesh = ObjLoader::LoadMeshData(model);
+			} catch (const std::exception& e) {
+				LOG_ERROR("Failed to load \"{}\" for \"{}\": {}", model, name, e.what());
+				return 1;
+			}
+			const glm::vec3 albedo = ReadVec3(object, "Albedo", glm::vec3(0.5f));
+			auto instances = object.find("Instances");
+			if (instances == object.end() || !instances->is_array()) {
+				baker.AddOccluder(name, std::move(mesh), transform.LocalTransform(), albedo);
+				continue;
+			}
+			for (const nlohmann::json& instance : *instances) {
+				Transform placement;
+				placement.SetLocalPosition(ReadVec3(instance, "Position", transform.GetLocalPosition()));
+				placement.SetLocalRotation(ReadVec3(instance, "Rotation", transform.GetLocalRotation()));
+				placement.SetLocalScale(ReadVec3(instance, "Scale", transform.GetLocalScale()));
+				baker.AddOccluder(name, MeshBuilder<VertexPosNormTexCol>(mesh), placement.LocalTransform(), albedo);
+			}
+			continue;
+		}
+
+		if (!heightmap.empty()) {
+			Heightmap::sptr heights = Heightmap::LoadFromFile(heightmap);
+			if (heights == nullptr) {
+				LOG_ERROR("Failed to load heightmap \"{}\" for \"{}\"", heightmap, name);
+				return 1;
+			}
+			baker.AddHeightfield(name, heights, transform.LocalTransform(), ReadVec3(object, "Albedo", glm::vec3(0.5f)));
+			continue;
+		}
+		try {
+			baker.AddObject(name, ObjLoader::LoadMeshData(model), transform.LocalTransform(), ReadVec3(object, "Albedo", glm::vec3(0.5f)));
+		} catch (const std::exception& e) {
+			LOG_ERROR("Failed to load \"{}\" for \"{}\": {}", model, name, e.what());
+			return 1;
+		}
+	}
+
+	std::string output = std::filesystem::path(manifestPath).parent_path().string();
+	output = manifest.value("Output", output.empty() ? std::string(".") : output);
+	std::error_code error;
+	std::filesystem::create_directories(output, error);
+	return baker.Bake(output) ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Heightmap.h"
+#include "MeshBuilder.h"
+#include "VertexTypes.h"
+
+/// <summary>
+/// Bakes the lighting for static geometry into lightmaps, entirely on the CPU so it can run without a window (ex: as
+/// part of a build step). Each object gets a second UV set, made by splitting it into charts of triangles that face
+/// the same way and packing them into its own lightmap. Every texel is then path traced against a BVH of the whole
+/// scene: direct light from the sun, sky light, a few diffuse bounces, and ambient occlusion.
+///
+/// Texels are traced on every core, but each texel seeds its own random numbers from where it is, so the results are
+/// the same from run to run no matter how many threads there are, or how the work is split between them.
+///
+/// The same scene is also used to bake an irradiance volume (see IrradianceVolume), a grid of probes that light the
+/// dynamic objects moving through it.
+/// </summary>
+class LightmapBaker final
+{
+public:
+	/// <summary>
+	/// The settings for a bake, shared by every object
+	/// </summary>
+	struct Settings
+	{
+		// How many lightmap texels to give each world unit, lowered automatically if an object won't fit in MaxSize
+		float     TexelsPerUnit = 4.0f;
+		uint32_t  MaxSize = 1024;
+		// The gap in texels around each chart, so bilinear filtering doesn't pick up a neighbouring chart
+		uint32_t  Padding = 2;
+		uint32_t  SamplesPerTexel = 64;
+		uint32_t  Bounces = 2;
+		// How close geometry needs to be to count as occluding a texel
+		float     AoDistance = 2.0f;
+		// The direction the sun's light travels in, and its color. SunAngle is the radius of the sun in radians
+		glm::vec3 SunDirection = glm::normalize(glm::vec3(0.4f, -1.0f, -0.3f));
+		glm::vec3 SunColor = glm::vec3(0.45f, 0.5f, 0.65f);
+		float     SunAngle = 0.02f;
+		glm::vec3 SkyColor = glm::vec3(0.12f, 0.14f, 0.2f);
+		// The world space corners of the irradiance volume, and how many probes it has along each axis (0 to skip it)
+		glm::vec3 VolumeMin = glm::vec3(0.0f);
+		glm::vec3 VolumeMax = glm::vec3(0.0f);
+		glm::uvec3 VolumeResolution = glm::uvec3(0);
+		uint32_t  SamplesPerProbe = 512;
+		// The number of threads to trace with, 0 to use every core
+		uint32_t  ThreadCount = 0;
+	};
+
+	explicit LightmapBaker(const Settings& settings) : _settings(settings) {}
+	~LightmapBaker() = default;
+
+	LightmapBaker(const LightmapBaker& other) = delete;
+	LightmapBaker& operator=(const LightmapBaker& other) = delete;
+
+	/// <summary>
+	/// Adds an object to the bake. Every object receives a lightmap, and blocks and bounces light for all the others
+	/// </summary>
+	/// <param name="name">The name of the object, used for the name of its lightmap file</param>
+	/// <param name="mesh">The object's mesh, in its local space</param>
+	/// <param name="transform">The object's local to world transform</param>
+	/// <param name="albedo">The average color of the object, used for light bouncing off of it</param>
+	void AddObject(const std::string& name, MeshBuilder<VertexPosNormTexCol>&& mesh, const glm::mat4& transform, const glm::vec3& albedo);
+
+	/// <summary>
+	/// Adds a heightfield (see Terrain) to the bake. Rather than being split into charts, its lightmap is stretched
+	/// straight over the heightmap, so the terrain can look it up with the same UVs, and no mesh is saved with it
+	/// </summary>
+	/// <param name="name">The name of the heightfield, used for the name of its lightmap file</param>
+	/// <param name="heightmap">The heights, which get stretched over the unit cube</param>
+	/// <param name="transform">The transform that puts the unit cube in place (see Terrain::GetTransform)</param>
+	/// <param name="albedo">The average color of the ground, used for light bouncing off of it</param>
+	void AddHeightfield(const std::string& name, const Heightmap::sptr& heightmap, const glm::mat4& transform, const glm::vec3& albedo);
+
+	/// <summary>
+	/// Adds an object that blocks and bounces light for the others, but doesn't get a lightmap of its own (ex: scenery
+	/// the game draws many times through one entity, which has nowhere to keep a lightmap per copy)
+	/// </summary>
+	/// <param name="name">The name of the object, used in log messages</param>
+	/// <param name="mesh">The object's mesh, in its local space</param>
+	/// <param name="transform">The object's local to world transform</param>
+	/// <param name="albedo">The average color of the object, used for light bouncing off of it</param>
+	void AddOccluder(const std::string& name, MeshBuilder<VertexPosNormTexCol>&& mesh, const glm::mat4& transform, const glm::vec3& albedo);
+
+	/// <summary>
+	/// Bakes every object, and writes their lightmaps (see Lightmap) and the irradiance volume to a directory
+	/// </summary>
+	/// <param name="outputDirectory">The directory to write the .lmap and .vol files to, it must already exist</param>
+	/// <returns>True if every file was written</returns>
+	bool Bake(const std::string& outputDirectory);
+
+	/// <summary>
+	/// Runs a bake described by a JSON manifest, this is what the --bake-lightmaps command line option calls
+	/// </summary>
+	/// <param name="manifestPath">The path to the manifest, lightmaps are written next to it. An object can be listed as
+	/// an Occluder, and can give a list of Instances (each with their own Position, Rotation and Scale) to place its model
+	/// more than once</param>
+	/// <returns>The exit code for the process, 0 on success</returns>
+	static int RunFromManifest(const std::string& manifestPath);
+
+private:
+	struct Object
+	{
+		std::string Name;
+		MeshBuilder<VertexPosNormTexCol> Mesh;
+		glm::mat4   Transform;
+		glm::vec3   Albedo;
+		// Only set for heightfields, which get their lightmap laid over the heightmap instead of packed charts
+		Heightmap::sptr Heightfield;
+		// Occluders are only traced against, they don't get a lightmap
+		bool        Occluder = false;
+	};
+
+	Settings            _settings;
+	std::vector<Object> _objects;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// A read-only memory mapping of a file, so that binary assets can be handed straight to OpenGL without first being
+/// copied into a buffer. The mapping is released when this object is destroyed
+/// </summary>
+class MappedFile final
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string& path) { Open(path); }
+	~MappedFile() { Close(); }
+
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+
+	/// <summary>
+	/// Maps a file into memory, closing any file that was already mapped
+	/// </summary>
+	/// <param name="path">The path of the file to map</param>
+	/// <returns>True if the file was mapped, false if it could not be opened or is empty</returns>
+	bool Open(const std::string& path);
+	/// <summary>
+	/// Releases the mapping, if there is one
+	/// </summary>
+	void Close();
+
+	bool IsOpen() const { return _data != nullptr; }
+	const uint8_t* GetData() const { return _data; }
+	size_t GetSize() const { return _size; }
+
+private:
+	const uint8_t* _data = nullptr;
+	size_t _size = 0;
+	#ifdef _WIN32
+	void* _file = nullptr;
+	void* _mapping = nullptr;
+	#endif
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <type_traits>
 #include "Graphics/VertexArrayObject.h"
 
 template <typename VertType>
@@ -92,6 +93,8 @@ public:
 		result->AddVertexBuffer(vbo, VertType::V_DECL);
 		result->SetIndexBuffer(ebo);
 
+		_CalculateBounds(result);
+
 		return result;
 	}
 	
@@ -112,6 +115,47 @@ public:
 	
 protected:
 	friend class MeshFactory;
+
+	// Detects whether a vertex type has a UV member, so we can calculate texel densities for textured meshes
+	template <typename T, typename = void>
+	struct _HasUV : std::false_type { };
+	template <typename T>
+	struct _HasUV<T, std::void_t<decltype(std::declval<T>().UV)>> : std::true_type { };
+
+	/// <summary>
+	/// Calculates the bounding box and UV density of this mesh and stores them in the VAO
+	/// </summary>
+	void _CalculateBounds(const VertexArrayObject::sptr& vao) const {
+		if (_vertices.empty()) {
+			return;
+		}
+		glm::vec3 min = _vertices[0].Position;
+		glm::vec3 max = _vertices[0].Position;
+		for (const VertType& vert : _vertices) {
+			min = glm::min(min, vert.Position);
+			max = glm::max(max, vert.Position);
+		}
+		vao->SetBounds(min, max);
+
+		if constexpr (_HasUV<VertType>::value) {
+			// Compare the total area of the triangles in UV space to their area in local space
+			float uvArea = 0.0f;
+			float worldArea = 0.0f;
+			const size_t triCount = GetTriangleCount();
+			for (size_t ix = 0; ix < triCount; ix++) {
+				const VertType& a = _vertices[_indices.empty() ? ix * 3     : _indices[ix * 3]];
+				const VertType& b = _vertices[_indices.empty() ? ix * 3 + 1 : _indices[ix * 3 + 1]];
+				const VertType& c = _vertices[_indices.empty() ? ix * 3 + 2 : _indices[ix * 3 + 2]];
+				worldArea += glm::length(glm::cross(b.Position - a.Position, c.Position - a.Position));
+				const glm::vec2 uvB = b.UV - a.UV;
+				const glm::vec2 uvC = c.UV - a.UV;
+				uvArea += glm::abs(uvB.x * uvC.y - uvB.y * uvC.x);
+			}
+			if (worldArea > 0.0f && uvArea > 0.0f) {
+				vao->SetUvDensity(glm::sqrt(uvArea / worldArea));
+			}
+		}
+	}
 	
 	std::vector<VertType> _vertices;
 	std::vector<uint32_t> _indices;
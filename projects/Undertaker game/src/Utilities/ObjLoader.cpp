@@ -9,6 +9,11 @@
 #include "StringUtils.h"
 
 VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, const glm::vec4& inColor)
+{
+	return LoadMeshData(filename, inColor).Bake();
+}
+
+MeshBuilder<VertexPosNormTexCol> ObjLoader::LoadMeshData(const std::string& filename, const glm::vec4& inColor)
 {	
 	// Open our file in binary mode
 	std::ifstream file;
@@ -125,5 +130,5 @@ VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, con
 	// You'll need to keep track of these and create vertex entries for each vertex in the face
 	// If you want to get fancy, you can track which vertices you've already added
 
-	return mesh.Bake();
+	return mesh;
 }
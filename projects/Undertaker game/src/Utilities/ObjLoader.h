@@ -5,6 +5,13 @@ class ObjLoader
 {
 public:
 	static VertexArrayObject::sptr LoadFromFile(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f));
+	/// <summary>
+	/// Loads an OBJ file into a mesh builder without creating any OpenGL objects, so that tools (like the lightmap
+	/// baker) can work with the geometry on the CPU, or without a context at all
+	/// </summary>
+	/// <param name="filename">The path of the file to load</param>
+	/// <param name="inColor">The color to give every vertex</param>
+	static MeshBuilder<VertexPosNormTexCol> LoadMeshData(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f));
 
 protected:
 	ObjLoader() = default;
@@ -0,0 +1,56 @@
+#pragma once
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// Helpers for 3 band (L2) spherical harmonics, which we use to store the diffuse lighting arriving at a point from
+/// every direction in 9 colors. The basis order and constants match EvaluateIrradiance in our shaders, so any
+/// coefficients made here can be handed straight to them
+/// </summary>
+class SphericalHarmonics final
+{
+public:
+	static const int COEFFICIENT_COUNT = 9;
+
+	/// <summary>
+	/// Evaluates the 9 basis functions for a direction
+	/// </summary>
+	/// <param name="d">The direction to evaluate, must be normalized</param>
+	/// <param name="basis">Receives the value of each basis function</param>
+	static void EvaluateBasis(const glm::vec3& d, float basis[COEFFICIENT_COUNT]) {
+		basis[0] = 0.282095f;
+		basis[1] = 0.488603f * d.y;
+		basis[2] = 0.488603f * d.z;
+		basis[3] = 0.488603f * d.x;
+		basis[4] = 1.092548f * d.x * d.y;
+		basis[5] = 1.092548f * d.y * d.z;
+		basis[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+		basis[7] = 1.092548f * d.x * d.z;
+		basis[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+	}
+
+	/// <summary>
+	/// Adds light arriving from a direction to a set of coefficients
+	/// </summary>
+	/// <param name="sh">The coefficients to add to</param>
+	/// <param name="direction">The direction the light is arriving from, must be normalized</param>
+	/// <param name="color">The light, already multiplied by the solid angle it covers</param>
+	static void AddSample(glm::vec3 sh[COEFFICIENT_COUNT], const glm::vec3& direction, const glm::vec3& color) {
+		float basis[COEFFICIENT_COUNT];
+		EvaluateBasis(direction, basis);
+		for (int ix = 0; ix < COEFFICIENT_COUNT; ix++) {
+			sh[ix] += color * basis[ix];
+		}
+	}
+
+	/// <summary>
+	/// Turns projected radiance into irradiance, by applying the cosine lobe (pi, 2pi/3, pi/4 per band). The result is
+	/// divided by pi, so shaders get the outgoing diffuse light directly
+	/// </summary>
+	/// <param name="sh">The coefficients to convolve, in place</param>
+	static void ConvolveCosineLobe(glm::vec3 sh[COEFFICIENT_COUNT]) {
+		const float bands[COEFFICIENT_COUNT] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+		for (int ix = 0; ix < COEFFICIENT_COUNT; ix++) {
+			sh[ix] *= bands[ix];
+		}
+	}
+};
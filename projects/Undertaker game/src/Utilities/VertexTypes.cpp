@@ -5,6 +5,7 @@ VertexPosCol* VPC = nullptr;
 VertexPosNormCol* VPNC = nullptr;
 VertexPosNormTex* VPNT = nullptr;
 VertexPosNormTexCol* VPNTC = nullptr;
+VertexPosNormTexColLm* VPNTCL = nullptr;
 
 const std::vector<BufferAttribute> VertexPosCol::V_DECL = {
 	BufferAttribute(0, 3, GL_FLOAT, false, sizeof(VertexPosCol), (size_t)&VPC->Position, AttribUsage::Position),
@@ -26,4 +27,11 @@ const std::vector<BufferAttribute> VertexPosNormTexCol::V_DECL = {
 	BufferAttribute(2, 3, GL_FLOAT, false, sizeof(VertexPosNormTexCol), (size_t)&VPNTC->Normal, AttribUsage::Normal),
 	BufferAttribute(3, 2, GL_FLOAT, false, sizeof(VertexPosNormTexCol), (size_t)&VPNTC->UV, AttribUsage::Texture),
 };
+const std::vector<BufferAttribute> VertexPosNormTexColLm::V_DECL = {
+	BufferAttribute(0, 3, GL_FLOAT, false, sizeof(VertexPosNormTexColLm), (size_t)&VPNTCL->Position, AttribUsage::Position),
+	BufferAttribute(1, 4, GL_FLOAT, false, sizeof(VertexPosNormTexColLm), (size_t)&VPNTCL->Color, AttribUsage::Color),
+	BufferAttribute(2, 3, GL_FLOAT, false, sizeof(VertexPosNormTexColLm), (size_t)&VPNTCL->Normal, AttribUsage::Normal),
+	BufferAttribute(3, 2, GL_FLOAT, false, sizeof(VertexPosNormTexColLm), (size_t)&VPNTCL->UV, AttribUsage::Texture),
+	BufferAttribute(4, 2, GL_FLOAT, false, sizeof(VertexPosNormTexColLm), (size_t)&VPNTCL->LightmapUV, AttribUsage::Texture1),
+};
 #pragma warning(pop)
\ No newline at end of file
@@ -56,5 +56,20 @@ struct VertexPosNormTexCol {
 	VertexPosNormTexCol(float x, float y, float z, float nX, float nY, float nZ, float u, float v, float r, float g, float b, float a = 1.0f) :
 		Position({ x, y, z }), Normal({ nX, nY, nZ }), UV({ u, v }), Color({r, g, b, a}) {}
 
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+// A VertexPosNormTexCol with a second, unique UV set for looking up baked lighting
+struct VertexPosNormTexColLm {
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::vec2 UV;
+	glm::vec4 Color;
+	glm::vec2 LightmapUV;
+
+	VertexPosNormTexColLm() : Position(glm::vec3(0.0f)), Normal(glm::vec3(0.0f)), UV(glm::vec2(0.0f, 0.0f)), Color(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)), LightmapUV(glm::vec2(0.0f)) {}
+	VertexPosNormTexColLm(const VertexPosNormTexCol& vert, const glm::vec2& lightmapUv) :
+		Position(vert.Position), Normal(vert.Normal), UV(vert.UV), Color(vert.Color), LightmapUV(lightmapUv) {}
+
 	static const std::vector<BufferAttribute> V_DECL;
 };
\ No newline at end of file
@@ -7,6 +7,8 @@
 #include <filesystem>
 #include <json.hpp>
 #include <fstream>
+#include <map>
+#include <thread>
 
 #include <GLM/glm.hpp>
 #include <GLM/gtc/matrix_transform.hpp>
@@ -41,8 +43,32 @@
 #include "Gameplay/Timing.h"
 #include "Graphics/TextureCubeMap.h"
 #include "Graphics/TextureCubeMapData.h"
+#include "Graphics/EnvironmentMap.h"
+#include "Graphics/ReflectionProbe.h"
+#include "Graphics/IrradianceVolume.h"
+#include "Graphics/Lightmap.h"
+#include "Graphics/Terrain.h"
+#include "Graphics/Texture2DArray.h"
 #include "Graphics/LUT.h"
+#include "Graphics/LutMixer.h"
 #include "Graphics/Post/CcEffect.h"
+#include "Graphics/Post/FogEffect.h"
+#include "Graphics/Post/GreyscaleEffect.h"
+#include "Graphics/Post/SepiaEffect.h"
+#include "Graphics/Post/PostProcessChain.h"
+#include "Graphics/TextureStreamer.h"
+#include "Graphics/GpuMemoryTracker.h"
+#include "Graphics/RenderTargetPool.h"
+#include "Graphics/FrameGraph.h"
+#include "Graphics/DynamicResolution.h"
+#include "Graphics/ParticleSystem.h"
+#include "Graphics/Impostor.h"
+#include "Graphics/CommandBuffer.h"
+#include "Graphics/FrameFence.h"
+#include "Utilities/FramePipeline.h"
+#include "Utilities/Frustum.h"
+#include "Utilities/Heightmap.h"
+#include "Utilities/LightmapBaker.h"
 #include <cstdlib>
 
 
@@ -82,11 +108,30 @@ void GlDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsi
 
 GLFWwindow* window;
 
+// GLFW can send dozens of size events a frame while a window edge is being dragged, so we only remember the latest one
+// and apply it once at the start of the next frame
+bool      windowResizePending = false;
+glm::ivec2 pendingWindowSize = glm::ivec2(0);
+
 void GlfwWindowResizedCallback(GLFWwindow* window, int width, int height) {
+	pendingWindowSize = glm::ivec2(width, height);
+	windowResizePending = true;
+}
+
+void ApplyPendingWindowResize() {
+	// A minimized window reports a size of zero, there's nothing to resize to until it comes back
+	if (!windowResizePending || pendingWindowSize.x <= 0 || pendingWindowSize.y <= 0) {
+		return;
+	}
+	windowResizePending = false;
+
+	const int width = pendingWindowSize.x;
+	const int height = pendingWindowSize.y;
 	glViewport(0, 0, width, height);
 	Application::Instance().ActiveScene->Registry().view<Camera>().each([=](Camera & cam) {
 		cam.ResizeWindow(width, height);
 	});
+	// Framebuffers only reallocate when the new size is in a different size class
 	Application::Instance().ActiveScene->Registry().view<Framebuffer>().each([=](Framebuffer& buf)
 	{
 		buf.Reshape(width, height);
@@ -215,6 +260,46 @@ void RenderVAO(
 	vao->Render();
 }
 
+// The uniforms each object sets when it's drawn. Command buffers are recorded on threads that can't look up uniform
+// locations, so they're looked up once per shader before recording starts
+struct DrawUniforms {
+	int ModelViewProjection;
+	int Model;
+	int NormalMatrix;
+};
+
+// A renderer waiting to be recorded into the scene's command buffers. The matrices are copied in, since enemies and
+// fences draw one renderer at many places in a frame
+struct SceneDraw {
+	const RendererComponent* Renderer;
+	glm::mat4                Model;
+	glm::mat3                NormalMatrix;
+	DrawUniforms             Uniforms;
+};
+
+// Records the same work as RenderVAO for a run of the scene's draws, this is called from several threads at once
+void RecordSceneDraws(CommandBuffer& commands, const std::vector<SceneDraw>& draws, size_t begin, size_t end, const glm::mat4& viewProjection) {
+	// Each run starts from nothing, so it doesn't depend on what the runs before it left bound
+	const Shader* current = nullptr;
+	const ShaderMaterial* currentMat = nullptr;
+	for (size_t ix = begin; ix < end; ix++) {
+		const SceneDraw& draw = draws[ix];
+		const ShaderMaterial& material = *draw.Renderer->Material;
+		if (current != material.Shader.get()) {
+			current = material.Shader.get();
+			commands.BindShader(*current);
+		}
+		if (currentMat != &material) {
+			currentMat = &material;
+			material.Record(commands);
+		}
+		commands.SetUniform(*current, draw.Uniforms.ModelViewProjection, viewProjection * draw.Model);
+		commands.SetUniform(*current, draw.Uniforms.Model, draw.Model);
+		commands.SetUniform(*current, draw.Uniforms.NormalMatrix, draw.NormalMatrix);
+		commands.DrawMesh(*draw.Renderer->Mesh);
+	}
+}
+
 void SetupShaderForFrame(const Shader::sptr& shader, const glm::mat4& view, const glm::mat4& projection) {
 	shader->Bind();
 	// These are the uniforms that update only once per frame
@@ -237,8 +322,6 @@ GLfloat EnemyPosX[200];
 GLfloat EnemyPosZ[200];
 GLfloat Enemy2PosX[200];
 GLfloat Enemy2PosZ[200];
-GLfloat BarrierX = -24;
-GLfloat BarrierZ = -27.5;
 GLfloat PosTimer;
 GLfloat PosMaxTime = 1.5f;
 GLfloat t = 0.0f;
@@ -264,6 +347,21 @@ glm::vec3 p0(20,10, 0), p1(0,10,20), p2(-20,10,0), p3(0,10,-20);
 
 GLfloat PUOriginPos = 1.0f;
 GLfloat PUNewPos = 3.5f;
+glm::vec3 PowerUpPos = p0;
+
+// Everything the renderer needs from one step of the game. The game thread fills one in each frame while the render
+// thread draws the one before it, so the render thread never reads the game's variables directly
+struct FramePacket
+{
+	glm::vec3 PlayerPosition;
+	float     PlayerYaw;
+	glm::vec3 PowerUpPosition;
+	bool      PowerUpTaken;
+	glm::vec3 LightPosition;
+	// Enemy positions on the ground (X and Z)
+	glm::vec2 Skeletons[200];
+	glm::vec2 Zombies[200];
+};
 
 //Keyboard Input
 //void keyboard() {
@@ -320,10 +418,11 @@ GLfloat PUNewPos = 3.5f;
 //	}
 //}
 
-void mouse() {
+// Input is handled on the render thread, so the player's position comes from the latest frame packet
+void mouse(const glm::vec3& playerPos) {
 	
 	POINT p;
-	glm::vec2 player(tranX, tranZ); //convert position coords to a vector
+	glm::vec2 player(playerPos.x, playerPos.z); //convert position coords to a vector
 
 	//Grab from entire screen position
 	if (GetCursorPos(&p)) 
@@ -513,9 +612,236 @@ float CollideZ(float tranX, float tranZ)
 		return tranZ;
 }
 
-int main() {
+// Runs one step of the game: the player, the power up, and spawning and moving the enemies. This runs on the game
+// thread, which owns every variable it touches, and everything the renderer needs from it goes into the packet
+void SimulateFrame(FramePacket& packet, float deltaTime)
+{
+	TimeCount = TimeCount + 1;
+	EnemySpawnCount = TimeCount / 200; //50
+
+	//std::cout << Catmull(-28, -24, 24, 28, t) << "\n";
+
+	PosTimer += deltaTime;
+	CatTimer += deltaTime;
+
+	if (PosTimer >= PosMaxTime)
+	{
+		PosTimer = 0.0f;
+		PULerp = !PULerp;
+	}
+
+	if (CatTimer >= CatMaxTime)
+	{
+		CatTimer = 0.0f;
+		CatmullLoop = CatmullLoop + 1;
+		if (CatmullLoop >= 4)
+			CatmullLoop = 0;
+	}
+
+	t = PosTimer / PosMaxTime;
+	CatT = CatTimer / CatMaxTime;
+
+	t = length(p1 - p0);
+
+	//Collision Function
+	tranX = CollideX(tranX, tranZ);
+	tranZ = CollideZ(tranX, tranZ);
+
+	//Set Player Movements
+	packet.PlayerPosition = glm::vec3(tranX, 1.0f, tranZ);
+	packet.PlayerYaw = rotY;
+
+	//Power Up
+	if (PULerp == true && PowerUpDropped == true)
+	{
+		PowerUpPos = glm::vec3(3.0f, LERP(PUOriginPos, PUNewPos, t), 8.0f);
+	}
+	else if (PULerp == false && PowerUpDropped == true)
+	{
+		PowerUpPos = glm::vec3(3.0f, LERP(PUNewPos, PUOriginPos, t), 8.0f);
+	}
+
+	if (tranX > 2.0f && tranX < 5.0f && tranZ > 6.5f && tranZ < 8.0f && PowerUpTaken == false && PowerUpDropped == true)
+	{				
+		if (PowerUpTaken == false && PowerUpDropped == true)
+		{
+			PowerUp = true;
+			LastTimeCount = TimeCount + 300;
+		}
+
+		PowerUpTaken = true;
+	}
+
+	if (TimeCount == LastTimeCount)
+	{
+		PowerUp = false;
+		
+	}
+
+	//Power Up Catmull Circle
+	if (CatmullLoop == 0 && PowerUpDropped == false)
+	{
+		PowerUpPos = Catmull(p0, p1, p2, p3, CatT);
+		if (rand() % 10 == 1)
+		{
+			PowerUpDropped == true;
+		}
+	}
+	else if (CatmullLoop == 1 && PowerUpDropped == false)
+	{
+		PowerUpPos = Catmull(p1, p2, p3, p0, CatT);
+		if (rand() % 10 == 1)
+		{
+			PowerUpDropped == true;
+		}
+	}
+	else if (CatmullLoop == 2 && PowerUpDropped == false)
+	{
+		PowerUpPos = Catmull(p2, p3, p0, p1, CatT);
+		if (rand() % 10 == 1)
+		{
+			PowerUpDropped == true;
+		}
+	}
+	else if (CatmullLoop == 3 && PowerUpDropped == false)
+	{
+		PowerUpPos = Catmull(p3, p0, p1, p2, CatT);
+		if (rand() % 10 == 1)
+		{
+			PowerUpDropped == true;
+		}
+	}
+
+	//Spawn Enemy
+	if (TimeCount % 10 == 0 && MaxEnemyCount < 200)
+	{
+		RandNum = rand() % 3;
+
+		if (RandNum == 0)
+		{
+			EnemyX = (rand() % 44) - 18;
+			EnemyZ = (rand() % 44) - 22;
+			if ((EnemyX > -18 && EnemyX < -14) || (EnemyX > 22 && EnemyX < 26))
+			{
+				EnemyPosX[EnemyNum] = EnemyX;
+				EnemyPosZ[EnemyNum] = EnemyZ;
+				EnemyNum = EnemyNum + 1;
+				MaxEnemyCount = MaxEnemyCount + 1;
+			}
+	}else if (RandNum == 1)
+		{
+			EnemyX = (rand() % 44) - 18;
+			EnemyZ = (rand() % 48) - 26;
+			if ((EnemyZ > -26 && EnemyZ < -22) || (EnemyZ > 18 && EnemyZ < 22))
+			{
+				EnemyPosX[EnemyNum] = EnemyX;
+				EnemyPosZ[EnemyNum] = EnemyZ;
+				EnemyNum = EnemyNum + 1;
+				MaxEnemyCount = MaxEnemyCount + 1;
+			}
+		}
+	}
+
+	//Spawn Enemy 2
+	if (TimeCount % 10 == 0 && MaxEnemy2Count < 200)
+	{
+		RandNum = rand() % 3;
+
+		if (RandNum == 0)
+		{
+			Enemy2X = (rand() % 44) - 18;
+			Enemy2Z = (rand() % 44) - 22;
+			if ((Enemy2X > -18 && Enemy2X < -14) || (Enemy2X > 22 && Enemy2X < 26))
+			{
+				Enemy2PosX[Enemy2Num] = Enemy2X;
+				Enemy2PosZ[Enemy2Num] = Enemy2Z;
+				Enemy2Num = Enemy2Num + 1;
+				MaxEnemy2Count = MaxEnemy2Count + 1;
+			}
+		}
+		else if (RandNum == 1)
+		{
+			Enemy2X = (rand() % 44) - 18;
+			Enemy2Z = (rand() % 48) - 26;
+			if ((Enemy2Z > -26 && Enemy2Z < -22) || (Enemy2Z > 18 && Enemy2Z < 22))
+			{
+				Enemy2PosX[Enemy2Num] = Enemy2X;
+				Enemy2PosZ[Enemy2Num] = Enemy2Z;
+				Enemy2Num = Enemy2Num + 1;
+				MaxEnemy2Count = MaxEnemy2Count + 1;
+			}
+		}
+	}
+
+	//Move Enemies
+	for (int Count = 0; Count < 200; Count++)
+	{
+		//Enemy X Movement
+		if (EnemyPosX[Count] > tranX)
+		{
+			EnemyPosX[Count] = EnemyPosX[Count] - 0.02;
+		}
+		else if (EnemyPosX[Count] < tranX)
+		{
+			EnemyPosX[Count] = EnemyPosX[Count] + 0.02;
+		}
+
+		//Enemy Z movement
+		if (EnemyPosZ[Count] > tranZ)
+		{
+			EnemyPosZ[Count] = EnemyPosZ[Count] - 0.02;
+		}
+		else if (EnemyPosZ[Count] < tranZ)
+		{
+			EnemyPosZ[Count] = EnemyPosZ[Count] + 0.02;
+		}
+
+		EnemyPosX[Count] = CollideX(EnemyPosX[Count], EnemyPosZ[Count]);
+		EnemyPosZ[Count] = CollideZ(EnemyPosX[Count], EnemyPosZ[Count]);
+
+		packet.Skeletons[Count] = glm::vec2(EnemyPosX[Count], EnemyPosZ[Count]);
+	}
+	for (int Count = 0; Count < 200; Count++)
+	{
+		//Enemy X Movement
+		if (Enemy2PosX[Count] > tranX)
+		{
+			Enemy2PosX[Count] = Enemy2PosX[Count] - 0.02;
+		}
+		else if (Enemy2PosX[Count] < tranX)
+		{
+			Enemy2PosX[Count] = Enemy2PosX[Count] + 0.02;
+		}
+
+		//Enemy Z movement
+		if (Enemy2PosZ[Count] > tranZ)
+		{
+			Enemy2PosZ[Count] = Enemy2PosZ[Count] - 0.02;
+		}
+		else if (Enemy2PosZ[Count] < tranZ)
+		{
+			Enemy2PosZ[Count] = Enemy2PosZ[Count] + 0.02;
+		}
+		Enemy2PosX[Count] = CollideX(Enemy2PosX[Count], Enemy2PosZ[Count]);
+		Enemy2PosZ[Count] = CollideZ(Enemy2PosX[Count], Enemy2PosZ[Count]);
+
+		packet.Zombies[Count] = glm::vec2(Enemy2PosX[Count], Enemy2PosZ[Count]);
+	}
+
+	packet.PowerUpPosition = PowerUpPos;
+	packet.PowerUpTaken = PowerUpTaken;
+	packet.LightPosition = glm::vec3(tranX, 0.0f, tranZ);
+}
+
+int main(int argc, char** argv) {
 	Logger::Init(); // We'll borrow the logger from the toolkit, but we need to initialize it
 
+	// Bake the static scenery's lighting and quit, this doesn't need a window so it can run as part of a build
+	// ex: --bake-lightmaps lightmaps/graveyard.json
+	if (argc > 1 && std::string(argv[1]) == "--bake-lightmaps") {
+		return LightmapBaker::RunFromManifest(argc > 2 ? argv[2] : "lightmaps/graveyard.json");
+	}
+
 	//Initialize GLFW
 	if (!initGLFW())
 		return 1;
@@ -542,17 +868,38 @@ int main() {
 	{
 		#pragma region Shader and ImGui
 
-		Shader::sptr colorCorrectionShader = Shader::Create();
-		colorCorrectionShader->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
-		colorCorrectionShader->LoadShaderPartFromFile("shaders/Post/color_correction_frag.glsl", GL_FRAGMENT_SHADER);
-		colorCorrectionShader->Link();
-
 		// Load our shaders
 		Shader::sptr shader = Shader::Create();
-		shader->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
+		shader->LoadShaderPartFromFiles({ "shaders/vertex_shader.glsl", "shaders/irradiance_volume.glsl" }, GL_VERTEX_SHADER);
 		shader->LoadShaderPartFromFile("shaders/frag_blinn_phong_textured.glsl", GL_FRAGMENT_SHADER);
 		shader->Link();
 
+		// The same lighting for static scenery with baked lightmaps, only the player's light is done per pixel
+		Shader::sptr lightmappedShader = Shader::Create();
+		lightmappedShader->LoadShaderPartFromFile("shaders/vertex_shader_lightmapped.glsl", GL_VERTEX_SHADER);
+		lightmappedShader->LoadShaderPartFromFile("shaders/frag_blinn_phong_lightmapped.glsl", GL_FRAGMENT_SHADER);
+		lightmappedShader->Link();
+
+		// The ground, drawn in chunks by the terrain rather than as a renderer (see Terrain)
+		Shader::sptr terrainShader = Shader::Create();
+		terrainShader->LoadShaderPartFromFiles({ "shaders/vertex_terrain.glsl", "shaders/irradiance_volume.glsl" }, GL_VERTEX_SHADER);
+		terrainShader->LoadShaderPartFromFile("shaders/frag_terrain.glsl", GL_FRAGMENT_SHADER);
+		terrainShader->Link();
+
+		// Draws distant scenery and enemies as impostors, which are lit the same way as everything else
+		ImpostorSystem impostorSystem;
+
+		// Most of the scene is recorded into command buffers across a few threads, then replayed by the executor. The
+		// lists are kept between frames so their memory is reused
+		CommandExecutor commandExecutor;
+		std::vector<CommandBuffer> sceneCommands;
+		std::vector<SceneDraw> sceneDraws;
+		uint32_t sceneRecordThreads = 1;
+
+		// Frame packets from the game thread, and fences on the frames we've handed to the GPU
+		FramePipeline<FramePacket> framePackets;
+		FrameFence frameFence;
+
 		glm::vec3 lightPos = glm::vec3(-24.0f, 0.0f, 20.0f);
 		glm::vec3 lightCol = glm::vec3(0.9f, 0.85f, 0.5f);
 		float     lightAmbientPow = 1.0f;
@@ -572,22 +919,42 @@ int main() {
 
 		// These are our application / scene level uniforms that don't necessarily update
 		// every frame
-		shader->SetUniform("u_LightPos", lightPos);
-		shader->SetUniform("u_LightCol", lightCol);
-		shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-		shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-		shader->SetUniform("u_AmbientCol", ambientCol);
-		shader->SetUniform("u_AmbientStrength", ambientPow);
-		shader->SetUniform("u_LightAttenuationConstant", 1.0f);
-		shader->SetUniform("u_LightAttenuationLinear", lightLinearFalloff);
-		shader->SetUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
-		shader->SetUniform("u_Option1", (int)Option1);
-		shader->SetUniform("u_Option2", (int)Option2);
-		shader->SetUniform("u_Option3", (int)Option3);
-		shader->SetUniform("u_Option4", (int)Option4);
-		shader->SetUniform("u_Option5", (int)Option5);
-
-		PostEffect* basicEffect;
+		for (const Shader::sptr& lit : { shader, lightmappedShader, terrainShader, impostorSystem.GetShader() }) {
+			lit->SetUniform("u_LightPos", lightPos);
+			lit->SetUniform("u_LightCol", lightCol);
+			lit->SetUniform("u_AmbientLightStrength", lightAmbientPow);
+			lit->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+			lit->SetUniform("u_AmbientCol", ambientCol);
+			lit->SetUniform("u_AmbientStrength", ambientPow);
+			lit->SetUniform("u_LightAttenuationConstant", 1.0f);
+			lit->SetUniform("u_LightAttenuationLinear", lightLinearFalloff);
+			lit->SetUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
+			lit->SetUniform("u_Option1", (int)Option1);
+			lit->SetUniform("u_Option2", (int)Option2);
+			lit->SetUniform("u_Option3", (int)Option3);
+			lit->SetUniform("u_Option4", (int)Option4);
+			lit->SetUniform("u_Option5", (int)Option5);
+		}
+
+		// Describes the passes that make up each frame, and keeps their timings
+		FrameGraph frameGraph;
+		// Our color grading chain, runs of per pixel effects get fused into a single pass
+		FogEffect fog;
+		CcEffect colorGrade;
+		GreyscaleEffect greyscale;
+		SepiaEffect sepia;
+		PostProcessChain postChain;
+		// Scales the scene's resolution to keep us within our GPU frame time
+		DynamicResolution dynamicResolution;
+		// Keeps the reflection probes up to date, a face at a time
+		ReflectionProbeSystem probeSystem;
+		// The heightmap the level sits on, created with the rest of the scene
+		Terrain::sptr heightmapTerrain;
+		// Simulates and draws every particle emitter in the scene
+		ParticleSystem particleSystem;
+		// How much of the brightened, warm, cool and custom grades to blend together
+		const char* gradeNames[4] = { "Brightened", "Warm", "Cool", "Custom" };
+		float gradeWeights[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
 		
 		// We'll add some ImGui controls to control our shader
 		imGuiCallbacks.push_back([&]() {
@@ -635,11 +1002,13 @@ int main() {
 					Option5 = true;
 				}
 
-				shader->SetUniform("u_Option1", (int)Option1);
-				shader->SetUniform("u_Option2", (int)Option2);
-				shader->SetUniform("u_Option3", (int)Option3);
-				shader->SetUniform("u_Option4", (int)Option4);
-				shader->SetUniform("u_Option5", (int)Option5);
+				for (const Shader::sptr& lit : { shader, lightmappedShader, terrainShader, impostorSystem.GetShader() }) {
+					lit->SetUniform("u_Option1", (int)Option1);
+					lit->SetUniform("u_Option2", (int)Option2);
+					lit->SetUniform("u_Option3", (int)Option3);
+					lit->SetUniform("u_Option4", (int)Option4);
+					lit->SetUniform("u_Option5", (int)Option5);
+				}
 			}
 			
 			#pragma region Lighting Settings
@@ -685,6 +1054,86 @@ int main() {
 			}
 			ImGui::PlotLines("FPS", fpsBuffer, 128);
 			ImGui::Text("MIN: %f MAX: %f AVG: %f", minFps, maxFps, avgFps / 128.0f);
+
+			if (ImGui::CollapsingHeader("Texture Streaming"))
+			{
+				TextureStreamer& streamer = TextureStreamer::Instance();
+				int budgetKb = (int)(streamer.UploadBudgetBytes / 1024);
+				if (ImGui::SliderInt("Upload Budget (KB)", &budgetKb, 64, 16384)) {
+					streamer.UploadBudgetBytes = (size_t)budgetKb * 1024;
+				}
+				ImGui::SliderFloat("Mip Bias", &streamer.MipBias, -2.0f, 4.0f);
+				ImGui::Text("Textures: %d Resident: %.2f MB Uploaded: %.1f KB", (int)streamer.GetTextureCount(),
+					streamer.GetResidentBytes() / (1024.0f * 1024.0f), streamer.GetUploadedBytes() / 1024.0f);
+			}
+			if (ImGui::CollapsingHeader("Post Processing"))
+			{
+				glm::vec3 fogColor = fog.GetColor();
+				float fogDensity = fog.GetDensity();
+				float fogStart = fog.GetStart();
+				ImGui::Checkbox("Fog", &fog.Enabled);
+				if (ImGui::ColorEdit3("Fog Color", &fogColor[0])) { fog.SetColor(fogColor); }
+				if (ImGui::SliderFloat("Fog Density", &fogDensity, 0.0f, 0.2f)) { fog.SetDensity(fogDensity); }
+				if (ImGui::SliderFloat("Fog Start", &fogStart, 0.0f, 50.0f)) { fog.SetStart(fogStart); }
+				ImGui::SliderFloat("Fog Edge Sharpness", &postChain.DepthSharpness, 0.0f, 100.0f);
+				float intensity = colorGrade.GetIntensity();
+				ImGui::Checkbox("Color Grade", &colorGrade.Enabled);
+				if (ImGui::SliderFloat("Grade Intensity", &intensity, 0.0f, 1.0f)) { colorGrade.SetIntensity(intensity); }
+				for (int ix = 0; ix < 4; ix++) {
+					ImGui::SliderFloat(gradeNames[ix], &gradeWeights[ix], 0.0f, 1.0f);
+				}
+				intensity = greyscale.GetIntensity();
+				ImGui::Checkbox("Greyscale", &greyscale.Enabled);
+				if (ImGui::SliderFloat("Greyscale Intensity", &intensity, 0.0f, 1.0f)) { greyscale.SetIntensity(intensity); }
+				intensity = sepia.GetIntensity();
+				ImGui::Checkbox("Sepia", &sepia.Enabled);
+				if (ImGui::SliderFloat("Sepia Intensity", &intensity, 0.0f, 1.0f)) { sepia.SetIntensity(intensity); }
+				ImGui::Text("Post passes: %d", postChain.GetPassCount());
+			}
+			if (ImGui::CollapsingHeader("Dynamic Resolution"))
+			{
+				dynamicResolution.RenderImGui();
+				ImGui::SliderFloat("Upscale Sharpness", &postChain.Sharpness, 0.0f, 1.0f);
+			}
+			if (ImGui::CollapsingHeader("Frame Graph"))
+			{
+				frameGraph.RenderImGui();
+			}
+			if (ImGui::CollapsingHeader("GPU Memory"))
+			{
+				GpuMemoryTracker::Instance().RenderImGui();
+				RenderTargetPool& pool = RenderTargetPool::Instance();
+				ImGui::Text("Pooled render targets: %d (%d in use, peak %d)", (int)pool.GetTargetCount(),
+					(int)pool.GetActiveCount(), (int)pool.GetPeakActiveCount());
+			}
+			if (ImGui::CollapsingHeader("Reflection Probes"))
+			{
+				probeSystem.RenderImGui(Application::Instance().ActiveScene->Registry());
+			}
+			if (heightmapTerrain != nullptr && ImGui::CollapsingHeader("Terrain"))
+			{
+				heightmapTerrain->RenderImGui();
+			}
+			if (ImGui::CollapsingHeader("Particles"))
+			{
+				particleSystem.RenderImGui(Application::Instance().ActiveScene->Registry());
+			}
+			if (ImGui::CollapsingHeader("Impostors"))
+			{
+				impostorSystem.RenderImGui();
+			}
+			if (ImGui::CollapsingHeader("Command Buffers"))
+			{
+				ImGui::Text("Recorded %d draws on %d thread(s)", (int)sceneDraws.size(), (int)sceneRecordThreads);
+				commandExecutor.RenderImGui();
+			}
+			if (ImGui::CollapsingHeader("Frame Pipeline"))
+			{
+				ImGui::Text("Packets waiting: %d", (int)framePackets.GetReadyCount());
+				ImGui::Text("Render thread waited %.3f ms for the game", framePackets.GetReadWaitMs());
+				ImGui::Text("Game thread waited %.3f ms for the renderer", framePackets.GetWriteWaitMs());
+				ImGui::Text("Render thread waited %.3f ms for the GPU", frameFence.GetLastWaitMs());
+			}
 			});
 
 		#pragma endregion 
@@ -696,24 +1145,31 @@ int main() {
 
 		#pragma region TEXTURE LOADING
 
-		// Load some textures from files
-		Texture2D::sptr grass = Texture2D::LoadFromFile("images/Grass.jpg");
-		Texture2D::sptr checker = Texture2D::LoadFromFile("images/checker.jpg");
-		Texture2D::sptr red = Texture2D::LoadFromFile("images/red.jpg");
-		Texture2D::sptr stone = Texture2D::LoadFromFile("images/stone.jpg");
-		Texture2D::sptr wood = Texture2D::LoadFromFile("images/wood.jpg");
-		Texture2D::sptr bark = Texture2D::LoadFromFile("images/bark.jpg");
-		Texture2D::sptr white = Texture2D::LoadFromFile("images/white.jpg");
-		Texture2D::sptr skeleton = Texture2D::LoadFromFile("images/skeleton.png");
-		Texture2D::sptr character = Texture2D::LoadFromFile("images/player.png");
-		Texture2D::sptr zombie = Texture2D::LoadFromFile("images/zombie.png");
-		Texture2D::sptr bullettex = Texture2D::LoadFromFile("images/bullet.png");
+		// Load some textures from files, only the low mips are uploaded now and the rest stream in as they are needed
+		TextureStreamer& streamer = TextureStreamer::Instance();
+		Texture2D::sptr grass = streamer.LoadFromFile("images/Grass.jpg");
+		Texture2D::sptr checker = streamer.LoadFromFile("images/checker.jpg");
+		Texture2D::sptr stone = streamer.LoadFromFile("images/stone.jpg");
+		Texture2D::sptr wood = streamer.LoadFromFile("images/wood.jpg");
+		Texture2D::sptr bark = streamer.LoadFromFile("images/bark.jpg");
+		Texture2D::sptr white = streamer.LoadFromFile("images/white.jpg");
+		Texture2D::sptr skeleton = streamer.LoadFromFile("images/skeleton.png");
+		Texture2D::sptr character = streamer.LoadFromFile("images/player.png");
+		Texture2D::sptr zombie = streamer.LoadFromFile("images/zombie.png");
+		Texture2D::sptr bullettex = streamer.LoadFromFile("images/bullet.png");
 		LUT3D baseCube("cubes/Neutral-512.cube");
 		LUT3D testCube("cubes/BrightenedCorrection.cube");
 		LUT3D warmCube("cubes/WarmColor.cube");
 		LUT3D coolCube("cubes/CoolColor.cube");
 		LUT3D customCube("cubes/CustomColor.cube");
 
+		// Blends our grades into a single LUT, so stacking them still only costs one lookup
+		LutMixer lutMixer;
+		lutMixer.AddSource(&testCube);
+		lutMixer.AddSource(&warmCube);
+		lutMixer.AddSource(&coolCube);
+		lutMixer.AddSource(&customCube);
+
 		// Creating an empty texture
 		Texture2DDescription desc = Texture2DDescription();
 		desc.Width = 1;
@@ -732,6 +1188,8 @@ int main() {
 		GameScene::RegisterComponentType<RendererComponent>();
 		GameScene::RegisterComponentType<BehaviourBinding>();
 		GameScene::RegisterComponentType<Camera>();
+		GameScene::RegisterComponentType<ParticleEmitter>();
+		GameScene::RegisterComponentType<ImpostorLOD>();
 
 		// Create a scene, and set it to be the active scene in the application
 		GameScene::sptr scene = GameScene::Create("test");
@@ -751,11 +1209,6 @@ int main() {
 		checkertexture->Set("s_Diffuse", checker);
 		checkertexture->Set("u_Shininess", 8.0f);
 
-		ShaderMaterial::sptr redtexture = ShaderMaterial::Create();
-		redtexture->Shader = shader;
-		redtexture->Set("s_Diffuse", red);
-		redtexture->Set("u_Shininess", 8.0f);
-
 		ShaderMaterial::sptr stonetexture = ShaderMaterial::Create();
 		stonetexture->Shader = shader;
 		stonetexture->Set("s_Diffuse", stone);
@@ -798,16 +1251,59 @@ int main() {
 
 		// Load a second material for our reflective material!
 		Shader::sptr reflectiveShader = Shader::Create();
-		reflectiveShader->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
+		reflectiveShader->LoadShaderPartFromFiles({ "shaders/vertex_shader.glsl", "shaders/irradiance_volume.glsl" }, GL_VERTEX_SHADER);
 		reflectiveShader->LoadShaderPartFromFile("shaders/frag_reflection.frag.glsl", GL_FRAGMENT_SHADER);
 		reflectiveShader->Link();
 
+		// The environment is filtered in the background (or read from its cache), until then it's a flat grey
+		EnvironmentMap::sptr environment = EnvironmentMap::Create("images/cubemaps/skybox/sky.png");
+		environment->SetUniforms(reflectiveShader);
+
+		ShaderMaterial::sptr reflectiveMaterial = ShaderMaterial::Create();
+		reflectiveMaterial->Shader = reflectiveShader;
+		reflectiveMaterial->Set("s_Environment", environment->GetRadiance());
+		reflectiveMaterial->Set("u_Roughness", 0.2f);
+		reflectiveMaterial->Set("u_Metallic", 1.0f);
+		reflectiveMaterial->UsesReflectionProbes = true;
+		probeSystem.SetUniforms(reflectiveShader);
+
 		//GameObjects
+		// The graveyard is flat, the hills around it are far enough out not to get in the way. The bounds need to
+		// match the Terrain entry in lightmaps/graveyard.json
+		{
+			Terrain::Settings settings;
+			settings.Position = glm::vec3(-90.0f, 0.0f, -89.0f);
+			settings.Size = glm::vec3(180.0f, 14.0f, 180.0f);
+
+			Texture2DArrayDescription desc;
+			desc.Width = 1024;
+			desc.Height = 1024;
+			desc.Layers = 3;
+			desc.Format = InternalFormat::RGB8;
+			Texture2DArray::sptr layers = Texture2DArray::Create(desc);
+			layers->SetDebugName("Terrain Layers");
+			// In the same order as the splat map's channels, grass, rock on the slopes, and dirt for the paths
+			const char* layerFiles[3] = { "images/grass.jpg", "images/stone.jpg", "images/bark.jpg" };
+			for (uint32_t ix = 0; ix < 3; ix++) {
+				layers->LoadLayer(ix, Texture2DData::LoadFromFile(layerFiles[ix]));
+			}
+			layers->GenerateMipMaps();
+
+			Texture2D::sptr splatmap = Texture2D::LoadFromFile("terrain/graveyard_splat.png");
+			splatmap->SetWrapS(WrapMode::ClampToEdge);
+			splatmap->SetWrapT(WrapMode::ClampToEdge);
+			splatmap->SetMinFilter(MinFilter::LinearMipLinear);
+			heightmapTerrain = Terrain::Create(settings, Heightmap::LoadFromFile("terrain/graveyard_height.png"), splatmap, layers);
+		}
+
+		// Reflection probes only know how to draw renderers, so they get a coarse copy of the terrain to capture
 		GameObject terrain = scene->CreateEntity("Terrain");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Terrain.obj");
-			terrain.emplace<RendererComponent>().SetMesh(vao).SetMaterial(grassmaterial);
-			terrain.get<Transform>().SetLocalPosition(0.0f, 0.0f, 1.0f).SetLocalScale(6.0f, 0.0f, 6.0f);
+			const Terrain::Settings& settings = heightmapTerrain->GetSettings();
+			const glm::vec2 tiling = glm::vec2(settings.Size.x, settings.Size.z) / settings.LayerTiling;
+			VertexArrayObject::sptr vao = heightmapTerrain->GetHeightmap()->BuildMesh(4, tiling, settings.Size).Bake();
+			terrain.emplace<RendererComponent>().SetMesh(vao).SetMaterial(grassmaterial).ProbeOnly = true;
+			terrain.get<Transform>().SetLocalPosition(settings.Position).SetLocalScale(settings.Size);
 			BehaviourBinding::BindDisabled<SimpleMoveBehaviour>(terrain);
 		}
 		
@@ -829,20 +1325,19 @@ int main() {
 		int width, height;
 		glfwGetWindowSize(window, &width, &height);
 
-		Framebuffer* colorCorrect;
-		GameObject colorCorrectionObj = scene->CreateEntity("Color Correction");
-		{
-			colorCorrect = &colorCorrectionObj.emplace<Framebuffer>();
-			colorCorrect->AddColorTarget(GL_RGBA8);
-			colorCorrect->AddDepthTarget();
-			colorCorrect->Init(width, height);
-		}
+		fog.Init(width, height);
+		fog.Enabled = false;
+		colorGrade.Init(width, height);
+		colorGrade.SetLUT(&lutMixer.GetOutput());
+		greyscale.Init(width, height);
+		greyscale.Enabled = false;
+		sepia.Init(width, height);
+		sepia.Enabled = false;
+		postChain.AddEffect(&fog);
+		postChain.AddEffect(&colorGrade);
+		postChain.AddEffect(&greyscale);
+		postChain.AddEffect(&sepia);
 
-		GameObject framebufferObject = scene->CreateEntity("Basic Effect");
-		{
-			basicEffect = &framebufferObject.emplace<PostEffect>();
-			basicEffect->Init(width, height);
-		}
 
 		VertexArrayObject::sptr vao1 = ObjLoader::LoadFromFile("models/skeleton.obj");
 		VertexArrayObject::sptr vao2 = ObjLoader::LoadFromFile("models/powerup.obj");
@@ -892,9 +1387,10 @@ int main() {
 		}
 
 		//Powerup vao
+		// The powerup is polished metal, so it picks up the sky and the probes around the graveyard
 		GameObject powerup = scene->CreateEntity("powerup");
 		{
-			powerup.emplace<RendererComponent>().SetMesh(vao2).SetMaterial(redtexture);
+			powerup.emplace<RendererComponent>().SetMesh(vao2).SetMaterial(reflectiveMaterial);
 			powerup.get<Transform>().SetLocalPosition(3.0f, 1.0f, 8.0f);
 			BehaviourBinding::BindDisabled<SimpleMoveBehaviour>(powerup);
 		}
@@ -1020,19 +1516,98 @@ int main() {
 			brokenwall.get<Transform>().SetLocalPosition(-22, 1, -22).SetLocalRotation(0, 0, 0).SetLocalScale(0.4, 0.4, 0.4);
 			BehaviourBinding::BindDisabled<SimpleMoveBehaviour>(brokenwall);
 		}
+
+		// Scenery that never moves is all the reflection probes will capture
+		for (GameObject scenery : { terrain, fencegate, cross, slab, spiderweb, deadtree, deadtree2, treestump1, treestump2,
+			treestump3, treestump4, treestump5, gravestone1, gravestone2, roundgravestone, brokenwall }) {
+			scenery.get<RendererComponent>().IsStatic = true;
+		}
+
+		// Scenery and enemies get swapped out for impostors when they're far away, objects with the same mesh and
+		// texture share an atlas
+		std::map<std::pair<VertexArrayObject*, ITexture*>, ImpostorAtlas::sptr> impostorAtlases;
+		auto getImpostor = [&](const RendererComponent& renderer) {
+			auto diffuse = renderer.Material->Textures.find(ShaderParamName("s_Diffuse"));
+			ITexture::sptr texture = diffuse != renderer.Material->Textures.end() ? diffuse->second : nullptr;
+			ImpostorAtlas::sptr& atlas = impostorAtlases[{ renderer.Mesh.get(), texture.get() }];
+			if (atlas == nullptr) {
+				atlas = impostorSystem.Bake(renderer.Mesh, texture);
+			}
+			return atlas;
+		};
+		for (GameObject scenery : { cross, slab, deadtree, deadtree2, treestump1, treestump2, treestump3, treestump4,
+			treestump5, gravestone1, gravestone2, roundgravestone, brokenwall }) {
+			scenery.emplace<ImpostorLOD>().Atlas = getImpostor(scenery.get<RendererComponent>());
+		}
+		// Every enemy is drawn through one object (see the scene pass), so they pick between mesh and impostor per enemy
+		ImpostorAtlas::sptr skeletonImpostor = getImpostor(enemy.get<RendererComponent>());
+		ImpostorAtlas::sptr zombieImpostor = getImpostor(enemy2.get<RendererComponent>());
+		LOG_INFO("Baked {} impostor atlases", impostorAtlases.size());
+
+		// Ghostly wisps rise off the graves, and dust drifts in through the gate
+		for (GameObject grave : { gravestone1, gravestone2, roundgravestone }) {
+			grave.emplace<ParticleEmitter>(ParticleEmitter::Ectoplasm());
+		}
+		GameObject gateDust = scene->CreateEntity("gateDust");
+		{
+			gateDust.emplace<ParticleEmitter>(ParticleEmitter::Dust());
+			gateDust.get<Transform>().SetLocalPosition(-1, 0.5f, 24);
+		}
+
+		// Swap in the baked lighting for any static scenery that has it. The baked mesh carries the lightmap UVs, and
+		// each object needs its own copy of its material to hold its lightmap
+		int lightmapCount = 0;
+		scene->Registry().view<GameObjectTag, RendererComponent, Transform>().each(
+			[&](entt::entity, GameObjectTag& tag, RendererComponent& renderer, Transform& transform) {
+			if (!renderer.IsStatic || renderer.ProbeOnly) {
+				return;
+			}
+			Lightmap::sptr lightmap = Lightmap::LoadFromFile(Lightmap::GetPath("lightmaps", tag.Name), transform.LocalTransform());
+			if (lightmap != nullptr) {
+				ShaderMaterial::sptr material = renderer.Material->CloneWithShader(lightmappedShader);
+				material->Set("s_Lightmap", lightmap->GetTexture());
+				renderer.SetMesh(lightmap->GetMesh()).SetMaterial(material);
+				lightmapCount++;
+			}
+		});
+		LOG_INFO("Using baked lighting for {} static objects", lightmapCount);
+		Lightmap::sptr terrainLightmap = Lightmap::LoadFromFile(Lightmap::GetPath("lightmaps", "Terrain"), heightmapTerrain->GetTransform());
+		if (terrainLightmap != nullptr) {
+			heightmapTerrain->SetLightmap(terrainLightmap->GetTexture());
+		}
+
+		// Everything else (the player, enemies, and scenery without a lightmap) gets its ambient light from the probes
+		IrradianceVolume::sptr irradianceVolume = IrradianceVolume::LoadFromFile(IrradianceVolume::GetPath("lightmaps"));
+		if (irradianceVolume != nullptr) {
+			irradianceVolume->SetUniforms(shader);
+			irradianceVolume->SetUniforms(terrainShader);
+			irradianceVolume->SetUniforms(impostorSystem.GetShader());
+		}
+
+		// Probes on either side of the graveyard, reflective objects blend between the two closest
+		GameObject probeWest = scene->CreateEntity("probeWest");
+		{
+			probeWest.emplace<ReflectionProbe>();
+			probeWest.get<Transform>().SetLocalPosition(-12.0f, 3.0f, 0.0f);
+		}
+		GameObject probeEast = scene->CreateEntity("probeEast");
+		{
+			probeEast.emplace<ReflectionProbe>();
+			probeEast.get<Transform>().SetLocalPosition(12.0f, 3.0f, 0.0f);
+		}
 		
 
 		#pragma endregion 
 		{
 			// Load our shaders
 			Shader::sptr shaders = std::make_shared<Shader>();
-			shaders->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
+			shaders->LoadShaderPartFromFiles({ "shaders/vertex_shader.glsl", "shaders/irradiance_volume.glsl" }, GL_VERTEX_SHADER);
 			shaders->LoadShaderPartFromFile("shaders/frag_blinn_phong_textured.glsl", GL_FRAGMENT_SHADER);
 			shaders->Link();
 
 			// Load our shaders
 			Shader::sptr shaders2 = std::make_shared<Shader>();
-			shaders2->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
+			shaders2->LoadShaderPartFromFiles({ "shaders/vertex_shader.glsl", "shaders/irradiance_volume.glsl" }, GL_VERTEX_SHADER);
 			shaders2->LoadShaderPartFromFile("shaders/frag_blinn_phong_textured.glsl", GL_FRAGMENT_SHADER);
 			shaders2->Link();
 
@@ -1059,45 +1634,41 @@ int main() {
 
 		double testNum;
 
+		// The game runs a step ahead on its own thread, while this thread (which owns the window and GL context) draws
+		// the last step it finished, so a frame takes as long as the slower of the two instead of both added together
+		std::thread gameThread([&framePackets]() {
+			double lastStep = glfwGetTime();
+			while (FramePacket* packet = framePackets.BeginWrite()) {
+				const double now = glfwGetTime();
+				SimulateFrame(*packet, glm::min(static_cast<float>(now - lastStep), 1.0f));
+				lastStep = now;
+				framePackets.EndWrite();
+			}
+		});
+
 		///// Game loop /////
 		while (!glfwWindowShouldClose(window)) {
 			glfwPollEvents();
+			ApplyPendingWindowResize();
+
+			// Don't get more than a couple of frames ahead of the GPU, then pick up the next step the game thread finished
+			frameFence.Wait();
+			const FramePacket* packet = framePackets.BeginRead();
+			if (packet == nullptr) {
+				break;
+			}
 
 			// Update the timing
 			time.CurrentFrame = glfwGetTime();
 			time.DeltaTime = static_cast<float>(time.CurrentFrame - time.LastFrame);
 
-			TimeCount = TimeCount + 1;
-			EnemySpawnCount = TimeCount / 200; //50
-			
-			//std::cout << Catmull(-28, -24, 24, 28, t) << "\n";
-			
 			time.DeltaTime = time.DeltaTime > 1.0f ? 1.0f : time.DeltaTime;
 
-			PosTimer += time.DeltaTime;
-			CatTimer += time.DeltaTime;
-
-			lightPos = glm::vec3(tranX, 0.0f, tranZ);
+			lightPos = packet->LightPosition;
 			shader->SetUniform("u_LightPos", lightPos);
-
-			if (PosTimer >= PosMaxTime)
-			{
-				PosTimer = 0.0f;
-				PULerp = !PULerp;
-			}
-
-			if (CatTimer >= CatMaxTime)
-			{
-				CatTimer = 0.0f;
-				CatmullLoop = CatmullLoop + 1;
-				if (CatmullLoop >= 4)
-					CatmullLoop = 0;
-			}
-
-			t = PosTimer / PosMaxTime;
-			CatT = CatTimer / CatMaxTime;
-
-			t = length(p1 - p0);
+			lightmappedShader->SetUniform("u_LightPos", lightPos);
+			terrainShader->SetUniform("u_LightPos", lightPos);
+			impostorSystem.GetShader()->SetUniform("u_LightPos", lightPos);
 
 			// Update our FPS tracker data
 			fpsBuffer[frameIx] = 1.0f / time.DeltaTime;
@@ -1106,7 +1677,7 @@ int main() {
 				frameIx = 0;
 
 			//keyboard();
-			mouse();
+			mouse(packet->PlayerPosition);
 
 			// We'll make sure our UI isn't focused before we start handling input for our game
 			if (!ImGui::IsAnyWindowFocused()) {
@@ -1128,15 +1699,13 @@ int main() {
 				}
 			});
 
-			// Clear the screen
+			particleSystem.Update(scene->Registry(), time.DeltaTime);
 
-			basicEffect->Clear();
-			colorCorrect->Clear();
-
-			glClearColor(0.08f, 0.17f, 0.31f, 1.0f);
-			glEnable(GL_DEPTH_TEST);
-			glClearDepth(1.0);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			// Our render targets are sized to match the window, but the scene only renders into part of them when
+			// we're running behind
+			glfwGetWindowSize(window, &width, &height);
+			dynamicResolution.Update(frameGraph.GetTotalGpuMs());
+			const glm::uvec2 renderSize = dynamicResolution.GetRenderSize(width, height);
 
 			// Grab out camera info from the camera object
 			Transform& camTransform = cameraObject.get<Transform>();
@@ -1144,135 +1713,10 @@ int main() {
 			glm::mat4 projection = cameraObject.get<Camera>().GetProjection();
 			glm::mat4 viewProjection = projection * view;
 			
-			//Collision Function
-			tranX = CollideX(tranX, tranZ);
-			tranZ = CollideZ(tranX, tranZ);
-
-			//Set Player Movements
-			player.get<Transform>().SetLocalPosition(tranX, 1.0f, tranZ).SetLocalRotation(0.0f, rotY, 1.0f);
-
-			//Power Up
-			if (PULerp == true && PowerUpDropped == true)
-			{
-				powerup.get<Transform>().SetLocalPosition(3.0f, LERP(PUOriginPos, PUNewPos, t), 8.0f);
-			}
-			else if (PULerp == false && PowerUpDropped == true)
-			{
-				powerup.get<Transform>().SetLocalPosition(3.0f, LERP(PUNewPos, PUOriginPos, t), 8.0f);
-			}
-
-			if (tranX > 2.0f && tranX < 5.0f && tranZ > 6.5f && tranZ < 8.0f && PowerUpTaken == false && PowerUpDropped == true)
-			{				
-				if (PowerUpTaken == false && PowerUpDropped == true)
-				{
-					PowerUp = true;
-					LastTimeCount = TimeCount + 300;
-				}
-
-				PowerUpTaken = true;
-			}
-
-			if (TimeCount == LastTimeCount)
-			{
-				PowerUp = false;
-				
-			}
-
-			//Power Up Catmull Circle
-			if (CatmullLoop == 0 && PowerUpDropped == false)
-			{
-				powerup.get<Transform>().SetLocalPosition(Catmull(p0, p1, p2, p3, CatT));
-				if (rand() % 10 == 1)
-				{
-					PowerUpDropped == true;
-				}
-			}
-			else if (CatmullLoop == 1 && PowerUpDropped == false)
-			{
-				powerup.get<Transform>().SetLocalPosition(Catmull(p1, p2, p3, p0, CatT));
-				if (rand() % 10 == 1)
-				{
-					PowerUpDropped == true;
-				}
-			}
-			else if (CatmullLoop == 2 && PowerUpDropped == false)
-			{
-				powerup.get<Transform>().SetLocalPosition(Catmull(p2, p3, p0, p1, CatT));
-				if (rand() % 10 == 1)
-				{
-					PowerUpDropped == true;
-				}
-			}
-			else if (CatmullLoop == 3 && PowerUpDropped == false)
-			{
-				powerup.get<Transform>().SetLocalPosition(Catmull(p3, p0, p1, p2, CatT));
-				if (rand() % 10 == 1)
-				{
-					PowerUpDropped == true;
-				}
-			}
-			
-			//Spawn Enemy
-			if (TimeCount % 10 == 0 && MaxEnemyCount < 200)
-			{
-				RandNum = rand() % 3;
-
-				if (RandNum == 0)
-				{
-					EnemyX = (rand() % 44) - 18;
-					EnemyZ = (rand() % 44) - 22;
-					if ((EnemyX > -18 && EnemyX < -14) || (EnemyX > 22 && EnemyX < 26))
-					{
-						EnemyPosX[EnemyNum] = EnemyX;
-						EnemyPosZ[EnemyNum] = EnemyZ;
-						EnemyNum = EnemyNum + 1;
-						MaxEnemyCount = MaxEnemyCount + 1;
-					}
-			}else if (RandNum == 1)
-				{
-					EnemyX = (rand() % 44) - 18;
-					EnemyZ = (rand() % 48) - 26;
-					if ((EnemyZ > -26 && EnemyZ < -22) || (EnemyZ > 18 && EnemyZ < 22))
-					{
-						EnemyPosX[EnemyNum] = EnemyX;
-						EnemyPosZ[EnemyNum] = EnemyZ;
-						EnemyNum = EnemyNum + 1;
-						MaxEnemyCount = MaxEnemyCount + 1;
-					}
-				}
-			}
+			// Move the objects the game thread owns to where it left them
+			player.get<Transform>().SetLocalPosition(packet->PlayerPosition).SetLocalRotation(0.0f, packet->PlayerYaw, 1.0f);
+			powerup.get<Transform>().SetLocalPosition(packet->PowerUpPosition);
 
-			//Spawn Enemy 2
-			if (TimeCount % 10 == 0 && MaxEnemy2Count < 200)
-			{
-				RandNum = rand() % 3;
-
-				if (RandNum == 0)
-				{
-					Enemy2X = (rand() % 44) - 18;
-					Enemy2Z = (rand() % 44) - 22;
-					if ((Enemy2X > -18 && Enemy2X < -14) || (Enemy2X > 22 && Enemy2X < 26))
-					{
-						Enemy2PosX[Enemy2Num] = Enemy2X;
-						Enemy2PosZ[Enemy2Num] = Enemy2Z;
-						Enemy2Num = Enemy2Num + 1;
-						MaxEnemy2Count = MaxEnemy2Count + 1;
-					}
-				}
-				else if (RandNum == 1)
-				{
-					Enemy2X = (rand() % 44) - 18;
-					Enemy2Z = (rand() % 48) - 26;
-					if ((Enemy2Z > -26 && Enemy2Z < -22) || (Enemy2Z > 18 && Enemy2Z < 22))
-					{
-						Enemy2PosX[Enemy2Num] = Enemy2X;
-						Enemy2PosZ[Enemy2Num] = Enemy2Z;
-						Enemy2Num = Enemy2Num + 1;
-						MaxEnemy2Count = MaxEnemy2Count + 1;
-					}
-				}
-			}
-						
 			// Sort the renderers by shader and material, we will go for a minimizing context switches approach here,
 			// but you could for instance sort front to back to optimize for fill rate if you have intensive fragment shaders
 			renderGroup.sort<RendererComponent>([](const RendererComponent& l, const RendererComponent& r) {
@@ -1291,155 +1735,275 @@ int main() {
 				return false;
 			});
 
-			// Start by assuming no shader or material is applied
-			Shader::sptr current = nullptr;
-			ShaderMaterial::sptr currentMat = nullptr;
+			// Cull renderers against the camera, and let the texture streamer know how much detail the visible ones need.
+			// Anything small enough on screen is queued as an impostor instead of drawing its mesh
+			Frustum frustum(viewProjection);
+			const bool isOrtho = projection[3][3] == 1.0f;
+			impostorSystem.BeginFrame();
+			// The probes are only worth keeping up to date while something on screen reflects them
+			bool probesNeeded = false;
+			renderGroup.each([&](entt::entity entity, RendererComponent& renderer, Transform& transform) {
+				glm::vec3 center;
+				const glm::mat4& model = transform.LocalTransform();
+				const float radius = Frustum::BoundingSphere(renderer.Mesh->GetBoundsMin(), renderer.Mesh->GetBoundsMax(), model, center);
+				renderer.IsVisible = !renderer.ProbeOnly && frustum.TestSphere(center, radius);
+				if (renderer.IsVisible) {
+					// Use the closest point of the bounds, so that large objects like the terrain get enough detail up close
+					const float depth = isOrtho ? 1.0f : glm::max((viewProjection * glm::vec4(center, 1.0f)).w - radius, 0.1f);
+					const float pixelsPerUnit = 0.5f * renderSize.y * projection[1][1] / depth;
+					const float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+					const float uvPerPixel = renderer.Mesh->GetUvDensity() / (glm::max(scale, 0.0001f) * pixelsPerUnit);
+					for (auto& kvp : renderer.Material->Textures) {
+						streamer.Request(kvp.second.get(), uvPerPixel);
+					}
+					if (renderer.Material->UsesReflectionProbes && !(renderer.Mesh == vao2 && packet->PowerUpTaken)) {
+						probesNeeded = true;
+					}
+				}
+				if (ImpostorLOD* lod = scene->Registry().try_get<ImpostorLOD>(entity)) {
+					lod->IsActive = renderer.IsVisible && impostorSystem.Submit(lod->Atlas, model,
+						ImpostorSystem::ProjectedSize(center, radius, viewProjection, projection, (float)renderSize.y));
+				}
+			});
 
-			colorCorrect->Bind();
+			// The terrain culls its own chunks, and picks their detail from how far they are from the camera
+			heightmapTerrain->Select(camTransform.GetLocalPosition(), frustum);
+
+			// Build this frame's passes, the graph works out what order they run in and what memory they need
+			// The scene is HDR, R11G11B10F gives us that for the same bandwidth as RGBA8 (we never need scene alpha)
+			// Its depth is kept as a texture, since low resolution post effects (like fog) read it
+			FrameGraphResource sceneColor = frameGraph.CreateTarget("Scene Color", RenderTargetDesc(width, height, GL_R11F_G11F_B10F, true, true));
+			FrameGraphResource backbuffer = frameGraph.ImportBackbuffer("Backbuffer", width, height);
+			FrameGraphResource probes = frameGraph.ImportResource("Reflection Probes");
+
+			// Update a slice of the reflection probes before the scene samples them. When nothing visible samples them
+			// they're left as they are, and pick up where they left off once something does
+			if (probesNeeded) {
+				frameGraph.AddPass("Reflection Probes", [&](FrameGraph::PassBuilder& builder) {
+					builder.Write(probes);
+				}, [&](FrameGraph&) {
+					probeSystem.Update(scene->Registry());
+				});
+			}
 
-			// Iterate over the render group components and draw them
-			renderGroup.each( [&](entt::entity, RendererComponent& renderer, Transform& transform) {
-				// If the shader has changed, bind it and set up it's uniforms
-				if (current != renderer.Material->Shader) {
-					current = renderer.Material->Shader;
-					current->Bind();
-					SetupShaderForFrame(current, view, projection);
+			frameGraph.AddPass("Scene", [&](FrameGraph::PassBuilder& builder) {
+				if (probesNeeded) {
+					builder.Read(probes);
 				}
-				// If the material has changed, apply it
-				if (currentMat != renderer.Material) {
-					currentMat = renderer.Material;
-					currentMat->Apply();
+				builder.Write(sceneColor);
+			}, [&](FrameGraph& graph) {
+				// Only clear the part of the target we'll actually render into
+				Framebuffer* target = graph.GetTarget(sceneColor);
+				glEnable(GL_SCISSOR_TEST);
+				glScissor(0, 0, renderSize.x, renderSize.y);
+				target->SetClearColor(glm::vec4(0.08f, 0.17f, 0.31f, 1.0f));
+				target->Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				glDisable(GL_SCISSOR_TEST);
+				glEnable(GL_DEPTH_TEST);
+				glViewport(0, 0, renderSize.x, renderSize.y);
+
+				if (irradianceVolume != nullptr) {
+					irradianceVolume->Bind();
 				}
-				// Render the mesh
-				if (renderer.Mesh == vao2 && PowerUpTaken == true)
-				{				
-				}
-				else if (renderer.Mesh == vao1)
-				{
-					for (int Count = 0; Count < 200; Count++)
+
+				// Reflective renderers (which pick their probes as they go) are drawn directly. Everything else is gathered
+				// up, recorded across threads in the same sorted order, and replayed here
+				auto isDrawnDirectly = [&](const RendererComponent& renderer) {
+					return renderer.Material->UsesReflectionProbes;
+				};
+
+				// Per frame uniforms are set and per object uniforms looked up here, since neither can happen while recording
+				Shader::sptr current = nullptr;
+				DrawUniforms uniforms = { -1, -1, -1 };
+				sceneDraws.clear();
+				auto addDraw = [&](const RendererComponent& renderer, const Transform& placement) {
+					sceneDraws.push_back({ &renderer, placement.LocalTransform(), placement.NormalMatrix(), uniforms });
+				};
+				// Enemies are all drawn through one object, so each one picks between its mesh and impostor here
+				auto addEnemy = [&](const RendererComponent& renderer, const Transform& placement, const ImpostorAtlas::sptr& impostor) {
+					glm::vec3 center;
+					const float radius = Frustum::BoundingSphere(renderer.Mesh->GetBoundsMin(), renderer.Mesh->GetBoundsMax(), placement.LocalTransform(), center);
+					const float pixelSize = ImpostorSystem::ProjectedSize(center, radius, viewProjection, projection, (float)renderSize.y);
+					if (!impostorSystem.Submit(impostor, placement.LocalTransform(), pixelSize)) {
+						addDraw(renderer, placement);
+					}
+				};
+				renderGroup.each([&](entt::entity entity, RendererComponent& renderer, Transform& transform) {
+					if (isDrawnDirectly(renderer)) {
+						return;
+					}
+					if (current != renderer.Material->Shader) {
+						current = renderer.Material->Shader;
+						SetupShaderForFrame(current, view, projection);
+						uniforms.ModelViewProjection = current->GetUniformLocation("u_ModelViewProjection");
+						uniforms.Model = current->GetUniformLocation("u_Model");
+						uniforms.NormalMatrix = current->GetUniformLocation("u_NormalMatrix");
+					}
+
+					// Enemies and fences are drawn many times through one object, each copy gets its own placement
+					Transform placement = transform;
+					if (renderer.Mesh == vao1)
 					{
-						//Enemy X Movement
-						if (EnemyPosX[Count] > tranX)
+						for (int Count = 0; Count < 200; Count++)
 						{
-							EnemyPosX[Count] = EnemyPosX[Count] - 0.02;
+							placement.SetLocalPosition(glm::vec3(packet->Skeletons[Count].x, 1.0f, packet->Skeletons[Count].y));
+							addEnemy(renderer, placement, skeletonImpostor);
 						}
-						else if (EnemyPosX[Count] < tranX)
+					}
+					else if (renderer.Mesh == vao20)
+					{
+						for (int Count = 0; Count < 200; Count++)
 						{
-							EnemyPosX[Count] = EnemyPosX[Count] + 0.02;
+							placement.SetLocalPosition(glm::vec3(packet->Zombies[Count].x, 1.0f, packet->Zombies[Count].y)).SetLocalRotation(0, 270, 0);
+							addEnemy(renderer, placement, zombieImpostor);
 						}
-
-						//Enemy Z movement
-						if (EnemyPosZ[Count] > tranZ)
+					}
+					else if (renderer.Mesh == vao6)
+					{
+						// The north and south fences leave a gap for the gate
+						placement.SetLocalRotation(0, 0, 0);
+						for (float barrierX = -24.0f; barrierX < 30.0f; barrierX += 3.0f)
 						{
-							EnemyPosZ[Count] = EnemyPosZ[Count] - 0.02;
+							addDraw(renderer, placement.SetLocalPosition(barrierX, 3.0f, -27.5f));
+							if (barrierX != 0.0f) {
+								addDraw(renderer, placement.SetLocalPosition(barrierX, 3.0f, 26));
+							}
 						}
-						else if (EnemyPosZ[Count] < tranZ)
+						placement.SetLocalRotation(0, 90, 0);
+						for (float barrierZ = -27.5f; barrierZ < 26.5f; barrierZ += 3.0f)
 						{
-							EnemyPosZ[Count] = EnemyPosZ[Count] + 0.02;
+							addDraw(renderer, placement.SetLocalPosition(27, 3.0f, barrierZ));
+							addDraw(renderer, placement.SetLocalPosition(-27, 3.0f, barrierZ));
 						}
-
-						EnemyPosX[Count] = CollideX(EnemyPosX[Count], EnemyPosZ[Count]);
-						EnemyPosZ[Count] = CollideZ(EnemyPosX[Count], EnemyPosZ[Count]);
-						
-						enemy.get<Transform>().SetLocalPosition(EnemyPosX[Count], 1.0f, EnemyPosZ[Count]);
-						RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
 					}
-				}
-				else if (renderer.Mesh == vao6)
-				{
-					for (int Count = 0; Count < 18; Count++)
+					else if (renderer.IsVisible && !(renderer.Mesh == vao2 && packet->PowerUpTaken))
 					{
-						barrier.get<Transform>().SetLocalRotation(0, 0, 0).SetLocalPosition(BarrierX, 3.0f, -27.5f);;
-						RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-						if (BarrierX == 0)
-						{
+						const ImpostorLOD* lod = scene->Registry().try_get<ImpostorLOD>(entity);
+						if (lod == nullptr || !lod->IsActive) {
+							addDraw(renderer, transform);
 						}
-						else{
-							barrier.get<Transform>().SetLocalPosition(BarrierX, 3.0f, 26);
-							RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-						}
-						BarrierX = BarrierX + 3;
 					}
+				});
 
-					for (int Count = 0; Count < 18; Count++)
-					{
-						barrier.get<Transform>().SetLocalRotation(0, 90, 0).SetLocalPosition(27, 3.0f, BarrierZ);
-						RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-						barrier.get<Transform>().SetLocalPosition(-27, 3.0f, BarrierZ);
-						RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-						BarrierZ = BarrierZ + 3;
-					}
+				sceneRecordThreads = CommandBuffer::RecordParallel(sceneCommands, sceneDraws.size(), [&](CommandBuffer& commands, size_t begin, size_t end) {
+					RecordSceneDraws(commands, sceneDraws, begin, end, viewProjection);
+				});
 
-					BarrierX = -24;
-					BarrierZ = -27.5f;
+				// SetupShaderForFrame bound shaders behind the executor's back, so start it from scratch
+				commandExecutor.ResetStats();
+				commandExecutor.Invalidate();
+				for (const CommandBuffer& commands : sceneCommands) {
+					commandExecutor.Execute(commands);
 				}
-				else if (renderer.Mesh == vao20)
-				{
-					for (int Count = 0; Count < 200; Count++)
-					{
-						//Enemy X Movement
-						if (Enemy2PosX[Count] > tranX)
-						{
-							Enemy2PosX[Count] = Enemy2PosX[Count] - 0.02;
-						}
-						else if (Enemy2PosX[Count] < tranX)
-						{
-							Enemy2PosX[Count] = Enemy2PosX[Count] + 0.02;
-						}
+				VertexArrayObject::UnBind();
 
-						//Enemy Z movement
-						if (Enemy2PosZ[Count] > tranZ)
-						{
-							Enemy2PosZ[Count] = Enemy2PosZ[Count] - 0.02;
-						}
-						else if (Enemy2PosZ[Count] < tranZ)
-						{
-							Enemy2PosZ[Count] = Enemy2PosZ[Count] + 0.02;
+				// Start the direct draws by assuming no shader or material is applied
+				current = nullptr;
+				ShaderMaterial::sptr currentMat = nullptr;
+
+				// Iterate over the render group components and draw them
+				renderGroup.each( [&](entt::entity entity, RendererComponent& renderer, Transform& transform) {
+					if (!isDrawnDirectly(renderer)) {
+						return;
+					}
+					// If the shader has changed, bind it and set up it's uniforms
+					if (current != renderer.Material->Shader) {
+						current = renderer.Material->Shader;
+						current->Bind();
+						SetupShaderForFrame(current, view, projection);
+					}
+					// If the material has changed, apply it
+					if (currentMat != renderer.Material) {
+						currentMat = renderer.Material;
+						currentMat->Apply();
+					}
+					// Reflective objects sample whichever probes are closest to them
+					if (currentMat->UsesReflectionProbes) {
+						probeSystem.BindNearest(scene->Registry(), current, transform.GetLocalPosition());
+					}
+					// Render the mesh
+					if (renderer.Mesh == vao2 && packet->PowerUpTaken == true)
+					{				
+					}
+					else if (renderer.IsVisible)
+					{
+						const ImpostorLOD* lod = scene->Registry().try_get<ImpostorLOD>(entity);
+						if (lod == nullptr || !lod->IsActive) {
+							RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
 						}
-						Enemy2PosX[Count] = CollideX(Enemy2PosX[Count], Enemy2PosZ[Count]);
-						Enemy2PosZ[Count] = CollideZ(Enemy2PosX[Count], Enemy2PosZ[Count]);
-						enemy2.get<Transform>().SetLocalPosition(Enemy2PosX[Count], 1.0f, Enemy2PosZ[Count]).SetLocalRotation(0, 270, 0);
-						RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
 					}
-				}
-				else
-				{
-					RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-				}
+				});
+
+				// Impostors go in as one instanced draw per atlas, after every mesh so they're all queued
+				impostorSystem.Render(view, projection);
+
+				// The ground goes last, most of it is hidden behind everything else
+				SetupShaderForFrame(terrainShader, view, projection);
+				heightmapTerrain->Render(terrainShader);
 			});
 
-			colorCorrect->Unbind();
+			// Particles blend over the finished scene, reading its depth to fade out where they meet it. Depth writes
+			// are off while they draw, so the depth buffer is never written while it's being sampled
+			frameGraph.AddPass("Particles", [&](FrameGraph::PassBuilder& builder) {
+				builder.Read(sceneColor, true);
+				builder.Write(sceneColor);
+			}, [&](FrameGraph& graph) {
+				graph.GetTarget(sceneColor)->BindDepthAsTexture(ParticleSystem::DEPTH_SLOT);
+				glEnable(GL_DEPTH_TEST);
+				glViewport(0, 0, renderSize.x, renderSize.y);
+				particleSystem.Render(scene->Registry(), view, projection,
+					cameraObject.get<Camera>().GetNearPlane(), cameraObject.get<Camera>().GetFarPlane());
+				graph.GetTarget(sceneColor)->UnbindTexture(ParticleSystem::DEPTH_SLOT);
+			});
 
-			colorCorrectionShader->Bind();
+			// Rebake the grading LUT if any of the weights were changed
+			for (int ix = 0; ix < 4; ix++) {
+				lutMixer.SetWeight(ix, gradeWeights[ix]);
+			}
+			lutMixer.Update();
 
-			colorCorrect->BindColorAsTexture(0, 0);
-			//testCube.bind(30);
-			//baseCube.bind(30);
-			//warmCube.bind(30);
-			//coolCube.bind(30);
-			customCube.bind(30);
+			// Pick up the filtered environment once the workers have finished with it
+			if (environment->Update()) {
+				environment->SetUniforms(reflectiveShader);
+			}
 
-			colorCorrect->DrawFullscreenQuad();
+			// Grade the scene straight onto the back buffer, scaling it back up to the full resolution
+			postChain.SetInputRect(renderSize.x, renderSize.y);
+			postChain.SetDepthPlanes(cameraObject.get<Camera>().GetNearPlane(), cameraObject.get<Camera>().GetFarPlane());
+			postChain.AddPasses(frameGraph, sceneColor, backbuffer, width, height);
 
-			//testCube.unbind(30);
-			//baseCube.unbind(30);
-			//warmCube.unbind(30);
-			//coolCube.unbind(30);
-			customCube.unbind(30);
-			colorCorrect->UnbindTexture(0);
+			frameGraph.AddPass("ImGui", [&](FrameGraph::PassBuilder& builder) {
+				builder.Write(backbuffer);
+			}, [&](FrameGraph&) {
+				// Draw our ImGui content
+				RenderImGui();
+			});
 
-			colorCorrectionShader->UnBind();
+			frameGraph.Execute();
+			RenderTargetPool::Instance().EndFrame();
 
-			// Draw our ImGui content
-			RenderImGui();
+			// Upload any texture detail that was requested this frame
+			streamer.Update();
+			// Evict streamed detail if we've gone over our memory budget
+			GpuMemoryTracker::Instance().Update();
 
 			scene->Poll();
 			glfwSwapBuffers(window);
+			frameFence.Signal();
 			time.LastFrame = time.CurrentFrame;
+
+			// Nothing reads the packet after this, so the game thread can have it back
+			framePackets.EndRead();
 		}
+
+		framePackets.Stop();
+		gameThread.join();
 		
 		// Nullify scene so that we can release references
 		Application::Instance().ActiveScene = nullptr;
+		TextureStreamer::Instance().Clear();
+		RenderTargetPool::Instance().Clear();
+		PostProcessChain::ClearCache();
 		ShutdownImGui();
 	}	
 